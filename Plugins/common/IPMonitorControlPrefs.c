@@ -29,6 +29,9 @@
 /*
  * Modification History
  *
+ * October 18, 2026
+ * - only refresh when the 'Verbose' setting was changed by a commit
+ *
  * January 14, 2013	Dieter Siegmund (dieter@apple)
  * - created
  */
@@ -38,6 +41,7 @@
 #include <SystemConfiguration/SCPrivate.h>
 #include <SystemConfiguration/scprefs_observer.h>
 #include "IPMonitorControlPrefs.h"
+#include "SCPreferencesInternal.h"
 
 os_log_t	__log_IPMonitor(void);
 
@@ -52,7 +56,8 @@ os_log_t	__log_IPMonitor(void);
  * kVerbose
  * - indicates whether IPMonitor is verbose or not
  */
-#define kVerbose			CFSTR("Verbose")
+#define kVerboseStr			"Verbose"
+#define kVerbose			CFSTR(kVerboseStr)
 
 static SCPreferencesRef			S_prefs;
 static IPMonitorControlPrefsCallBack	S_callback;
@@ -142,9 +147,12 @@ IPMonitorControlPrefsChanged(SCPreferencesRef prefs,
 			     SCPreferencesNotification type,
 			     void * info)
 {
-#pragma unused(prefs)
-#pragma unused(type)
 #pragma unused(info)
+    if ((type == kSCPreferencesNotificationCommit)
+	&& !_SCPreferencesPathChanged(prefs, CFSTR("/" kVerboseStr))) {
+	/* if the commit did not change the setting */
+	return;
+    }
     prefs_changed(NULL);
     return;
 }
@@ -29,6 +29,9 @@
 /*
  * Modification History
  *
+ * October 18, 2026
+ * - only refresh when 'AllowNewInterfaces' was changed by a commit
+ *
  * January 12, 2017	Allan Nathanson (ajn@apple.com)
  * - created
  */
@@ -38,6 +41,7 @@
 #include <SystemConfiguration/SCPrivate.h>
 #include <SystemConfiguration/scprefs_observer.h>
 #include "InterfaceNamerControlPrefs.h"
+#include "SCPreferencesInternal.h"
 
 /*
  * kInterfaceNamerControlPrefsID
@@ -51,7 +55,8 @@
  * - indicates whether InterfaceNamer is allowed to create new interfaces
  *   while the screen is locked or not
  */
-#define kAllowNewInterfaces			CFSTR("AllowNewInterfaces")
+#define kAllowNewInterfacesStr			"AllowNewInterfaces"
+#define kAllowNewInterfaces			CFSTR(kAllowNewInterfacesStr)
 
 static SCPreferencesRef				S_prefs;
 static InterfaceNamerControlPrefsCallBack	S_callback;
@@ -151,9 +156,12 @@ InterfaceNamerControlPrefsChanged(SCPreferencesRef		prefs,
 				  SCPreferencesNotification	type,
 				  void				*info)
 {
-#pragma unused(prefs)
-#pragma unused(type)
 #pragma unused(info)
+    if ((type == kSCPreferencesNotificationCommit)
+	&& !_SCPreferencesPathChanged(prefs, CFSTR("/" kAllowNewInterfacesStr))) {
+	/* if the commit did not change the setting */
+	return;
+    }
     prefs_changed(NULL);
     return;
 }
@@ -270,12 +270,11 @@ SCBondInterfaceCopyAll(SCPreferencesRef prefs)
 	context.prefs = prefs;
 	context.ni_prefs = ni_prefs;
 
-	path = CFStringCreateWithFormat(NULL,
-					NULL,
-					CFSTR("/%@/%@"),
-					kSCPrefVirtualNetworkInterfaces,
-					kSCNetworkInterfaceTypeBond);
-	dict = SCPreferencesPathGetValue(prefs, path);
+	path = __SCKeyCreateInterned(CFSTR(""),
+				     kSCPrefVirtualNetworkInterfaces,
+				     kSCNetworkInterfaceTypeBond,
+				     NULL);
+	dict = __SCPreferencesPathGetValue(prefs, path);
 	CFRelease(path);
 	if (isA_CFDictionary(dict)) {
 		my_CFDictionaryApplyFunction(dict, add_configured_interface, &context);
@@ -524,13 +523,12 @@ SCBondInterfaceCreate(SCPreferencesRef prefs)
 		CFStringRef			path;
 
 		bond_if = CFStringCreateWithFormat(allocator, NULL, CFSTR("bond%ld"), i);
-		path    = CFStringCreateWithFormat(allocator,
-						   NULL,
-						   CFSTR("/%@/%@/%@"),
-						   kSCPrefVirtualNetworkInterfaces,
-						   kSCNetworkInterfaceTypeBond,
-						   bond_if);
-		dict = SCPreferencesPathGetValue(prefs, path);
+		path    = __SCKeyCreateInterned(CFSTR(""),
+						kSCPrefVirtualNetworkInterfaces,
+						kSCNetworkInterfaceTypeBond,
+						bond_if,
+						NULL);
+		dict = __SCPreferencesPathGetValue(prefs, path);
 		if (dict != NULL) {
 			// if bond interface name not available
 			CFRelease(path);
@@ -587,12 +585,11 @@ SCBondInterfaceRemove(SCBondInterfaceRef bond)
 	}
 
 	bond_if = SCNetworkInterfaceGetBSDName(bond);
-	path    = CFStringCreateWithFormat(NULL,
-					   NULL,
-					   CFSTR("/%@/%@/%@"),
-					   kSCPrefVirtualNetworkInterfaces,
-					   kSCNetworkInterfaceTypeBond,
-					   bond_if);
+	path    = __SCKeyCreateInterned(CFSTR(""),
+					kSCPrefVirtualNetworkInterfaces,
+					kSCNetworkInterfaceTypeBond,
+					bond_if,
+					NULL);
 	ok = SCPreferencesPathRemoveValue(interfacePrivate->prefs, path);
 	CFRelease(path);
 
@@ -646,13 +643,12 @@ __SCBondInterfaceSetMemberInterfaces(SCBondInterfaceRef bond, CFArrayRef members
 		CFMutableDictionaryRef	newDict;
 		CFStringRef		path;
 
-		path = CFStringCreateWithFormat(NULL,
-						NULL,
-						CFSTR("/%@/%@/%@"),
-						kSCPrefVirtualNetworkInterfaces,
-						kSCNetworkInterfaceTypeBond,
-						interfacePrivate->entity_device);
-		dict = SCPreferencesPathGetValue(interfacePrivate->prefs, path);
+		path = __SCKeyCreateInterned(CFSTR(""),
+					     kSCPrefVirtualNetworkInterfaces,
+					     kSCNetworkInterfaceTypeBond,
+					     interfacePrivate->entity_device,
+					     NULL);
+		dict = __SCPreferencesPathGetValue(interfacePrivate->prefs, path);
 		if (!isA_CFDictionary(dict)) {
 			// if the prefs are confused
 			CFRelease(path);
@@ -805,13 +801,12 @@ SCBondInterfaceSetLocalizedDisplayName(SCBondInterfaceRef bond, CFStringRef newN
 		CFMutableDictionaryRef	newDict;
 		CFStringRef		path;
 
-		path = CFStringCreateWithFormat(NULL,
-						NULL,
-						CFSTR("/%@/%@/%@"),
-						kSCPrefVirtualNetworkInterfaces,
-						kSCNetworkInterfaceTypeBond,
-						interfacePrivate->entity_device);
-		dict = SCPreferencesPathGetValue(interfacePrivate->prefs, path);
+		path = __SCKeyCreateInterned(CFSTR(""),
+					     kSCPrefVirtualNetworkInterfaces,
+					     kSCNetworkInterfaceTypeBond,
+					     interfacePrivate->entity_device,
+					     NULL);
+		dict = __SCPreferencesPathGetValue(interfacePrivate->prefs, path);
 		if (!isA_CFDictionary(dict)) {
 			// if the prefs are confused
 			CFRelease(path);
@@ -869,13 +864,12 @@ SCBondInterfaceSetOptions(SCBondInterfaceRef bond, CFDictionaryRef newOptions)
 		CFMutableDictionaryRef	newDict;
 		CFStringRef		path;
 
-		path = CFStringCreateWithFormat(NULL,
-						NULL,
-						CFSTR("/%@/%@/%@"),
-						kSCPrefVirtualNetworkInterfaces,
-						kSCNetworkInterfaceTypeBond,
-						interfacePrivate->entity_device);
-		dict = SCPreferencesPathGetValue(interfacePrivate->prefs, path);
+		path = __SCKeyCreateInterned(CFSTR(""),
+					     kSCPrefVirtualNetworkInterfaces,
+					     kSCNetworkInterfaceTypeBond,
+					     interfacePrivate->entity_device,
+					     NULL);
+		dict = __SCPreferencesPathGetValue(interfacePrivate->prefs, path);
 		if (!isA_CFDictionary(dict)) {
 			// if the prefs are confused
 			CFRelease(path);
@@ -933,13 +927,12 @@ _SCBondInterfaceSetMode(SCBondInterfaceRef bond, CFNumberRef mode)
 		CFMutableDictionaryRef	newDict;
 		CFStringRef		path;
 
-		path = CFStringCreateWithFormat(NULL,
-						NULL,
-						CFSTR("/%@/%@/%@"),
-						kSCPrefVirtualNetworkInterfaces,
-						kSCNetworkInterfaceTypeBond,
-						interfacePrivate->entity_device);
-		dict = SCPreferencesPathGetValue(interfacePrivate->prefs, path);
+		path = __SCKeyCreateInterned(CFSTR(""),
+					     kSCPrefVirtualNetworkInterfaces,
+					     kSCNetworkInterfaceTypeBond,
+					     interfacePrivate->entity_device,
+					     NULL);
+		dict = __SCPreferencesPathGetValue(interfacePrivate->prefs, path);
 		if (!isA_CFDictionary(dict)) {
 			// if the prefs are confused
 			CFRelease(path);
@@ -0,0 +1,734 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: compiled SCDynamicStore key patterns and a sorted
+ *   key index used to answer key list / multi-key pattern queries
+ */
+
+#include "SCDynamicStoreInternal.h"
+
+
+/*
+ * SCDynamicStore key patterns are POSIX extended regular expressions.  In
+ * practice almost all of them are literals with, at most, a wildcard or
+ * two (e.g. "^State:/Network/Service/[^/]+/IPv4$").  When a pattern is
+ * compiled we pull out :
+ *
+ *   - the literal prefix (anchored patterns only)
+ *   - the literal suffix (patterns ending with '$' only)
+ *   - the longest literal run that any match must contain
+ *
+ * Keys that fail any of the literal checks are rejected without running
+ * the regex.  Patterns that are entirely literal never run the regex at
+ * all.  The key index keeps the keys sorted so that anchored patterns
+ * only need to visit the keys sharing the literal prefix.
+ */
+
+
+struct __SCDPattern {
+	CFStringRef		pattern;
+
+	Boolean			anchoredStart;
+	Boolean			anchoredEnd;
+	Boolean			literal;	// TRUE if no regex needed
+
+	char			*prefix;	// if anchoredStart
+	size_t			prefixLen;
+	char			*suffix;	// if anchoredEnd
+	size_t			suffixLen;
+	char			*required;	// must appear somewhere
+	size_t			requiredLen;
+
+	Boolean			compiled;
+	regex_t			preg;
+};
+
+
+typedef struct {
+	char			*str;
+	size_t			len;
+	CFStringRef		key;
+} SCDKeyIndexEntry;
+
+
+#define	N_PATTERN_CACHE_MAX	256
+
+
+struct __SCDKeyIndex {
+	pthread_mutex_t		lock;
+
+	/* keys, sorted (strcmp) by UTF-8 representation */
+	SCDKeyIndexEntry	*entries;
+	CFIndex			count;
+	CFIndex			size;
+
+	/* compiled pattern cache, <pattern> --> SCDPatternRef */
+	CFMutableDictionaryRef	patterns;
+};
+
+
+#pragma mark -
+#pragma mark Pattern analysis
+
+
+static Boolean
+isPatternMeta(char c)
+{
+	return (strchr(".[]()*+?{}|^$\\", c) != NULL) && (c != '\0');
+}
+
+
+static const char *
+skipBracket(const char *p)
+{
+	// p points at '['
+	p++;
+	if (*p == '^') p++;
+	if (*p == ']') p++;		// leading ']' is a literal
+	while ((*p != '\0') && (*p != ']')) {
+		if ((p[0] == '[') && ((p[1] == ':') || (p[1] == '.') || (p[1] == '='))) {
+			char		close	= p[1];
+
+			p += 2;
+			while ((*p != '\0') && !((p[0] == close) && (p[1] == ']'))) p++;
+			if (*p != '\0') p += 2;
+			continue;
+		}
+		p++;
+	}
+	return (*p == ']') ? p + 1 : p;
+}
+
+
+static const char *
+skipGroup(const char *p)
+{
+	int	depth	= 0;
+
+	// p points at '('
+	while (*p != '\0') {
+		if (*p == '\\') {
+			p += (p[1] != '\0') ? 2 : 1;
+			continue;
+		}
+		if (*p == '[') {
+			p = skipBracket(p);
+			continue;
+		}
+		if (*p == '(') {
+			depth++;
+		} else if (*p == ')') {
+			if (--depth == 0) {
+				return p + 1;
+			}
+		}
+		p++;
+	}
+	return p;
+}
+
+
+static char *
+copyRun(const char *run, size_t len)
+{
+	char	*str;
+
+	str = CFAllocatorAllocate(NULL, len + 1, 0);
+	memcpy(str, run, len);
+	str[len] = '\0';
+	return str;
+}
+
+
+static void
+analyzePattern(SCDPatternRef pattern, const char *str)
+{
+	size_t		bestLen		= 0;
+	char		*best		= NULL;
+	const char	*p		= str;
+	char		*run;
+	size_t		runLen		= 0;
+	Boolean		runIsPrefix;
+	Boolean		lastAtomInRun	= FALSE;
+	Boolean		literal		= TRUE;
+
+	// a top-level alternation defeats any literal analysis
+	for (p = str; *p != '\0'; ) {
+		if (*p == '\\') {
+			p += (p[1] != '\0') ? 2 : 1;
+		} else if (*p == '[') {
+			p = skipBracket(p);
+		} else if (*p == '(') {
+			p = skipGroup(p);
+		} else if (*p == '|') {
+			return;
+		} else {
+			p++;
+		}
+	}
+
+	run = CFAllocatorAllocate(NULL, strlen(str) + 1, 0);
+	best = CFAllocatorAllocate(NULL, strlen(str) + 1, 0);
+
+	p = str;
+	if (*p == '^') {
+		pattern->anchoredStart = TRUE;
+		p++;
+	}
+	runIsPrefix = pattern->anchoredStart;
+
+#define	END_RUN()							\
+	do {								\
+		if (runIsPrefix && (runLen > 0)) {			\
+			pattern->prefix = copyRun(run, runLen);		\
+			pattern->prefixLen = runLen;			\
+		}							\
+		if (runLen > bestLen) {					\
+			memcpy(best, run, runLen);			\
+			bestLen = runLen;				\
+		}							\
+		runLen = 0;						\
+		runIsPrefix = FALSE;					\
+		lastAtomInRun = FALSE;					\
+	} while (0)
+
+	while (*p != '\0') {
+		char	c	= *p;
+
+		if ((c == '$') && (p[1] == '\0')) {
+			pattern->anchoredEnd = TRUE;
+			if (runLen > 0) {
+				pattern->suffix = copyRun(run, runLen);
+				pattern->suffixLen = runLen;
+			}
+			p++;
+			break;
+		}
+
+		if (c == '\\') {
+			if ((p[1] != '\0') && isPatternMeta(p[1])) {
+				run[runLen++] = p[1];
+				lastAtomInRun = TRUE;
+				p += 2;
+				continue;
+			}
+			// unknown escape, treat as a non-literal atom
+			literal = FALSE;
+			END_RUN();
+			p += (p[1] != '\0') ? 2 : 1;
+			continue;
+		}
+
+		switch (c) {
+			case '*' :
+			case '?' :
+			case '{' :
+				// the previous atom is optional (or repeated an unknown # of times)
+				literal = FALSE;
+				if (lastAtomInRun && (runLen > 0)) {
+					// drop the (possibly multi-byte) character it applies to
+					do {
+						runLen--;
+					} while ((runLen > 0) && (((unsigned char)run[runLen] & 0xc0) == 0x80));
+				}
+				END_RUN();
+				if (c == '{') {
+					while ((*p != '\0') && (*p != '}')) p++;
+				}
+				if (*p != '\0') p++;
+				break;
+			case '+' :
+				// the previous atom must appear at least once
+				literal = FALSE;
+				END_RUN();
+				p++;
+				break;
+			case '.' :
+				literal = FALSE;
+				END_RUN();
+				p++;
+				break;
+			case '[' :
+				literal = FALSE;
+				END_RUN();
+				p = skipBracket(p);
+				break;
+			case '(' :
+				literal = FALSE;
+				END_RUN();
+				p = skipGroup(p);
+				break;
+			case '^' :
+			case '$' :
+			case ')' :
+			case '}' :
+			case ']' :
+				literal = FALSE;
+				END_RUN();
+				p++;
+				break;
+			default :
+				run[runLen++] = c;
+				lastAtomInRun = TRUE;
+				p++;
+				break;
+		}
+	}
+
+	if (!pattern->anchoredEnd || (pattern->suffix == NULL)) {
+		END_RUN();
+	} else {
+		// the suffix run was already captured, account for it as "required"
+		if (runIsPrefix && (runLen > 0) && (pattern->prefix == NULL)) {
+			pattern->prefix = copyRun(run, runLen);
+			pattern->prefixLen = runLen;
+		}
+		if (runLen > bestLen) {
+			memcpy(best, run, runLen);
+			bestLen = runLen;
+		}
+	}
+
+#undef	END_RUN
+
+	if (bestLen > 0) {
+		pattern->required = copyRun(best, bestLen);
+		pattern->requiredLen = bestLen;
+	}
+
+	// a pattern with only literal characters does not need the regex
+	pattern->literal = literal;
+
+	CFAllocatorDeallocate(NULL, run);
+	CFAllocatorDeallocate(NULL, best);
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Compiled patterns
+
+
+SCDPatternRef
+__SCDPatternCreate(CFStringRef patternString)
+{
+	SCDPatternRef	pattern;
+	int		reError;
+	char		*str;
+
+	if (!isA_CFString(patternString)) {
+		_SCErrorSet(kSCStatusInvalidArgument);
+		return NULL;
+	}
+
+	str = _SC_cfstring_to_cstring(patternString, NULL, 0, kCFStringEncodingUTF8);
+	if (str == NULL) {
+		_SCErrorSet(kSCStatusFailed);
+		return NULL;
+	}
+
+	pattern = calloc(1, sizeof(*pattern));
+	if (pattern == NULL) {
+		CFAllocatorDeallocate(NULL, str);
+		_SCErrorSet(kSCStatusFailed);
+		return NULL;
+	}
+	pattern->pattern = CFRetain(patternString);
+
+	analyzePattern(pattern, str);
+
+	if (!pattern->literal) {
+		reError = regcomp(&pattern->preg, str, REG_EXTENDED);
+		if (reError != 0) {
+			char	reErrBuf[256];
+
+			(void) regerror(reError, &pattern->preg, reErrBuf, sizeof(reErrBuf));
+			SC_log(LOG_INFO, "regcomp(%@) failed: %s", patternString, reErrBuf);
+			CFAllocatorDeallocate(NULL, str);
+			__SCDPatternRelease(pattern);
+			_SCErrorSet(kSCStatusFailed);
+			return NULL;
+		}
+		pattern->compiled = TRUE;
+	}
+
+	CFAllocatorDeallocate(NULL, str);
+	return pattern;
+}
+
+
+void
+__SCDPatternRelease(SCDPatternRef pattern)
+{
+	if (pattern == NULL) {
+		return;
+	}
+
+	if (pattern->compiled)		regfree(&pattern->preg);
+	if (pattern->prefix != NULL)	CFAllocatorDeallocate(NULL, pattern->prefix);
+	if (pattern->suffix != NULL)	CFAllocatorDeallocate(NULL, pattern->suffix);
+	if (pattern->required != NULL)	CFAllocatorDeallocate(NULL, pattern->required);
+	CFRelease(pattern->pattern);
+	free(pattern);
+	return;
+}
+
+
+Boolean
+__SCDPatternMatch(SCDPatternRef pattern, const char *key, size_t keyLen)
+{
+	if (pattern->prefixLen > 0) {
+		if ((keyLen < pattern->prefixLen) ||
+		    (memcmp(key, pattern->prefix, pattern->prefixLen) != 0)) {
+			return FALSE;
+		}
+	}
+
+	if (pattern->suffixLen > 0) {
+		if ((keyLen < pattern->suffixLen) ||
+		    (memcmp(key + keyLen - pattern->suffixLen, pattern->suffix, pattern->suffixLen) != 0)) {
+			return FALSE;
+		}
+	}
+
+	if (pattern->literal) {
+		if (pattern->anchoredStart && pattern->anchoredEnd) {
+			return (keyLen == pattern->prefixLen);
+		}
+		if (pattern->anchoredStart || pattern->anchoredEnd) {
+			return TRUE;
+		}
+		return (pattern->required == NULL) || (strstr(key, pattern->required) != NULL);
+	}
+
+	if ((pattern->requiredLen > 0) &&
+	    (pattern->requiredLen > pattern->prefixLen) &&
+	    (pattern->requiredLen > pattern->suffixLen) &&
+	    (strstr(key, pattern->required) == NULL)) {
+		return FALSE;
+	}
+
+	return (regexec(&pattern->preg, key, 0, NULL, 0) == 0);
+}
+
+
+Boolean
+__SCDPatternMatchKey(SCDPatternRef pattern, CFStringRef key)
+{
+	char		buf[256];
+	Boolean		match;
+	char		*str;
+
+	str = _SC_cfstring_to_cstring(key, buf, sizeof(buf), kCFStringEncodingUTF8);
+	if (str == NULL) {
+		str = _SC_cfstring_to_cstring(key, NULL, 0, kCFStringEncodingUTF8);
+		if (str == NULL) {
+			return FALSE;
+		}
+	}
+
+	match = __SCDPatternMatch(pattern, str, strlen(str));
+	if (str != buf) {
+		CFAllocatorDeallocate(NULL, str);
+	}
+
+	return match;
+}
+
+
+const char *
+__SCDPatternGetRequiredLiteral(SCDPatternRef pattern, size_t *len)
+{
+	*len = pattern->requiredLen;
+	return pattern->required;
+}
+
+
+#pragma mark -
+#pragma mark Key index
+
+
+static CFIndex
+keyIndexLowerBound(SCDKeyIndexRef keyIndex, const char *str, size_t len)
+{
+	CFIndex		hi	= keyIndex->count;
+	CFIndex		lo	= 0;
+
+	while (lo < hi) {
+		CFIndex		mid	= lo + (hi - lo) / 2;
+		int		cmp;
+		size_t		n;
+
+		n = (keyIndex->entries[mid].len < len) ? keyIndex->entries[mid].len : len;
+		cmp = memcmp(keyIndex->entries[mid].str, str, n);
+		if (cmp == 0) {
+			cmp = (keyIndex->entries[mid].len < len) ? -1 : 0;
+		}
+		if (cmp < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+
+static Boolean
+keyIndexEntryEqual(SCDKeyIndexRef keyIndex, CFIndex i, const char *str, size_t len)
+{
+	return ((i < keyIndex->count) &&
+		(keyIndex->entries[i].len == len) &&
+		(memcmp(keyIndex->entries[i].str, str, len) == 0));
+}
+
+
+static void
+patternCacheRelease(const void *key, const void *value, void *context)
+{
+#pragma unused(key)
+#pragma unused(context)
+	__SCDPatternRelease((SCDPatternRef)value);
+	return;
+}
+
+
+SCDKeyIndexRef
+__SCDKeyIndexCreate(void)
+{
+	SCDKeyIndexRef	keyIndex;
+
+	keyIndex = calloc(1, sizeof(*keyIndex));
+	if (keyIndex == NULL) {
+		_SCErrorSet(kSCStatusFailed);
+		return NULL;
+	}
+	pthread_mutex_init(&keyIndex->lock, NULL);
+	keyIndex->patterns = CFDictionaryCreateMutable(NULL,
+						       0,
+						       &kCFTypeDictionaryKeyCallBacks,
+						       NULL);
+	return keyIndex;
+}
+
+
+void
+__SCDKeyIndexRelease(SCDKeyIndexRef keyIndex)
+{
+	CFIndex		i;
+
+	if (keyIndex == NULL) {
+		return;
+	}
+
+	for (i = 0; i < keyIndex->count; i++) {
+		CFAllocatorDeallocate(NULL, keyIndex->entries[i].str);
+		CFRelease(keyIndex->entries[i].key);
+	}
+	if (keyIndex->entries != NULL) {
+		free(keyIndex->entries);
+	}
+
+	CFDictionaryApplyFunction(keyIndex->patterns, patternCacheRelease, NULL);
+	CFRelease(keyIndex->patterns);
+
+	pthread_mutex_destroy(&keyIndex->lock);
+	free(keyIndex);
+	return;
+}
+
+
+CFIndex
+__SCDKeyIndexGetCount(SCDKeyIndexRef keyIndex)
+{
+	CFIndex		n;
+
+	pthread_mutex_lock(&keyIndex->lock);
+	n = keyIndex->count;
+	pthread_mutex_unlock(&keyIndex->lock);
+
+	return n;
+}
+
+
+Boolean
+__SCDKeyIndexAddKey(SCDKeyIndexRef keyIndex, CFStringRef key)
+{
+	CFIndex		i;
+	size_t		len;
+	char		*str;
+
+	str = _SC_cfstring_to_cstring(key, NULL, 0, kCFStringEncodingUTF8);
+	if (str == NULL) {
+		return FALSE;
+	}
+	len = strlen(str);
+
+	pthread_mutex_lock(&keyIndex->lock);
+
+	i = keyIndexLowerBound(keyIndex, str, len);
+	if (keyIndexEntryEqual(keyIndex, i, str, len)) {
+		// if already indexed
+		pthread_mutex_unlock(&keyIndex->lock);
+		CFAllocatorDeallocate(NULL, str);
+		return FALSE;
+	}
+
+	if (keyIndex->count == keyIndex->size) {
+		keyIndex->size = (keyIndex->size > 0) ? keyIndex->size * 2 : 64;
+		keyIndex->entries = reallocf(keyIndex->entries, keyIndex->size * sizeof(SCDKeyIndexEntry));
+	}
+	memmove(&keyIndex->entries[i + 1],
+		&keyIndex->entries[i],
+		(keyIndex->count - i) * sizeof(SCDKeyIndexEntry));
+	keyIndex->entries[i].str = str;
+	keyIndex->entries[i].len = len;
+	keyIndex->entries[i].key = CFRetain(key);
+	keyIndex->count++;
+
+	pthread_mutex_unlock(&keyIndex->lock);
+
+	return TRUE;
+}
+
+
+Boolean
+__SCDKeyIndexRemoveKey(SCDKeyIndexRef keyIndex, CFStringRef key)
+{
+	char		buf[256];
+	CFIndex		i;
+	Boolean		removed	= FALSE;
+	char		*str;
+
+	str = _SC_cfstring_to_cstring(key, buf, sizeof(buf), kCFStringEncodingUTF8);
+	if (str == NULL) {
+		str = _SC_cfstring_to_cstring(key, NULL, 0, kCFStringEncodingUTF8);
+		if (str == NULL) {
+			return FALSE;
+		}
+	}
+
+	pthread_mutex_lock(&keyIndex->lock);
+
+	i = keyIndexLowerBound(keyIndex, str, strlen(str));
+	if (keyIndexEntryEqual(keyIndex, i, str, strlen(str))) {
+		CFAllocatorDeallocate(NULL, keyIndex->entries[i].str);
+		CFRelease(keyIndex->entries[i].key);
+		memmove(&keyIndex->entries[i],
+			&keyIndex->entries[i + 1],
+			(keyIndex->count - i - 1) * sizeof(SCDKeyIndexEntry));
+		keyIndex->count--;
+		removed = TRUE;
+	}
+
+	pthread_mutex_unlock(&keyIndex->lock);
+
+	if (str != buf) {
+		CFAllocatorDeallocate(NULL, str);
+	}
+
+	return removed;
+}
+
+
+static SCDPatternRef
+keyIndexCopyPatternLocked(SCDKeyIndexRef keyIndex, CFStringRef patternString)
+{
+	SCDPatternRef	pattern;
+
+	pattern = (SCDPatternRef)CFDictionaryGetValue(keyIndex->patterns, patternString);
+	if (pattern != NULL) {
+		return pattern;
+	}
+
+	pattern = __SCDPatternCreate(patternString);
+	if (pattern == NULL) {
+		return NULL;
+	}
+
+	if (CFDictionaryGetCount(keyIndex->patterns) >= N_PATTERN_CACHE_MAX) {
+		// keep it simple, start over
+		CFDictionaryApplyFunction(keyIndex->patterns, patternCacheRelease, NULL);
+		CFDictionaryRemoveAllValues(keyIndex->patterns);
+	}
+	CFDictionarySetValue(keyIndex->patterns, patternString, pattern);
+
+	return pattern;
+}
+
+
+CFArrayRef
+__SCDKeyIndexCopyMatchingKeys(SCDKeyIndexRef keyIndex, CFStringRef patternString)
+{
+	CFIndex			first;
+	CFIndex			i;
+	CFIndex			last;
+	CFMutableArrayRef	keys;
+	SCDPatternRef		pattern;
+
+	pthread_mutex_lock(&keyIndex->lock);
+
+	pattern = keyIndexCopyPatternLocked(keyIndex, patternString);
+	if (pattern == NULL) {
+		pthread_mutex_unlock(&keyIndex->lock);
+		return NULL;
+	}
+
+	keys = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+
+	first = 0;
+	last  = keyIndex->count;
+	if (pattern->prefixLen > 0) {
+		// only visit the keys sharing the literal prefix
+		first = keyIndexLowerBound(keyIndex, pattern->prefix, pattern->prefixLen);
+		for (last = first; last < keyIndex->count; last++) {
+			if ((keyIndex->entries[last].len < pattern->prefixLen) ||
+			    (memcmp(keyIndex->entries[last].str, pattern->prefix, pattern->prefixLen) != 0)) {
+				break;
+			}
+		}
+		if (pattern->literal && pattern->anchoredEnd) {
+			// exact match
+			last = (keyIndexEntryEqual(keyIndex, first, pattern->prefix, pattern->prefixLen))
+				? first + 1 : first;
+		}
+	}
+
+	for (i = first; i < last; i++) {
+		SCDKeyIndexEntry	*entry	= &keyIndex->entries[i];
+
+		if (__SCDPatternMatch(pattern, entry->str, entry->len)) {
+			CFArrayAppendValue(keys, entry->key);
+		}
+	}
+
+	pthread_mutex_unlock(&keyIndex->lock);
+
+	_SCErrorSet(kSCStatusOK);
+	return keys;
+}
@@ -0,0 +1,464 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: batched key list / multi-key fetch merged with
+ *   the uncommitted changes of an active block of operations
+ * - added _SCDynamicStoreCopyChangedValues(), _SCDynamicStoreEstimateSize()
+ */
+
+#include "SCDynamicStoreInternal.h"
+
+
+/*
+ * While a block of operations is active (see _SCDynamicStoreCacheOpen())
+ * any set/remove requests are held in the session and are not visible to
+ * the server.  The routines below issue a single request to "configd"
+ * and then overlay the pending changes so that callers see the store as
+ * it will look once the block is committed.
+ */
+
+
+#define	N_QUICK	64
+
+
+typedef struct {
+	CFMutableSetRef	keys;
+	SCDPatternRef	*patterns;
+	CFIndex		nPatterns;
+} pendingMatchContext, *pendingMatchContextRef;
+
+
+static Boolean
+pendingMatchContextInit(pendingMatchContextRef context, CFArrayRef keys, CFArrayRef patterns)
+{
+	CFIndex		i;
+	CFIndex		n;
+
+	context->keys      = NULL;
+	context->patterns  = NULL;
+	context->nPatterns = 0;
+
+	n = (keys != NULL) ? CFArrayGetCount(keys) : 0;
+	if (n > 0) {
+		context->keys = CFSetCreateMutable(NULL, n, &kCFTypeSetCallBacks);
+		for (i = 0; i < n; i++) {
+			CFSetAddValue(context->keys, CFArrayGetValueAtIndex(keys, i));
+		}
+	}
+
+	n = (patterns != NULL) ? CFArrayGetCount(patterns) : 0;
+	if (n == 0) {
+		return TRUE;
+	}
+
+	context->patterns = CFAllocatorAllocate(NULL, n * sizeof(SCDPatternRef), 0);
+	for (i = 0; i < n; i++) {
+		SCDPatternRef	pattern;
+
+		pattern = __SCDPatternCreate(CFArrayGetValueAtIndex(patterns, i));
+		if (pattern == NULL) {
+			break;
+		}
+		context->patterns[context->nPatterns++] = pattern;
+	}
+
+	return (context->nPatterns == n);
+}
+
+
+static void
+pendingMatchContextFree(pendingMatchContextRef context)
+{
+	CFIndex		i;
+
+	for (i = 0; i < context->nPatterns; i++) {
+		__SCDPatternRelease(context->patterns[i]);
+	}
+	if (context->patterns != NULL) {
+		CFAllocatorDeallocate(NULL, context->patterns);
+	}
+	if (context->keys != NULL) {
+		CFRelease(context->keys);
+	}
+
+	return;
+}
+
+
+static Boolean
+pendingKeyMatches(pendingMatchContextRef context, CFStringRef key)
+{
+	CFIndex		i;
+
+	if ((context->keys != NULL) && CFSetContainsValue(context->keys, key)) {
+		return TRUE;
+	}
+
+	for (i = 0; i < context->nPatterns; i++) {
+		if (__SCDPatternMatchKey(context->patterns[i], key)) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+
+static Boolean
+pendingChanges(SCDynamicStorePrivateRef storePrivate)
+{
+	if (!storePrivate->cache_active) {
+		return FALSE;
+	}
+
+	return (((storePrivate->cached_set != NULL) &&
+		 (CFDictionaryGetCount(storePrivate->cached_set) > 0)) ||
+		((storePrivate->cached_removals != NULL) &&
+		 (CFArrayGetCount(storePrivate->cached_removals) > 0)));
+}
+
+
+#pragma mark -
+#pragma mark Merged key list / values
+
+
+CFArrayRef
+_SCDynamicStoreCopyKeyListMerged(SCDynamicStoreRef store, CFStringRef pattern)
+{
+	pendingMatchContext		context;
+	CFIndex				i;
+	CFArrayRef			list;
+	CFMutableSetRef			listed;
+	CFMutableArrayRef		merged;
+	CFIndex				n;
+	CFArrayRef			patterns;
+	SCDynamicStorePrivateRef	storePrivate	= (SCDynamicStorePrivateRef)store;
+
+	if (store == NULL) {
+		_SCErrorSet(kSCStatusNoStoreSession);
+		return NULL;
+	}
+
+	list = SCDynamicStoreCopyKeyList(store, pattern);
+	if (!isA_CFString(pattern) || !pendingChanges(storePrivate)) {
+		return list;
+	}
+
+	if (list == NULL) {
+		if (SCError() != kSCStatusOK) {
+			return NULL;
+		}
+		merged = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	} else {
+		merged = CFArrayCreateMutableCopy(NULL, 0, list);
+		CFRelease(list);
+	}
+
+	patterns = CFArrayCreate(NULL, (const void **)&pattern, 1, &kCFTypeArrayCallBacks);
+	if (!pendingMatchContextInit(&context, NULL, patterns)) {
+		pendingMatchContextFree(&context);
+		CFRelease(patterns);
+		CFRelease(merged);
+		_SCErrorSet(kSCStatusFailed);
+		return NULL;
+	}
+	CFRelease(patterns);
+
+	// the keys in the list (for quick membership tests)
+	n = CFArrayGetCount(merged);
+	listed = CFSetCreateMutable(NULL, n, &kCFTypeSetCallBacks);
+	for (i = 0; i < n; i++) {
+		CFSetAddValue(listed, CFArrayGetValueAtIndex(merged, i));
+	}
+
+	if (storePrivate->cached_set != NULL) {
+		const void *	keys_q[N_QUICK];
+		const void **	keys	= keys_q;
+
+		n = CFDictionaryGetCount(storePrivate->cached_set);
+		if (n > (CFIndex)(sizeof(keys_q) / sizeof(CFStringRef))) {
+			keys = CFAllocatorAllocate(NULL, n * sizeof(CFStringRef), 0);
+		}
+		CFDictionaryGetKeysAndValues(storePrivate->cached_set, keys, NULL);
+		for (i = 0; i < n; i++) {
+			CFStringRef	key	= (CFStringRef)keys[i];
+
+			if (!CFSetContainsValue(listed, key) &&
+			    pendingKeyMatches(&context, key)) {
+				CFArrayAppendValue(merged, key);
+				CFSetAddValue(listed, key);
+			}
+		}
+		if (keys != keys_q) {
+			CFAllocatorDeallocate(NULL, keys);
+		}
+	}
+
+	if (storePrivate->cached_removals != NULL) {
+		Boolean		removed	= FALSE;
+
+		n = CFArrayGetCount(storePrivate->cached_removals);
+		for (i = 0; i < n; i++) {
+			CFStringRef	key	= CFArrayGetValueAtIndex(storePrivate->cached_removals, i);
+
+			if (CFSetContainsValue(listed, key)) {
+				CFSetRemoveValue(listed, key);
+				removed = TRUE;
+			}
+		}
+
+		if (removed) {
+			CFMutableArrayRef	remaining;
+
+			// keep the listed keys (in order) that were not removed
+			n = CFArrayGetCount(merged);
+			remaining = CFArrayCreateMutable(NULL, CFSetGetCount(listed), &kCFTypeArrayCallBacks);
+			for (i = 0; i < n; i++) {
+				CFStringRef	key	= CFArrayGetValueAtIndex(merged, i);
+
+				if (CFSetContainsValue(listed, key)) {
+					CFArrayAppendValue(remaining, key);
+				}
+			}
+			CFRelease(merged);
+			merged = remaining;
+		}
+	}
+
+	CFRelease(listed);
+	pendingMatchContextFree(&context);
+
+	_SCErrorSet(kSCStatusOK);
+	return merged;
+}
+
+
+CFDictionaryRef
+_SCDynamicStoreCopyMultipleMerged(SCDynamicStoreRef store, CFArrayRef keys, CFArrayRef patterns)
+{
+	pendingMatchContext		context;
+	CFDictionaryRef			dict;
+	CFMutableDictionaryRef		merged;
+	SCDynamicStorePrivateRef	storePrivate	= (SCDynamicStorePrivateRef)store;
+
+	if (store == NULL) {
+		_SCErrorSet(kSCStatusNoStoreSession);
+		return NULL;
+	}
+
+	dict = SCDynamicStoreCopyMultiple(store, keys, patterns);
+	if (!pendingChanges(storePrivate)) {
+		return dict;
+	}
+
+	if (dict == NULL) {
+		if ((SCError() != kSCStatusOK) && (SCError() != kSCStatusNoKey)) {
+			return NULL;
+		}
+		merged = CFDictionaryCreateMutable(NULL,
+						   0,
+						   &kCFTypeDictionaryKeyCallBacks,
+						   &kCFTypeDictionaryValueCallBacks);
+	} else {
+		merged = CFDictionaryCreateMutableCopy(NULL, 0, dict);
+		CFRelease(dict);
+	}
+
+	if (!pendingMatchContextInit(&context, keys, patterns)) {
+		pendingMatchContextFree(&context);
+		CFRelease(merged);
+		_SCErrorSet(kSCStatusFailed);
+		return NULL;
+	}
+
+	if (storePrivate->cached_set != NULL) {
+		CFIndex		i;
+		CFIndex		n;
+		const void *	keys_q[N_QUICK];
+		const void **	setKeys		= keys_q;
+		const void *	values_q[N_QUICK];
+		const void **	setValues	= values_q;
+
+		n = CFDictionaryGetCount(storePrivate->cached_set);
+		if (n > (CFIndex)(sizeof(keys_q) / sizeof(CFStringRef))) {
+			setKeys   = CFAllocatorAllocate(NULL, n * sizeof(CFStringRef), 0);
+			setValues = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+		}
+		CFDictionaryGetKeysAndValues(storePrivate->cached_set, setKeys, setValues);
+		for (i = 0; i < n; i++) {
+			if (pendingKeyMatches(&context, (CFStringRef)setKeys[i])) {
+				CFDictionarySetValue(merged, setKeys[i], setValues[i]);
+			}
+		}
+		if (setKeys != keys_q) {
+			CFAllocatorDeallocate(NULL, setKeys);
+			CFAllocatorDeallocate(NULL, setValues);
+		}
+	}
+
+	if (storePrivate->cached_removals != NULL) {
+		CFIndex		i;
+		CFIndex		n;
+
+		n = CFArrayGetCount(storePrivate->cached_removals);
+		for (i = 0; i < n; i++) {
+			CFDictionaryRemoveValue(merged,
+						CFArrayGetValueAtIndex(storePrivate->cached_removals, i));
+		}
+	}
+
+	pendingMatchContextFree(&context);
+
+	_SCErrorSet(kSCStatusOK);
+	return merged;
+}
+
+
+
+#pragma mark -
+#pragma mark Changed values
+
+
+/*
+ * _SCDynamicStoreEstimateSize
+ *
+ * Returns a (cheap, approximate) estimate of the encoded size of a
+ * property list, for deciding whether the values are worth sending
+ * without serializing them.
+ */
+CFIndex
+_SCDynamicStoreEstimateSize(CFPropertyListRef value)
+{
+	CFTypeID	type;
+
+	if (value == NULL) {
+		return 0;
+	}
+
+	type = CFGetTypeID(value);
+	if (type == CFStringGetTypeID()) {
+		return CFStringGetLength(value) + 2;
+	} else if (type == CFDataGetTypeID()) {
+		return CFDataGetLength(value) + 2;
+	} else if (type == CFArrayGetTypeID()) {
+		CFIndex	i;
+		CFIndex	n;
+		CFIndex	size	= 2;
+
+		n = CFArrayGetCount(value);
+		for (i = 0; i < n; i++) {
+			size += _SCDynamicStoreEstimateSize(CFArrayGetValueAtIndex(value, i)) + 2;
+		}
+		return size;
+	} else if (type == CFDictionaryGetTypeID()) {
+		CFIndex		i;
+		const void *	keys_q[N_QUICK];
+		const void **	keys		= keys_q;
+		CFIndex		n;
+		CFIndex		size		= 2;
+		const void *	values_q[N_QUICK];
+		const void **	values		= values_q;
+
+		n = CFDictionaryGetCount(value);
+		if (n > (CFIndex)(sizeof(keys_q) / sizeof(CFTypeRef))) {
+			keys   = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+			values = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+		}
+		CFDictionaryGetKeysAndValues(value, keys, values);
+		for (i = 0; i < n; i++) {
+			size += _SCDynamicStoreEstimateSize(keys[i]) +
+				_SCDynamicStoreEstimateSize(values[i]) + 4;
+		}
+		if (keys != keys_q) {
+			CFAllocatorDeallocate(NULL, keys);
+			CFAllocatorDeallocate(NULL, values);
+		}
+		return size;
+	}
+
+	// numbers, booleans, dates
+	return 9;
+}
+
+
+/*
+ * _SCDynamicStoreCopyChangedValues
+ *
+ * Fetches the current values of the keys reported by a change
+ * notification (which only carries the keys) with a single request,
+ * rather than one request per key.
+ */
+CFDictionaryRef
+_SCDynamicStoreCopyChangedValues(SCDynamicStoreRef store, CFArrayRef changedKeys, CFIndex maxBytes)
+{
+	CFDictionaryRef		dict;
+	CFIndex			i;
+	CFIndex			n;
+	CFMutableDictionaryRef	values;
+
+	if (store == NULL) {
+		_SCErrorSet(kSCStatusNoStoreSession);
+		return NULL;
+	}
+
+	if (!isA_CFArray(changedKeys)) {
+		_SCErrorSet(kSCStatusInvalidArgument);
+		return NULL;
+	}
+
+	// a single request for all of the changed keys
+	dict = _SCDynamicStoreCopyMultipleMerged(store, changedKeys, NULL);
+	if ((dict == NULL) && (SCError() != kSCStatusOK) && (SCError() != kSCStatusNoKey)) {
+		return NULL;
+	}
+
+	if ((dict != NULL) && (maxBytes > 0) && (_SCDynamicStoreEstimateSize(dict) > maxBytes)) {
+		// too large, the caller should fall back to the keys
+		CFRelease(dict);
+		_SCErrorSet(kSCStatusOK);
+		return NULL;
+	}
+
+	values = CFDictionaryCreateMutable(NULL,
+					   0,
+					   &kCFTypeDictionaryKeyCallBacks,
+					   &kCFTypeDictionaryValueCallBacks);
+	n = CFArrayGetCount(changedKeys);
+	for (i = 0; i < n; i++) {
+		CFStringRef		key	= CFArrayGetValueAtIndex(changedKeys, i);
+		CFPropertyListRef	value	= NULL;
+
+		if (dict != NULL) {
+			value = CFDictionaryGetValue(dict, key);
+		}
+		CFDictionarySetValue(values, key, (value != NULL) ? value : kCFNull);
+	}
+	if (dict != NULL) CFRelease(dict);
+
+	_SCErrorSet(kSCStatusOK);
+	return values;
+}
@@ -0,0 +1,748 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: notification routing index
+ */
+
+#include "SCDynamicStoreInternal.h"
+
+
+/*
+ * Maps a changed SCDynamicStore key to the watchers (sessions) that have
+ * registered interest in it, without visiting every watcher.
+ *
+ * - watched keys live in a hash table, <key> --> watchers
+ * - each distinct watched pattern is compiled once and shared by all of
+ *   the watchers that registered it
+ * - the longest literal run of each pattern is added to an Aho-Corasick
+ *   automaton.  A single pass over the changed key yields the candidate
+ *   patterns, which are then confirmed with __SCDPatternMatch()
+ * - patterns without any literal run are always confirmed
+ *
+ * The automaton is rebuilt (lazily) when the set of patterns changes.
+ */
+
+
+typedef struct routerWatcher {
+	const void		*watcher;
+	CFArrayRef		keys;
+	CFArrayRef		patterns;
+	uint64_t		stamp;
+} routerWatcher;
+
+
+typedef struct routerPattern {
+	CFStringRef		string;
+	SCDPatternRef		pattern;
+	routerWatcher		**watchers;
+	CFIndex			nWatchers;
+	CFIndex			size;
+	uint64_t		stamp;
+} routerPattern;
+
+
+typedef struct {
+	int32_t			child;		// first child
+	int32_t			sibling;	// next sibling
+	int32_t			fail;
+	int32_t			dict;		// next node (on the fail chain) with outputs
+	int32_t			output;		// first output, -1 if none
+	UInt8			c;
+} routerNode;
+
+
+typedef struct {
+	routerPattern		*pattern;
+	int32_t			next;
+} routerOutput;
+
+
+struct __SCDNotifyRouter {
+	pthread_mutex_t		lock;
+
+	CFMutableDictionaryRef	watchers;	// <watcher> --> routerWatcher *
+	CFMutableDictionaryRef	keys;		// <key> --> CFArray(routerWatcher *)
+	CFMutableDictionaryRef	patterns;	// <pattern> --> routerPattern *
+
+	/* Aho-Corasick automaton (valid if !dirty) */
+	Boolean			dirty;
+	routerNode		*nodes;
+	int32_t			nNodes;
+	int32_t			nodesSize;
+	routerOutput		*outputs;
+	int32_t			nOutputs;
+	int32_t			outputsSize;
+	routerPattern		**always;	// patterns without a literal run
+	CFIndex			nAlways;
+
+	uint64_t		stamp;
+	SCDNotifyRouterStatistics	stats;
+};
+
+
+/* the watchers matching a key, collected with the router locked */
+#define	N_QUICK	32
+
+typedef struct {
+	const void		**watchers;
+	CFIndex			nWatchers;
+	CFIndex			size;
+	const void		*watchers_q[N_QUICK];
+} routerMatches;
+
+
+#pragma mark -
+#pragma mark Aho-Corasick automaton
+
+
+static int32_t
+nodeAdd(SCDNotifyRouterRef router, UInt8 c)
+{
+	routerNode	*node;
+
+	if (router->nNodes == router->nodesSize) {
+		router->nodesSize = (router->nodesSize > 0) ? router->nodesSize * 2 : 256;
+		router->nodes = reallocf(router->nodes, router->nodesSize * sizeof(routerNode));
+	}
+
+	node = &router->nodes[router->nNodes];
+	node->child   = -1;
+	node->sibling = -1;
+	node->fail    = 0;
+	node->dict    = -1;
+	node->output  = -1;
+	node->c       = c;
+
+	return router->nNodes++;
+}
+
+
+static int32_t
+nodeChild(SCDNotifyRouterRef router, int32_t node, UInt8 c)
+{
+	int32_t		child;
+
+	for (child = router->nodes[node].child; child != -1; child = router->nodes[child].sibling) {
+		if (router->nodes[child].c == c) {
+			return child;
+		}
+	}
+
+	return -1;
+}
+
+
+static void
+automatonAddPattern(SCDNotifyRouterRef router, routerPattern *pattern)
+{
+	size_t		i;
+	size_t		len;
+	const char	*literal;
+	int32_t		node	= 0;
+	routerOutput	*output;
+
+	literal = __SCDPatternGetRequiredLiteral(pattern->pattern, &len);
+	if (len == 0) {
+		router->always[router->nAlways++] = pattern;
+		return;
+	}
+
+	for (i = 0; i < len; i++) {
+		int32_t		child;
+
+		child = nodeChild(router, node, (UInt8)literal[i]);
+		if (child == -1) {
+			child = nodeAdd(router, (UInt8)literal[i]);
+			router->nodes[child].sibling = router->nodes[node].child;
+			router->nodes[node].child = child;
+		}
+		node = child;
+	}
+
+	if (router->nOutputs == router->outputsSize) {
+		router->outputsSize = (router->outputsSize > 0) ? router->outputsSize * 2 : 256;
+		router->outputs = reallocf(router->outputs, router->outputsSize * sizeof(routerOutput));
+	}
+	output = &router->outputs[router->nOutputs];
+	output->pattern = pattern;
+	output->next = router->nodes[node].output;
+	router->nodes[node].output = router->nOutputs++;
+
+	return;
+}
+
+
+static void
+automatonBuild(SCDNotifyRouterRef router)
+{
+	CFIndex		i;
+	CFIndex		n;
+	int32_t		*queue;
+	int32_t		queueHead	= 0;
+	int32_t		queueTail	= 0;
+	const void *	values_q[64];
+	const void **	values		= values_q;
+
+	router->nNodes = 0;
+	router->nOutputs = 0;
+	router->nAlways = 0;
+	(void) nodeAdd(router, 0);		// root
+
+	n = CFDictionaryGetCount(router->patterns);
+	if (router->always != NULL) {
+		free(router->always);
+	}
+	router->always = (n > 0) ? malloc(n * sizeof(routerPattern *)) : NULL;
+
+	if (n > (CFIndex)(sizeof(values_q) / sizeof(CFTypeRef))) {
+		values = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+	}
+	CFDictionaryGetKeysAndValues(router->patterns, NULL, values);
+	for (i = 0; i < n; i++) {
+		automatonAddPattern(router, (routerPattern *)values[i]);
+	}
+	if (values != values_q) {
+		CFAllocatorDeallocate(NULL, values);
+	}
+
+	// compute the failure and dictionary links (breadth first)
+	queue = malloc(router->nNodes * sizeof(int32_t));
+	queue[queueTail++] = 0;
+	while (queueHead < queueTail) {
+		int32_t		child;
+		int32_t		node	= queue[queueHead++];
+
+		for (child = router->nodes[node].child; child != -1; child = router->nodes[child].sibling) {
+			int32_t		fail;
+			UInt8		c	= router->nodes[child].c;
+
+			queue[queueTail++] = child;
+
+			fail = 0;
+			if (node != 0) {
+				int32_t		f	= router->nodes[node].fail;
+
+				while (TRUE) {
+					int32_t		next;
+
+					next = nodeChild(router, f, c);
+					if (next != -1) {
+						fail = next;
+						break;
+					}
+					if (f == 0) {
+						break;
+					}
+					f = router->nodes[f].fail;
+				}
+			}
+			router->nodes[child].fail = fail;
+			router->nodes[child].dict = (router->nodes[fail].output != -1)
+							? fail
+							: router->nodes[fail].dict;
+		}
+	}
+	free(queue);
+
+	router->dirty = FALSE;
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Watchers
+
+
+static void
+patternAddWatcher(routerPattern *pattern, routerWatcher *watcher)
+{
+	if (pattern->nWatchers == pattern->size) {
+		pattern->size = (pattern->size > 0) ? pattern->size * 2 : 4;
+		pattern->watchers = reallocf(pattern->watchers, pattern->size * sizeof(routerWatcher *));
+	}
+	pattern->watchers[pattern->nWatchers++] = watcher;
+	return;
+}
+
+
+static Boolean
+patternRemoveWatcher(routerPattern *pattern, routerWatcher *watcher)
+{
+	CFIndex		i;
+
+	for (i = 0; i < pattern->nWatchers; i++) {
+		if (pattern->watchers[i] == watcher) {
+			pattern->watchers[i] = pattern->watchers[--pattern->nWatchers];
+			break;
+		}
+	}
+
+	return (pattern->nWatchers == 0);
+}
+
+
+static void
+patternRelease(routerPattern *pattern)
+{
+	__SCDPatternRelease(pattern->pattern);
+	CFRelease(pattern->string);
+	if (pattern->watchers != NULL) {
+		free(pattern->watchers);
+	}
+	free(pattern);
+	return;
+}
+
+
+static void
+routerRemoveWatcherLocked(SCDNotifyRouterRef router, routerWatcher *watcher)
+{
+	CFIndex		i;
+	CFIndex		n;
+
+	n = (watcher->keys != NULL) ? CFArrayGetCount(watcher->keys) : 0;
+	for (i = 0; i < n; i++) {
+		CFIndex			j;
+		CFStringRef		key	= CFArrayGetValueAtIndex(watcher->keys, i);
+		CFMutableArrayRef	list;
+
+		list = (CFMutableArrayRef)CFDictionaryGetValue(router->keys, key);
+		if (list == NULL) {
+			continue;
+		}
+		j = CFArrayGetFirstIndexOfValue(list, CFRangeMake(0, CFArrayGetCount(list)), watcher);
+		if (j != kCFNotFound) {
+			CFArrayRemoveValueAtIndex(list, j);
+		}
+		if (CFArrayGetCount(list) == 0) {
+			CFDictionaryRemoveValue(router->keys, key);
+		}
+	}
+
+	n = (watcher->patterns != NULL) ? CFArrayGetCount(watcher->patterns) : 0;
+	for (i = 0; i < n; i++) {
+		routerPattern	*pattern;
+		CFStringRef	string	= CFArrayGetValueAtIndex(watcher->patterns, i);
+
+		pattern = (routerPattern *)CFDictionaryGetValue(router->patterns, string);
+		if ((pattern != NULL) && patternRemoveWatcher(pattern, watcher)) {
+			CFDictionaryRemoveValue(router->patterns, string);
+			patternRelease(pattern);
+			router->dirty = TRUE;
+		}
+	}
+
+	CFDictionaryRemoveValue(router->watchers, watcher->watcher);
+	if (watcher->keys != NULL) CFRelease(watcher->keys);
+	if (watcher->patterns != NULL) CFRelease(watcher->patterns);
+	free(watcher);
+
+	return;
+}
+
+
+static CFArrayRef
+copyUniqueStrings(CFArrayRef list)
+{
+	CFIndex			i;
+	CFIndex			n;
+	CFMutableArrayRef	unique;
+
+	n = (list != NULL) ? CFArrayGetCount(list) : 0;
+	if (n == 0) {
+		return NULL;
+	}
+
+	unique = CFArrayCreateMutable(NULL, n, &kCFTypeArrayCallBacks);
+	for (i = 0; i < n; i++) {
+		CFStringRef	str	= CFArrayGetValueAtIndex(list, i);
+
+		if (isA_CFString(str) &&
+		    !CFArrayContainsValue(unique, CFRangeMake(0, CFArrayGetCount(unique)), str)) {
+			CFArrayAppendValue(unique, str);
+		}
+	}
+
+	return unique;
+}
+
+
+#pragma mark -
+#pragma mark Notification router SPIs
+
+
+SCDNotifyRouterRef
+__SCDNotifyRouterCreate(void)
+{
+	SCDNotifyRouterRef	router;
+
+	router = calloc(1, sizeof(*router));
+	pthread_mutex_init(&router->lock, NULL);
+	router->watchers = CFDictionaryCreateMutable(NULL, 0, NULL, NULL);
+	router->keys = CFDictionaryCreateMutable(NULL,
+						 0,
+						 &kCFTypeDictionaryKeyCallBacks,
+						 &kCFTypeDictionaryValueCallBacks);
+	router->patterns = CFDictionaryCreateMutable(NULL,
+						     0,
+						     &kCFTypeDictionaryKeyCallBacks,
+						     NULL);
+	router->dirty = TRUE;
+
+	return router;
+}
+
+
+void
+__SCDNotifyRouterRelease(SCDNotifyRouterRef router)
+{
+	CFIndex		i;
+	CFIndex		n;
+	const void	**values;
+
+	if (router == NULL) {
+		return;
+	}
+
+	n = CFDictionaryGetCount(router->watchers);
+	if (n > 0) {
+		values = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+		CFDictionaryGetKeysAndValues(router->watchers, NULL, values);
+		for (i = 0; i < n; i++) {
+			routerRemoveWatcherLocked(router, (routerWatcher *)values[i]);
+		}
+		CFAllocatorDeallocate(NULL, values);
+	}
+
+	CFRelease(router->watchers);
+	CFRelease(router->keys);
+	CFRelease(router->patterns);
+	if (router->nodes != NULL) free(router->nodes);
+	if (router->outputs != NULL) free(router->outputs);
+	if (router->always != NULL) free(router->always);
+	pthread_mutex_destroy(&router->lock);
+	free(router);
+
+	return;
+}
+
+
+Boolean
+__SCDNotifyRouterSetWatcher(SCDNotifyRouterRef	router,
+			    const void		*watcher,
+			    CFArrayRef		keys,
+			    CFArrayRef		patterns)
+{
+	CFIndex		i;
+	CFIndex		n;
+	routerWatcher	*newWatcher;
+	routerWatcher	*oldWatcher;
+	CFArrayRef	uniqueKeys;
+	CFArrayRef	uniquePatterns;
+
+	uniqueKeys = copyUniqueStrings(keys);
+	uniquePatterns = copyUniqueStrings(patterns);
+
+	pthread_mutex_lock(&router->lock);
+
+	// compile any new patterns first so that a bad pattern changes nothing
+	n = (uniquePatterns != NULL) ? CFArrayGetCount(uniquePatterns) : 0;
+	for (i = 0; i < n; i++) {
+		routerPattern	*pattern;
+		CFStringRef	string	= CFArrayGetValueAtIndex(uniquePatterns, i);
+
+		if (CFDictionaryContainsKey(router->patterns, string)) {
+			continue;
+		}
+
+		pattern = calloc(1, sizeof(*pattern));
+		pattern->pattern = __SCDPatternCreate(string);
+		if (pattern->pattern == NULL) {
+			CFIndex		j;
+
+			free(pattern);
+
+			// discard any patterns compiled for this request
+			for (j = 0; j < i; j++) {
+				string = CFArrayGetValueAtIndex(uniquePatterns, j);
+				pattern = (routerPattern *)CFDictionaryGetValue(router->patterns, string);
+				if ((pattern != NULL) && (pattern->nWatchers == 0)) {
+					CFDictionaryRemoveValue(router->patterns, string);
+					patternRelease(pattern);
+				}
+			}
+			pthread_mutex_unlock(&router->lock);
+			if (uniqueKeys != NULL) CFRelease(uniqueKeys);
+			CFRelease(uniquePatterns);
+			_SCErrorSet(kSCStatusFailed);
+			return FALSE;
+		}
+		pattern->string = CFRetain(string);
+		CFDictionarySetValue(router->patterns, string, pattern);
+		router->dirty = TRUE;
+	}
+
+	oldWatcher = (routerWatcher *)CFDictionaryGetValue(router->watchers, watcher);
+
+	newWatcher = calloc(1, sizeof(*newWatcher));
+	newWatcher->watcher = watcher;
+	newWatcher->keys = uniqueKeys;
+	newWatcher->patterns = uniquePatterns;
+
+	n = (uniqueKeys != NULL) ? CFArrayGetCount(uniqueKeys) : 0;
+	for (i = 0; i < n; i++) {
+		CFStringRef		key	= CFArrayGetValueAtIndex(uniqueKeys, i);
+		CFMutableArrayRef	list;
+
+		list = (CFMutableArrayRef)CFDictionaryGetValue(router->keys, key);
+		if (list == NULL) {
+			list = CFArrayCreateMutable(NULL, 0, NULL);
+			CFDictionarySetValue(router->keys, key, list);
+			CFRelease(list);
+		}
+		CFArrayAppendValue(list, newWatcher);
+	}
+
+	n = (uniquePatterns != NULL) ? CFArrayGetCount(uniquePatterns) : 0;
+	for (i = 0; i < n; i++) {
+		routerPattern	*pattern;
+
+		pattern = (routerPattern *)CFDictionaryGetValue(router->patterns,
+								 CFArrayGetValueAtIndex(uniquePatterns, i));
+		patternAddWatcher(pattern, newWatcher);
+	}
+
+	// now that the new patterns are referenced, drop the old registration
+	if (oldWatcher != NULL) {
+		routerRemoveWatcherLocked(router, oldWatcher);
+	}
+
+	if ((uniqueKeys != NULL) || (uniquePatterns != NULL)) {
+		CFDictionarySetValue(router->watchers, watcher, newWatcher);
+	} else {
+		// nothing to watch
+		free(newWatcher);
+	}
+
+	pthread_mutex_unlock(&router->lock);
+
+	return TRUE;
+}
+
+
+void
+__SCDNotifyRouterRemoveWatcher(SCDNotifyRouterRef router, const void *watcher)
+{
+	routerWatcher	*oldWatcher;
+
+	pthread_mutex_lock(&router->lock);
+	oldWatcher = (routerWatcher *)CFDictionaryGetValue(router->watchers, watcher);
+	if (oldWatcher != NULL) {
+		routerRemoveWatcherLocked(router, oldWatcher);
+	}
+	pthread_mutex_unlock(&router->lock);
+
+	return;
+}
+
+
+static void
+matchesAdd(routerMatches *matches, const void *watcher)
+{
+	if (matches->nWatchers >= matches->size) {
+		const void	**watchers;
+
+		matches->size *= 2;
+		watchers = CFAllocatorAllocate(NULL, matches->size * sizeof(const void *), 0);
+		memcpy(watchers, matches->watchers, matches->nWatchers * sizeof(const void *));
+		if (matches->watchers != matches->watchers_q) {
+			CFAllocatorDeallocate(NULL, matches->watchers);
+		}
+		matches->watchers = watchers;
+	}
+
+	matches->watchers[matches->nWatchers++] = watcher;
+	return;
+}
+
+
+static void
+routeToPattern(SCDNotifyRouterRef	router,
+	       routerPattern		*pattern,
+	       const char		*str,
+	       size_t			len,
+	       routerMatches		*matches)
+{
+	CFIndex		i;
+
+	if (pattern->stamp == router->stamp) {
+		// if already checked
+		return;
+	}
+	pattern->stamp = router->stamp;
+
+	router->stats.candidates++;
+	if (!__SCDPatternMatch(pattern->pattern, str, len)) {
+		return;
+	}
+	router->stats.confirmed++;
+
+	for (i = 0; i < pattern->nWatchers; i++) {
+		routerWatcher	*watcher	= pattern->watchers[i];
+
+		if (watcher->stamp != router->stamp) {
+			watcher->stamp = router->stamp;
+			matchesAdd(matches, watcher->watcher);
+		}
+	}
+
+	return;
+}
+
+
+void
+__SCDNotifyRouterApply(SCDNotifyRouterRef		router,
+		       CFStringRef			key,
+		       SCDNotifyRouterApplierFunction	applier,
+		       void				*context)
+{
+	char		buf[256];
+	CFIndex		i;
+	size_t		len;
+	CFArrayRef	list;
+	routerMatches	matches;
+	int32_t		state	= 0;
+	char		*str;
+
+	str = _SC_cfstring_to_cstring(key, buf, sizeof(buf), kCFStringEncodingUTF8);
+	if (str == NULL) {
+		str = _SC_cfstring_to_cstring(key, NULL, 0, kCFStringEncodingUTF8);
+		if (str == NULL) {
+			return;
+		}
+	}
+	len = strlen(str);
+
+	matches.watchers  = matches.watchers_q;
+	matches.nWatchers = 0;
+	matches.size      = N_QUICK;
+
+	pthread_mutex_lock(&router->lock);
+
+	router->stamp++;
+	router->stats.routes++;
+
+	// watched keys
+	list = CFDictionaryGetValue(router->keys, key);
+	if (list != NULL) {
+		CFIndex		n;
+
+		n = CFArrayGetCount(list);
+		for (i = 0; i < n; i++) {
+			routerWatcher	*watcher	= (routerWatcher *)CFArrayGetValueAtIndex(list, i);
+
+			if (watcher->stamp != router->stamp) {
+				watcher->stamp = router->stamp;
+				matchesAdd(&matches, watcher->watcher);
+			}
+		}
+	}
+
+	// watched patterns
+	if (CFDictionaryGetCount(router->patterns) > 0) {
+		size_t		j;
+
+		if (router->dirty) {
+			automatonBuild(router);
+		}
+
+		for (j = 0; j < len; j++) {
+			int32_t		match;
+			UInt8		c	= (UInt8)str[j];
+
+			while (TRUE) {
+				int32_t		next;
+
+				next = nodeChild(router, state, c);
+				if (next != -1) {
+					state = next;
+					break;
+				}
+				if (state == 0) {
+					break;
+				}
+				state = router->nodes[state].fail;
+			}
+
+			match = (router->nodes[state].output != -1) ? state : router->nodes[state].dict;
+			while (match != -1) {
+				int32_t		output;
+
+				for (output = router->nodes[match].output;
+				     output != -1;
+				     output = router->outputs[output].next) {
+					routeToPattern(router, router->outputs[output].pattern, str, len, &matches);
+				}
+				match = router->nodes[match].dict;
+			}
+		}
+
+		for (i = 0; i < router->nAlways; i++) {
+			routeToPattern(router, router->always[i], str, len, &matches);
+		}
+	}
+
+	pthread_mutex_unlock(&router->lock);
+
+	// report the matching watchers (without holding the lock)
+	for (i = 0; i < matches.nWatchers; i++) {
+		applier(matches.watchers[i], context);
+	}
+	if (matches.watchers != matches.watchers_q) {
+		CFAllocatorDeallocate(NULL, matches.watchers);
+	}
+
+	if (str != buf) {
+		CFAllocatorDeallocate(NULL, str);
+	}
+
+	return;
+}
+
+
+Boolean
+__SCDNotifyRouterGetStatistics(SCDNotifyRouterRef router, SCDNotifyRouterStatistics *stats)
+{
+	pthread_mutex_lock(&router->lock);
+	*stats = router->stats;
+	stats->watchers = CFDictionaryGetCount(router->watchers);
+	stats->keys = CFDictionaryGetCount(router->keys);
+	stats->patterns = CFDictionaryGetCount(router->patterns);
+	pthread_mutex_unlock(&router->lock);
+
+	return TRUE;
+}
@@ -1,6 +1,24 @@
 #include <SystemConfiguration/SystemConfiguration.h>
 #include <SystemConfiguration/SCValidation.h>
 #include <SystemConfiguration/SCPrivate.h>
+#include "SCDynamicStoreInternal.h"
+
+#pragma mark -
+#pragma mark SCDynamicStore logging
+
+
+__private_extern__ os_log_t
+__log_SCDynamicStore(void)
+{
+	static os_log_t	log	= NULL;
+
+	if (log == NULL) {
+		log = os_log_create("com.apple.SystemConfiguration", "SCDynamicStore");
+	}
+
+	return log;
+}
+
 
 #pragma mark -
 #pragma mark DOS encoding/codepage
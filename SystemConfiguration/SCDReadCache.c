@@ -0,0 +1,533 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: opt-in, notification-invalidated read cache
+ *   for SCDynamicStoreCopyValue()
+ */
+
+#include "SCDynamicStoreInternal.h"
+#include "SCObjectState.h"
+
+
+/*
+ * The SCDynamicStore session objects are created by the framework so we
+ * cannot hang any additional state off of them.  Instead, each session
+ * with an active read cache has an entry in a process-wide side table
+ * (see SCObjectState.h).  The entry is released when the cache is
+ * disabled or when the session is deallocated.  Each user of a cache
+ * holds a reference so that a concurrent disable cannot free it.
+ *
+ * Each cache owns a private "watcher" session that is registered for
+ * notifications on every key that has been read through the cache.  When
+ * the watcher reports a change (or the server restarts) the affected
+ * cache entries are discarded and the next read goes back to "configd".
+ *
+ * A key is only cached once the watcher has been registered for it.  The
+ * first read of a key queues it for registration; the registrations are
+ * done (and coalesced) on the watcher's queue, outside of the cache lock.
+ */
+
+
+#define	N_READ_CACHE_KEYS_MAX	1024
+
+
+typedef struct {
+	pthread_mutex_t				lock;
+	uint32_t				refs;
+
+	/* the private session used to track changes to cached keys */
+	SCDynamicStoreRef			watcher;
+	dispatch_queue_t			queue;
+
+	/* cached values (kCFNull if the key is known to not exist) */
+	CFMutableDictionaryRef			values;
+
+	/* keys registered for notification with the watcher */
+	CFMutableSetRef				watched;
+
+	/* keys waiting to be registered */
+	CFMutableSetRef				pending;
+	Boolean					registering;
+
+	/* bumped on every invalidation */
+	uint64_t				generation;
+
+	SCDynamicStoreReadCacheStatistics	stats;
+} SCDReadCache, *SCDReadCacheRef;
+
+
+static pthread_once_t		readCachesInitialized	= PTHREAD_ONCE_INIT;
+static SCObjectStateTableRef	readCaches		= NULL;	// <store> --> SCDReadCacheRef
+
+
+#pragma mark -
+#pragma mark Read cache (internal)
+
+
+static const void *
+readCacheRetain(const void *info)
+{
+	SCDReadCacheRef	cache	= (SCDReadCacheRef)info;
+
+	pthread_mutex_lock(&cache->lock);
+	cache->refs++;
+	pthread_mutex_unlock(&cache->lock);
+
+	return cache;
+}
+
+
+static void
+readCacheDeallocate(SCDReadCacheRef cache)
+{
+	dispatch_queue_t	queue	= cache->queue;
+
+	// stop any new notification callbacks
+	(void) SCDynamicStoreSetDispatchQueue(cache->watcher, NULL);
+
+	/*
+	 * ... and tear down once any queued callbacks have drained.  We may
+	 * be running on the watcher's queue so we can't wait here.
+	 */
+	dispatch_async(queue, ^{
+		CFRelease(cache->watcher);
+		CFRelease(cache->values);
+		CFRelease(cache->watched);
+		CFRelease(cache->pending);
+		pthread_mutex_destroy(&cache->lock);
+		free(cache);
+	});
+	dispatch_release(queue);
+
+	return;
+}
+
+
+static void
+readCacheRelease(const void *info)
+{
+	SCDReadCacheRef	cache	= (SCDReadCacheRef)info;
+	uint32_t	refs;
+
+	pthread_mutex_lock(&cache->lock);
+	refs = --cache->refs;
+	pthread_mutex_unlock(&cache->lock);
+
+	if (refs == 0) {
+		readCacheDeallocate(cache);
+	}
+
+	return;
+}
+
+
+static void
+readCachesInitialize(void)
+{
+	readCaches = __SCObjectStateTableCreate(readCacheRetain, readCacheRelease);
+	return;
+}
+
+
+/*
+ * readCacheCopy()
+ * - returns the [retained] read cache for the session, NULL if the
+ *   cache is not enabled
+ */
+static SCDReadCacheRef
+readCacheCopy(SCDynamicStoreRef store)
+{
+	pthread_once(&readCachesInitialized, readCachesInitialize);
+	if (readCaches == NULL) {
+		return NULL;
+	}
+
+	return (SCDReadCacheRef)__SCObjectStateCopy(readCaches, store, NULL);
+}
+
+
+static void
+readCacheFlushLocked(SCDReadCacheRef cache)
+{
+	if (CFDictionaryGetCount(cache->values) > 0) {
+		CFDictionaryRemoveAllValues(cache->values);
+		cache->stats.flushes++;
+	}
+	cache->generation++;
+	return;
+}
+
+
+static void
+readCacheChanged(SCDynamicStoreRef watcher, CFArrayRef changedKeys, void *info)
+{
+#pragma unused(watcher)
+	SCDReadCacheRef	cache	= (SCDReadCacheRef)info;
+	CFIndex		i;
+	CFIndex		n;
+
+	n = CFArrayGetCount(changedKeys);
+	pthread_mutex_lock(&cache->lock);
+	for (i = 0; i < n; i++) {
+		CFStringRef	key	= CFArrayGetValueAtIndex(changedKeys, i);
+
+		if (CFDictionaryContainsKey(cache->values, key)) {
+			CFDictionaryRemoveValue(cache->values, key);
+			cache->stats.invalidations++;
+		}
+	}
+	cache->generation++;
+	pthread_mutex_unlock(&cache->lock);
+
+	return;
+}
+
+
+static void
+readCacheReconnected(SCDynamicStoreRef watcher, void *info)
+{
+	SCDReadCacheRef	cache	= (SCDReadCacheRef)info;
+
+	// anything could have changed while we were not connected
+	pthread_mutex_lock(&cache->lock);
+	readCacheFlushLocked(cache);
+	pthread_mutex_unlock(&cache->lock);
+
+	SC_log(LOG_INFO, "SCDynamicStore read cache flushed, watcher %p reconnected", watcher);
+	return;
+}
+
+
+static void
+readCacheAppendKey(const void *value, void *context)
+{
+	CFArrayAppendValue((CFMutableArrayRef)context, value);
+	return;
+}
+
+
+static void
+readCacheRegister(SCDReadCacheRef cache)
+{
+	CFMutableArrayRef	keys;
+	CFSetRef		registering;
+
+	// (called on the watcher's queue)
+	pthread_mutex_lock(&cache->lock);
+	keys = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	CFSetApplyFunction(cache->watched, readCacheAppendKey, keys);
+	CFSetApplyFunction(cache->pending, readCacheAppendKey, keys);
+	registering = CFSetCreateCopy(NULL, cache->pending);
+	cache->registering = FALSE;
+	pthread_mutex_unlock(&cache->lock);
+
+	if (SCDynamicStoreSetNotificationKeys(cache->watcher, keys, NULL)) {
+		CFIndex		i;
+		CFIndex		n;
+
+		// the keys can now be cached
+		pthread_mutex_lock(&cache->lock);
+		n = CFArrayGetCount(keys);
+		for (i = 0; i < n; i++) {
+			CFStringRef	key	= CFArrayGetValueAtIndex(keys, i);
+
+			if (CFSetContainsValue(registering, key)) {
+				CFSetRemoveValue(cache->pending, key);
+				CFSetAddValue(cache->watched, key);
+			}
+		}
+		pthread_mutex_unlock(&cache->lock);
+	} else {
+		SC_log(LOG_NOTICE, "SCDynamicStoreSetNotificationKeys() failed: %s", SCErrorString(SCError()));
+
+		// allow the keys to be queued again
+		pthread_mutex_lock(&cache->lock);
+		CFSetRemoveAllValues(cache->pending);
+		pthread_mutex_unlock(&cache->lock);
+	}
+
+	CFRelease(registering);
+	CFRelease(keys);
+	return;
+}
+
+
+static const void *
+readCacheCreate(CFTypeRef object)
+{
+	SCDReadCacheRef			cache;
+	SCDynamicStoreRef		store		= (SCDynamicStoreRef)object;
+	SCDynamicStoreContext		context		= { 0, NULL, NULL, NULL, NULL };
+	CFStringRef			name;
+	SCDynamicStorePrivateRef	storePrivate	= (SCDynamicStorePrivateRef)store;
+
+	cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		_SCErrorSet(kSCStatusFailed);
+		return NULL;
+	}
+	pthread_mutex_init(&cache->lock, NULL);
+	cache->refs = 1;		// the side table's reference
+	cache->values = CFDictionaryCreateMutable(NULL,
+						  0,
+						  &kCFTypeDictionaryKeyCallBacks,
+						  &kCFTypeDictionaryValueCallBacks);
+	cache->watched = CFSetCreateMutable(NULL, 0, &kCFTypeSetCallBacks);
+	cache->pending = CFSetCreateMutable(NULL, 0, &kCFTypeSetCallBacks);
+
+	context.info = cache;
+	name = CFStringCreateWithFormat(NULL, NULL, CFSTR("%@ (read cache)"),
+					(storePrivate->name != NULL) ? storePrivate->name : CFSTR("SCDynamicStore"));
+	cache->watcher = SCDynamicStoreCreate(NULL, name, readCacheChanged, &context);
+	CFRelease(name);
+	if (cache->watcher == NULL) {
+		SC_log(LOG_NOTICE, "SCDynamicStoreCreate() failed: %s", SCErrorString(SCError()));
+		goto fail;
+	}
+
+	(void) SCDynamicStoreSetDisconnectCallBack(cache->watcher, readCacheReconnected);
+
+	cache->queue = dispatch_queue_create("com.apple.SystemConfiguration.SCDynamicStoreReadCache", NULL);
+	if (!SCDynamicStoreSetDispatchQueue(cache->watcher, cache->queue)) {
+		SC_log(LOG_NOTICE, "SCDynamicStoreSetDispatchQueue() failed: %s", SCErrorString(SCError()));
+		goto fail;
+	}
+
+	return cache;
+
+    fail :
+
+	if (cache->watcher != NULL) CFRelease(cache->watcher);
+	if (cache->queue != NULL) dispatch_release(cache->queue);
+	CFRelease(cache->values);
+	CFRelease(cache->watched);
+	CFRelease(cache->pending);
+	pthread_mutex_destroy(&cache->lock);
+	free(cache);
+	return NULL;
+}
+
+
+#pragma mark -
+#pragma mark Read cache SPIs
+
+
+Boolean
+_SCDynamicStoreReadCacheEnable(SCDynamicStoreRef store, Boolean enable)
+{
+	SCDReadCacheRef	cache;
+
+	if (store == NULL) {
+		_SCErrorSet(kSCStatusNoStoreSession);
+		return FALSE;
+	}
+
+	pthread_once(&readCachesInitialized, readCachesInitialize);
+	if (readCaches == NULL) {
+		_SCErrorSet(kSCStatusFailed);
+		return FALSE;
+	}
+
+	if (!enable) {
+		__SCObjectStateRemove(readCaches, store);
+		return TRUE;
+	}
+
+	cache = (SCDReadCacheRef)__SCObjectStateCopy(readCaches, store, readCacheCreate);
+	if (cache == NULL) {
+		return FALSE;
+	}
+	readCacheRelease(cache);
+
+	return TRUE;
+}
+
+
+Boolean
+_SCDynamicStoreReadCacheIsEnabled(SCDynamicStoreRef store)
+{
+	SCDReadCacheRef	cache;
+
+	if (store == NULL) {
+		return FALSE;
+	}
+
+	cache = readCacheCopy(store);
+	if (cache == NULL) {
+		return FALSE;
+	}
+	readCacheRelease(cache);
+
+	return TRUE;
+}
+
+
+CFPropertyListRef
+_SCDynamicStoreReadCacheCopyValue(SCDynamicStoreRef store, CFStringRef key)
+{
+	SCDReadCacheRef		cache;
+	Boolean			cacheable	= FALSE;
+	uint64_t		generation;
+	Boolean			registerKeys	= FALSE;
+	int			sc_status;
+	CFPropertyListRef	value;
+
+	if ((store == NULL) ||
+	    !isA_CFString(key) ||
+	    _SCDynamicStoreCacheIsActive(store)) {
+		// if no session, bad key, or block of operations in progress
+		return SCDynamicStoreCopyValue(store, key);
+	}
+
+	cache = readCacheCopy(store);
+	if (cache == NULL) {
+		return SCDynamicStoreCopyValue(store, key);
+	}
+
+	pthread_mutex_lock(&cache->lock);
+
+	value = CFDictionaryGetValue(cache->values, key);
+	if (value != NULL) {
+		cache->stats.hits++;
+		if (isA_CFType(value, CFNullGetTypeID())) {
+			pthread_mutex_unlock(&cache->lock);
+			readCacheRelease(cache);
+			_SCErrorSet(kSCStatusNoKey);
+			return NULL;
+		}
+
+		CFRetain(value);
+		pthread_mutex_unlock(&cache->lock);
+		readCacheRelease(cache);
+		_SCErrorSet(kSCStatusOK);
+		return value;
+	}
+
+	cache->stats.misses++;
+
+	/*
+	 * only cache the value if the watcher was registered for the key
+	 * *before* fetching it (so that any change racing with the fetch is
+	 * reported); otherwise, queue the key for registration
+	 */
+	if (CFSetContainsValue(cache->watched, key)) {
+		cacheable = TRUE;
+	} else if (!CFSetContainsValue(cache->pending, key) &&
+		   ((CFSetGetCount(cache->watched) + CFSetGetCount(cache->pending)) < N_READ_CACHE_KEYS_MAX)) {
+		CFSetAddValue(cache->pending, key);
+		if (!cache->registering) {
+			cache->registering = TRUE;
+			registerKeys = TRUE;
+		}
+	}
+	generation = cache->generation;
+
+	pthread_mutex_unlock(&cache->lock);
+
+	if (registerKeys) {
+		(void) readCacheRetain(cache);
+		dispatch_async(cache->queue, ^{
+			readCacheRegister(cache);
+			readCacheRelease(cache);
+		});
+	}
+
+	value = SCDynamicStoreCopyValue(store, key);
+	sc_status = SCError();
+
+	if (cacheable && ((value != NULL) || (sc_status == kSCStatusNoKey))) {
+		pthread_mutex_lock(&cache->lock);
+		if (generation == cache->generation) {
+			// if no changes were reported while we were fetching
+			CFDictionarySetValue(cache->values,
+					     key,
+					     (value != NULL) ? value : (CFPropertyListRef)kCFNull);
+		}
+		pthread_mutex_unlock(&cache->lock);
+	}
+	readCacheRelease(cache);
+
+	_SCErrorSet(sc_status);
+	return value;
+}
+
+
+void
+_SCDynamicStoreReadCacheInvalidate(SCDynamicStoreRef store, CFStringRef key)
+{
+	SCDReadCacheRef	cache;
+
+	if (store == NULL) {
+		return;
+	}
+
+	cache = readCacheCopy(store);
+	if (cache == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+	if (key == NULL) {
+		readCacheFlushLocked(cache);
+	} else {
+		if (CFDictionaryContainsKey(cache->values, key)) {
+			CFDictionaryRemoveValue(cache->values, key);
+			cache->stats.invalidations++;
+		}
+		cache->generation++;
+	}
+	pthread_mutex_unlock(&cache->lock);
+	readCacheRelease(cache);
+
+	return;
+}
+
+
+Boolean
+_SCDynamicStoreReadCacheGetStatistics(SCDynamicStoreRef store, SCDynamicStoreReadCacheStatistics *stats)
+{
+	SCDReadCacheRef	cache;
+
+	if ((store == NULL) || (stats == NULL)) {
+		_SCErrorSet(kSCStatusInvalidArgument);
+		return FALSE;
+	}
+
+	cache = readCacheCopy(store);
+	if (cache == NULL) {
+		_SCErrorSet(kSCStatusFailed);
+		return FALSE;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+	*stats = cache->stats;
+	stats->keys = CFDictionaryGetCount(cache->values);
+	pthread_mutex_unlock(&cache->lock);
+	readCacheRelease(cache);
+
+	return TRUE;
+}
@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: streaming binary (full and delta) store snapshots
+ */
+
+#include <errno.h>
+#include <unistd.h>
+#include <libkern/OSByteOrder.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "SCDynamicStoreInternal.h"
+
+
+/*
+ * Snapshot file format (all integers are big-endian)
+ *
+ *   header	"SCDS", version (4), flags (4), base generation (8), generation (8)
+ *   record	type (1), key length (4), key (UTF-8)
+ *		[value length (4), value (binary property list)]	if type == set
+ *   ...
+ *   end	type (1) == 0
+ *
+ * Records are written as they are produced so a snapshot never needs
+ * the whole store serialized in memory.  A delta snapshot carries only
+ * the keys set or removed after "base generation".
+ */
+
+
+#define	SNAPSHOT_MAGIC		"SCDS"
+#define	SNAPSHOT_VERSION	1
+#define	SNAPSHOT_HEADER_SIZE	(4 + 4 + 4 + 8 + 8)
+#define	SNAPSHOT_BUFFER_SIZE	(64 * 1024)
+
+enum {
+	kSnapshotRecordEnd	= 0,
+	kSnapshotRecordSet	= 1,
+	kSnapshotRecordRemove	= 2,
+};
+
+
+struct __SCDSnapshotWriter {
+	int		fd;
+	Boolean		failed;
+	size_t		used;
+	UInt8		buf[SNAPSHOT_BUFFER_SIZE];
+};
+
+
+#pragma mark -
+#pragma mark Writer
+
+
+static void
+writerFlush(SCDSnapshotWriterRef writer)
+{
+	const UInt8	*p	= writer->buf;
+	size_t		len	= writer->used;
+
+	while (!writer->failed && (len > 0)) {
+		ssize_t		n;
+
+		n = write(writer->fd, p, len);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			SC_log(LOG_NOTICE, "snapshot write() failed: %s", strerror(errno));
+			writer->failed = TRUE;
+			break;
+		}
+		p += n;
+		len -= n;
+	}
+
+	writer->used = 0;
+	return;
+}
+
+
+static void
+writerAppend(SCDSnapshotWriterRef writer, const void *bytes, size_t len)
+{
+	const UInt8	*p	= bytes;
+
+	while (!writer->failed && (len > 0)) {
+		size_t		n;
+
+		if (writer->used == sizeof(writer->buf)) {
+			writerFlush(writer);
+			continue;
+		}
+
+		n = sizeof(writer->buf) - writer->used;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(writer->buf + writer->used, p, n);
+		writer->used += n;
+		p += n;
+		len -= n;
+	}
+
+	return;
+}
+
+
+static void
+writerAppendUInt32(SCDSnapshotWriterRef writer, uint32_t val)
+{
+	val = OSSwapHostToBigInt32(val);
+	writerAppend(writer, &val, sizeof(val));
+	return;
+}
+
+
+static void
+writerAppendInt64(SCDSnapshotWriterRef writer, int64_t val)
+{
+	uint64_t	val_n	= OSSwapHostToBigInt64((uint64_t)val);
+
+	writerAppend(writer, &val_n, sizeof(val_n));
+	return;
+}
+
+
+static Boolean
+writerAppendKey(SCDSnapshotWriterRef writer, UInt8 type, CFStringRef key)
+{
+	char		buf[256];
+	char		*str;
+
+	str = _SC_cfstring_to_cstring(key, buf, sizeof(buf), kCFStringEncodingUTF8);
+	if (str == NULL) {
+		str = _SC_cfstring_to_cstring(key, NULL, 0, kCFStringEncodingUTF8);
+		if (str == NULL) {
+			return FALSE;
+		}
+	}
+
+	writerAppend(writer, &type, sizeof(type));
+	writerAppendUInt32(writer, (uint32_t)strlen(str));
+	writerAppend(writer, str, strlen(str));
+
+	if (str != buf) {
+		CFAllocatorDeallocate(NULL, str);
+	}
+
+	return TRUE;
+}
+
+
+SCDSnapshotWriterRef
+__SCDSnapshotWriterCreate(int fd, const SCDSnapshotHeader *header)
+{
+	SCDSnapshotWriterRef	writer;
+
+	writer = malloc(sizeof(*writer));
+	if (writer == NULL) {
+		_SCErrorSet(kSCStatusFailed);
+		return NULL;
+	}
+	writer->fd = fd;
+	writer->failed = FALSE;
+	writer->used = 0;
+
+	writerAppend(writer, SNAPSHOT_MAGIC, 4);
+	writerAppendUInt32(writer, SNAPSHOT_VERSION);
+	writerAppendUInt32(writer, header->flags);
+	writerAppendInt64(writer, header->baseGeneration);
+	writerAppendInt64(writer, header->generation);
+
+	return writer;
+}
+
+
+Boolean
+__SCDSnapshotWriterAddValue(SCDSnapshotWriterRef writer, CFStringRef key, CFPropertyListRef value)
+{
+	CFDataRef	data;
+
+	data = CFPropertyListCreateData(NULL, value, kCFPropertyListBinaryFormat_v1_0, 0, NULL);
+	if (data == NULL) {
+		SC_log(LOG_NOTICE, "CFPropertyListCreateData() failed for %@", key);
+		return FALSE;
+	}
+
+	if (writerAppendKey(writer, kSnapshotRecordSet, key)) {
+		writerAppendUInt32(writer, (uint32_t)CFDataGetLength(data));
+		writerAppend(writer, CFDataGetBytePtr(data), CFDataGetLength(data));
+	}
+	CFRelease(data);
+
+	return !writer->failed;
+}
+
+
+Boolean
+__SCDSnapshotWriterAddRemoval(SCDSnapshotWriterRef writer, CFStringRef key)
+{
+	(void) writerAppendKey(writer, kSnapshotRecordRemove, key);
+	return !writer->failed;
+}
+
+
+Boolean
+__SCDSnapshotWriterClose(SCDSnapshotWriterRef writer)
+{
+	Boolean	ok;
+	UInt8	type	= kSnapshotRecordEnd;
+
+	writerAppend(writer, &type, sizeof(type));
+	writerFlush(writer);
+	ok = !writer->failed;
+	free(writer);
+
+	if (!ok) {
+		_SCErrorSet(kSCStatusFailed);
+	}
+	return ok;
+}
+
+
+#pragma mark -
+#pragma mark Reader
+
+
+static Boolean
+readUInt32(const UInt8 **p, const UInt8 *end, uint32_t *val)
+{
+	uint32_t	val_n;
+
+	if ((size_t)(end - *p) < sizeof(val_n)) {
+		return FALSE;
+	}
+	memcpy(&val_n, *p, sizeof(val_n));
+	*val = OSSwapBigToHostInt32(val_n);
+	*p += sizeof(val_n);
+	return TRUE;
+}
+
+
+static Boolean
+readInt64(const UInt8 **p, const UInt8 *end, int64_t *val)
+{
+	uint64_t	val_n;
+
+	if ((size_t)(end - *p) < sizeof(val_n)) {
+		return FALSE;
+	}
+	memcpy(&val_n, *p, sizeof(val_n));
+	*val = (int64_t)OSSwapBigToHostInt64(val_n);
+	*p += sizeof(val_n);
+	return TRUE;
+}
+
+
+static Boolean
+snapshotParse(const UInt8			*bytes,
+	      size_t				len,
+	      SCDSnapshotHeader			*header,
+	      SCDSnapshotApplierFunction	applier,
+	      void				*context)
+{
+	const UInt8	*end	= bytes + len;
+	const UInt8	*p	= bytes;
+	uint32_t	version;
+
+	if ((len < SNAPSHOT_HEADER_SIZE) || (memcmp(p, SNAPSHOT_MAGIC, 4) != 0)) {
+		return FALSE;
+	}
+	p += 4;
+	if (!readUInt32(&p, end, &version) || (version != SNAPSHOT_VERSION) ||
+	    !readUInt32(&p, end, &header->flags) ||
+	    !readInt64(&p, end, &header->baseGeneration) ||
+	    !readInt64(&p, end, &header->generation)) {
+		return FALSE;
+	}
+	header->version = version;
+
+	while (p < end) {
+		CFStringRef		key;
+		uint32_t		keyLen;
+		UInt8			type	= *p++;
+		CFPropertyListRef	value	= NULL;
+
+		if (type == kSnapshotRecordEnd) {
+			return TRUE;
+		}
+		if ((type != kSnapshotRecordSet) && (type != kSnapshotRecordRemove)) {
+			return FALSE;
+		}
+
+		if (!readUInt32(&p, end, &keyLen) || ((size_t)(end - p) < keyLen)) {
+			return FALSE;
+		}
+		key = CFStringCreateWithBytes(NULL, p, keyLen, kCFStringEncodingUTF8, FALSE);
+		p += keyLen;
+		if (key == NULL) {
+			return FALSE;
+		}
+
+		if (type == kSnapshotRecordSet) {
+			CFDataRef	data;
+			uint32_t	valueLen;
+
+			if (!readUInt32(&p, end, &valueLen) || ((size_t)(end - p) < valueLen)) {
+				CFRelease(key);
+				return FALSE;
+			}
+			data = CFDataCreateWithBytesNoCopy(NULL, p, valueLen, kCFAllocatorNull);
+			value = CFPropertyListCreateWithData(NULL, data, kCFPropertyListImmutable, NULL, NULL);
+			CFRelease(data);
+			p += valueLen;
+			if (value == NULL) {
+				CFRelease(key);
+				return FALSE;
+			}
+		}
+
+		applier(key, value, context);
+		CFRelease(key);
+		if (value != NULL) CFRelease(value);
+	}
+
+	// if truncated (no end record)
+	return FALSE;
+}
+
+
+Boolean
+__SCDSnapshotRead(int				fd,
+		  SCDSnapshotHeader		*header,
+		  SCDSnapshotApplierFunction	applier,
+		  void				*context)
+{
+	void		*bytes;
+	Boolean		ok;
+	struct stat	sb;
+
+	if ((fstat(fd, &sb) == -1) || (sb.st_size < SNAPSHOT_HEADER_SIZE)) {
+		_SCErrorSet(kSCStatusInvalidArgument);
+		return FALSE;
+	}
+
+	bytes = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (bytes == MAP_FAILED) {
+		SC_log(LOG_NOTICE, "snapshot mmap() failed: %s", strerror(errno));
+		_SCErrorSet(kSCStatusFailed);
+		return FALSE;
+	}
+	(void) madvise(bytes, (size_t)sb.st_size, MADV_SEQUENTIAL);
+
+	ok = snapshotParse(bytes, (size_t)sb.st_size, header, applier, context);
+	(void) munmap(bytes, (size_t)sb.st_size);
+
+	_SCErrorSet(ok ? kSCStatusOK : kSCStatusFailed);
+	return ok;
+}
@@ -113,6 +113,55 @@ typedef struct {
 } SCDynamicStorePrivate, *SCDynamicStorePrivateRef;
 
 
+/* read cache statistics, see _SCDynamicStoreReadCacheGetStatistics() */
+typedef struct {
+	uint64_t			hits;
+	uint64_t			misses;
+	uint64_t			invalidations;
+	uint64_t			flushes;
+	CFIndex				keys;
+} SCDynamicStoreReadCacheStatistics;
+
+
+/* compiled SCDynamicStore key pattern, see __SCDPatternCreate() */
+typedef struct __SCDPattern	*SCDPatternRef;
+
+/* sorted index of SCDynamicStore keys, see __SCDKeyIndexCreate() */
+typedef struct __SCDKeyIndex	*SCDKeyIndexRef;
+
+/* notification routing index, see __SCDNotifyRouterCreate() */
+typedef struct __SCDNotifyRouter	*SCDNotifyRouterRef;
+
+typedef void (*SCDNotifyRouterApplierFunction)	(const void	*watcher,
+						 void		*context);
+
+/* notification router statistics, see __SCDNotifyRouterGetStatistics() */
+typedef struct {
+	uint64_t			routes;		// keys routed
+	uint64_t			candidates;	// patterns confirmed with the regex
+	uint64_t			confirmed;	// ... that matched
+	CFIndex				watchers;
+	CFIndex				keys;
+	CFIndex				patterns;
+} SCDNotifyRouterStatistics;
+
+/* SCDynamicStore snapshot streams, see __SCDSnapshotWriterCreate() */
+typedef struct __SCDSnapshotWriter	*SCDSnapshotWriterRef;
+
+typedef struct {
+	uint32_t			version;
+	uint32_t			flags;
+	int64_t				baseGeneration;	// (delta) changes after this generation
+	int64_t				generation;
+} SCDSnapshotHeader;
+
+#define	kSCDSnapshotFlagDelta		0x00000001
+
+typedef void (*SCDSnapshotApplierFunction)	(CFStringRef		key,
+						 CFPropertyListRef	value,		// NULL if removed
+						 void			*context);
+
+
 __BEGIN_DECLS
 
 __private_extern__
@@ -140,6 +189,195 @@ __private_extern__
 Boolean
 __SCDynamicStoreReconnectNotifications	(SCDynamicStoreRef		store);
 
+/*
+ * SCDynamicStore key patterns
+ *
+ * The literal prefix, suffix, and longest required run are extracted from
+ * each pattern so that most keys can be accepted or rejected without
+ * running the regex.
+ */
+SCDPatternRef
+__SCDPatternCreate			(CFStringRef			pattern);
+
+void
+__SCDPatternRelease			(SCDPatternRef			pattern);
+
+Boolean
+__SCDPatternMatch			(SCDPatternRef			pattern,
+					 const char			*key,
+					 size_t				keyLen);
+
+Boolean
+__SCDPatternMatchKey			(SCDPatternRef			pattern,
+					 CFStringRef			key);
+
+const char *
+__SCDPatternGetRequiredLiteral		(SCDPatternRef			pattern,
+					 size_t				*len);
+
+/*
+ * SCDynamicStore key index
+ *
+ * Keys are kept sorted so that anchored patterns only visit the range of
+ * keys sharing their literal prefix.  Compiled patterns are cached.
+ */
+SCDKeyIndexRef
+__SCDKeyIndexCreate			(void);
+
+void
+__SCDKeyIndexRelease			(SCDKeyIndexRef			keyIndex);
+
+CFIndex
+__SCDKeyIndexGetCount			(SCDKeyIndexRef			keyIndex);
+
+Boolean
+__SCDKeyIndexAddKey			(SCDKeyIndexRef			keyIndex,
+					 CFStringRef			key);
+
+Boolean
+__SCDKeyIndexRemoveKey			(SCDKeyIndexRef			keyIndex,
+					 CFStringRef			key);
+
+CFArrayRef
+__SCDKeyIndexCopyMatchingKeys		(SCDKeyIndexRef			keyIndex,
+					 CFStringRef			pattern);
+
+/*
+ * SCDynamicStore notification routing
+ *
+ * Maps a changed key to the watchers (sessions) whose notification keys
+ * or patterns match it.  Watched keys are hashed; the longest literal run
+ * of each pattern feeds an Aho-Corasick automaton so that only candidate
+ * patterns are confirmed with the regex.  The applier is called at most
+ * once per watcher, after the router has been unlocked (so it may call
+ * back into the router).  A watcher removed while the key is being
+ * routed may still be reported.
+ */
+SCDNotifyRouterRef
+__SCDNotifyRouterCreate			(void);
+
+void
+__SCDNotifyRouterRelease		(SCDNotifyRouterRef		router);
+
+Boolean
+__SCDNotifyRouterSetWatcher		(SCDNotifyRouterRef		router,
+					 const void			*watcher,
+					 CFArrayRef			keys,
+					 CFArrayRef			patterns);
+
+void
+__SCDNotifyRouterRemoveWatcher		(SCDNotifyRouterRef		router,
+					 const void			*watcher);
+
+void
+__SCDNotifyRouterApply			(SCDNotifyRouterRef		router,
+					 CFStringRef			key,
+					 SCDNotifyRouterApplierFunction	applier,
+					 void				*context);
+
+Boolean
+__SCDNotifyRouterGetStatistics		(SCDNotifyRouterRef		router,
+					 SCDNotifyRouterStatistics	*stats);
+
+/*
+ * SCDynamicStore snapshots
+ *
+ * A snapshot is a stream of key/value (and, for a delta, key removal)
+ * records, each value encoded as a binary property list.  Records are
+ * buffered and written as they are added; __SCDSnapshotRead() maps the
+ * file and calls the applier for each record.  __SCDSnapshotWriterCreate()
+ * returns NULL if the writer could not be allocated.
+ */
+SCDSnapshotWriterRef
+__SCDSnapshotWriterCreate		(int				fd,
+					 const SCDSnapshotHeader	*header);
+
+Boolean
+__SCDSnapshotWriterAddValue		(SCDSnapshotWriterRef		writer,
+					 CFStringRef			key,
+					 CFPropertyListRef		value);
+
+Boolean
+__SCDSnapshotWriterAddRemoval		(SCDSnapshotWriterRef		writer,
+					 CFStringRef			key);
+
+Boolean
+__SCDSnapshotWriterClose		(SCDSnapshotWriterRef		writer);
+
+Boolean
+__SCDSnapshotRead			(int				fd,
+					 SCDSnapshotHeader		*header,
+					 SCDSnapshotApplierFunction	applier,
+					 void				*context);
+
+/*
+ * Key list / multi-key fetch merged with any uncommitted changes held
+ * by an active block of operations (see _SCDynamicStoreCacheOpen()).
+ * Each call results in a single request to the server.
+ */
+CFArrayRef
+_SCDynamicStoreCopyKeyListMerged	(SCDynamicStoreRef		store,
+					 CFStringRef			pattern);
+
+CFDictionaryRef
+_SCDynamicStoreCopyMultipleMerged	(SCDynamicStoreRef		store,
+					 CFArrayRef			keys,
+					 CFArrayRef			patterns);
+
+/*
+ * Fetches the current values for the keys reported by a change
+ * notification, <key> --> <value> (or kCFNull if the key was removed),
+ * with a single request.  This is a second round trip; the notification
+ * itself carries only the keys.  If "maxBytes" is > 0 and the (estimated)
+ * size of the values is larger, NULL is returned (with SCError() ==
+ * kSCStatusOK) and the caller should treat the notification as key-only.
+ */
+CFDictionaryRef
+_SCDynamicStoreCopyChangedValues	(SCDynamicStoreRef		store,
+					 CFArrayRef			changedKeys,
+					 CFIndex			maxBytes);
+
+/*
+ * Returns a cheap estimate of the encoded size of a property list.
+ */
+CFIndex
+_SCDynamicStoreEstimateSize		(CFPropertyListRef		value);
+
+/*
+ * SCDynamicStore read cache
+ *
+ * When enabled, values returned by _SCDynamicStoreReadCacheCopyValue()
+ * are retained and served locally until "configd" reports that the key
+ * has changed.  The cache is bypassed while a block of operations is in
+ * progress (see _SCDynamicStoreCacheOpen()).
+ *
+ * Notes:
+ * - changes made through the same session are not seen until reported
+ *   by the server; callers should _SCDynamicStoreReadCacheInvalidate()
+ *   the key after a local set/remove/notify.
+ * - the cache is released when it is disabled or when the session is
+ *   deallocated; readers on other threads keep it alive until they are
+ *   done.
+ */
+Boolean
+_SCDynamicStoreReadCacheEnable		(SCDynamicStoreRef		store,
+					 Boolean			enable);
+
+Boolean
+_SCDynamicStoreReadCacheIsEnabled	(SCDynamicStoreRef		store);
+
+CFPropertyListRef
+_SCDynamicStoreReadCacheCopyValue	(SCDynamicStoreRef		store,
+					 CFStringRef			key);
+
+void
+_SCDynamicStoreReadCacheInvalidate	(SCDynamicStoreRef		store,
+					 CFStringRef			key);		// NULL == all keys
+
+Boolean
+_SCDynamicStoreReadCacheGetStatistics	(SCDynamicStoreRef			store,
+					 SCDynamicStoreReadCacheStatistics	*stats);
+
 __END_DECLS
 
 #endif	/* _SCDYNAMICSTOREINTERNAL_H */
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: process-wide interning of store keys and
+ *   preferences paths
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+
+#include "SCPreferencesInternal.h"
+
+
+/*
+ * The same store keys and preferences paths are built over and over
+ * (often from the same service IDs and entity names).  Instead of
+ * formatting a new CFString each time, the components are concatenated
+ * into a stack buffer, hashed, and looked up in a process-wide table of
+ * immutable strings.  A hit returns the existing string (retained) so
+ * there is no allocation and later CFEqual() calls on the key take the
+ * pointer equality fast path.
+ *
+ * Lookups do not take a lock.  The table is open addressed; entries are
+ * never removed or modified once published, and a table that has been
+ * outgrown is retired (but not freed) so that a concurrent reader can
+ * finish its probe.  Inserts, and growing the table, are serialized.
+ *
+ * Interned strings live for the life of the process so the table is
+ * capped; once full, or for components too long for the stack buffer,
+ * a new (uninterned) string is returned.
+ */
+
+
+#define	INTERN_KEY_MAX		512			// bytes (UTF-8)
+#define	INTERN_TABLE_SIZE_MIN	256
+#define	INTERN_ENTRIES_MAX	(64 * 1024)
+
+
+typedef struct {
+	uint64_t	hash;
+	CFIndex		len;
+	CFStringRef	str;
+	char		bytes[];
+} internEntry;
+
+
+typedef struct internTable {
+	CFIndex			size;			// power of 2
+	CFIndex			count;
+	struct internTable	*retired;		// outgrown (but still readable) tables
+	internEntry		*slots[];
+} internTable;
+
+
+static internTable	*internKeys	= NULL;
+static pthread_mutex_t	internKeys_lock	= PTHREAD_MUTEX_INITIALIZER;
+
+
+static uint64_t
+internHash(const char *bytes, CFIndex len)
+{
+	uint64_t	hash	= 0xcbf29ce484222325ULL;	// FNV-1a
+	CFIndex		i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= (uint8_t)bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+
+static internEntry *
+internTableLookup(internTable *table, uint64_t hash, const char *bytes, CFIndex len, CFIndex *slot)
+{
+	CFIndex		i;
+	CFIndex		mask	= table->size - 1;
+
+	for (i = (CFIndex)hash & mask; ; i = (i + 1) & mask) {
+		internEntry	*entry;
+
+		entry = __atomic_load_n(&table->slots[i], __ATOMIC_ACQUIRE);
+		if (entry == NULL) {
+			// not found
+			if (slot != NULL) {
+				*slot = i;
+			}
+			return NULL;
+		}
+
+		if ((entry->hash == hash) &&
+		    (entry->len == len) &&
+		    (memcmp(entry->bytes, bytes, len) == 0)) {
+			return entry;
+		}
+	}
+}
+
+
+static internTable *
+internTableCreate(CFIndex size)
+{
+	internTable	*table;
+
+	table = calloc(1, sizeof(internTable) + size * sizeof(internEntry *));
+	table->size = size;
+	return table;
+}
+
+
+static internTable *
+internTableGrow(internTable *table)
+{
+	CFIndex		i;
+	internTable	*newTable;
+
+	newTable = internTableCreate(table->size * 2);
+	for (i = 0; i < table->size; i++) {
+		internEntry	*entry	= table->slots[i];
+		CFIndex		slot;
+
+		if (entry != NULL) {
+			(void) internTableLookup(newTable, entry->hash, entry->bytes, entry->len, &slot);
+			newTable->slots[slot] = entry;
+			newTable->count++;
+		}
+	}
+	newTable->retired = table;
+
+	return newTable;
+}
+
+
+static Boolean
+internAppend(char *buf, CFIndex *len, CFStringRef str)
+{
+	CFIndex		avail	= INTERN_KEY_MAX - *len;
+	const char	*cstr;
+	CFRange		range;
+	CFIndex		used	= 0;
+
+	cstr = CFStringGetCStringPtr(str, kCFStringEncodingUTF8);
+	if (cstr != NULL) {
+		size_t	n	= strlen(cstr);
+
+		if ((CFIndex)n > avail) {
+			return FALSE;
+		}
+		memcpy(buf + *len, cstr, n);
+		*len += n;
+		return TRUE;
+	}
+
+	range = CFRangeMake(0, CFStringGetLength(str));
+	if (CFStringGetBytes(str,
+			     range,
+			     kCFStringEncodingUTF8,
+			     0,
+			     FALSE,
+			     (UInt8 *)buf + *len,
+			     avail,
+			     &used) != range.length) {
+		// if too long
+		return FALSE;
+	}
+	*len += used;
+
+	return TRUE;
+}
+
+
+static CFStringRef
+internCopyString(const char *bytes, CFIndex len)
+{
+	uint64_t	hash;
+	internEntry	*entry;
+	CFIndex		slot;
+	CFStringRef	str;
+	internTable	*table;
+
+	hash = internHash(bytes, len);
+
+	table = __atomic_load_n(&internKeys, __ATOMIC_ACQUIRE);
+	if (table != NULL) {
+		entry = internTableLookup(table, hash, bytes, len, NULL);
+		if (entry != NULL) {
+			return CFRetain(entry->str);
+		}
+	}
+
+	pthread_mutex_lock(&internKeys_lock);
+
+	table = internKeys;
+	if (table == NULL) {
+		table = internTableCreate(INTERN_TABLE_SIZE_MIN);
+		__atomic_store_n(&internKeys, table, __ATOMIC_RELEASE);
+	}
+
+	// check again, another thread may have added the key
+	entry = internTableLookup(table, hash, bytes, len, &slot);
+	if (entry != NULL) {
+		str = CFRetain(entry->str);
+		goto done;
+	}
+
+	str = CFStringCreateWithBytes(NULL, (const UInt8 *)bytes, len, kCFStringEncodingUTF8, FALSE);
+	if ((str == NULL) || (table->count >= INTERN_ENTRIES_MAX)) {
+		// if not valid or if the table is full
+		goto done;
+	}
+
+	if ((table->count + 1) * 2 > table->size) {
+		// keep the load factor at or below 1/2
+		table = internTableGrow(table);
+		(void) internTableLookup(table, hash, bytes, len, &slot);
+		__atomic_store_n(&internKeys, table, __ATOMIC_RELEASE);
+	}
+
+	entry = malloc(sizeof(internEntry) + len);
+	entry->hash = hash;
+	entry->len = len;
+	entry->str = CFRetain(str);	// the table's reference
+	memcpy(entry->bytes, bytes, len);
+	table->count++;
+	__atomic_store_n(&table->slots[slot], entry, __ATOMIC_RELEASE);
+
+    done :
+
+	pthread_mutex_unlock(&internKeys_lock);
+	return str;
+}
+
+
+#pragma mark -
+#pragma mark Interned keys
+
+
+__private_extern__ CFStringRef
+__SCStringCreateInterned(const CFStringRef *pieces, CFIndex nPieces)
+{
+	char		buf[INTERN_KEY_MAX];
+	CFIndex		i;
+	CFIndex		len	= 0;
+
+	for (i = 0; i < nPieces; i++) {
+		if (!internAppend(buf, &len, pieces[i])) {
+			CFStringRef		key;
+			CFMutableStringRef	str;
+
+			// if too long to intern
+			str = CFStringCreateMutable(NULL, 0);
+			for (i = 0; i < nPieces; i++) {
+				CFStringAppend(str, pieces[i]);
+			}
+			key = CFStringCreateCopy(NULL, str);
+			CFRelease(str);
+			return key;
+		}
+	}
+
+	return internCopyString(buf, len);
+}
+
+
+__private_extern__ CFStringRef
+__SCKeyCreateInterned(CFStringRef prefix, ...)
+{
+	va_list		ap;
+	CFStringRef	component;
+	CFIndex		n		= 0;
+	CFStringRef	pieces[32];
+
+	pieces[n++] = prefix;
+	va_start(ap, prefix);
+	while ((component = va_arg(ap, CFStringRef)) != NULL) {
+		if (n + 2 > (CFIndex)(sizeof(pieces) / sizeof(pieces[0]))) {
+			CFIndex			i;
+			CFStringRef		key;
+			CFMutableStringRef	str;
+
+			// if too many components to intern
+			str = CFStringCreateMutable(NULL, 0);
+			for (i = 0; i < n; i++) {
+				CFStringAppend(str, pieces[i]);
+			}
+			do {
+				CFStringAppend(str, CFSTR("/"));
+				CFStringAppend(str, component);
+			} while ((component = va_arg(ap, CFStringRef)) != NULL);
+			va_end(ap);
+			key = CFStringCreateCopy(NULL, str);
+			CFRelease(str);
+			return key;
+		}
+		pieces[n++] = CFSTR("/");
+		pieces[n++] = component;
+	}
+	va_end(ap);
+
+	return __SCStringCreateInterned(pieces, n);
+}
@@ -24,6 +24,11 @@
 /*
  * Modification History
  *
+ * October 18, 2026
+ * - cache (and index) the NetworkConfiguration.plist templates
+ * - compare configurations by identity before content
+ * - only copy a configuration when its Inactive state must change
+ *
  * May 27, 2004		Allan Nathanson <ajn@apple.com>
  * - initial revision
  */
@@ -32,7 +37,10 @@
 #include "SCNetworkConfigurationInternal.h"
 #include "SCPreferencesInternal.h"
 
+#include <pthread.h>
 #include <sys/ioctl.h>
+#include <sys/param.h>
+#include <sys/stat.h>
 #include <net/if.h>
 
 
@@ -280,7 +288,7 @@ __SCNetworkConfigurationGetValue(SCPreferencesRef prefs, CFStringRef path)
 {
 	CFDictionaryRef config;
 
-	config = SCPreferencesPathGetValue(prefs, path);
+	config = __SCPreferencesPathGetValue_lazy(prefs, path);
 	if (isEffectivelyEmptyConfiguration(config)) {
 		// ignore [effectively] empty configuration entities
 		config = NULL;
@@ -290,6 +298,74 @@ __SCNetworkConfigurationGetValue(SCPreferencesRef prefs, CFStringRef path)
 }
 
 
+#define	N_QUICK	32
+
+
+/*
+ * __configValueEqual
+ * - compares two configuration values.  The values in a configuration
+ *   are shared (not copied) with the preferences it was read from, so the
+ *   entries that were not changed are the same objects; those match by
+ *   identity and only the entries that differ are compared in depth.
+ */
+static Boolean
+__configValueEqual(CFTypeRef val1, CFTypeRef val2)
+{
+	if (val1 == val2) {
+		return TRUE;
+	}
+	if ((val1 == NULL) || (val2 == NULL)) {
+		return FALSE;
+	}
+
+	if (isA_CFDictionary(val1) && isA_CFDictionary(val2)) {
+		Boolean		equal		= TRUE;
+		CFIndex		i;
+		const void *	keys_q[N_QUICK];
+		const void **	keys		= keys_q;
+		CFIndex		n;
+		const void *	values_q[N_QUICK];
+		const void **	values		= values_q;
+
+		n = CFDictionaryGetCount(val1);
+		if (n != CFDictionaryGetCount(val2)) {
+			return FALSE;
+		}
+		if (n > (CFIndex)(sizeof(keys_q) / sizeof(CFTypeRef))) {
+			keys   = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+			values = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+		}
+		CFDictionaryGetKeysAndValues(val1, keys, values);
+		for (i = 0; equal && (i < n); i++) {
+			equal = __configValueEqual(values[i], CFDictionaryGetValue(val2, keys[i]));
+		}
+		if (keys != keys_q) {
+			CFAllocatorDeallocate(NULL, keys);
+			CFAllocatorDeallocate(NULL, values);
+		}
+		return equal;
+	}
+
+	if (isA_CFArray(val1) && isA_CFArray(val2)) {
+		CFIndex		i;
+		CFIndex		n;
+
+		n = CFArrayGetCount(val1);
+		if (n != CFArrayGetCount(val2)) {
+			return FALSE;
+		}
+		for (i = 0; i < n; i++) {
+			if (!__configValueEqual(CFArrayGetValueAtIndex(val1, i), CFArrayGetValueAtIndex(val2, i))) {
+				return FALSE;
+			}
+		}
+		return TRUE;
+	}
+
+	return CFEqual(val1, val2);
+}
+
+
 __private_extern__ Boolean
 __SCNetworkConfigurationSetValue(SCPreferencesRef	prefs,
 				 CFStringRef		path,
@@ -298,7 +374,7 @@ __SCNetworkConfigurationSetValue(SCPreferencesRef	prefs,
 {
 	Boolean			changed;
 	CFDictionaryRef		curConfig;
-	CFMutableDictionaryRef	newConfig	= NULL;
+	CFDictionaryRef		newConfig	= NULL;
 	Boolean			ok;
 
 	if ((config != NULL) && !isA_CFDictionary(config)) {
@@ -306,32 +382,46 @@ __SCNetworkConfigurationSetValue(SCPreferencesRef	prefs,
 		return FALSE;
 	}
 
-	curConfig = SCPreferencesPathGetValue(prefs, path);
+	curConfig = __SCPreferencesPathGetValue(prefs, path);
 	curConfig = isA_CFDictionary(curConfig);
 
 	if (config != NULL) {
-		newConfig = CFDictionaryCreateMutableCopy(NULL, 0, config);
+		// an immutable copy (a retain if "config" is already immutable,
+		// a copy of the dictionary if not)
+		newConfig = CFDictionaryCreateCopy(NULL, config);
 	}
 
 	if (keepInactive) {
-		if (config == NULL) {
-			newConfig = CFDictionaryCreateMutable(NULL,
-							      0,
-							      &kCFTypeDictionaryKeyCallBacks,
-							      &kCFTypeDictionaryValueCallBacks);
-		}
+		Boolean		inactive;
 
-		if (isA_CFDictionary(curConfig) && CFDictionaryContainsKey(curConfig, kSCResvInactive)) {
-			// if currently disabled
-			CFDictionarySetValue(newConfig, kSCResvInactive, kCFBooleanTrue);
-		} else {
-			// if currently enabled
-			CFDictionaryRemoveValue(newConfig, kSCResvInactive);
+		inactive = isA_CFDictionary(curConfig) && CFDictionaryContainsKey(curConfig, kSCResvInactive);
+		if (config == NULL) {
+			newConfig = CFDictionaryCreate(NULL,
+						       (const void **)&kSCResvInactive,
+						       (const void **)&kCFBooleanTrue,
+						       inactive ? 1 : 0,
+						       &kCFTypeDictionaryKeyCallBacks,
+						       &kCFTypeDictionaryValueCallBacks);
+		} else if (inactive ? !_SC_CFEqual(CFDictionaryGetValue(config, kSCResvInactive), kCFBooleanTrue)
+				    : CFDictionaryContainsKey(config, kSCResvInactive)) {
+			CFMutableDictionaryRef	overlay;
+
+			// overlay the [current] disabled state (the values are shared, not copied)
+			overlay = CFDictionaryCreateMutableCopy(NULL, 0, config);
+			if (inactive) {
+				// if currently disabled
+				CFDictionarySetValue(overlay, kSCResvInactive, kCFBooleanTrue);
+			} else {
+				// if currently enabled
+				CFDictionaryRemoveValue(overlay, kSCResvInactive);
+			}
+			CFRelease(newConfig);
+			newConfig = overlay;
 		}
 	}
 
 	// check if the configuration changed
-	changed = !_SC_CFEqual(curConfig, newConfig);
+	changed = !__configValueEqual(curConfig, newConfig);
 
 	// set new configuration
 	if (!changed) {
@@ -359,7 +449,7 @@ __getPrefsEnabled(SCPreferencesRef prefs, CFStringRef path)
 {
 	CFDictionaryRef config;
 
-	config = SCPreferencesPathGetValue(prefs, path);
+	config = __SCPreferencesPathGetValue_lazy(prefs, path);
 	if (isA_CFDictionary(config) && CFDictionaryContainsKey(config, kSCResvInactive)) {
 		return FALSE;
 	}
@@ -379,7 +469,7 @@ __setPrefsEnabled(SCPreferencesRef      prefs,
 	Boolean					ok		= FALSE;
 
 	// preserve current configuration
-	curConfig = SCPreferencesPathGetValue(prefs, path);
+	curConfig = __SCPreferencesPathGetValue(prefs, path);
 	if (curConfig != NULL) {
 		if (!isA_CFDictionary(curConfig)) {
 			_SCErrorSet(kSCStatusFailed);
@@ -433,11 +523,26 @@ __setPrefsEnabled(SCPreferencesRef      prefs,
 
 #define NETWORKCONFIGURATION_RESOURCE_FILE	"NetworkConfiguration.plist"
 
-static CFDictionaryRef
-__copyTemplates()
+/*
+ * The templates are read (once, and again only if the file changes) and
+ * indexed by interface type and child interface type so that a lookup
+ * need not parse the file nor format a "<type>-<child>" key.  The
+ * [immutable] templates are shared with the callers.
+ */
+static struct {
+	char		path[MAXPATHLEN];
+	struct stat	statBuf;	// of the file, as read
+	CFDictionaryRef	interfaces;	// [interfaceType][childType] --> interface template
+	CFDictionaryRef	protocols;	// [interfaceType][childType] --> { protocolType : template }
+} templates;
+
+static pthread_mutex_t	templates_lock	= PTHREAD_MUTEX_INITIALIZER;
+
+
+static CFURLRef
+__copyTemplatesURL()
 {
 	CFBundleRef     bundle;
-	CFDictionaryRef templates;
 	CFURLRef	url;
 
 	bundle = _SC_CFBundleGet();
@@ -463,54 +568,179 @@ __copyTemplates()
 		}
 	}
 
-	templates = _SCCreatePropertyListFromResource(url);
-	CFRelease(url);
+	return url;
+}
 
-	if ((templates != NULL) && !isA_CFDictionary(templates)) {
-		CFRelease(templates);
-		return NULL;
-	}
 
-	return templates;
+static void
+__templatesIndexAdd(CFMutableDictionaryRef index, CFStringRef interfaceType, CFTypeRef childType, CFTypeRef value)
+{
+	CFMutableDictionaryRef	children;
+
+	children = (CFMutableDictionaryRef)CFDictionaryGetValue(index, interfaceType);
+	if (children == NULL) {
+		children = CFDictionaryCreateMutable(NULL,
+						     0,
+						     &kCFTypeDictionaryKeyCallBacks,
+						     &kCFTypeDictionaryValueCallBacks);
+		CFDictionarySetValue(index, interfaceType, children);
+		CFRelease(children);
+	}
+	CFDictionarySetValue(children, childType, value);
+	return;
 }
 
 
-__private_extern__ CFDictionaryRef
-__copyInterfaceTemplate(CFStringRef      interfaceType,
-			CFStringRef      childInterfaceType)
+static void
+__templatesIndexAddTemplate(const void *key, const void *value, void *context)
 {
-	CFDictionaryRef interface       = NULL;
-	CFDictionaryRef interfaces;
-	CFDictionaryRef templates;
+	CFMutableDictionaryRef	index		= (CFMutableDictionaryRef)context;
+	CFStringRef		name		= (CFStringRef)key;
+	CFRange			range;
 
-	templates = __copyTemplates();
-	if (templates == NULL) {
-		return NULL;
+	if (!isA_CFString(name) || !isA_CFDictionary(value)) {
+		return;
 	}
 
-	interfaces = CFDictionaryGetValue(templates, CFSTR("Interface"));
-	if (!isA_CFDictionary(interfaces)) {
-		CFRelease(templates);
-		return NULL;
+	// "<type>" (no child interface)
+	__templatesIndexAdd(index, name, kCFNull, value);
+
+	// "<type>-<child>" (split at each "-", should the type itself have one)
+	range = CFRangeMake(0, CFStringGetLength(name));
+	while (CFStringFindWithOptions(name, CFSTR("-"), range, 0, &range)) {
+		CFStringRef	childType;
+		CFIndex		end		= CFStringGetLength(name);
+		CFStringRef	interfaceType;
+
+		interfaceType = CFStringCreateWithSubstring(NULL, name, CFRangeMake(0, range.location));
+		childType = CFStringCreateWithSubstring(NULL, name, CFRangeMake(range.location + 1, end - range.location - 1));
+		__templatesIndexAdd(index, interfaceType, childType, value);
+		CFRelease(interfaceType);
+		CFRelease(childType);
+
+		range = CFRangeMake(range.location + 1, end - range.location - 1);
+	}
+
+	return;
+}
+
+
+static CFDictionaryRef
+__templatesCreateIndex(CFDictionaryRef dict)
+{
+	CFMutableDictionaryRef	index;
+
+	index = CFDictionaryCreateMutable(NULL,
+					  0,
+					  &kCFTypeDictionaryKeyCallBacks,
+					  &kCFTypeDictionaryValueCallBacks);
+	if (isA_CFDictionary(dict)) {
+		CFDictionaryApplyFunction(dict, __templatesIndexAddTemplate, index);
 	}
+	return index;
+}
+
+
+/*
+ * __templatesLoad
+ * - (re)reads the templates if not yet read or if the file has changed;
+ *   called with templates_lock held
+ */
+static Boolean
+__templatesLoad()
+{
+	struct stat	statBuf;
+	CFDictionaryRef	plist;
+	CFURLRef	url;
 
-	if (childInterfaceType == NULL) {
-		interface = CFDictionaryGetValue(interfaces, interfaceType);
+	if (templates.path[0] == '\0') {
+		url = __copyTemplatesURL();
+		if (url == NULL) {
+			return FALSE;
+		}
+		if (!CFURLGetFileSystemRepresentation(url, TRUE, (UInt8 *)templates.path, sizeof(templates.path))) {
+			templates.path[0] = '\0';
+		}
 	} else {
-		CFStringRef     expandedType;
+		url = NULL;
+	}
+
+	if (stat(templates.path, &statBuf) == -1) {
+		memset(&statBuf, 0, sizeof(statBuf));
+	}
+	if ((templates.interfaces != NULL) &&
+	    (statBuf.st_dev == templates.statBuf.st_dev) &&
+	    (statBuf.st_ino == templates.statBuf.st_ino) &&
+	    (statBuf.st_size == templates.statBuf.st_size) &&
+	    (statBuf.st_mtimespec.tv_sec == templates.statBuf.st_mtimespec.tv_sec) &&
+	    (statBuf.st_mtimespec.tv_nsec == templates.statBuf.st_mtimespec.tv_nsec)) {
+		// if unchanged
+		if (url != NULL) CFRelease(url);
+		return TRUE;
+	}
+
+	if ((url == NULL) && (templates.path[0] != '\0')) {
+		url = CFURLCreateFromFileSystemRepresentation(NULL,
+							      (const UInt8 *)templates.path,
+							      (CFIndex)strlen(templates.path),
+							      FALSE);
+	}
+	if (url == NULL) {
+		return (templates.interfaces != NULL);
+	}
+	plist = __SCCreatePropertyListFromResource(url);
+	CFRelease(url);
+	if (!isA_CFDictionary(plist)) {
+		if (plist != NULL) CFRelease(plist);
+		// keep any templates we already have
+		return (templates.interfaces != NULL);
+	}
+
+	if (templates.interfaces != NULL) CFRelease(templates.interfaces);
+	templates.interfaces = __templatesCreateIndex(CFDictionaryGetValue(plist, CFSTR("Interface")));
+	if (templates.protocols != NULL) CFRelease(templates.protocols);
+	templates.protocols = __templatesCreateIndex(CFDictionaryGetValue(plist, CFSTR("Protocol")));
+	templates.statBuf = statBuf;
+	CFRelease(plist);
+
+	return TRUE;
+}
+
+
+static CFDictionaryRef
+__templatesLookup(CFDictionaryRef index, CFStringRef interfaceType, CFStringRef childInterfaceType)
+{
+	CFDictionaryRef	children;
+	CFTypeRef	childType	= kCFNull;
 
+	if (childInterfaceType != NULL) {
 		if (CFStringFind(childInterfaceType, CFSTR("."), 0).location != kCFNotFound) {
 			// if "vendor" type
-			childInterfaceType = CFSTR("*");
+			childType = CFSTR("*");
+		} else {
+			childType = childInterfaceType;
 		}
+	}
+
+	children = CFDictionaryGetValue(index, interfaceType);
+	if (children == NULL) {
+		return NULL;
+	}
+
+	return CFDictionaryGetValue(children, childType);
+}
+
+
+__private_extern__ CFDictionaryRef
+__copyInterfaceTemplate(CFStringRef      interfaceType,
+			CFStringRef      childInterfaceType)
+{
+	CFDictionaryRef interface       = NULL;
 
-		expandedType = CFStringCreateWithFormat(NULL,
-							NULL,
-							CFSTR("%@-%@"),
-							interfaceType,
-							childInterfaceType);
-		interface = CFDictionaryGetValue(interfaces, expandedType);
-		CFRelease(expandedType);
+	pthread_mutex_lock(&templates_lock);
+
+	if (__templatesLoad()) {
+		interface = __templatesLookup(templates.interfaces, interfaceType, childInterfaceType);
 	}
 
 	if (isA_CFDictionary(interface) && (CFDictionaryGetCount(interface) > 0)) {
@@ -519,7 +749,7 @@ __copyInterfaceTemplate(CFStringRef      interfaceType,
 		interface = NULL;
 	}
 
-	CFRelease(templates);
+	pthread_mutex_unlock(&templates_lock);
 
 	return interface;
 }
@@ -532,37 +762,11 @@ __copyProtocolTemplate(CFStringRef      interfaceType,
 {
 	CFDictionaryRef interface       = NULL;
 	CFDictionaryRef protocol	= NULL;
-	CFDictionaryRef protocols;
-	CFDictionaryRef templates;
-
-	templates = __copyTemplates();
-	if (templates == NULL) {
-		return NULL;
-	}
 
-	protocols = CFDictionaryGetValue(templates, CFSTR("Protocol"));
-	if (!isA_CFDictionary(protocols)) {
-		CFRelease(templates);
-		return NULL;
-	}
-
-	if (childInterfaceType == NULL) {
-		interface = CFDictionaryGetValue(protocols, interfaceType);
-	} else {
-		CFStringRef     expandedType;
-
-		if (CFStringFind(childInterfaceType, CFSTR("."), 0).location != kCFNotFound) {
-			// if "vendor" type
-			childInterfaceType = CFSTR("*");
-		}
+	pthread_mutex_lock(&templates_lock);
 
-		expandedType = CFStringCreateWithFormat(NULL,
-							NULL,
-							CFSTR("%@-%@"),
-							interfaceType,
-							childInterfaceType);
-		interface = CFDictionaryGetValue(protocols, expandedType);
-		CFRelease(expandedType);
+	if (__templatesLoad()) {
+		interface = __templatesLookup(templates.protocols, interfaceType, childInterfaceType);
 	}
 
 	if (isA_CFDictionary(interface)) {
@@ -574,7 +778,7 @@ __copyProtocolTemplate(CFStringRef      interfaceType,
 		}
 	}
 
-	CFRelease(templates);
+	pthread_mutex_unlock(&templates_lock);
 
 	return protocol;
 }
@@ -658,7 +862,7 @@ __SCPreferencesPathCreateUniqueChild_WithMoreSCFCompatibility(SCPreferencesRef p
 		Boolean	ok;
 
 		path = CFStringCreateWithFormat(NULL, NULL, CFSTR("%@/%@"), prefix, CFSTR("0"));
-		dict = SCPreferencesPathGetValue(prefs, path);
+		dict = __SCPreferencesPathGetValue(prefs, path);
 		if (dict != NULL) {
 			// if path "0" exists
 			CFRelease(path);
@@ -3026,10 +3026,10 @@ extendedConfigurationTypes(SCNetworkInterfaceRef interface)
 		}
 
 		// add stored extended configuration types
-		path = SCPreferencesPathKeyCreateSetNetworkInterfaceEntity(NULL,				// allocator
-									   SCNetworkSetGetSetID(set),		// set
-									   interfacePrivate->entity_device,	// service
-									   NULL);				// entity
+		path = __SCPreferencesPathKeyCreateSetNetworkInterfaceEntity(NULL,				// allocator
+									     SCNetworkSetGetSetID(set),		// set
+									     interfacePrivate->entity_device,	// service
+									     NULL);				// entity
 		configs = __SCNetworkConfigurationGetValue(interfacePrivate->prefs, path);
 		CFRelease(path);
 		if (isA_CFDictionary(configs)) {
@@ -3096,10 +3096,10 @@ copyPerInterfaceConfigurationPaths(SCNetworkInterfacePrivateRef	interfacePrivate
 		if (CFArrayContainsValue(services,
 					 CFRangeMake(0, CFArrayGetCount(services)),
 					 service)) {
-			path = SCPreferencesPathKeyCreateSetNetworkInterfaceEntity(NULL,				// allocator
-										   SCNetworkSetGetSetID(set),		// set
-										   interfacePrivate->entity_device,	// service
-										   extendedType);			// entity
+			path = __SCPreferencesPathKeyCreateSetNetworkInterfaceEntity(NULL,				// allocator
+										     SCNetworkSetGetSetID(set),		// set
+										     interfacePrivate->entity_device,	// service
+										     extendedType);			// entity
 			if (array == NULL) {
 				array = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
 			}
@@ -3126,18 +3126,18 @@ copyConfigurationPaths(SCNetworkInterfacePrivateRef	interfacePrivate,
 	interfaceIndex = findConfiguration(interfacePrivate->interface_type);
 	if (interfaceIndex == kCFNotFound) {
 		// unknown interface type, use per-service configuration preferences
-		path = SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
-								      interfacePrivate->serviceID,	// service
-								      extendedType);			// entity
+		path = __SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
+									interfacePrivate->serviceID,	// service
+									extendedType);			// entity
 		array = stringCreateArray(path);
 		CFRelease(path);
 	}
 
 	else if (!configurations[interfaceIndex].per_interface_config) {
 		// known interface type, per-service configuration preferences
-		path = SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
-								      interfacePrivate->serviceID,	// service
-								      extendedType);			// entity
+		path = __SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
+									interfacePrivate->serviceID,	// service
+									extendedType);			// entity
 		array = stringCreateArray(path);
 		CFRelease(path);
 	}
@@ -3385,7 +3385,7 @@ copy_ppp_entity(CFStringRef bsdName)
 
 			components = CFStringCreateArrayBySeparatingStrings(NULL, pppKey, CFSTR("/"));
 			serviceID = CFArrayGetValueAtIndex(components, 3);
-			interfaceKey = SCDynamicStoreKeyCreateNetworkServiceEntity(NULL, kSCDynamicStoreDomainSetup, serviceID, kSCEntNetInterface);
+			interfaceKey = __SCDynamicStoreKeyCreateNetworkServiceEntity(NULL, kSCDynamicStoreDomainSetup, serviceID, kSCEntNetInterface);
 			interfaceVal = CFDictionaryGetValue(dict, interfaceKey);
 			CFRelease(interfaceKey);
 			CFRelease(components);
@@ -5233,10 +5233,10 @@ __SCNetworkInterfaceGetDefaultConfiguration(SCNetworkSetRef set, SCNetworkInterf
 		if (set != NULL) {
 			CFStringRef	path;
 
-			path = SCPreferencesPathKeyCreateSetNetworkInterfaceEntity(NULL,				// allocator
-										   SCNetworkSetGetSetID(set),		// set
-										   interfacePrivate->entity_device,	// interface
-										   defaultType);			// entity
+			path = __SCPreferencesPathKeyCreateSetNetworkInterfaceEntity(NULL,				// allocator
+										     SCNetworkSetGetSetID(set),		// set
+										     interfacePrivate->entity_device,	// interface
+										     defaultType);			// entity
 			if (path != NULL) {
 				config = __SCNetworkConfigurationGetValue(interfacePrivate->prefs, path);
 				CFRelease(path);
@@ -5322,9 +5322,9 @@ SCNetworkInterfaceGetConfiguration(SCNetworkInterfaceRef interface)
 
 			// if AirPort interface, check for a per-service config
 			interfacePrivate = (SCNetworkInterfacePrivateRef)interface;
-			path = SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
-									      interfacePrivate->serviceID,	// service
-									      kSCEntNetAirPort);		// entity
+			path = __SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
+										interfacePrivate->serviceID,	// service
+										kSCEntNetAirPort);		// entity
 			config = __SCNetworkConfigurationGetValue(interfacePrivate->prefs, path);
 			CFRelease(path);
 		}
@@ -5501,10 +5501,10 @@ copy_display_name(SCNetworkInterfaceRef interface, Boolean localized, Boolean ol
 
 			// check for (and use) the name of the interface when it
 			// was last available
-			path = SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,
-									      interfacePrivate->serviceID,
-									      kSCEntNetInterface);
-			entity = SCPreferencesPathGetValue(interfacePrivate->prefs, path);
+			path = __SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,
+										interfacePrivate->serviceID,
+										kSCEntNetInterface);
+			entity = __SCPreferencesPathGetValue(interfacePrivate->prefs, path);
 			CFRelease(path);
 			if (isA_CFDictionary(entity)) {
 				CFStringRef	name;
@@ -5674,10 +5674,10 @@ __SCNetworkInterfaceSetDefaultConfiguration(SCNetworkSetRef		set,
 	if (set != NULL) {
 		CFStringRef	path;
 
-		path = SCPreferencesPathKeyCreateSetNetworkInterfaceEntity(NULL,				// allocator
-									   SCNetworkSetGetSetID(set),		// set
-									   interfacePrivate->entity_device,	// interface
-									   defaultType);			// entity
+		path = __SCPreferencesPathKeyCreateSetNetworkInterfaceEntity(NULL,				// allocator
+									     SCNetworkSetGetSetID(set),		// set
+									     interfacePrivate->entity_device,	// interface
+									     defaultType);			// entity
 		if (path != NULL) {
 			ok = __SCNetworkConfigurationSetValue(interfacePrivate->prefs, path, config, FALSE);
 			CFRelease(path);
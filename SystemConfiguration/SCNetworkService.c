@@ -434,9 +434,9 @@ __SCNetworkServiceSetInterfaceEntity(SCNetworkServiceRef     service,
 	CFStringRef			path;
 	SCNetworkServicePrivateRef      servicePrivate		= (SCNetworkServicePrivateRef)service;
 
-	path = SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
-							      servicePrivate->serviceID,	// service
-							      kSCEntNetInterface);		// entity
+	path = __SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
+								servicePrivate->serviceID,	// service
+								kSCEntNetInterface);		// entity
 	entity = __SCNetworkInterfaceCopyInterfaceEntity(interface);
 	ok = SCPreferencesPathSetValue(servicePrivate->prefs, path, entity);
 	CFRelease(entity);
@@ -500,10 +500,10 @@ SCNetworkServiceGetName(SCNetworkServiceRef service)
 		return servicePrivate->name;
 	}
 
-	path = SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
-							      servicePrivate->serviceID,	// service
-							      NULL);				// entity
-	entity = SCPreferencesPathGetValue(servicePrivate->prefs, path);
+	path = __SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
+								servicePrivate->serviceID,	// service
+								NULL);				// entity
+	entity = __SCPreferencesPathGetValue(servicePrivate->prefs, path);
 	CFRelease(path);
 
 	useSystemInterfaces = !_SCNetworkConfigurationBypassSystemInterfaces(servicePrivate->prefs);
@@ -644,10 +644,10 @@ __SCNetworkServiceExists(SCNetworkServiceRef service)
 		return FALSE;
 	}
 
-	path = SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
-							      servicePrivate->serviceID,	// service
-							      kSCEntNetInterface);     		 // entity
-	entity = SCPreferencesPathGetValue(servicePrivate->prefs, path);
+	path = __SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
+								servicePrivate->serviceID,	// service
+								kSCEntNetInterface);     		 // entity
+	entity = __SCPreferencesPathGetValue(servicePrivate->prefs, path);
 	CFRelease(path);
 
 	if (!isA_CFDictionary(entity)) {
@@ -701,10 +701,10 @@ replaceServiceID(const void *value, void *context)
 	}
 
 	// check if service with old serviceID is part of the set
-	path = SCPreferencesPathKeyCreateSetNetworkServiceEntity(NULL,				// allocator
-								 setPrivate->setID,		// set
-								 service_context->oldServiceID,	// service
-								 NULL);				// entity
+	path = __SCPreferencesPathKeyCreateSetNetworkServiceEntity(NULL,				// allocator
+								   setPrivate->setID,		// set
+								   service_context->oldServiceID,	// service
+								   NULL);				// entity
 	oldLink = SCPreferencesPathGetLink(setPrivate->prefs, path);
 	if (oldLink == NULL) {
 		// don't make any changes if service with old serviceID is not found
@@ -716,13 +716,13 @@ replaceServiceID(const void *value, void *context)
 	CFRelease(path);
 
 	// create the link between "set" and the "service"
-	path = SCPreferencesPathKeyCreateSetNetworkServiceEntity(NULL,				// allocator
-								 setPrivate->setID,		// set
-								 service_context->newServiceID,	// service
-								 NULL);				// entity
-	link = SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
-							      service_context->newServiceID,	// service
-							      NULL);				// entity
+	path = __SCPreferencesPathKeyCreateSetNetworkServiceEntity(NULL,				// allocator
+								   setPrivate->setID,		// set
+								   service_context->newServiceID,	// service
+								   NULL);				// entity
+	link = __SCPreferencesPathKeyCreateNetworkServiceEntity(NULL,				// allocator
+								service_context->newServiceID,	// service
+								NULL);				// entity
 	(void) SCPreferencesPathSetLink(setPrivate->prefs, path, link);
 
     done:
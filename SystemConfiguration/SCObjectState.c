@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: per-object state for framework-allocated objects
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <CoreFoundation/CFRuntime.h>
+#include <objc/runtime.h>
+
+#include "SCObjectState.h"
+
+
+/*
+ * Each table maps an object pointer to its state.  The first time state
+ * is added for an object, the object is also given a "sentinel" (an
+ * associated object, keyed by the table).  The runtime releases the
+ * sentinel when the object is deallocated and the sentinel's finalizer
+ * then removes the object's state; a new object later allocated at the
+ * same address starts out without any.
+ */
+
+
+struct __SCObjectStateTable {
+	pthread_mutex_t			lock;
+	CFMutableDictionaryRef		states;		// <object pointer> --> state
+	SCObjectStateRetainCallBack	retain;
+	SCObjectStateReleaseCallBack	release;
+};
+
+
+typedef struct {
+	CFRuntimeBase			cfBase;
+	SCObjectStateTableRef		table;
+	const void			*object;	// [weak]
+} SCObjectStateSentinel, *SCObjectStateSentinelRef;
+
+
+static void		__SCObjectStateSentinelDeallocate	(CFTypeRef cf);
+
+
+static const CFRuntimeClass __SCObjectStateSentinelClass = {
+	0,					// version
+	"SCObjectStateSentinel",		// className
+	NULL,					// init
+	NULL,					// copy
+	__SCObjectStateSentinelDeallocate,	// dealloc
+	NULL,					// equal
+	NULL,					// hash
+	NULL,					// copyFormattingDesc
+	NULL					// copyDebugDesc
+};
+
+
+static CFTypeID		__kSCObjectStateSentinelTypeID	= _kCFRuntimeNotATypeID;
+static pthread_once_t	sentinel_init			= PTHREAD_ONCE_INIT;
+
+
+static void
+__SCObjectStateSentinelInitialize(void)
+{
+	__kSCObjectStateSentinelTypeID = _CFRuntimeRegisterClass(&__SCObjectStateSentinelClass);
+	return;
+}
+
+
+static void
+__SCObjectStateSentinelDeallocate(CFTypeRef cf)
+{
+	SCObjectStateSentinelRef	sentinel	= (SCObjectStateSentinelRef)cf;
+
+	// the object is being deallocated
+	__SCObjectStateRemove(sentinel->table, sentinel->object);
+	return;
+}
+
+
+static void
+sentinelAttach(SCObjectStateTableRef table, CFTypeRef object)
+{
+	SCObjectStateSentinelRef	sentinel;
+	uint32_t			size;
+
+	if (objc_getAssociatedObject((id)(void *)object, table) != NULL) {
+		// if already watching for the object to be deallocated
+		return;
+	}
+
+	pthread_once(&sentinel_init, __SCObjectStateSentinelInitialize);
+
+	size = sizeof(SCObjectStateSentinel) - sizeof(CFRuntimeBase);
+	sentinel = (SCObjectStateSentinelRef)_CFRuntimeCreateInstance(NULL,
+								      __kSCObjectStateSentinelTypeID,
+								      size,
+								      NULL);
+	if (sentinel == NULL) {
+		return;
+	}
+	sentinel->table = table;
+	sentinel->object = object;
+
+	objc_setAssociatedObject((id)(void *)object, table, (id)(void *)sentinel, OBJC_ASSOCIATION_RETAIN);
+	CFRelease(sentinel);
+	return;
+}
+
+
+__private_extern__ SCObjectStateTableRef
+__SCObjectStateTableCreate(SCObjectStateRetainCallBack retain, SCObjectStateReleaseCallBack release)
+{
+	SCObjectStateTableRef	table;
+
+	table = calloc(1, sizeof(*table));
+	if (table == NULL) {
+		return NULL;
+	}
+	pthread_mutex_init(&table->lock, NULL);
+	table->states = CFDictionaryCreateMutable(NULL, 0, NULL, NULL);
+	table->retain = retain;
+	table->release = release;
+
+	return table;
+}
+
+
+__private_extern__ const void *
+__SCObjectStateCopy(SCObjectStateTableRef table, CFTypeRef object, SCObjectStateCreateCallBack create)
+{
+	const void	*state;
+
+	pthread_mutex_lock(&table->lock);
+	state = CFDictionaryGetValue(table->states, object);
+	if ((state == NULL) && (create != NULL)) {
+		state = (*create)(object);
+		if (state != NULL) {
+			CFDictionarySetValue(table->states, object, state);
+			sentinelAttach(table, object);
+		}
+	}
+	if (state != NULL) {
+		state = (*table->retain)(state);
+	}
+	pthread_mutex_unlock(&table->lock);
+
+	return state;
+}
+
+
+__private_extern__ void
+__SCObjectStateRemove(SCObjectStateTableRef table, CFTypeRef object)
+{
+	const void	*state;
+
+	pthread_mutex_lock(&table->lock);
+	state = CFDictionaryGetValue(table->states, object);
+	if (state != NULL) {
+		CFDictionaryRemoveValue(table->states, object);
+	}
+	pthread_mutex_unlock(&table->lock);
+
+	if (state != NULL) {
+		// (outside of the lock, releasing the state may release other objects)
+		(*table->release)(state);
+	}
+
+	return;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef _SCOBJECTSTATE_H
+#define _SCOBJECTSTATE_H
+
+#include <sys/cdefs.h>
+#include <CoreFoundation/CoreFoundation.h>
+
+
+/*
+ * The SCPreferences and SCDynamicStore objects are created by the
+ * SystemConfiguration framework; their layout is not ours to extend.
+ * Any additional per-object state is kept in a side table, keyed by the
+ * object pointer, and is released when the object is deallocated.
+ */
+typedef struct __SCObjectStateTable	*SCObjectStateTableRef;
+
+typedef const void *	(*SCObjectStateRetainCallBack)	(const void *state);
+typedef void		(*SCObjectStateReleaseCallBack)	(const void *state);
+typedef const void *	(*SCObjectStateCreateCallBack)	(CFTypeRef object);	// retained by the table
+
+
+__BEGIN_DECLS
+
+SCObjectStateTableRef
+__SCObjectStateTableCreate		(SCObjectStateRetainCallBack	retain,
+					 SCObjectStateReleaseCallBack	release);
+
+/*
+ * __SCObjectStateCopy
+ * - returns the [retained] state of the object.  If there is none and
+ *   "create" is not NULL, the state is created (with the table lock
+ *   held) and added.
+ */
+const void *
+__SCObjectStateCopy			(SCObjectStateTableRef		table,
+					 CFTypeRef			object,
+					 SCObjectStateCreateCallBack	create);
+
+/*
+ * __SCObjectStateRemove
+ * - removes (and releases) the state of the object.  This is done when
+ *   the object is deallocated.
+ */
+void
+__SCObjectStateRemove			(SCObjectStateTableRef		table,
+					 CFTypeRef			object);
+
+__END_DECLS
+
+#endif	/* _SCOBJECTSTATE_H */
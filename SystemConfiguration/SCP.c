@@ -242,12 +242,12 @@ _SCPNotificationKey(CFAllocatorRef	allocator,
 						  kCFStringEncodingASCII,
 						  kCFAllocatorNull);
 
-	storeKey = CFStringCreateWithFormat(allocator,
-					    NULL,
-					    CFSTR("%@%@:%@"),
-					    kSCDynamicStoreDomainPrefs,
-					    keyStr,
-					    pathStr);
+	// "<Prefs:><keyStr>:<path>", shared by all sessions for the same prefs
+	{
+		CFStringRef	pieces[]	= { kSCDynamicStoreDomainPrefs, keyStr, CFSTR(":"), pathStr };
+
+		storeKey = __SCStringCreateInterned(pieces, sizeof(pieces) / sizeof(pieces[0]));
+	}
 
 	CFRelease(pathStr);
 	CFAllocatorDeallocate(NULL, path);
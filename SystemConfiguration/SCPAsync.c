@@ -0,0 +1,434 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: asynchronous commit / apply
+ */
+
+#include <Block.h>
+#include <pthread.h>
+
+#include "SCPreferencesInternal.h"
+
+
+/*
+ * An asynchronous commit takes a snapshot of the preferences (a shallow
+ * copy; values are replaced, never modified, when the preferences are
+ * changed) and hands it to a per-session serial worker queue.  The worker
+ * serializes and writes the snapshot with an optimistic commit (so that
+ * the commit still fails if others have committed since the session read
+ * the preferences) and then calls the completion handlers.
+ *
+ * A commit requested while an earlier one is still waiting for the worker
+ * replaces that commit's snapshot; both completion handlers are called
+ * once the (single) write is done.  Applies are queued behind any pending
+ * commit.
+ */
+
+
+typedef struct __SCPreferencesCompletion {
+	dispatch_queue_t			queue;
+	SCPreferencesCompletionHandler		handler;
+	struct __SCPreferencesCompletion	*next;
+} completion, *completionRef;
+
+
+#pragma mark -
+#pragma mark Commit latency
+
+
+#define	N_LATENCY_SAMPLES	1024
+
+
+static uint64_t		latency_samples[N_LATENCY_SAMPLES];	// usec
+static uint64_t		latency_count		= 0;
+static pthread_mutex_t	latency_lock		= PTHREAD_MUTEX_INITIALIZER;
+
+
+static void
+latencyAdd(uint64_t usec)
+{
+	pthread_mutex_lock(&latency_lock);
+	latency_samples[latency_count % N_LATENCY_SAMPLES] = usec;
+	latency_count++;
+	pthread_mutex_unlock(&latency_lock);
+	return;
+}
+
+
+static int
+compareSamples(const void *a, const void *b)
+{
+	uint64_t	sa	= *(const uint64_t *)a;
+	uint64_t	sb	= *(const uint64_t *)b;
+
+	return (sa < sb) ? -1 : ((sa > sb) ? 1 : 0);
+}
+
+
+static void
+addLatency(CFMutableDictionaryRef dict, CFStringRef key, uint64_t usec)
+{
+	CFNumberRef	num;
+	SInt64		val	= (SInt64)usec;
+
+	num = CFNumberCreate(NULL, kCFNumberSInt64Type, &val);
+	CFDictionarySetValue(dict, key, num);
+	CFRelease(num);
+	return;
+}
+
+
+/*
+ * _SCPreferencesCopyCommitLatency
+ *
+ * Returns the latency (in microseconds, from request to completion) of
+ * the most recent asynchronous commits.
+ */
+CFDictionaryRef
+_SCPreferencesCopyCommitLatency(void)
+{
+	uint64_t		count;
+	CFMutableDictionaryRef	dict;
+	uint64_t		n;
+	uint64_t		samples[N_LATENCY_SAMPLES];
+	SInt64			total;
+	CFNumberRef		num;
+
+	pthread_mutex_lock(&latency_lock);
+	count = latency_count;
+	n = (count < N_LATENCY_SAMPLES) ? count : N_LATENCY_SAMPLES;
+	memcpy(samples, latency_samples, (size_t)n * sizeof(uint64_t));
+	pthread_mutex_unlock(&latency_lock);
+
+	dict = CFDictionaryCreateMutable(NULL,
+					 0,
+					 &kCFTypeDictionaryKeyCallBacks,
+					 &kCFTypeDictionaryValueCallBacks);
+	total = (SInt64)count;
+	num = CFNumberCreate(NULL, kCFNumberSInt64Type, &total);
+	CFDictionarySetValue(dict, kSCPreferencesLatencyCount, num);
+	CFRelease(num);
+	if (n > 0) {
+		qsort(samples, (size_t)n, sizeof(uint64_t), compareSamples);
+		addLatency(dict, kSCPreferencesLatencyP50, samples[(n - 1) * 50 / 100]);
+		addLatency(dict, kSCPreferencesLatencyP90, samples[(n - 1) * 90 / 100]);
+		addLatency(dict, kSCPreferencesLatencyP99, samples[(n - 1) * 99 / 100]);
+		addLatency(dict, kSCPreferencesLatencyMax, samples[n - 1]);
+	}
+
+	return dict;
+}
+
+
+#pragma mark -
+#pragma mark Worker
+
+
+static dispatch_queue_t
+asyncQueue(SCPreferencesExtraRef extra)
+{
+	// must be called with the session lock held
+	if (extra->asyncQueue == NULL) {
+		extra->asyncQueue = dispatch_queue_create("SCPreferences async commit", NULL);
+	}
+	return extra->asyncQueue;
+}
+
+
+static void
+completionsCall(completionRef completions, Boolean ok, int sc_status)
+{
+	while (completions != NULL) {
+		completionRef	next	= completions->next;
+
+		if (completions->handler != NULL) {
+			dispatch_queue_t		queue	= completions->queue;
+			SCPreferencesCompletionHandler	handler	= completions->handler;
+
+			dispatch_async(queue, ^{
+				handler(ok, sc_status);
+				Block_release(handler);
+				dispatch_release(queue);
+			});
+		}
+		CFAllocatorDeallocate(NULL, completions);
+		completions = next;
+	}
+
+	return;
+}
+
+
+static void
+asyncCommit(SCPreferencesRef prefs, SCPreferencesExtraRef extra)
+{
+	completionRef		completions;
+	CFDictionaryRef		journalBase;
+	off_t			journalSize;
+	Boolean			ok;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	int			sc_status;
+	CFDataRef		signature;
+	CFDictionaryRef		snapshot;
+	uint64_t		started;
+	SCPreferencesExtraRef	workerExtra;
+	SCPreferencesPrivateRef	workerPrivate;
+
+	pthread_mutex_lock(&prefsPrivate->lock);
+	snapshot = extra->asyncSnapshot;
+	extra->asyncSnapshot = NULL;
+	completions = extra->asyncCompletions;
+	extra->asyncCompletions = NULL;
+	started = extra->asyncRequested;
+	signature = (prefsPrivate->signature != NULL) ? CFRetain(prefsPrivate->signature) : NULL;
+	journalBase = (extra->journalBase != NULL) ? CFRetain(extra->journalBase) : NULL;
+	journalSize = extra->journalSize;
+	pthread_mutex_unlock(&prefsPrivate->lock);
+
+	if (snapshot == NULL) {
+		// if nothing to commit
+		if (signature != NULL) CFRelease(signature);
+		if (journalBase != NULL) CFRelease(journalBase);
+		completionsCall(completions, TRUE, kSCStatusOK);
+		return;
+	}
+
+	// the worker session stands in for the session, as read (and changed)
+	if (extra->asyncPrefs == NULL) {
+		extra->asyncPrefs = SCPreferencesCreateWithOptions(NULL,
+								   prefsPrivate->name,
+								   prefsPrivate->prefsID,
+								   NULL,
+								   prefsPrivate->options);
+	}
+	if (extra->asyncPrefs == NULL) {
+		sc_status = SCError();
+		CFRelease(snapshot);
+		if (signature != NULL) CFRelease(signature);
+		if (journalBase != NULL) CFRelease(journalBase);
+		completionsCall(completions, FALSE, sc_status);
+		return;
+	}
+	workerPrivate = (SCPreferencesPrivateRef)extra->asyncPrefs;
+	workerExtra = __SCPreferencesGetExtra(extra->asyncPrefs);
+	if (workerExtra == NULL) {
+		CFRelease(snapshot);
+		if (signature != NULL) CFRelease(signature);
+		if (journalBase != NULL) CFRelease(journalBase);
+		completionsCall(completions, FALSE, kSCStatusFailed);
+		return;
+	}
+	__SCPreferencesReleaseDocument(workerExtra);
+	if (workerPrivate->prefs != NULL) CFRelease(workerPrivate->prefs);
+	workerPrivate->prefs = CFDictionaryCreateMutableCopy(NULL, 0, snapshot);
+	if (workerPrivate->signature != NULL) CFRelease(workerPrivate->signature);
+	workerPrivate->signature = signature;
+	if (workerExtra->journalBase != NULL) CFRelease(workerExtra->journalBase);
+	workerExtra->journalBase = journalBase;
+	workerExtra->journalSize = journalSize;
+	workerPrivate->accessed = TRUE;
+	workerPrivate->changed = TRUE;
+
+	ok = _SCPreferencesCommitOptimistic(extra->asyncPrefs);
+	sc_status = SCError();
+
+	if (ok) {
+		// the session now reflects the committed preferences
+		pthread_mutex_lock(&prefsPrivate->lock);
+		if (prefsPrivate->signature != NULL) CFRelease(prefsPrivate->signature);
+		prefsPrivate->signature = CFRetain(workerPrivate->signature);
+		if (extra->journalBase != NULL) CFRelease(extra->journalBase);
+		extra->journalBase = CFRetain(workerExtra->journalBase);
+		extra->journalSize = workerExtra->journalSize;
+		if ((extra->asyncSnapshot == NULL) &&
+		    (prefsPrivate->prefs != NULL) &&
+		    CFEqual(prefsPrivate->prefs, snapshot)) {
+			// if not changed since the snapshot was taken
+			prefsPrivate->changed = FALSE;
+		}
+		pthread_mutex_unlock(&prefsPrivate->lock);
+	}
+
+	latencyAdd(__SCPreferencesStatsNow() - started);
+	CFRelease(snapshot);
+
+	completionsCall(completions, ok, sc_status);
+	return;
+}
+
+
+static Boolean
+asyncEnqueue(SCPreferencesRef prefs, dispatch_queue_t queue, SCPreferencesCompletionHandler handler, Boolean commit)
+{
+	completionRef		entry;
+	SCPreferencesExtraRef	extra;
+	completionRef		*last;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	Boolean			schedule;
+
+	if (prefsPrivate->authorizationData != NULL) {
+		// asynchronous commits are not supported via the helper
+		_SCErrorSet(kSCStatusAccessError);
+		return FALSE;
+	}
+
+	extra = __SCPreferencesGetExtra(prefs);
+	if (extra == NULL) {
+		_SCErrorSet(kSCStatusFailed);
+		return FALSE;
+	}
+
+	entry = CFAllocatorAllocate(NULL, sizeof(completion), 0);
+	memset(entry, 0, sizeof(completion));
+	if (handler != NULL) {
+		entry->queue = (queue != NULL) ? queue : dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+		dispatch_retain(entry->queue);
+		entry->handler = Block_copy(handler);
+	}
+
+	if (!commit) {
+		// apply, after any pending commit
+		CFRetain(prefs);
+		pthread_mutex_lock(&prefsPrivate->lock);
+		dispatch_async(asyncQueue(extra), ^{
+			Boolean		ok;
+			uint64_t	started;
+
+			started = __SCPreferencesStatsNow();
+			ok = SCPreferencesApplyChanges(prefs);
+			__SCPreferencesStatsAdd(prefs, kSCPStatApply, __SCPreferencesStatsNow() - started);
+			completionsCall(entry, ok, ok ? kSCStatusOK : SCError());
+			CFRelease(prefs);
+		});
+		pthread_mutex_unlock(&prefsPrivate->lock);
+		_SCErrorSet(kSCStatusOK);
+		return TRUE;
+	}
+
+	pthread_mutex_lock(&prefsPrivate->lock);
+
+	if (prefsPrivate->locked) {
+		Boolean		ok;
+		uint64_t	started;
+
+		// the worker would block on the lock we already hold; commit now
+		// (under the caller's lock), completing any pending requests too
+		if (extra->asyncSnapshot != NULL) {
+			CFRelease(extra->asyncSnapshot);
+			extra->asyncSnapshot = NULL;
+		}
+		for (last = &extra->asyncCompletions; *last != NULL; last = &(*last)->next) {
+			// find the end of the list
+		}
+		*last = entry;
+		entry = extra->asyncCompletions;
+		extra->asyncCompletions = NULL;
+		pthread_mutex_unlock(&prefsPrivate->lock);
+
+		started = __SCPreferencesStatsNow();
+		ok = _SCPreferencesCommitOptimistic(prefs);
+		latencyAdd(__SCPreferencesStatsNow() - started);
+		completionsCall(entry, ok, ok ? kSCStatusOK : SCError());
+		_SCErrorSet(kSCStatusOK);
+		return TRUE;
+	}
+
+	if (prefsPrivate->accessed && prefsPrivate->changed) {
+		// replace any pending snapshot (coalescing back-to-back commits)
+		if (extra->asyncSnapshot != NULL) CFRelease(extra->asyncSnapshot);
+		extra->asyncSnapshot = CFDictionaryCreateCopy(NULL, prefsPrivate->prefs);
+	}
+
+	for (last = &extra->asyncCompletions; *last != NULL; last = &(*last)->next) {
+		// find the end of the list
+	}
+	*last = entry;
+
+	schedule = !extra->asyncScheduled;
+	if (schedule) {
+		extra->asyncScheduled = TRUE;
+		extra->asyncRequested = __SCPreferencesStatsNow();
+		CFRetain(prefs);
+		dispatch_async(asyncQueue(extra), ^{
+			pthread_mutex_lock(&prefsPrivate->lock);
+			extra->asyncScheduled = FALSE;
+			pthread_mutex_unlock(&prefsPrivate->lock);
+
+			asyncCommit(prefs, extra);
+			CFRelease(prefs);
+		});
+	}
+
+	pthread_mutex_unlock(&prefsPrivate->lock);
+
+	_SCErrorSet(kSCStatusOK);
+	return TRUE;
+}
+
+
+/*
+ * _SCPreferencesCommitChangesAsync
+ *
+ * Commits the changes in the background; the handler is called on the
+ * given queue when done.  Commits requested before the worker gets to an
+ * earlier request are coalesced (the latest changes are written once).
+ * If the session holds the preferences lock the commit is done now, under
+ * that lock (the worker would otherwise wait for it).
+ */
+Boolean
+_SCPreferencesCommitChangesAsync(SCPreferencesRef			prefs,
+				 dispatch_queue_t			queue,
+				 SCPreferencesCompletionHandler		handler)
+{
+	return asyncEnqueue(prefs, queue, handler, TRUE);
+}
+
+
+/*
+ * _SCPreferencesApplyChangesAsync
+ *
+ * Requests that the preferences be applied (after any pending commit);
+ * the handler is called on the given queue when done.
+ */
+Boolean
+_SCPreferencesApplyChangesAsync(SCPreferencesRef			prefs,
+				dispatch_queue_t			queue,
+				SCPreferencesCompletionHandler		handler)
+{
+	return asyncEnqueue(prefs, queue, handler, FALSE);
+}
+
+
+__private_extern__ void
+__SCPreferencesAsyncRelease(SCPreferencesExtraRef extra)
+{
+	// no work is pending (each pending request holds a reference to the session)
+	if (extra->asyncPrefs != NULL)		CFRelease(extra->asyncPrefs);
+	if (extra->asyncSnapshot != NULL)	CFRelease(extra->asyncSnapshot);
+	if (extra->asyncQueue != NULL)		dispatch_release(extra->asyncQueue);
+	return;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: process-wide cache of parsed preferences files
+ */
+
+#include <pthread.h>
+
+#include "SCPreferencesInternal.h"
+
+
+/*
+ * Short-lived SCPreferences sessions are often created for the same file
+ * (e.g. NetworkInterfaces.plist, once per interface lookup).  Rather than
+ * reading and parsing the file each time, the parsed (immutable) property
+ * list is kept here, keyed by path and file signature.  A session that
+ * finds a matching entry starts with a [shallow] mutable copy of the
+ * cached dictionary; the values themselves are shared and, since changes
+ * replace (rather than modify) values, are never written to.
+ *
+ * A changed file has a new signature and simply misses.
+ */
+
+
+#define	N_CACHE_ENTRIES		8
+
+
+typedef struct {
+	char			*path;
+	CFDataRef		signature;
+	CFDictionaryRef		prefs;
+	CFPropertyListFormat	format;
+	uint64_t		lastUsed;
+} cacheEntry;
+
+
+static cacheEntry	cache[N_CACHE_ENTRIES];
+static uint64_t		cache_clock		= 0;
+static pthread_mutex_t	cache_lock		= PTHREAD_MUTEX_INITIALIZER;
+
+
+static void
+cacheEntryClear(cacheEntry *entry)
+{
+	if (entry->path != NULL)	free(entry->path);
+	if (entry->signature != NULL)	CFRelease(entry->signature);
+	if (entry->prefs != NULL)	CFRelease(entry->prefs);
+	memset(entry, 0, sizeof(*entry));
+	return;
+}
+
+
+/*
+ * __SCPreferencesCacheCopy
+ *
+ * Returns the cached preferences for the file at "path" if they were
+ * parsed from a file with the same signature.
+ */
+__private_extern__ CFDictionaryRef
+__SCPreferencesCacheCopy(const char *path, CFDataRef signature, CFPropertyListFormat *format)
+{
+	int		i;
+	CFDictionaryRef	prefs	= NULL;
+
+	pthread_mutex_lock(&cache_lock);
+	for (i = 0; i < N_CACHE_ENTRIES; i++) {
+		cacheEntry	*entry	= &cache[i];
+
+		if ((entry->path == NULL) || (strcmp(entry->path, path) != 0)) {
+			continue;
+		}
+
+		if (CFEqual(entry->signature, signature)) {
+			entry->lastUsed = ++cache_clock;
+			prefs = CFRetain(entry->prefs);
+			if (format != NULL) {
+				*format = entry->format;
+			}
+		} else {
+			// if the file has changed
+			cacheEntryClear(entry);
+		}
+		break;
+	}
+	pthread_mutex_unlock(&cache_lock);
+
+	return prefs;
+}
+
+
+/*
+ * __SCPreferencesCacheAdd
+ *
+ * Remembers the (immutable) preferences parsed from the file at "path".
+ */
+__private_extern__ void
+__SCPreferencesCacheAdd(const char *path, CFDataRef signature, CFDictionaryRef prefs, CFPropertyListFormat format)
+{
+	int		i;
+	cacheEntry	*entry	= NULL;
+
+	pthread_mutex_lock(&cache_lock);
+	for (i = 0; i < N_CACHE_ENTRIES; i++) {
+		if ((cache[i].path != NULL) && (strcmp(cache[i].path, path) == 0)) {
+			// replace the entry for this file
+			entry = &cache[i];
+			break;
+		}
+		if ((entry == NULL) ||
+		    ((entry->path != NULL) && ((cache[i].path == NULL) || (cache[i].lastUsed < entry->lastUsed)))) {
+			// an empty or the least recently used entry
+			entry = &cache[i];
+		}
+	}
+
+	cacheEntryClear(entry);
+	entry->path = strdup(path);
+	entry->signature = CFRetain(signature);
+	entry->prefs = CFRetain(prefs);
+	entry->format = format;
+	entry->lastUsed = ++cache_clock;
+	pthread_mutex_unlock(&cache_lock);
+
+	return;
+}
+
+
+void
+__SCPreferencesCacheFlush(void)
+{
+	int	i;
+
+	pthread_mutex_lock(&cache_lock);
+	for (i = 0; i < N_CACHE_ENTRIES; i++) {
+		cacheEntryClear(&cache[i]);
+	}
+	pthread_mutex_unlock(&cache_lock);
+
+	return;
+}
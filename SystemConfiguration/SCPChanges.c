@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: change sets published with commit notifications
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include "SCPreferencesInternal.h"
+
+
+/*
+ * When committing, the paths (down to the second level) that were added,
+ * removed or modified are published as the value of the "commit" session
+ * key, together with tokens identifying the state of the preferences
+ * before and after the commit :
+ *
+ *   {
+ *     Added    : [ "/key", "/key/subkey", ... ],
+ *     Removed  : [ ... ],
+ *     Modified : [ ... ],
+ *     Base     : <state before the commit>,
+ *     Token    : <state after the commit>,
+ *   }
+ *
+ * A state token is the file signature and the size of the journal.  A
+ * listener only trusts a change set if its "Token" is the current state
+ * (no commit, or a commit that did not publish a change set, has happened
+ * since) and its "Base" is the state the listener last saw.  Otherwise the
+ * changes are unknown and listeners should refresh everything.
+ *
+ * The value stays in the store, so a commit that changed more than
+ * N_CHANGES_MAX paths does not publish a change set (the key is only
+ * notified and listeners see unknown changes).
+ */
+
+
+#define	kChangesBase		CFSTR("Base")
+#define	kChangesToken		CFSTR("Token")
+
+#define	N_CHANGES_MAX		128
+
+
+static CFDataRef
+stateToken(CFDataRef signature, off_t journalSize)
+{
+	CFMutableDataRef	token;
+	int64_t			size	= (int64_t)journalSize;
+
+	token = CFDataCreateMutable(NULL, 0);
+	if (signature != NULL) {
+		CFDataAppendBytes(token, CFDataGetBytePtr(signature), CFDataGetLength(signature));
+	}
+	CFDataAppendBytes(token, (const UInt8 *)&size, sizeof(size));
+	return token;
+}
+
+
+static CFDataRef
+stateTokenFromFile(SCPreferencesPrivateRef prefsPrivate)
+{
+	char		*journal	= NULL;
+	off_t		journalSize	= 0;
+	CFDataRef	signature;
+	struct stat	statBuf;
+	CFDataRef	token;
+
+	if (stat(prefsPrivate->path, &statBuf) == -1) {
+		memset(&statBuf, 0, sizeof(statBuf));
+	}
+	signature = __SCPSignatureFromStatbuf(&statBuf);
+
+	if (asprintf(&journal, "%s.journal", prefsPrivate->path) != -1) {
+		if (stat(journal, &statBuf) == 0) {
+			journalSize = statBuf.st_size;
+		}
+		free(journal);
+	}
+
+	token = stateToken(signature, journalSize);
+	CFRelease(signature);
+	return token;
+}
+
+
+static Boolean
+tokenEqual(CFTypeRef token1, CFDataRef token2)
+{
+	return isA_CFData(token1) && CFEqual(token1, token2);
+}
+
+
+static void
+changesAppendPath(CFMutableArrayRef paths, CFStringRef parent, CFStringRef key)
+{
+	CFStringRef	path;
+
+	if (parent != NULL) {
+		path = CFStringCreateWithFormat(NULL, NULL, CFSTR("/%@/%@"), parent, key);
+	} else {
+		path = CFStringCreateWithFormat(NULL, NULL, CFSTR("/%@"), key);
+	}
+	CFArrayAppendValue(paths, path);
+	CFRelease(path);
+	return;
+}
+
+
+static void
+changesDiff(CFDictionaryRef		before,
+	    CFDictionaryRef		after,
+	    CFStringRef			parent,
+	    CFMutableArrayRef		added,
+	    CFMutableArrayRef		removed,
+	    CFMutableArrayRef		modified)
+{
+	CFIndex		i;
+	const void	**keys;
+	CFIndex		n;
+	CFIndex		nAfter;
+	CFIndex		nBefore;
+
+	nAfter = CFDictionaryGetCount(after);
+	nBefore = CFDictionaryGetCount(before);
+	n = nAfter + nBefore;
+	keys = CFAllocatorAllocate(NULL, (n + 1) * sizeof(CFTypeRef), 0);
+	CFDictionaryGetKeysAndValues(after, keys, NULL);
+	CFDictionaryGetKeysAndValues(before, keys + nAfter, NULL);
+
+	for (i = 0; i < n; i++) {
+		CFStringRef	key		= keys[i];
+		CFTypeRef	newValue	= CFDictionaryGetValue(after, key);
+		CFTypeRef	oldValue	= CFDictionaryGetValue(before, key);
+
+		if (!isA_CFString(key)) {
+			continue;
+		}
+
+		if (oldValue == NULL) {
+			changesAppendPath(added, parent, key);
+		} else if (newValue == NULL) {
+			changesAppendPath(removed, parent, key);
+		} else if (i >= nAfter) {
+			// if already handled
+			continue;
+		} else if ((oldValue != newValue) && !CFEqual(oldValue, newValue)) {
+			changesAppendPath(modified, parent, key);
+			if ((parent == NULL) && isA_CFDictionary(oldValue) && isA_CFDictionary(newValue)) {
+				// and report which second-level entries changed
+				changesDiff(oldValue, newValue, key, added, removed, modified);
+			}
+		}
+	}
+
+	CFAllocatorDeallocate(NULL, keys);
+	return;
+}
+
+
+/*
+ * __SCPreferencesCreateChanges
+ *
+ * Returns the paths added, removed and modified between "before" and
+ * "after".
+ */
+__private_extern__ CFDictionaryRef
+__SCPreferencesCreateChanges(CFDictionaryRef before, CFDictionaryRef after)
+{
+	CFMutableArrayRef	added;
+	CFMutableDictionaryRef	changes;
+	CFMutableArrayRef	modified;
+	CFMutableArrayRef	removed;
+
+	added    = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	removed  = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	modified = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+
+	if ((before != NULL) && (after != NULL)) {
+		changesDiff(before, after, NULL, added, removed, modified);
+	} else if (after != NULL) {
+		CFDictionaryRef	empty;
+
+		empty = CFDictionaryCreate(NULL, NULL, NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+		changesDiff(empty, after, NULL, added, removed, modified);
+		CFRelease(empty);
+	}
+
+	changes = CFDictionaryCreateMutable(NULL,
+					    0,
+					    &kCFTypeDictionaryKeyCallBacks,
+					    &kCFTypeDictionaryValueCallBacks);
+	CFDictionarySetValue(changes, kSCPreferencesChangesAdded,    added);
+	CFDictionarySetValue(changes, kSCPreferencesChangesRemoved,  removed);
+	CFDictionarySetValue(changes, kSCPreferencesChangesModified, modified);
+	CFRelease(added);
+	CFRelease(removed);
+	CFRelease(modified);
+
+	return changes;
+}
+
+
+static void
+notifyCommit(SCPreferencesRef prefs, CFDictionaryRef before, CFDataRef beforeToken)
+{
+	CFMutableDictionaryRef	changes;
+	SCPreferencesExtraRef	extra;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	CFIndex			n;
+	CFDataRef		token;
+
+	changes = (CFMutableDictionaryRef)__SCPreferencesCreateChanges(before, prefsPrivate->prefs);
+	n = CFArrayGetCount(CFDictionaryGetValue(changes, kSCPreferencesChangesAdded)) +
+	    CFArrayGetCount(CFDictionaryGetValue(changes, kSCPreferencesChangesRemoved)) +
+	    CFArrayGetCount(CFDictionaryGetValue(changes, kSCPreferencesChangesModified));
+	extra = __SCPreferencesGetExtra(prefs);
+	token = stateToken(prefsPrivate->signature, (extra != NULL) ? extra->journalSize : 0);
+	CFDictionarySetValue(changes, kChangesBase, beforeToken);
+	CFDictionarySetValue(changes, kChangesToken, token);
+	CFRelease(token);
+
+	__SCPreferencesAddSessionKeys(prefs);
+	if ((n > N_CHANGES_MAX) ||
+	    !SCDynamicStoreSetValue(NULL, prefsPrivate->sessionKeyCommit, changes)) {
+		// if too many changes to publish (or could not publish)
+		(void) SCDynamicStoreNotifyValue(NULL, prefsPrivate->sessionKeyCommit);
+	}
+	CFRelease(changes);
+
+	return;
+}
+
+
+/*
+ * __SCPreferencesCommitted
+ *
+ * Updates the session after its changes have been written (to the file
+ * or the journal) and posts the "commit" notification along with the
+ * set of paths that were changed.
+ */
+__private_extern__ void
+__SCPreferencesCommitted(SCPreferencesRef prefs, off_t journalSize)
+{
+	CFDictionaryRef		before		= NULL;
+	CFDataRef		beforeToken;
+	SCPreferencesExtraRef	extra;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	struct stat		statBuf;
+
+	extra = __SCPreferencesGetExtra(prefs);
+	if (extra != NULL) {
+		before = extra->journalBase;
+		extra->journalBase = NULL;
+	}
+	beforeToken = stateToken(prefsPrivate->signature, (extra != NULL) ? extra->journalSize : 0);
+
+	// update signature
+	if (stat(prefsPrivate->path, &statBuf) == -1) {
+		memset(&statBuf, 0, sizeof(statBuf));
+	}
+	if (prefsPrivate->signature != NULL) CFRelease(prefsPrivate->signature);
+	prefsPrivate->signature = __SCPSignatureFromStatbuf(&statBuf);
+
+	if (extra != NULL) {
+		extra->journalBase = CFDictionaryCreateCopy(NULL, prefsPrivate->prefs);
+		extra->journalSize = journalSize;
+	}
+	prefsPrivate->changed = FALSE;
+
+	// post notification
+	notifyCommit(prefs, before, beforeToken);
+
+	if (before != NULL) CFRelease(before);
+	CFRelease(beforeToken);
+	return;
+}
+
+
+/*
+ * __SCPreferencesCopyNotifiedChanges
+ *
+ * Returns the change set published with a "commit" notification, NULL if
+ * the changes are not known.
+ */
+__private_extern__ CFDictionaryRef
+__SCPreferencesCopyNotifiedChanges(SCPreferencesRef prefs, SCDynamicStoreRef store)
+{
+	CFDictionaryRef		changes;
+	CFDataRef		current;
+	SCPreferencesExtraRef	extra;
+	CFDataRef		lastToken;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+
+	extra = __SCPreferencesGetExtra(prefs);
+	if (extra == NULL) {
+		return NULL;
+	}
+
+	current = stateTokenFromFile(prefsPrivate);
+	lastToken = extra->changesToken;
+	extra->changesToken = current;
+
+	changes = SCDynamicStoreCopyValue(store, prefsPrivate->sessionKeyCommit);
+	if (!isA_CFDictionary(changes) ||
+	    !tokenEqual(CFDictionaryGetValue(changes, kChangesToken), current) ||
+	    ((lastToken != NULL) && !tokenEqual(CFDictionaryGetValue(changes, kChangesBase), lastToken)) ||
+	    !isA_CFArray(CFDictionaryGetValue(changes, kSCPreferencesChangesAdded)) ||
+	    !isA_CFArray(CFDictionaryGetValue(changes, kSCPreferencesChangesRemoved)) ||
+	    !isA_CFArray(CFDictionaryGetValue(changes, kSCPreferencesChangesModified))) {
+		// if the change set is not for this (the latest) commit
+		if (changes != NULL) CFRelease(changes);
+		changes = NULL;
+	}
+
+	if (lastToken != NULL) CFRelease(lastToken);
+	return changes;
+}
+
+
+#pragma mark -
+#pragma mark Change set query
+
+
+/*
+ * _SCPreferencesGetChanges
+ *
+ * Returns the paths added, removed and modified by the commit being
+ * reported to the SCPreferences callback, NULL if not known.
+ */
+CFDictionaryRef
+_SCPreferencesGetChanges(SCPreferencesRef prefs)
+{
+	SCPreferencesExtraRef	extra;
+
+	extra = __SCPreferencesGetExtra(prefs);
+	return (extra != NULL) ? extra->changes : NULL;
+}
+
+
+static Boolean
+pathOverlaps(CFStringRef path1, CFStringRef path2)
+{
+	CFIndex		len1	= CFStringGetLength(path1);
+	CFIndex		len2	= CFStringGetLength(path2);
+	CFStringRef	longer	= (len1 > len2) ? path1 : path2;
+	CFIndex		n	= (len1 > len2) ? len2 : len1;
+	CFStringRef	shorter	= (len1 > len2) ? path2 : path1;
+
+	if (!CFStringHasPrefix(longer, shorter)) {
+		return FALSE;
+	}
+
+	// a path overlaps its ancestors and descendants
+	return (len1 == len2) ||
+	       CFStringHasSuffix(shorter, CFSTR("/")) ||
+	       (CFStringGetCharacterAtIndex(longer, n) == '/');
+}
+
+
+/*
+ * _SCPreferencesPathChanged
+ *
+ * Returns TRUE if the commit being reported to the SCPreferences callback
+ * changed the given path, a path below it or a path above it (or if the
+ * changes are not known).  "/" matches any change.
+ */
+Boolean
+_SCPreferencesPathChanged(SCPreferencesRef prefs, CFStringRef path)
+{
+	CFDictionaryRef		changes;
+	CFStringRef		kinds[]		= { kSCPreferencesChangesAdded,
+						    kSCPreferencesChangesRemoved,
+						    kSCPreferencesChangesModified };
+	int			k;
+
+	changes = _SCPreferencesGetChanges(prefs);
+	if (changes == NULL) {
+		// if the changes are not known
+		return TRUE;
+	}
+
+	for (k = 0; k < (int)(sizeof(kinds) / sizeof(kinds[0])); k++) {
+		CFArrayRef	paths	= CFDictionaryGetValue(changes, kinds[k]);
+		CFIndex		i;
+		CFIndex		n;
+
+		n = CFArrayGetCount(paths);
+		for (i = 0; i < n; i++) {
+			if (pathOverlaps(path, CFArrayGetValueAtIndex(paths, i))) {
+				return TRUE;
+			}
+		}
+	}
+
+	return FALSE;
+}
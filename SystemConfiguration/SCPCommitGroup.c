@@ -0,0 +1,553 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: grouped commit of parent and companion preferences
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include "SCPreferencesInternal.h"
+
+
+/*
+ * A grouped commit writes the changed preferences of a parent and its
+ * companions (e.g. preferences.plist and NetworkInterfaces.plist) as a
+ * unit :
+ *
+ *   1. each new file is written to "<file>-group-new", followed by a
+ *      write barrier (rather than a full sync)
+ *   2. the list of renames to be done is written to "<parent file>.commit"
+ *      and that file is fully synced; this single sync makes everything
+ *      written so far durable and is the commit point
+ *   3. the new files are renamed into place
+ *   4. the directory is synced and the "<parent file>.commit" file is
+ *      removed
+ *
+ * A grouped commit always holds the parent's lock (even if the parent
+ * itself was not changed).  Should we crash between 2. and 4., the renames
+ * are completed (rolled forward) by the next grouped commit or when the
+ * parent or a companion is accessed while holding the parent's lock; a
+ * "-group-new" file is never renamed into place while another process may
+ * still be writing it.  Before 2. nothing has changed.
+ */
+
+
+#define	GROUP_NEW_SUFFIX	"-group-new"
+#define	GROUP_COMMIT_SUFFIX	".commit"
+
+
+static char *
+groupCommitPath(SCPreferencesPrivateRef parentPrivate)
+{
+	char	*path	= NULL;
+
+	if (asprintf(&path, "%s" GROUP_COMMIT_SUFFIX, parentPrivate->path) == -1) {
+		return NULL;
+	}
+	return path;
+}
+
+
+static Boolean
+fileBarrier(int fd)
+{
+#ifdef	F_BARRIERFSYNC
+	if (fcntl(fd, F_BARRIERFSYNC) == 0) {
+		return TRUE;
+	}
+#endif	// F_BARRIERFSYNC
+	return (fsync(fd) == 0);
+}
+
+
+static Boolean
+fileSync(int fd)
+{
+#ifdef	F_FULLFSYNC
+	if (fcntl(fd, F_FULLFSYNC) == 0) {
+		return TRUE;
+	}
+#endif	// F_FULLFSYNC
+	return (fsync(fd) == 0);
+}
+
+
+static Boolean
+groupSyncDirectory(const char *path)
+{
+	char		dir[MAXPATHLEN];
+	int		fd;
+	Boolean		ok;
+	const char	*slash;
+
+	slash = strrchr(path, '/');
+	if (slash == NULL) {
+		strlcpy(dir, ".", sizeof(dir));
+	} else if (slash == path) {
+		strlcpy(dir, "/", sizeof(dir));
+	} else {
+		snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+	}
+
+	fd = open(dir, O_RDONLY, 0);
+	if (fd == -1) {
+		SC_log(LOG_NOTICE, "open() failed: %s", strerror(errno));
+		return FALSE;
+	}
+	ok = fileSync(fd);
+	(void) close(fd);
+
+	return ok;
+}
+
+
+static Boolean
+groupWriteFile(SCPreferencesRef prefs, const char *path, CFDataRef data, const char *like, Boolean sync)
+{
+	int		fd;
+	Boolean		ok;
+	uint64_t	started;
+	struct stat	statBuf;
+
+	if ((like == NULL) || (stat(like, &statBuf) == -1)) {
+		memset(&statBuf, 0, sizeof(statBuf));
+		statBuf.st_mode = 0644;
+		statBuf.st_uid = geteuid();
+		statBuf.st_gid = getegid();
+	}
+
+	(void) unlink(path);
+	fd = open(path, O_WRONLY|O_CREAT|O_EXCL, statBuf.st_mode & 07777);
+	if (fd == -1) {
+		SC_log(LOG_NOTICE, "open() failed: %s", strerror(errno));
+		return FALSE;
+	}
+	(void) fchown(fd, statBuf.st_uid, statBuf.st_gid);
+	ok = (write(fd, CFDataGetBytePtr(data), CFDataGetLength(data)) == CFDataGetLength(data));
+	if (ok) {
+		started = __SCPreferencesStatsNow();
+		ok = sync ? fileSync(fd) : fileBarrier(fd);
+		__SCPreferencesStatsAdd(prefs, kSCPStatSync, __SCPreferencesStatsNow() - started);
+	}
+	if (ok) {
+		__SCPreferencesStatsAdd(prefs, kSCPStatBytesWritten, (uint64_t)CFDataGetLength(data));
+	} else {
+		SC_log(LOG_NOTICE, "write() failed: %s", strerror(errno));
+		(void) unlink(path);
+	}
+	(void) close(fd);
+
+	return ok;
+}
+
+
+/*
+ * groupRename
+ * - completes the renames listed in a ".commit" file; a new file that no
+ *   longer exists has already been renamed
+ */
+static Boolean
+groupRename(CFArrayRef renames)
+{
+	CFIndex		i;
+	CFIndex		n;
+	Boolean		ok	= TRUE;
+
+	n = CFArrayGetCount(renames);
+	for (i = 0; i + 1 < n; i += 2) {
+		char	newPath[MAXPATHLEN];
+		char	path[MAXPATHLEN];
+
+		if (!_SC_cfstring_to_cstring(CFArrayGetValueAtIndex(renames, i), newPath, sizeof(newPath), kCFStringEncodingUTF8) ||
+		    !_SC_cfstring_to_cstring(CFArrayGetValueAtIndex(renames, i + 1), path, sizeof(path), kCFStringEncodingUTF8)) {
+			ok = FALSE;
+			continue;
+		}
+		if ((rename(newPath, path) == -1) && (errno != ENOENT)) {
+			SC_log(LOG_NOTICE, "rename() failed: %s", strerror(errno));
+			ok = FALSE;
+		}
+	}
+
+	return ok;
+}
+
+
+static CFArrayRef
+groupCopyRenames(const char *commitPath)
+{
+	UInt8		*bytes;
+	CFDataRef	data;
+	int		fd;
+	CFArrayRef	renames	= NULL;
+	struct stat	statBuf;
+
+	fd = open(commitPath, O_RDONLY, 0);
+	if (fd == -1) {
+		return NULL;
+	}
+	if ((fstat(fd, &statBuf) == -1) || (statBuf.st_size == 0)) {
+		(void) close(fd);
+		return NULL;
+	}
+
+	bytes = CFAllocatorAllocate(NULL, (CFIndex)statBuf.st_size, 0);
+	if (read(fd, bytes, (size_t)statBuf.st_size) == statBuf.st_size) {
+		data = CFDataCreateWithBytesNoCopy(NULL, bytes, (CFIndex)statBuf.st_size, kCFAllocatorNull);
+		renames = CFPropertyListCreateWithData(NULL, data, kCFPropertyListImmutable, NULL, NULL);
+		CFRelease(data);
+		if ((renames != NULL) && !isA_CFArray(renames)) {
+			CFRelease(renames);
+			renames = NULL;
+		}
+	}
+	CFAllocatorDeallocate(NULL, bytes);
+	(void) close(fd);
+
+	return renames;
+}
+
+
+/*
+ * groupRecover
+ * - completes an interrupted grouped commit, returning TRUE if the
+ *   preferences were changed; must be called with the parent's lock held
+ */
+static Boolean
+groupRecover(SCPreferencesPrivateRef parentPrivate)
+{
+	char		*commitPath;
+	CFArrayRef	renames;
+	struct stat	statBuf;
+
+	commitPath = groupCommitPath(parentPrivate);
+	if (commitPath == NULL) {
+		return FALSE;
+	}
+	if (stat(commitPath, &statBuf) == -1) {
+		// if no interrupted commit
+		free(commitPath);
+		return FALSE;
+	}
+
+	renames = groupCopyRenames(commitPath);
+	if (renames != NULL) {
+		SC_log(LOG_NOTICE, "SCPreferences() completing interrupted commit: %s", commitPath);
+		if (groupRename(renames) && groupSyncDirectory(commitPath)) {
+			(void) unlink(commitPath);
+		}
+		CFRelease(renames);
+	}
+	free(commitPath);
+	return TRUE;
+}
+
+
+/*
+ * __SCPreferencesGroupRecover
+ *
+ * Completes a grouped commit that was interrupted after its commit point.
+ * This is only done while the parent's lock is held (otherwise the next
+ * grouped commit will).
+ */
+__private_extern__ void
+__SCPreferencesGroupRecover(SCPreferencesRef prefs)
+{
+	SCPreferencesPrivateRef	parentPrivate;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+
+	parentPrivate = (prefsPrivate->parent != NULL) ? (SCPreferencesPrivateRef)prefsPrivate->parent
+						       : prefsPrivate;
+	if (!parentPrivate->locked) {
+		return;
+	}
+
+	(void) groupRecover(parentPrivate);
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Commit
+
+
+static Boolean
+groupSameDirectory(const char *path1, const char *path2)
+{
+	const char	*slash1	= strrchr(path1, '/');
+	const char	*slash2	= strrchr(path2, '/');
+
+	if ((slash1 == NULL) || (slash2 == NULL)) {
+		return (slash1 == slash2);
+	}
+	return ((slash1 - path1) == (slash2 - path2)) && (strncmp(path1, path2, slash1 - path1) == 0);
+}
+
+
+static CFComparisonResult
+groupComparePaths(const void *val1, const void *val2, void *context)
+{
+#pragma unused(context)
+	SCPreferencesPrivateRef	prefsPrivate1	= (SCPreferencesPrivateRef)val1;
+	SCPreferencesPrivateRef	prefsPrivate2	= (SCPreferencesPrivateRef)val2;
+	int			result;
+
+	result = strcmp(prefsPrivate1->path, prefsPrivate2->path);
+	return (result < 0) ? kCFCompareLessThan : ((result > 0) ? kCFCompareGreaterThan : kCFCompareEqualTo);
+}
+
+
+static CFArrayRef
+groupCopyMembers(SCPreferencesPrivateRef parentPrivate)
+{
+	CFMutableArrayRef	members;
+
+	// (the parent, changed or not, is always locked)
+	members = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	CFArrayAppendValue(members, parentPrivate);
+
+	pthread_mutex_lock(&parentPrivate->lock);
+	if (parentPrivate->companions != NULL) {
+		CFIndex		i;
+		CFIndex		n;
+		const void	**values;
+
+		n = CFDictionaryGetCount(parentPrivate->companions);
+		values = CFAllocatorAllocate(NULL, (n + 1) * sizeof(CFTypeRef), 0);
+		CFDictionaryGetKeysAndValues(parentPrivate->companions, NULL, values);
+		for (i = 0; i < n; i++) {
+			SCPreferencesPrivateRef	companionPrivate	= (SCPreferencesPrivateRef)values[i];
+
+			if (companionPrivate->accessed && companionPrivate->changed) {
+				CFArrayAppendValue(members, companionPrivate);
+			}
+		}
+		CFAllocatorDeallocate(NULL, values);
+	}
+	pthread_mutex_unlock(&parentPrivate->lock);
+
+	// lock in a consistent order
+	CFArraySortValues(members, CFRangeMake(0, CFArrayGetCount(members)), groupComparePaths, NULL);
+	return members;
+}
+
+
+/*
+ * _SCPreferencesCommitGroup
+ *
+ * Commits the changes made to the preferences and to their parent and
+ * companions as a unit.
+ */
+Boolean
+_SCPreferencesCommitGroup(SCPreferencesRef prefs)
+{
+	char			*commitPath	= NULL;
+	Boolean			committed	= FALSE;
+	CFIndex			i;
+	CFArrayRef		members;
+	CFIndex			n;
+	CFIndex			nLocked		= 0;
+	Boolean			ok		= FALSE;
+	int			parentLockFD	= -1;
+	SCPreferencesPrivateRef	parentPrivate;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	CFMutableArrayRef	renames		= NULL;
+	int			sc_status	= kSCStatusFailed;
+	uint64_t		started;
+	Boolean			*wasLocked;
+
+	started = __SCPreferencesStatsNow();
+
+	parentPrivate = (prefsPrivate->parent != NULL) ? (SCPreferencesPrivateRef)prefsPrivate->parent
+						       : prefsPrivate;
+	members = groupCopyMembers(parentPrivate);
+	n = CFArrayGetCount(members);
+	if ((n == 1) && (!parentPrivate->accessed || !parentPrivate->changed)) {
+		// if no changes
+		CFRelease(members);
+		_SCErrorSet(kSCStatusOK);
+		return TRUE;
+	}
+	wasLocked = CFAllocatorAllocate(NULL, n * sizeof(Boolean), 0);
+
+	for (i = 0; i < n; i++) {
+		SCPreferencesPrivateRef	memberPrivate	= (SCPreferencesPrivateRef)CFArrayGetValueAtIndex(members, i);
+
+		if (memberPrivate->authorizationData != NULL) {
+			// grouped commits are not supported via the helper
+			sc_status = kSCStatusAccessError;
+			goto done;
+		}
+
+		// the renames are recorded next to (and recovered with) the parent
+		if (!groupSameDirectory(memberPrivate->path, parentPrivate->path)) {
+			SC_log(LOG_NOTICE, "SCPreferences() grouped commit: \"%s\" not with \"%s\"",
+			       memberPrivate->path,
+			       parentPrivate->path);
+			sc_status = kSCStatusInvalidArgument;
+			goto done;
+		}
+	}
+
+	// lock (and check that nobody else has committed since we read)
+	for (i = 0; i < n; i++) {
+		SCPreferencesRef	member	= (SCPreferencesRef)CFArrayGetValueAtIndex(members, i);
+
+		SCPreferencesPrivateRef	memberPrivate	= (SCPreferencesPrivateRef)member;
+
+		wasLocked[i] = memberPrivate->locked;
+		if (wasLocked[i]) {
+			// if already locked
+		} else if (!memberPrivate->accessed || !memberPrivate->changed) {
+			// the (unchanged) parent; take the lock file without
+			// checking the session for changes by others
+			wasLocked[i] = TRUE;
+			parentLockFD = __SCPreferencesLockFileOpen(member);
+			if (parentLockFD == -1) {
+				goto done;
+			}
+		} else if (!__SCPreferencesLockTimed(member, TRUE)) {
+			sc_status = SCError();
+			goto done;
+		}
+		nLocked++;
+	}
+
+	// complete any earlier, interrupted, grouped commit (which leaves
+	// what we read out of date)
+	if (groupRecover(parentPrivate)) {
+		sc_status = kSCStatusStale;
+		goto done;
+	}
+
+	// write the new files
+	renames = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	for (i = 0; i < n; i++) {
+		CFDataRef		data;
+		SCPreferencesPrivateRef	memberPrivate	= (SCPreferencesPrivateRef)CFArrayGetValueAtIndex(members, i);
+		char			newPath[MAXPATHLEN];
+		CFStringRef		str;
+
+		if (!memberPrivate->accessed || !memberPrivate->changed) {
+			continue;
+		}
+
+		data = __SCPreferencesCreateData((SCPreferencesRef)memberPrivate);
+		if (data == NULL) {
+			goto done;
+		}
+		snprintf(newPath, sizeof(newPath), "%s" GROUP_NEW_SUFFIX, memberPrivate->path);
+		ok = groupWriteFile((SCPreferencesRef)memberPrivate, newPath, data, memberPrivate->path, FALSE);
+		CFRelease(data);
+		if (!ok) {
+			goto done;
+		}
+
+		str = CFStringCreateWithCString(NULL, newPath, kCFStringEncodingUTF8);
+		CFArrayAppendValue(renames, str);
+		CFRelease(str);
+		str = CFStringCreateWithCString(NULL, memberPrivate->path, kCFStringEncodingUTF8);
+		CFArrayAppendValue(renames, str);
+		CFRelease(str);
+	}
+	ok = FALSE;
+
+	if (CFArrayGetCount(renames) > 0) {
+		CFDataRef	data;
+
+		// commit point
+		commitPath = groupCommitPath(parentPrivate);
+		data = CFPropertyListCreateData(NULL, renames, kCFPropertyListBinaryFormat_v1_0, 0, NULL);
+		if ((commitPath == NULL) || (data == NULL) || !groupWriteFile(prefs, commitPath, data, NULL, TRUE)) {
+			if (data != NULL) CFRelease(data);
+			goto done;
+		}
+		CFRelease(data);
+		committed = TRUE;
+
+		if (!groupRename(renames) || !groupSyncDirectory(commitPath)) {
+			// leave the ".commit" file for recovery
+			goto done;
+		}
+		(void) unlink(commitPath);
+	}
+
+	// update the sessions
+	for (i = 0; i < n; i++) {
+		SCPreferencesRef	member		= (SCPreferencesRef)CFArrayGetValueAtIndex(members, i);
+		SCPreferencesPrivateRef	memberPrivate	= (SCPreferencesPrivateRef)member;
+
+		if (!memberPrivate->accessed || !memberPrivate->changed) {
+			continue;
+		}
+
+		__SCPreferencesCommitted(member, 0);
+	}
+
+	__SCPreferencesStatsAdd(prefs, kSCPStatCommit, __SCPreferencesStatsNow() - started);
+
+	SC_log(LOG_INFO, "SCPreferences() grouped commit: %s, %ld file(s)",
+	       parentPrivate->path,
+	       (long)(CFArrayGetCount(renames) / 2));
+
+	sc_status = kSCStatusOK;
+	ok = TRUE;
+
+    done :
+
+	if (!committed && (renames != NULL)) {
+		// if we did not get to the commit point, clean up
+		for (i = 0; i < CFArrayGetCount(renames); i += 2) {
+			char	newPath[MAXPATHLEN];
+
+			if (_SC_cfstring_to_cstring(CFArrayGetValueAtIndex(renames, i), newPath, sizeof(newPath), kCFStringEncodingUTF8)) {
+				(void) unlink(newPath);
+			}
+		}
+	}
+	for (i = 0; i < nLocked; i++) {
+		if (!wasLocked[i]) {
+			(void) SCPreferencesUnlock((SCPreferencesRef)CFArrayGetValueAtIndex(members, i));
+		}
+	}
+	if (parentLockFD != -1) {
+		(void) flock(parentLockFD, LOCK_UN);
+		(void) close(parentLockFD);
+	}
+	if (commitPath != NULL) free(commitPath);
+	if (renames != NULL) CFRelease(renames);
+	CFAllocatorDeallocate(NULL, wasLocked);
+	CFRelease(members);
+
+	_SCErrorSet(sc_status);
+	return ok;
+}
@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: optimistic (compare-and-swap) preferences commits
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include "SCPreferencesInternal.h"
+
+
+/*
+ * An optimistic writer reads (and changes) the preferences without taking
+ * the preferences lock.  Only when committing is the lock file held, and
+ * only long enough to check that the preferences have not been changed
+ * since they were read (the file signature and journal) and to rename the
+ * [already written and synced] new file into place.  If they have been
+ * changed, the commit fails with kSCStatusStale and the writer can call
+ * _SCPreferencesRebase() to re-apply its changes to the current
+ * preferences and try again.
+ *
+ * Readers never take the lock; the file is only ever replaced (renamed)
+ * so they always see a complete configuration.
+ */
+
+
+/*
+ * __SCPreferencesLockFileOpen
+ * - opens (and takes) the preferences lock file, returning the descriptor
+ *   to be closed (after LOCK_UN) when done; the session is not marked as
+ *   locked
+ */
+__private_extern__ int
+__SCPreferencesLockFileOpen(SCPreferencesRef prefs)
+{
+	int			fd;
+	char			*lockPath	= NULL;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	struct stat		statBuf;
+	struct stat		statBuf2;
+
+	if (asprintf(&lockPath, "%s-lock", prefsPrivate->path) == -1) {
+		return -1;
+	}
+
+	while (TRUE) {
+		fd = open(lockPath, O_WRONLY|O_CREAT, 0644);
+		if (fd == -1) {
+			SC_log(LOG_NOTICE, "open() failed: %s", strerror(errno));
+			break;
+		}
+		if (flock(fd, LOCK_EX) == -1) {
+			SC_log(LOG_NOTICE, "flock() failed: %s", strerror(errno));
+			(void) close(fd);
+			fd = -1;
+			break;
+		}
+
+		// the lock file is removed when an SCPreferencesLock() holder
+		// unlocks; make sure that we hold the lock on the current file
+		if ((fstat(fd, &statBuf) == 0) &&
+		    (stat(lockPath, &statBuf2) == 0) &&
+		    (statBuf.st_dev == statBuf2.st_dev) &&
+		    (statBuf.st_ino == statBuf2.st_ino)) {
+			break;
+		}
+		(void) close(fd);
+	}
+
+	free(lockPath);
+	return fd;
+}
+
+
+static int
+newFileWrite(SCPreferencesPrivateRef prefsPrivate, CFDataRef data, char **newPath)
+{
+	int		fd;
+	struct stat	statBuf;
+
+	if (stat(prefsPrivate->path, &statBuf) == -1) {
+		memset(&statBuf, 0, sizeof(statBuf));
+		statBuf.st_mode = 0644;
+		statBuf.st_uid = geteuid();
+		statBuf.st_gid = getegid();
+	}
+
+	if (asprintf(newPath, "%s-%d-new", prefsPrivate->path, getpid()) == -1) {
+		*newPath = NULL;
+		return kSCStatusFailed;
+	}
+	(void) unlink(*newPath);
+	fd = open(*newPath, O_WRONLY|O_CREAT|O_EXCL, statBuf.st_mode & 07777);
+	if (fd == -1) {
+		SC_log(LOG_NOTICE, "open() failed: %s", strerror(errno));
+		return (errno == EACCES) ? kSCStatusAccessError : kSCStatusFailed;
+	}
+	(void) fchown(fd, statBuf.st_uid, statBuf.st_gid);
+	if ((write(fd, CFDataGetBytePtr(data), CFDataGetLength(data)) != CFDataGetLength(data)) ||
+	    (__SCPreferencesSyncTimed((SCPreferencesRef)prefsPrivate, fd) == -1)) {
+		SC_log(LOG_NOTICE, "write() failed: %s", strerror(errno));
+		(void) close(fd);
+		(void) unlink(*newPath);
+		return kSCStatusFailed;
+	}
+	(void) close(fd);
+	__SCPreferencesStatsAdd((SCPreferencesRef)prefsPrivate, kSCPStatBytesWritten, (uint64_t)CFDataGetLength(data));
+
+	return kSCStatusOK;
+}
+
+
+/*
+ * _SCPreferencesCommitOptimistic
+ *
+ * Commits the changes if (and only if) nobody else has committed since
+ * the preferences were read.
+ */
+Boolean
+_SCPreferencesCommitOptimistic(SCPreferencesRef prefs)
+{
+	CFDataRef		data		= NULL;
+	char			*journal	= NULL;
+	uint64_t		locked		= 0;
+	int			lockFD		= -1;
+	char			*newPath	= NULL;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	int			sc_status	= kSCStatusFailed;
+	uint64_t		started;
+
+	started = __SCPreferencesStatsNow();
+
+	if (prefsPrivate->authorizationData != NULL) {
+		// optimistic commits are not supported via the helper
+		_SCErrorSet(kSCStatusAccessError);
+		return FALSE;
+	}
+
+	if (!prefsPrivate->accessed || !prefsPrivate->changed) {
+		// if no changes
+		_SCErrorSet(kSCStatusOK);
+		return TRUE;
+	}
+
+	// serialize, write and sync the new file before taking the lock
+	data = __SCPreferencesCreateData(prefs);
+	if (data == NULL) {
+		goto done;
+	}
+	sc_status = newFileWrite(prefsPrivate, data, &newPath);
+	if (sc_status != kSCStatusOK) {
+		goto done;
+	}
+
+	if (!prefsPrivate->locked) {
+		uint64_t	waiting;
+
+		waiting = __SCPreferencesStatsNow();
+		lockFD = __SCPreferencesLockFileOpen(prefs);
+		if (lockFD == -1) {
+			sc_status = kSCStatusFailed;
+			goto done;
+		}
+		locked = __SCPreferencesStatsNow();
+		__SCPreferencesStatsAdd(prefs, kSCPStatLockWait, locked - waiting);
+	}
+
+	if (!__SCPreferencesIsCurrent(prefs)) {
+		// if others have committed since we read the preferences
+		sc_status = kSCStatusStale;
+		goto done;
+	}
+
+	if (rename(newPath, prefsPrivate->path) == -1) {
+		SC_log(LOG_NOTICE, "rename() failed: %s", strerror(errno));
+		sc_status = kSCStatusFailed;
+		goto done;
+	}
+	free(newPath);
+	newPath = NULL;
+
+	// any journaled changes are now part of the file
+	if (asprintf(&journal, "%s.journal", prefsPrivate->path) != -1) {
+		(void) unlink(journal);
+		free(journal);
+	}
+
+	__SCPreferencesCommitted(prefs, 0);
+	__SCPreferencesStatsAdd(prefs, kSCPStatCommit, __SCPreferencesStatsNow() - started);
+
+	sc_status = kSCStatusOK;
+
+    done :
+
+	if (lockFD != -1) {
+		(void) flock(lockFD, LOCK_UN);
+		(void) close(lockFD);
+		__SCPreferencesStatsAdd(prefs, kSCPStatLockHold, __SCPreferencesStatsNow() - locked);
+	}
+	if (newPath != NULL) {
+		(void) unlink(newPath);
+		free(newPath);
+	}
+	if (data != NULL) CFRelease(data);
+
+	_SCErrorSet(sc_status);
+	return (sc_status == kSCStatusOK);
+}
+
+
+#pragma mark -
+#pragma mark Rebase
+
+
+static Boolean
+valueEqual(CFTypeRef a, CFTypeRef b)
+{
+	if (a == b) {
+		return TRUE;
+	}
+	if ((a == NULL) || (b == NULL)) {
+		return FALSE;
+	}
+	return CFEqual(a, b);
+}
+
+
+/*
+ * rebaseValue
+ * - returns (retained) the result of applying our change (from "base" to
+ *   "mine") to "theirs", NULL if none (or if in conflict).  Dictionaries
+ *   are merged entry by entry down to the second level of the preferences
+ *   (depth -1 being the preferences themselves).
+ */
+static CFTypeRef
+rebaseValue(CFTypeRef base, CFTypeRef mine, CFTypeRef theirs, int depth, Boolean *conflict)
+{
+	if (valueEqual(mine, base)) {
+		// if we did not change it
+		return (theirs != NULL) ? CFRetain(theirs) : NULL;
+	}
+	if (valueEqual(theirs, base) || valueEqual(theirs, mine)) {
+		// if they did not change it (or made the same change)
+		return (mine != NULL) ? CFRetain(mine) : NULL;
+	}
+
+	if ((depth <= 0) && isA_CFDictionary(base) && isA_CFDictionary(mine) && isA_CFDictionary(theirs)) {
+		CFIndex			i;
+		const void		**keys;
+		CFMutableDictionaryRef	merged;
+		CFIndex			n;
+
+		// we both changed a dictionary, merge the entries
+		merged = CFDictionaryCreateMutableCopy(NULL, 0, theirs);
+		n = CFDictionaryGetCount(mine) + CFDictionaryGetCount(base);
+		keys = CFAllocatorAllocate(NULL, (n + 1) * sizeof(CFTypeRef), 0);
+		CFDictionaryGetKeysAndValues(mine, keys, NULL);
+		CFDictionaryGetKeysAndValues(base, keys + CFDictionaryGetCount(mine), NULL);
+		for (i = 0; (i < n) && !*conflict; i++) {
+			CFTypeRef	value;
+
+			value = rebaseValue(CFDictionaryGetValue(base, keys[i]),
+					    CFDictionaryGetValue(mine, keys[i]),
+					    CFDictionaryGetValue(theirs, keys[i]),
+					    depth + 1,
+					    conflict);
+			if (value != NULL) {
+				CFDictionarySetValue(merged, keys[i], value);
+				CFRelease(value);
+			} else {
+				CFDictionaryRemoveValue(merged, keys[i]);
+			}
+		}
+		CFAllocatorDeallocate(NULL, keys);
+		if (*conflict) {
+			CFRelease(merged);
+			return NULL;
+		}
+		return merged;
+	}
+
+	*conflict = TRUE;
+	return NULL;
+}
+
+
+/*
+ * _SCPreferencesRebase
+ *
+ * Re-applies the changes made by this session to the current (committed)
+ * preferences.  Top-level and second-level entries changed by both this
+ * session and another writer are a conflict; the session is then left
+ * unchanged and kSCStatusStale is returned.
+ *
+ * The current preferences are read with a separate session; only our own
+ * state (see SCPreferencesExtra) of that session is taken over.
+ */
+Boolean
+_SCPreferencesRebase(SCPreferencesRef prefs)
+{
+	Boolean			conflict	= FALSE;
+	SCPreferencesRef	current;
+	SCPreferencesExtraRef	currentExtra;
+	SCPreferencesPrivateRef	currentPrivate;
+	SCPreferencesExtraRef	extra;
+	CFMutableDictionaryRef	merged;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+
+	extra = __SCPreferencesGetExtra(prefs);
+	if ((prefsPrivate->authorizationData != NULL) || (extra == NULL) || (extra->journalBase == NULL)) {
+		// if using the helper (or if the preferences have not been read)
+		_SCErrorSet(kSCStatusFailed);
+		return FALSE;
+	}
+
+	current = SCPreferencesCreateWithOptions(NULL,
+						 prefsPrivate->name,
+						 prefsPrivate->prefsID,
+						 NULL,
+						 prefsPrivate->options);
+	if (current == NULL) {
+		return FALSE;
+	}
+	currentPrivate = (SCPreferencesPrivateRef)current;
+	__SCPreferencesAccess(current);
+	currentExtra = __SCPreferencesGetExtra(current);
+	if ((currentExtra == NULL) || (currentExtra->journalBase == NULL)) {
+		CFRelease(current);
+		_SCErrorSet(kSCStatusFailed);
+		return FALSE;
+	}
+
+	merged = (CFMutableDictionaryRef)rebaseValue(extra->journalBase,
+						     prefsPrivate->prefs,
+						     currentPrivate->prefs,
+						     -1,
+						     &conflict);
+	if (conflict || (merged == NULL)) {
+		if (merged != NULL) CFRelease(merged);
+		CFRelease(current);
+		_SCErrorSet(kSCStatusStale);
+		return FALSE;
+	}
+	if (merged == (CFMutableDictionaryRef)currentPrivate->prefs) {
+		// if the merged dictionary is theirs, we need our own copy
+		CFRelease(merged);
+		merged = CFDictionaryCreateMutableCopy(NULL, 0, currentPrivate->prefs);
+	}
+
+	// adopt the current preferences (and how they were read), with our changes
+	CFRelease(prefsPrivate->prefs);
+	prefsPrivate->prefs = merged;
+	if (prefsPrivate->signature != NULL) CFRelease(prefsPrivate->signature);
+	prefsPrivate->signature = (currentPrivate->signature != NULL) ? CFRetain(currentPrivate->signature) : NULL;
+	CFRelease(extra->journalBase);
+	extra->journalBase = CFRetain(currentExtra->journalBase);
+	extra->journalSize = currentExtra->journalSize;
+	extra->format = currentExtra->format;
+	__SCPreferencesReleaseDocument(extra);
+	extra->document = currentExtra->document;	// (the mapping of the current file, if any)
+	currentExtra->document = NULL;
+	prefsPrivate->changed = TRUE;
+	CFRelease(current);
+
+	_SCErrorSet(kSCStatusOK);
+	return TRUE;
+}
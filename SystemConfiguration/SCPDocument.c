@@ -0,0 +1,829 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: mmap-backed, lazily materialized preferences
+ */
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "SCPreferencesInternal.h"
+
+
+/*
+ * An SCPDocument is a read-only mapping of an XML preferences file along
+ * with an index of the top-level and second-level dictionary entries.
+ * Building the index is a single scan over the bytes that does not
+ * create any objects.  An entry's value is only parsed (and then cached)
+ * when it is needed, e.g. when a path below it is read.
+ *
+ * Values handed out by the document are immutable and are remembered.
+ * When the preferences are written, any entry whose value is still the
+ * same object is copied from the mapped file byte for byte; only the
+ * entries that were replaced are serialized again.  Since the file was
+ * written by the same XML writer, the result is identical to serializing
+ * the whole tree.
+ */
+
+
+#define	kLinkKey	CFSTR("__LINK__")	// kSCResvLink
+#define	N_LINKS_MAX	8
+
+
+typedef struct __SCPDocumentEntry {
+	CFStringRef			key;
+	CFIndex				start;		// start of the entry (the "<key>" line)
+	CFIndex				end;		// end of the entry (after the value's line)
+	CFIndex				valueStart;
+	CFIndex				valueEnd;
+
+	/* indexed dictionary entries (nChildren == -1 if not indexed) */
+	CFIndex				nChildren;
+	struct __SCPDocumentEntry	*children;
+	CFMutableDictionaryRef		childIndex;	// key --> SCPDocumentEntry *
+
+	/* the materialized value */
+	CFTypeRef			value;
+} SCPDocumentEntry;
+
+
+struct __SCPDocument {
+	const UInt8		*bytes;
+	size_t			len;
+	CFDataRef		signature;
+
+	/* the top-level dictionary (and its "<dict>" ... "</dict>" lines) */
+	SCPDocumentEntry	root;
+	CFIndex			bodyStart;
+	CFIndex			bodyEnd;
+};
+
+
+#pragma mark -
+#pragma mark Scanner
+
+
+static Boolean
+hasPrefix(SCPDocumentRef doc, CFIndex p, const char *str)
+{
+	size_t	n	= strlen(str);
+
+	return ((doc->len - p) >= n) && (memcmp(doc->bytes + p, str, n) == 0);
+}
+
+
+static CFIndex
+findByte(SCPDocumentRef doc, CFIndex p, UInt8 c)
+{
+	const UInt8	*q;
+
+	q = memchr(doc->bytes + p, c, doc->len - p);
+	return (q != NULL) ? (q - doc->bytes) : -1;
+}
+
+
+static CFIndex
+skipSpace(SCPDocumentRef doc, CFIndex p)
+{
+	while ((p < (CFIndex)doc->len) && isspace(doc->bytes[p])) {
+		p++;
+	}
+	return p;
+}
+
+
+/*
+ * skipMarkup
+ * - skips white space, comments, processing instructions and <!DOCTYPE>
+ */
+static CFIndex
+skipMarkup(SCPDocumentRef doc, CFIndex p)
+{
+	while (TRUE) {
+		p = skipSpace(doc, p);
+		if (hasPrefix(doc, p, "<!--")) {
+			const UInt8	*q;
+
+			q = memmem(doc->bytes + p, doc->len - p, "-->", 3);
+			if (q == NULL) {
+				return -1;
+			}
+			p = (q - doc->bytes) + 3;
+		} else if (hasPrefix(doc, p, "<?") || hasPrefix(doc, p, "<!DOCTYPE")) {
+			p = findByte(doc, p, '>');
+			if (p == -1) {
+				return -1;
+			}
+			p++;
+		} else {
+			return p;
+		}
+	}
+}
+
+
+/*
+ * skipElement
+ * - returns the offset just past the element starting at "p"
+ */
+static CFIndex
+skipElement(SCPDocumentRef doc, CFIndex p)
+{
+	CFIndex		name;
+	CFIndex		nameLen	= 0;
+	CFIndex		q;
+
+	if ((p >= (CFIndex)doc->len) || (doc->bytes[p] != '<')) {
+		return -1;
+	}
+	name = p + 1;
+	while (((name + nameLen) < (CFIndex)doc->len) && isalnum(doc->bytes[name + nameLen])) {
+		nameLen++;
+	}
+	if (nameLen == 0) {
+		return -1;
+	}
+
+	q = findByte(doc, name + nameLen, '>');
+	if (q == -1) {
+		return -1;
+	}
+	if (doc->bytes[q - 1] == '/') {
+		// if <empty/>
+		return q + 1;
+	}
+	q++;
+
+	if (((nameLen == 4) && (memcmp(doc->bytes + name, "dict", 4) == 0)) ||
+	    ((nameLen == 5) && (memcmp(doc->bytes + name, "array", 5) == 0))) {
+		int	depth	= 1;
+
+		while (depth > 0) {
+			CFIndex	r;
+
+			q = findByte(doc, q, '<');
+			if ((q == -1) || hasPrefix(doc, q, "<![CDATA[")) {
+				return -1;
+			}
+			if (hasPrefix(doc, q, "<!--")) {
+				q = skipMarkup(doc, q);
+				if (q == -1) {
+					return -1;
+				}
+				continue;
+			}
+			r = findByte(doc, q, '>');
+			if (r == -1) {
+				return -1;
+			}
+			if (doc->bytes[q + 1] == '/') {
+				depth--;
+			} else if (doc->bytes[r - 1] != '/') {
+				depth++;
+			}
+			q = r + 1;
+		}
+		return q;
+	}
+
+	// <string>, <integer>, ... text content is escaped so the next
+	// markup must be the closing tag
+	q = findByte(doc, q, '<');
+	if ((q == -1) ||
+	    ((doc->len - q) < (size_t)(nameLen + 3)) ||
+	    (doc->bytes[q + 1] != '/') ||
+	    (memcmp(doc->bytes + q + 2, doc->bytes + name, nameLen) != 0) ||
+	    (doc->bytes[q + 2 + nameLen] != '>')) {
+		return -1;
+	}
+
+	return q + 3 + nameLen;
+}
+
+
+static CFIndex
+lineStart(SCPDocumentRef doc, CFIndex p)
+{
+	CFIndex	q	= p;
+
+	while ((q > 0) && ((doc->bytes[q - 1] == '\t') || (doc->bytes[q - 1] == ' '))) {
+		q--;
+	}
+	return ((q > 0) && (doc->bytes[q - 1] == '\n')) ? q : p;
+}
+
+
+static CFIndex
+lineEnd(SCPDocumentRef doc, CFIndex p)
+{
+	return ((p < (CFIndex)doc->len) && (doc->bytes[p] == '\n')) ? p + 1 : p;
+}
+
+
+static CFStringRef
+createKey(SCPDocumentRef doc, CFIndex start, CFIndex end)
+{
+	CFMutableDataRef	xml;
+	CFStringRef		key;
+
+	if (memchr(doc->bytes + start, '&', end - start) == NULL) {
+		return CFStringCreateWithBytes(NULL,
+					       doc->bytes + start,
+					       end - start,
+					       kCFStringEncodingUTF8,
+					       FALSE);
+	}
+
+	// if the key has character references, let the parser decode them
+	xml = CFDataCreateMutable(NULL, 0);
+	CFDataAppendBytes(xml, (const UInt8 *)"<plist version=\"1.0\"><string>", 29);
+	CFDataAppendBytes(xml, doc->bytes + start, end - start);
+	CFDataAppendBytes(xml, (const UInt8 *)"</string></plist>", 17);
+	key = CFPropertyListCreateWithData(NULL, xml, kCFPropertyListImmutable, NULL, NULL);
+	CFRelease(xml);
+	if ((key != NULL) && !isA_CFString(key)) {
+		CFRelease(key);
+		key = NULL;
+	}
+
+	return key;
+}
+
+
+/*
+ * scanDictionary
+ * - indexes the entries of the dictionary whose content starts at "p"
+ *   and returns the offset of its closing "</dict>" tag
+ */
+static CFIndex
+scanDictionary(SCPDocumentRef doc, CFIndex p, SCPDocumentEntry *dict, int depth)
+{
+	CFIndex		nAlloc	= 0;
+
+	dict->nChildren = 0;
+	dict->childIndex = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, NULL);
+
+	while (TRUE) {
+		SCPDocumentEntry	*entry;
+		CFIndex			keyEnd;
+		CFIndex			keyStart;
+
+		p = skipMarkup(doc, p);
+		if (p == -1) {
+			return -1;
+		}
+		if (hasPrefix(doc, p, "</dict>")) {
+			CFIndex	i;
+
+			// (the entries don't move once the array is complete)
+			for (i = 0; i < dict->nChildren; i++) {
+				CFDictionarySetValue(dict->childIndex,
+						     dict->children[i].key,
+						     &dict->children[i]);
+			}
+			return p;
+		}
+		if (!hasPrefix(doc, p, "<key>")) {
+			return -1;
+		}
+
+		if (dict->nChildren == nAlloc) {
+			nAlloc = (nAlloc == 0) ? 16 : nAlloc * 2;
+			dict->children = reallocf(dict->children, nAlloc * sizeof(SCPDocumentEntry));
+			if (dict->children == NULL) {
+				dict->nChildren = 0;
+				return -1;
+			}
+		}
+		entry = &dict->children[dict->nChildren];
+		memset(entry, 0, sizeof(*entry));
+		entry->nChildren = -1;
+		entry->start = lineStart(doc, p);
+
+		keyStart = p + 5;
+		keyEnd = findByte(doc, keyStart, '<');
+		if ((keyEnd == -1) || !hasPrefix(doc, keyEnd, "</key>")) {
+			return -1;
+		}
+		entry->key = createKey(doc, keyStart, keyEnd);
+		if (entry->key == NULL) {
+			return -1;
+		}
+		dict->nChildren++;
+
+		p = skipSpace(doc, keyEnd + 6);
+		entry->valueStart = p;
+		if ((depth == 0) && hasPrefix(doc, p, "<dict>")) {
+			// index the second level
+			p = scanDictionary(doc, p + 6, entry, depth + 1);
+			if (p == -1) {
+				return -1;
+			}
+			p += 7;		// "</dict>"
+		} else {
+			p = skipElement(doc, p);
+			if (p == -1) {
+				return -1;
+			}
+		}
+		entry->valueEnd = p;
+		entry->end = lineEnd(doc, p);
+	}
+}
+
+
+static Boolean
+scanDocument(SCPDocumentRef doc)
+{
+	CFIndex		p;
+
+	p = skipMarkup(doc, 0);
+	if ((p == -1) || !hasPrefix(doc, p, "<plist")) {
+		return FALSE;
+	}
+	p = findByte(doc, p, '>');
+	if (p == -1) {
+		return FALSE;
+	}
+	p = skipMarkup(doc, p + 1);
+	if ((p == -1) || !hasPrefix(doc, p, "<dict>")) {
+		// if not a (non-empty) dictionary
+		return FALSE;
+	}
+	doc->bodyStart = lineEnd(doc, p + 6);
+
+	p = scanDictionary(doc, p + 6, &doc->root, 0);
+	if (p == -1) {
+		return FALSE;
+	}
+	doc->bodyEnd = lineStart(doc, p);
+
+	return TRUE;
+}
+
+
+#pragma mark -
+#pragma mark Materialization
+
+
+static CFTypeRef
+entryGetValue(SCPDocumentRef doc, SCPDocumentEntry *entry)
+{
+	if (entry->value != NULL) {
+		return entry->value;
+	}
+
+	if (entry->nChildren >= 0) {
+		CFIndex		i;
+		const void	**keys;
+		const void	**values;
+
+		// build the dictionary from its (separately cached) entries
+		keys = CFAllocatorAllocate(NULL, (entry->nChildren + 1) * 2 * sizeof(CFTypeRef), 0);
+		values = keys + entry->nChildren + 1;
+		for (i = 0; i < entry->nChildren; i++) {
+			keys[i] = entry->children[i].key;
+			values[i] = entryGetValue(doc, &entry->children[i]);
+			if (values[i] == NULL) {
+				CFAllocatorDeallocate(NULL, keys);
+				return NULL;
+			}
+		}
+		entry->value = CFDictionaryCreate(NULL,
+						  keys,
+						  values,
+						  entry->nChildren,
+						  &kCFTypeDictionaryKeyCallBacks,
+						  &kCFTypeDictionaryValueCallBacks);
+		CFAllocatorDeallocate(NULL, keys);
+	} else {
+		CFErrorRef		error	= NULL;
+		CFMutableDataRef	xml;
+
+		entry->value = _SCCreatePropertyListWithXMLBytes(doc->bytes + entry->valueStart,
+								 entry->valueEnd - entry->valueStart);
+		if (entry->value != NULL) {
+			return entry->value;
+		}
+
+		xml = CFDataCreateMutable(NULL, 0);
+		CFDataAppendBytes(xml, (const UInt8 *)"<plist version=\"1.0\">", 21);
+		CFDataAppendBytes(xml, doc->bytes + entry->valueStart, entry->valueEnd - entry->valueStart);
+		CFDataAppendBytes(xml, (const UInt8 *)"</plist>", 8);
+		entry->value = CFPropertyListCreateWithData(NULL, xml, kCFPropertyListImmutable, NULL, &error);
+		CFRelease(xml);
+		if (entry->value == NULL) {
+			SC_log(LOG_NOTICE, "CFPropertyListCreateWithData(\"%@\"): %@", entry->key, error);
+			if (error != NULL) CFRelease(error);
+		}
+	}
+
+	return entry->value;
+}
+
+
+static void
+entryRelease(SCPDocumentEntry *entry)
+{
+	CFIndex	i;
+
+	for (i = 0; i < entry->nChildren; i++) {
+		entryRelease(&entry->children[i]);
+	}
+	if (entry->children != NULL)	free(entry->children);
+	if (entry->childIndex != NULL)	CFRelease(entry->childIndex);
+	if (entry->key != NULL)		CFRelease(entry->key);
+	if (entry->value != NULL)	CFRelease(entry->value);
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Documents
+
+
+__private_extern__ SCPDocumentRef
+__SCPDocumentCreate(int fd, const struct stat *statBuf)
+{
+	void		*bytes;
+	SCPDocumentRef	doc;
+
+	if (statBuf->st_size <= 0) {
+		return NULL;
+	}
+
+	bytes = mmap(NULL, (size_t)statBuf->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (bytes == MAP_FAILED) {
+		SC_log(LOG_INFO, "mmap() failed: %s", strerror(errno));
+		return NULL;
+	}
+
+	doc = calloc(1, sizeof(*doc));
+	if (doc == NULL) {
+		(void) munmap(bytes, (size_t)statBuf->st_size);
+		return NULL;
+	}
+	doc->bytes = bytes;
+	doc->len = (size_t)statBuf->st_size;
+	doc->signature = __SCPSignatureFromStatbuf(statBuf);
+	doc->root.nChildren = -1;
+
+	if (!scanDocument(doc)) {
+		// if not an XML dictionary we know how to index
+		__SCPDocumentRelease(doc);
+		return NULL;
+	}
+
+	return doc;
+}
+
+
+__private_extern__ void
+__SCPDocumentRelease(SCPDocumentRef doc)
+{
+	entryRelease(&doc->root);
+	CFRelease(doc->signature);
+	(void) munmap((void *)doc->bytes, doc->len);
+	free(doc);
+	return;
+}
+
+
+__private_extern__ CFDataRef
+__SCPDocumentGetSignature(SCPDocumentRef doc)
+{
+	return doc->signature;
+}
+
+
+__private_extern__ CFDictionaryRef
+__SCPDocumentGetPreferences(SCPDocumentRef doc)
+{
+	return entryGetValue(doc, &doc->root);
+}
+
+
+/*
+ * __SCPDocumentGetPathValue
+ * - returns the dictionary at "path", following links the same way as
+ *   SCPreferencesPathGetValue(); while the path is within the indexed
+ *   (top-level and second-level) entries it is followed through the
+ *   index, so only the entry at the end of the path (or the one below
+ *   which the path continues) is materialized
+ */
+__private_extern__ CFDictionaryRef
+__SCPDocumentGetPathValue(SCPDocumentRef doc, CFStringRef path)
+{
+	CFArrayRef		components;
+	SCPDocumentEntry	*entry;
+	CFIndex			i;
+	int			nLinks		= 0;
+	CFIndex			n;
+	CFMutableStringRef	newPath		= NULL;
+	CFTypeRef		value		= NULL;
+
+    restart :
+
+	components = CFStringCreateArrayBySeparatingStrings(NULL, path, CFSTR("/"));
+	n = CFArrayGetCount(components);
+	if ((n < 2) || (CFStringGetLength(CFArrayGetValueAtIndex(components, 0)) != 0)) {
+		// if not an absolute path
+		goto done;
+	}
+
+	if ((n == 2) && (CFStringGetLength(CFArrayGetValueAtIndex(components, 1)) == 0)) {
+		// if "/"
+		value = __SCPDocumentGetPreferences(doc);
+		goto done;
+	}
+
+	value = NULL;
+	entry = &doc->root;	// (while != NULL, an indexed dictionary)
+	for (i = 1; i < n; i++) {
+		CFStringRef		component	= CFArrayGetValueAtIndex(components, i);
+		CFStringRef		link		= NULL;
+
+		if (entry != NULL) {
+			entry = (SCPDocumentEntry *)CFDictionaryGetValue(entry->childIndex, component);
+			if (entry == NULL) {
+				goto done;
+			}
+			if (entry->nChildren < 0) {
+				// if the path continues below the index
+				value = entryGetValue(doc, entry);
+				entry = NULL;
+			}
+		} else {
+			value = CFDictionaryGetValue(value, component);
+		}
+
+		if (entry != NULL) {
+			SCPDocumentEntry	*linkEntry;
+
+			linkEntry = (SCPDocumentEntry *)CFDictionaryGetValue(entry->childIndex, kLinkKey);
+			if (linkEntry != NULL) {
+				link = entryGetValue(doc, linkEntry);
+			}
+		} else if (isA_CFDictionary(value)) {
+			link = CFDictionaryGetValue(value, kLinkKey);
+		} else {
+			value = NULL;
+			goto done;
+		}
+
+		if (isA_CFString(link)) {
+			CFIndex	j;
+
+			// follow the link, then the rest of the path
+			if (++nLinks > N_LINKS_MAX) {
+				value = NULL;
+				goto done;
+			}
+			if (newPath != NULL) CFRelease(newPath);
+			newPath = CFStringCreateMutableCopy(NULL, 0, link);
+			for (j = i + 1; j < n; j++) {
+				CFStringAppend(newPath, CFSTR("/"));
+				CFStringAppend(newPath, CFArrayGetValueAtIndex(components, j));
+			}
+			CFRelease(components);
+			path = newPath;
+			goto restart;
+		}
+	}
+
+	if (entry != NULL) {
+		value = entryGetValue(doc, entry);
+	}
+
+    done :
+
+	CFRelease(components);
+	if (newPath != NULL) CFRelease(newPath);
+	return value;
+}
+
+
+#pragma mark -
+#pragma mark Write-back
+
+
+static void
+appendIndent(CFMutableDataRef data, int depth)
+{
+	static const UInt8	tabs[]	= "\t\t\t\t\t\t\t\t";
+
+	CFDataAppendBytes(data, tabs, (depth < 8) ? depth : 8);
+	return;
+}
+
+
+static void
+appendKey(CFMutableDataRef data, CFStringRef key, int depth)
+{
+	CFIndex		i;
+	CFIndex		len;
+	CFIndex		n;
+	CFDataRef	utf8;
+	const UInt8	*bytes;
+
+	appendIndent(data, depth);
+	CFDataAppendBytes(data, (const UInt8 *)"<key>", 5);
+
+	utf8 = CFStringCreateExternalRepresentation(NULL, key, kCFStringEncodingUTF8, 0);
+	bytes = CFDataGetBytePtr(utf8);
+	len = CFDataGetLength(utf8);
+	for (i = 0, n = 0; i < len; i++) {
+		const char	*entity;
+
+		switch (bytes[i]) {
+			case '&' : entity = "&amp;"; break;
+			case '<' : entity = "&lt;";  break;
+			case '>' : entity = "&gt;";  break;
+			default  : continue;
+		}
+		CFDataAppendBytes(data, bytes + n, i - n);
+		CFDataAppendBytes(data, (const UInt8 *)entity, strlen(entity));
+		n = i + 1;
+	}
+	CFDataAppendBytes(data, bytes + n, len - n);
+	CFRelease(utf8);
+
+	CFDataAppendBytes(data, (const UInt8 *)"</key>\n", 7);
+	return;
+}
+
+
+static Boolean
+appendValue(CFMutableDataRef data, CFPropertyListRef value, int depth)
+{
+	const UInt8	*bytes;
+	const UInt8	*end;
+	const UInt8	*p;
+	CFDataRef	xml;
+
+	xml = CFPropertyListCreateData(NULL, value, kCFPropertyListXMLFormat_v1_0, 0, NULL);
+	if (xml == NULL) {
+		return FALSE;
+	}
+
+	// the value is everything between the "<plist>" and "</plist>" lines
+	bytes = CFDataGetBytePtr(xml);
+	end = bytes + CFDataGetLength(xml);
+	p = memmem(bytes, end - bytes, "<plist version=\"1.0\">\n", 22);
+	if (p == NULL) {
+		CFRelease(xml);
+		return FALSE;
+	}
+	p += 22;
+	end -= 9;	// "</plist>\n"
+
+	while (p < end) {
+		const UInt8	*nl;
+
+		nl = memchr(p, '\n', end - p);
+		nl = (nl != NULL) ? nl + 1 : end;
+		appendIndent(data, depth);
+		CFDataAppendBytes(data, p, nl - p);
+		p = nl;
+	}
+	CFRelease(xml);
+
+	return TRUE;
+}
+
+
+static CFArrayRef
+copySortedKeys(CFDictionaryRef dict)
+{
+	CFMutableArrayRef	keys;
+	CFIndex			n;
+	const void		**list;
+
+	n = CFDictionaryGetCount(dict);
+	list = CFAllocatorAllocate(NULL, (n + 1) * sizeof(CFTypeRef), 0);
+	CFDictionaryGetKeysAndValues(dict, list, NULL);
+	keys = CFArrayCreateMutable(NULL, n, &kCFTypeArrayCallBacks);
+	CFArrayReplaceValues(keys, CFRangeMake(0, 0), list, n);
+	CFAllocatorDeallocate(NULL, list);
+
+	// same order as the XML writer
+	CFArraySortValues(keys, CFRangeMake(0, n), (CFComparatorFunction)CFStringCompare, NULL);
+	return keys;
+}
+
+
+static Boolean
+appendEntry(SCPDocumentRef		doc,
+	    CFMutableDataRef		data,
+	    SCPDocumentEntry		*parent,
+	    CFStringRef			key,
+	    CFPropertyListRef		value,
+	    int				depth)
+{
+	SCPDocumentEntry	*entry	= NULL;
+	Boolean			ok	= TRUE;
+
+	if (parent->childIndex != NULL) {
+		entry = (SCPDocumentEntry *)CFDictionaryGetValue(parent->childIndex, key);
+	}
+
+	if ((entry != NULL) && (entry->value == value)) {
+		// if untouched, copy the original bytes
+		CFDataAppendBytes(data, doc->bytes + entry->start, entry->end - entry->start);
+		return TRUE;
+	}
+
+	appendKey(data, key, depth);
+
+	if ((entry != NULL) &&
+	    (entry->nChildren >= 0) &&
+	    isA_CFDictionary(value) &&
+	    (CFDictionaryGetCount(value) > 0)) {
+		CFIndex		i;
+		CFArrayRef	keys;
+		CFIndex		n;
+
+		// a replaced dictionary may still hold many untouched entries
+		appendIndent(data, depth);
+		CFDataAppendBytes(data, (const UInt8 *)"<dict>\n", 7);
+		keys = copySortedKeys(value);
+		n = CFArrayGetCount(keys);
+		for (i = 0; ok && (i < n); i++) {
+			CFStringRef	childKey	= CFArrayGetValueAtIndex(keys, i);
+
+			ok = appendEntry(doc, data, entry, childKey, CFDictionaryGetValue(value, childKey), depth + 1);
+		}
+		CFRelease(keys);
+		appendIndent(data, depth);
+		CFDataAppendBytes(data, (const UInt8 *)"</dict>\n", 8);
+		return ok;
+	}
+
+	return appendValue(data, value, depth);
+}
+
+
+/*
+ * __SCPDocumentCreateXMLData
+ * - serializes "prefs", reusing the document's bytes for unchanged entries
+ */
+__private_extern__ CFDataRef
+__SCPDocumentCreateXMLData(SCPDocumentRef doc, CFDictionaryRef prefs)
+{
+	CFMutableDataRef	data;
+	CFIndex			i;
+	CFArrayRef		keys;
+	CFIndex			n;
+	Boolean			ok	= TRUE;
+
+	n = CFDictionaryGetCount(prefs);
+	if ((n == 0) || (doc->root.nChildren <= 0)) {
+		return CFPropertyListCreateData(NULL, prefs, kCFPropertyListXMLFormat_v1_0, 0, NULL);
+	}
+
+	data = CFDataCreateMutable(NULL, 0);
+	CFDataAppendBytes(data, doc->bytes, doc->bodyStart);
+
+	keys = copySortedKeys(prefs);
+	for (i = 0; ok && (i < n); i++) {
+		CFStringRef	key	= CFArrayGetValueAtIndex(keys, i);
+
+		ok = appendEntry(doc, data, &doc->root, key, CFDictionaryGetValue(prefs, key), 1);
+	}
+	CFRelease(keys);
+
+	CFDataAppendBytes(data, doc->bytes + doc->bodyEnd, doc->len - doc->bodyEnd);
+
+	if (!ok) {
+		CFRelease(data);
+		return CFPropertyListCreateData(NULL, prefs, kCFPropertyListXMLFormat_v1_0, 0, NULL);
+	}
+
+	return data;
+}
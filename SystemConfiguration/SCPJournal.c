@@ -0,0 +1,781 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: append-only journal of preferences changes
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libkern/OSByteOrder.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include "SCPreferencesInternal.h"
+
+
+/*
+ * Instead of rewriting the whole preferences file, a journaled commit
+ * appends the top-level and second-level entries that changed to
+ * "<file>.journal" :
+ *
+ *   header	"SCPJ", version (4), base file signature length (4), signature
+ *   record	payload length (4), CRC-32 of payload (4), payload
+ *   ...
+ *
+ * A record's payload is a binary property list, [ path ] to remove an
+ * entry or [ path, value ] to set one, where a path is an array of one or
+ * two keys.  All integers are big-endian.
+ *
+ * The base file is never modified so readers that do not know about the
+ * journal still see a valid (if older) configuration.  The journal names
+ * the signature of the base file it applies to and is ignored once the
+ * base file has been replaced.  Replaying stops at the first truncated
+ * or corrupt record (e.g. a torn write), which is cut off by the next
+ * commit.  Once the journal grows past a threshold, the configuration
+ * is compacted : the base file is rewritten (write, fsync, rename) and
+ * only then is the journal removed.
+ */
+
+
+#define	JOURNAL_MAGIC			"SCPJ"
+#define	JOURNAL_VERSION			1
+#define	JOURNAL_COMPACT_SIZE_DEFAULT	(256 * 1024)
+
+
+#pragma mark -
+#pragma mark CRC-32
+
+
+static uint32_t
+journalCRC(const UInt8 *bytes, size_t len)
+{
+	static uint32_t		table[256];
+	static dispatch_once_t	once;
+	uint32_t		crc	= 0xffffffff;
+	size_t			i;
+
+	dispatch_once(&once, ^{
+		uint32_t	c;
+		int		j;
+		int		n;
+
+		for (n = 0; n < 256; n++) {
+			c = (uint32_t)n;
+			for (j = 0; j < 8; j++) {
+				c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+			}
+			table[n] = c;
+		}
+	});
+
+	for (i = 0; i < len; i++) {
+		crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+	}
+
+	return crc ^ 0xffffffff;
+}
+
+
+#pragma mark -
+#pragma mark Journal file
+
+
+/*
+ * journalEnabled
+ * - returns TRUE if the session was created with the "journal" option
+ *   and the preferences are not in the default directory.  Only this library replays the journal; the preferences
+ *   read by configd and the SystemConfiguration framework (which do not)
+ *   must never be journaled.
+ */
+static Boolean
+journalEnabled(SCPreferencesPrivateRef prefsPrivate)
+{
+	CFBooleanRef	journal;
+
+	if (prefsPrivate->options == NULL) {
+		return FALSE;
+	}
+
+	journal = CFDictionaryGetValue(prefsPrivate->options, kSCPreferencesOptionJournal);
+	if (!isA_CFBoolean(journal) || !CFBooleanGetValue(journal)) {
+		return FALSE;
+	}
+
+	if (strncmp(prefsPrivate->path, PREFS_DEFAULT_DIR_PATH "/", sizeof(PREFS_DEFAULT_DIR_PATH)) == 0) {
+		// if the [system] preferences
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+static char *
+journalPath(SCPreferencesPrivateRef prefsPrivate)
+{
+	char	*path	= NULL;
+
+	if (asprintf(&path, "%s.journal", prefsPrivate->path) == -1) {
+		return NULL;
+	}
+	return path;
+}
+
+
+static CFDataRef
+journalCreateHeader(CFDataRef signature)
+{
+	CFMutableDataRef	header;
+	uint32_t		val;
+
+	header = CFDataCreateMutable(NULL, 0);
+	CFDataAppendBytes(header, (const UInt8 *)JOURNAL_MAGIC, 4);
+	val = OSSwapHostToBigInt32(JOURNAL_VERSION);
+	CFDataAppendBytes(header, (const UInt8 *)&val, sizeof(val));
+	val = OSSwapHostToBigInt32((uint32_t)CFDataGetLength(signature));
+	CFDataAppendBytes(header, (const UInt8 *)&val, sizeof(val));
+	CFDataAppendBytes(header, CFDataGetBytePtr(signature), CFDataGetLength(signature));
+
+	return header;
+}
+
+
+typedef void (*journalApplierFunction)(CFArrayRef record, void *context);
+
+
+/*
+ * journalScan
+ * - calls the applier for each valid record of a journal that applies to
+ *   the base file with the given signature.  Returns the length of the
+ *   valid portion of the journal (0 if none, -1 if the journal does not
+ *   exist or does not apply).
+ */
+static off_t
+journalScan(int fd, CFDataRef signature, journalApplierFunction applier, void *context)
+{
+	void		*bytes;
+	const UInt8	*end;
+	CFDataRef	header;
+	const UInt8	*p;
+	struct stat	statBuf;
+	off_t		valid	= -1;
+
+	if ((fstat(fd, &statBuf) == -1) || (statBuf.st_size == 0)) {
+		return -1;
+	}
+
+	bytes = mmap(NULL, (size_t)statBuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (bytes == MAP_FAILED) {
+		SC_log(LOG_NOTICE, "journal mmap() failed: %s", strerror(errno));
+		return -1;
+	}
+	p = bytes;
+	end = p + statBuf.st_size;
+
+	header = journalCreateHeader(signature);
+	if ((statBuf.st_size < CFDataGetLength(header)) ||
+	    (memcmp(p, CFDataGetBytePtr(header), CFDataGetLength(header)) != 0)) {
+		// if the journal is for another base file
+		CFRelease(header);
+		goto done;
+	}
+	p += CFDataGetLength(header);
+	CFRelease(header);
+
+	while (TRUE) {
+		uint32_t	crc;
+		CFDataRef	data;
+		uint32_t	len;
+		CFArrayRef	record;
+
+		valid = p - (const UInt8 *)bytes;
+		if ((end - p) < 8) {
+			break;
+		}
+		memcpy(&len, p, sizeof(len));
+		len = OSSwapBigToHostInt32(len);
+		memcpy(&crc, p + 4, sizeof(crc));
+		crc = OSSwapBigToHostInt32(crc);
+		if (((size_t)(end - p - 8) < len) || (journalCRC(p + 8, len) != crc)) {
+			// if truncated or corrupt
+			break;
+		}
+
+		data = CFDataCreateWithBytesNoCopy(NULL, p + 8, len, kCFAllocatorNull);
+		record = CFPropertyListCreateWithData(NULL, data, kCFPropertyListImmutable, NULL, NULL);
+		CFRelease(data);
+		if (!isA_CFArray(record) ||
+		    (CFArrayGetCount(record) < 1) ||
+		    !isA_CFArray(CFArrayGetValueAtIndex(record, 0))) {
+			if (record != NULL) CFRelease(record);
+			break;
+		}
+		if (applier != NULL) {
+			applier(record, context);
+		}
+		CFRelease(record);
+
+		p += 8 + len;
+	}
+
+    done :
+
+	(void) munmap(bytes, (size_t)statBuf.st_size);
+	return valid;
+}
+
+
+static void
+journalApplyRecord(CFArrayRef record, void *context)
+{
+	CFMutableDictionaryRef	prefs	= (CFMutableDictionaryRef)context;
+	CFArrayRef		path	= CFArrayGetValueAtIndex(record, 0);
+	CFTypeRef		value	= NULL;
+	CFStringRef		key;
+
+	if (CFArrayGetCount(record) > 1) {
+		value = CFArrayGetValueAtIndex(record, 1);
+	}
+
+	key = CFArrayGetValueAtIndex(path, 0);
+	if (CFArrayGetCount(path) == 1) {
+		if (value != NULL) {
+			CFDictionarySetValue(prefs, key, value);
+		} else {
+			CFDictionaryRemoveValue(prefs, key);
+		}
+	} else {
+		CFDictionaryRef		cur;
+		CFMutableDictionaryRef	newDict;
+
+		cur = CFDictionaryGetValue(prefs, key);
+		if (isA_CFDictionary(cur)) {
+			newDict = CFDictionaryCreateMutableCopy(NULL, 0, cur);
+		} else {
+			newDict = CFDictionaryCreateMutable(NULL,
+							    0,
+							    &kCFTypeDictionaryKeyCallBacks,
+							    &kCFTypeDictionaryValueCallBacks);
+		}
+		if (value != NULL) {
+			CFDictionarySetValue(newDict, CFArrayGetValueAtIndex(path, 1), value);
+		} else {
+			CFDictionaryRemoveValue(newDict, CFArrayGetValueAtIndex(path, 1));
+		}
+		CFDictionarySetValue(prefs, key, newDict);
+		CFRelease(newDict);
+	}
+
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Replay
+
+
+/*
+ * __SCPreferencesJournalReplay
+ *
+ * Applies the journal (if any) to the preferences just read from the base
+ * file and remembers what they looked like so that a journaled commit can
+ * tell what changed.
+ */
+__private_extern__ void
+__SCPreferencesJournalReplay(SCPreferencesRef prefs)
+{
+	SCPreferencesExtraRef	extra;
+	int			fd;
+	char			*path;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+
+	extra = __SCPreferencesGetExtra(prefs);
+	if (extra == NULL) {
+		return;
+	}
+
+	extra->journalSize = 0;
+	path = journalEnabled(prefsPrivate) ? journalPath(prefsPrivate) : NULL;
+	if (path != NULL) {
+		fd = open(path, O_RDONLY, 0);
+		if (fd != -1) {
+			off_t	valid;
+
+			valid = journalScan(fd,
+					    prefsPrivate->signature,
+					    journalApplyRecord,
+					    (void *)prefsPrivate->prefs);
+			if (valid > 0) {
+				extra->journalSize = valid;
+			}
+			(void) close(fd);
+		}
+		free(path);
+	}
+
+	if (extra->journalBase != NULL) CFRelease(extra->journalBase);
+	extra->journalBase = CFDictionaryCreateCopy(NULL, prefsPrivate->prefs);
+	return;
+}
+
+
+__private_extern__ Boolean
+__SCPreferencesJournalExists(SCPreferencesRef prefs)
+{
+	Boolean			exists		= FALSE;
+	char			*path;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	struct stat		statBuf;
+
+	if (!journalEnabled(prefsPrivate)) {
+		// if any journal is not ours to replay
+		return FALSE;
+	}
+
+	path = journalPath(prefsPrivate);
+	if (path != NULL) {
+		exists = (stat(path, &statBuf) == 0) && (statBuf.st_size > 0);
+		free(path);
+	}
+
+	return exists;
+}
+
+
+/*
+ * journalIsCurrent
+ * - returns TRUE if neither the base file nor the journal (open on "fd",
+ *   or -1 if none) have changed since the preferences were read
+ */
+static Boolean
+journalIsCurrent(SCPreferencesRef prefs, int fd, off_t *valid)
+{
+	Boolean			current;
+	SCPreferencesExtraRef	extra;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	CFDataRef		signature;
+	struct stat		statBuf;
+	off_t			size		= -1;
+
+	extra = __SCPreferencesGetExtra(prefs);
+	if ((extra == NULL) || (prefsPrivate->signature == NULL)) {
+		return FALSE;
+	}
+
+	if (stat(prefsPrivate->path, &statBuf) == -1) {
+		memset(&statBuf, 0, sizeof(statBuf));
+	}
+	signature = __SCPSignatureFromStatbuf(&statBuf);
+	if (fd != -1) {
+		size = journalScan(fd, prefsPrivate->signature, NULL, NULL);
+	}
+	current = CFEqual(signature, prefsPrivate->signature) &&
+		  ((size > 0) ? (size == extra->journalSize) : (extra->journalSize == 0));
+	CFRelease(signature);
+
+	if (valid != NULL) {
+		*valid = size;
+	}
+	return current;
+}
+
+
+/*
+ * __SCPreferencesIsCurrent
+ *
+ * Returns TRUE if the preferences (base file and journal) have not been
+ * changed since they were read by this session.
+ */
+__private_extern__ Boolean
+__SCPreferencesIsCurrent(SCPreferencesRef prefs)
+{
+	Boolean			current;
+	int			fd		= -1;
+	char			*path;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+
+	path = journalEnabled(prefsPrivate) ? journalPath(prefsPrivate) : NULL;
+	if (path != NULL) {
+		fd = open(path, O_RDONLY, 0);
+		free(path);
+	}
+	current = journalIsCurrent(prefs, fd, NULL);
+	if (fd != -1) {
+		(void) close(fd);
+	}
+
+	return current;
+}
+
+
+#pragma mark -
+#pragma mark Commit
+
+
+static Boolean
+journalAppendRecord(CFMutableDataRef buf, CFArrayRef path, CFTypeRef value)
+{
+	CFTypeRef	elements[2];
+	CFDataRef	payload;
+	CFArrayRef	record;
+	uint32_t	val;
+
+	elements[0] = path;
+	elements[1] = value;
+	record = CFArrayCreate(NULL, elements, (value != NULL) ? 2 : 1, &kCFTypeArrayCallBacks);
+	payload = CFPropertyListCreateData(NULL, record, kCFPropertyListBinaryFormat_v1_0, 0, NULL);
+	CFRelease(record);
+	if (payload == NULL) {
+		SC_log(LOG_NOTICE, "journal record for %@ could not be serialized", path);
+		return FALSE;
+	}
+
+	val = OSSwapHostToBigInt32((uint32_t)CFDataGetLength(payload));
+	CFDataAppendBytes(buf, (const UInt8 *)&val, sizeof(val));
+	val = OSSwapHostToBigInt32(journalCRC(CFDataGetBytePtr(payload), CFDataGetLength(payload)));
+	CFDataAppendBytes(buf, (const UInt8 *)&val, sizeof(val));
+	CFDataAppendBytes(buf, CFDataGetBytePtr(payload), CFDataGetLength(payload));
+	CFRelease(payload);
+
+	return TRUE;
+}
+
+
+static Boolean
+journalDiff(CFDictionaryRef base, CFDictionaryRef prefs, CFStringRef parent, CFMutableDataRef buf)
+{
+	CFIndex		i;
+	const void	**keys;
+	CFIndex		n;
+	CFIndex		nBase;
+	CFIndex		nPrefs;
+	Boolean		ok	= TRUE;
+
+	// keys in either dictionary
+	nBase = CFDictionaryGetCount(base);
+	nPrefs = CFDictionaryGetCount(prefs);
+	keys = CFAllocatorAllocate(NULL, (nBase + nPrefs + 1) * sizeof(CFTypeRef), 0);
+	CFDictionaryGetKeysAndValues(prefs, keys, NULL);
+	CFDictionaryGetKeysAndValues(base, keys + nPrefs, NULL);
+	n = nPrefs + nBase;
+
+	for (i = 0; ok && (i < n); i++) {
+		CFStringRef	key		= keys[i];
+		CFTypeRef	newValue	= CFDictionaryGetValue(prefs, key);
+		CFTypeRef	oldValue	= CFDictionaryGetValue(base, key);
+		CFArrayRef	path;
+		CFStringRef	pathKeys[2];
+
+		if ((i >= nPrefs) && (newValue != NULL)) {
+			// if already handled
+			continue;
+		}
+		if ((oldValue == newValue) ||
+		    ((oldValue != NULL) && (newValue != NULL) && CFEqual(oldValue, newValue))) {
+			// if not changed
+			continue;
+		}
+
+		if ((parent == NULL) && isA_CFDictionary(oldValue) && isA_CFDictionary(newValue)) {
+			// record the changed second-level entries
+			ok = journalDiff(oldValue, newValue, key, buf);
+			continue;
+		}
+
+		if (parent != NULL) {
+			pathKeys[0] = parent;
+			pathKeys[1] = key;
+			path = CFArrayCreate(NULL, (const void **)pathKeys, 2, &kCFTypeArrayCallBacks);
+		} else {
+			path = CFArrayCreate(NULL, (const void **)&key, 1, &kCFTypeArrayCallBacks);
+		}
+		ok = journalAppendRecord(buf, path, newValue);
+		CFRelease(path);
+	}
+
+	CFAllocatorDeallocate(NULL, keys);
+	return ok;
+}
+
+
+static CFIndex
+journalCompactSize(SCPreferencesPrivateRef prefsPrivate)
+{
+	CFNumberRef	num;
+	CFIndex		size	= JOURNAL_COMPACT_SIZE_DEFAULT;
+
+	if (prefsPrivate->options != NULL) {
+		num = CFDictionaryGetValue(prefsPrivate->options, kSCPreferencesOptionJournalCompactSize);
+		if (isA_CFNumber(num)) {
+			(void) CFNumberGetValue(num, kCFNumberCFIndexType, &size);
+		}
+	}
+
+	return size;
+}
+
+
+static Boolean
+journalWriteBase(SCPreferencesRef prefs)
+{
+	CFDataRef		data;
+	int			fd;
+	char			*newPath	= NULL;
+	Boolean			ok		= FALSE;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	struct stat		statBuf;
+
+	data = __SCPreferencesCreateData(prefs);
+	if (data == NULL) {
+		return FALSE;
+	}
+
+	if (stat(prefsPrivate->path, &statBuf) == -1) {
+		memset(&statBuf, 0, sizeof(statBuf));
+		statBuf.st_mode = 0644;
+		statBuf.st_uid = geteuid();
+		statBuf.st_gid = getegid();
+	}
+
+	if (asprintf(&newPath, "%s-compact", prefsPrivate->path) == -1) {
+		CFRelease(data);
+		return FALSE;
+	}
+	(void) unlink(newPath);
+	fd = open(newPath, O_WRONLY|O_CREAT|O_EXCL, statBuf.st_mode & 07777);
+	if (fd != -1) {
+		(void) fchown(fd, statBuf.st_uid, statBuf.st_gid);
+		if ((write(fd, CFDataGetBytePtr(data), CFDataGetLength(data)) == CFDataGetLength(data)) &&
+		    (__SCPreferencesSyncTimed(prefs, fd) == 0) &&
+		    (rename(newPath, prefsPrivate->path) == 0)) {
+			__SCPreferencesStatsAdd(prefs, kSCPStatBytesWritten, (uint64_t)CFDataGetLength(data));
+			ok = TRUE;
+		} else {
+			SC_log(LOG_NOTICE, "could not write \"%s\": %s", prefsPrivate->path, strerror(errno));
+			(void) unlink(newPath);
+		}
+		(void) close(fd);
+	} else {
+		SC_log(LOG_NOTICE, "open() failed: %s", strerror(errno));
+	}
+
+	free(newPath);
+	CFRelease(data);
+	return ok;
+}
+
+
+/*
+ * __SCPreferencesJournalCompact
+ *
+ * Folds the journal into the base file.  The new base file is written
+ * (and renamed into place) before the journal is removed; should we
+ * crash in between, the journal no longer matches the base file and is
+ * ignored.
+ */
+__private_extern__ Boolean
+__SCPreferencesJournalCompact(SCPreferencesRef prefs)
+{
+	char			*path;
+	Boolean			ok;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	Boolean			wasLocked;
+
+	wasLocked = prefsPrivate->locked;
+	if (!wasLocked && !__SCPreferencesLockTimed(prefs, TRUE)) {
+		return FALSE;
+	}
+
+	__SCPreferencesAccess(prefs);
+
+	ok = journalWriteBase(prefs);
+	if (ok) {
+		path = journalPath(prefsPrivate);
+		if (path != NULL) {
+			(void) unlink(path);
+			free(path);
+		}
+		SC_log(LOG_INFO, "SCPreferences() journal compacted: %s", prefsPrivate->path);
+	}
+
+	if (!wasLocked) {
+		(void) SCPreferencesUnlock(prefs);
+	}
+
+	_SCErrorSet(ok ? kSCStatusOK : kSCStatusFailed);
+	return ok;
+}
+
+
+static void
+journalCompactInBackground(SCPreferencesRef prefs)
+{
+	CFDictionaryRef		options;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	CFStringRef		prefsID;
+
+	// (with the same options, e.g. the protection class, as the session)
+	prefsID = (prefsPrivate->prefsID != NULL) ? CFRetain(prefsPrivate->prefsID) : NULL;
+	options = (prefsPrivate->options != NULL) ? CFRetain(prefsPrivate->options) : NULL;
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+		SCPreferencesRef	compact;
+
+		compact = SCPreferencesCreateWithOptions(NULL,
+							 CFSTR("SCPreferences journal compaction"),
+							 prefsID,
+							 NULL,
+							 options);
+		if (compact != NULL) {
+			(void) __SCPreferencesJournalCompact(compact);
+			CFRelease(compact);
+		}
+		if (prefsID != NULL) CFRelease(prefsID);
+		if (options != NULL) CFRelease(options);
+	});
+
+	return;
+}
+
+
+/*
+ * _SCPreferencesCommitJournal
+ *
+ * Commits the changes made to the preferences by appending them to the
+ * journal rather than rewriting the base file.
+ */
+Boolean
+_SCPreferencesCommitJournal(SCPreferencesRef prefs)
+{
+	CFMutableDataRef	buf		= NULL;
+	SCPreferencesExtraRef	extra;
+	int			fd		= -1;
+	Boolean			ok		= FALSE;
+	char			*path		= NULL;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	int			sc_status	= kSCStatusFailed;
+	uint64_t		started;
+	off_t			valid;
+	Boolean			wasLocked;
+
+	started = __SCPreferencesStatsNow();
+
+	if (prefsPrivate->authorizationData != NULL) {
+		// journaled commits are not supported via the helper
+		_SCErrorSet(kSCStatusAccessError);
+		return FALSE;
+	}
+
+	if (!journalEnabled(prefsPrivate)) {
+		// if not a journaled session (or the preferences are read by others)
+		_SCErrorSet(kSCStatusInvalidArgument);
+		return FALSE;
+	}
+
+	wasLocked = prefsPrivate->locked;
+	if (!wasLocked && !__SCPreferencesLockTimed(prefs, TRUE)) {
+		return FALSE;
+	}
+
+	if (!prefsPrivate->accessed || !prefsPrivate->changed) {
+		// if no changes
+		ok = TRUE;
+		goto done;
+	}
+
+	path = journalPath(prefsPrivate);
+	if (path == NULL) {
+		goto done;
+	}
+	fd = open(path, O_RDWR|O_CREAT, 0644);
+	if (fd == -1) {
+		SC_log(LOG_NOTICE, "open() failed: %s", strerror(errno));
+		sc_status = (errno == EACCES) ? kSCStatusAccessError : kSCStatusFailed;
+		goto done;
+	}
+
+	if (!journalIsCurrent(prefs, fd, &valid)) {
+		// if others have committed [to the base file or journal] since we read it
+		sc_status = kSCStatusStale;
+		goto done;
+	}
+
+	buf = CFDataCreateMutable(NULL, 0);
+	if (valid <= 0) {
+		CFDataRef	header;
+
+		// start a new journal (for this base file)
+		header = journalCreateHeader(prefsPrivate->signature);
+		CFDataAppendBytes(buf, CFDataGetBytePtr(header), CFDataGetLength(header));
+		CFRelease(header);
+		valid = 0;
+	}
+	extra = __SCPreferencesGetExtra(prefs);
+	if ((extra == NULL) || (extra->journalBase == NULL) ||
+	    !journalDiff(extra->journalBase, prefsPrivate->prefs, NULL, buf)) {
+		// if a change could not be recorded, commit nothing
+		goto done;
+	}
+
+	// cut off anything after the last valid record (e.g. a torn write) and append
+	if ((ftruncate(fd, valid) == -1) ||
+	    (lseek(fd, valid, SEEK_SET) == -1) ||
+	    (write(fd, CFDataGetBytePtr(buf), CFDataGetLength(buf)) != CFDataGetLength(buf)) ||
+	    (__SCPreferencesSyncTimed(prefs, fd) == -1)) {
+		SC_log(LOG_NOTICE, "journal write() failed: %s", strerror(errno));
+		(void) ftruncate(fd, valid);
+		goto done;
+	}
+
+	__SCPreferencesCommitted(prefs, valid + CFDataGetLength(buf));
+	__SCPreferencesStatsAdd(prefs, kSCPStatBytesWritten, (uint64_t)CFDataGetLength(buf));
+	__SCPreferencesStatsAdd(prefs, kSCPStatCommit, __SCPreferencesStatsNow() - started);
+
+	SC_log(LOG_INFO, "SCPreferences() journal commit: %s, %ld bytes (journal now %lld bytes)",
+	       prefsPrivate->path,
+	       (long)CFDataGetLength(buf),
+	       (long long)extra->journalSize);
+
+	if (extra->journalSize > journalCompactSize(prefsPrivate)) {
+		journalCompactInBackground(prefs);
+	}
+
+	ok = TRUE;
+
+    done :
+
+	if (fd != -1)		(void) close(fd);
+	if (path != NULL)	free(path);
+	if (buf != NULL)	CFRelease(buf);
+	if (!wasLocked) {
+		(void) SCPreferencesUnlock(prefs);
+	}
+
+	_SCErrorSet(ok ? kSCStatusOK : sc_status);
+	return ok;
+}
@@ -24,6 +24,16 @@
 /*
  * Modification History
  *
+ * October 18, 2026
+ * - added binary storage format
+ * - added process-wide cache of parsed preferences
+ * - added index of resolved paths
+ * - added journal replay
+ * - added grouped commit recovery
+ * - added change sets to commit notifications
+ * - added asynchronous commit / apply
+ * - added lock / commit instrumentation
+ *
  * February 16, 2004		Allan Nathanson <ajn@apple.com>
  * - add preference notification APIs
  *
@@ -44,6 +54,7 @@
 #include <dispatch/dispatch.h>
 
 #include "SCPreferencesInternal.h"
+#include "SCObjectState.h"
 #include "SCD.h"
 #include "SCHelper_client.h"
 #include "dy_framework.h"
@@ -65,6 +76,74 @@ __log_SCPreferences(void)
 }
 
 
+/*
+ * the additional (SCPreferencesExtra) state of each session
+ */
+static SCObjectStateTableRef	extraTable		= NULL;
+static pthread_once_t		extraInitialized	= PTHREAD_ONCE_INIT;
+
+
+static const void *
+extraRetain(const void *state)
+{
+	// the state lives as long as the session
+	return state;
+}
+
+
+static void
+extraRelease(const void *state)
+{
+	SCPreferencesExtraRef	extra	= (SCPreferencesExtraRef)state;
+
+	if (extra->document != NULL)		__SCPDocumentRelease(extra->document);
+	__SCPreferencesPathIndexFlush(extra);
+	if (extra->journalBase != NULL)		CFRelease(extra->journalBase);
+	if (extra->changesToken != NULL)	CFRelease(extra->changesToken);
+	__SCPreferencesAsyncRelease(extra);
+	free(extra);
+	return;
+}
+
+
+static const void *
+extraCreate(CFTypeRef object)
+{
+#pragma unused(object)
+	SCPreferencesExtraRef	extra;
+
+	extra = calloc(1, sizeof(SCPreferencesExtra));
+	if (extra == NULL) {
+		return NULL;
+	}
+
+	/* initialize non-zero/NULL members */
+	extra->format = kCFPropertyListXMLFormat_v1_0;
+
+	return extra;
+}
+
+
+static void
+extraInitialize(void)
+{
+	extraTable = __SCObjectStateTableCreate(extraRetain, extraRelease);
+	return;
+}
+
+
+__private_extern__ SCPreferencesExtraRef
+__SCPreferencesGetExtra(SCPreferencesRef prefs)
+{
+	pthread_once(&extraInitialized, extraInitialize);
+	if (extraTable == NULL) {
+		return NULL;
+	}
+
+	return (SCPreferencesExtraRef)__SCObjectStateCopy(extraTable, prefs, extraCreate);
+}
+
+
 static CFStringRef
 __SCPreferencesCopyDescription(CFTypeRef cf) {
 	CFAllocatorRef		allocator	= CFGetAllocator(cf);
@@ -488,10 +567,22 @@ __SCPreferencesCreate(CFAllocatorRef	allocator,
 }
 
 
+__private_extern__ void
+__SCPreferencesReleaseDocument(SCPreferencesExtraRef extra)
+{
+	if (extra->document != NULL) {
+		__SCPDocumentRelease(extra->document);
+		extra->document = NULL;
+	}
+	return;
+}
+
+
 __private_extern__ void
 __SCPreferencesAccess(SCPreferencesRef	prefs)
 {
 	CFAllocatorRef		allocator	= CFGetAllocator(prefs);
+	SCPreferencesExtraRef	extra;
 	int			fd		= -1;
 	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
 	struct stat		statBuf;
@@ -501,6 +592,39 @@ __SCPreferencesAccess(SCPreferencesRef	prefs)
 		return;
 	}
 
+	extra = __SCPreferencesGetExtra(prefs);
+
+	if ((prefsPrivate->authorizationData == NULL) &&
+	    ((prefsPrivate->parent != NULL) || (prefsPrivate->companions != NULL))) {
+		// complete any interrupted grouped commit
+		__SCPreferencesGroupRecover(prefs);
+	}
+
+	if ((prefsPrivate->authorizationData == NULL) &&
+	    (stat(prefsPrivate->path, &statBuf) == 0) &&
+	    (statBuf.st_size > 0)) {
+		CFDictionaryRef		dict;
+		CFPropertyListFormat	format;
+		CFDataRef		signature;
+
+		/*
+		 * check if the [unchanged] file has already been parsed
+		 */
+		signature = __SCPSignatureFromStatbuf(&statBuf);
+		dict = __SCPreferencesCacheCopy(prefsPrivate->path, signature, &format);
+		if (dict != NULL) {
+			if (prefsPrivate->signature != NULL) CFRelease(prefsPrivate->signature);
+			prefsPrivate->signature = signature;
+			prefsPrivate->prefs = CFDictionaryCreateMutableCopy(allocator, 0, dict);
+			if (extra != NULL) {
+				extra->format = format;
+			}
+			CFRelease(dict);
+			goto done;
+		}
+		CFRelease(signature);
+	}
+
 	if (access(prefsPrivate->path, R_OK) == 0) {
 		fd = open(prefsPrivate->path, O_RDONLY, 0644);
 	} else {
@@ -539,13 +663,44 @@ __SCPreferencesAccess(SCPreferencesRef	prefs)
 	if (prefsPrivate->signature != NULL) CFRelease(prefsPrivate->signature);
 	prefsPrivate->signature = __SCPSignatureFromStatbuf(&statBuf);
 
+	if ((extra != NULL) &&
+	    (extra->document != NULL) &&
+	    !CFEqual(__SCPDocumentGetSignature(extra->document), prefsPrivate->signature)) {
+		// if the file has changed since it was mapped
+		__SCPreferencesReleaseDocument(extra);
+	}
+
 	if (statBuf.st_size > 0) {
 		CFDictionaryRef		dict;
 		CFErrorRef		error	= NULL;
+		CFPropertyListFormat	format;
 		CFMutableDataRef	xmlData;
 
 		/*
-		 * extract property list
+		 * map and index the property list (or reuse the mapping made
+		 * for an earlier path lookup), materializing each top-level
+		 * and second-level entry separately
+		 */
+		if ((extra != NULL) && (extra->document == NULL)) {
+			extra->document = __SCPDocumentCreate(fd, &statBuf);
+		}
+		if ((extra != NULL) && (extra->document != NULL)) {
+			dict = __SCPDocumentGetPreferences(extra->document);
+			if (dict != NULL) {
+				prefsPrivate->prefs = CFDictionaryCreateMutableCopy(allocator, 0, dict);
+				extra->format = kCFPropertyListXMLFormat_v1_0;
+				__SCPreferencesCacheAdd(prefsPrivate->path, prefsPrivate->signature, dict, extra->format);
+				goto done;
+			}
+
+			// if an entry could not be materialized, parse the whole file
+			__SCPreferencesReleaseDocument(extra);
+		}
+
+		/*
+		 * extract property list (not an XML dictionary that can be
+		 * indexed, e.g. a binary property list, or one that could not
+		 * be materialized)
 		 */
 		xmlData = CFDataCreateMutable(allocator, (CFIndex)statBuf.st_size);
 		CFDataSetLength(xmlData, (CFIndex)statBuf.st_size);
@@ -560,7 +715,11 @@ __SCPreferencesAccess(SCPreferencesRef	prefs)
 		/*
 		 * load preferences
 		 */
-		dict = CFPropertyListCreateWithData(allocator, xmlData, kCFPropertyListImmutable, NULL, &error);
+		format = kCFPropertyListXMLFormat_v1_0;
+		dict = _SCCreatePropertyListWithXMLBytes(CFDataGetBytePtr(xmlData), CFDataGetLength(xmlData));
+		if (dict == NULL) {
+			dict = CFPropertyListCreateWithData(allocator, xmlData, kCFPropertyListImmutable, &format, &error);
+		}
 		CFRelease(xmlData);
 		if (dict == NULL) {
 			/* corrupt prefs file, start fresh */
@@ -582,6 +741,10 @@ __SCPreferencesAccess(SCPreferencesRef	prefs)
 		}
 
 		prefsPrivate->prefs = CFDictionaryCreateMutableCopy(allocator, 0, dict);
+		if (extra != NULL) {
+			extra->format = format;
+		}
+		__SCPreferencesCacheAdd(prefsPrivate->path, prefsPrivate->signature, dict, format);
 		CFRelease(dict);
 	}
 
@@ -603,6 +766,11 @@ __SCPreferencesAccess(SCPreferencesRef	prefs)
 		prefsPrivate->changed = FALSE;
 	}
 
+	if ((prefsPrivate->authorizationData == NULL) && (prefsPrivate->signature != NULL)) {
+		// apply any changes committed to the journal
+		__SCPreferencesJournalReplay(prefs);
+	}
+
 	SC_log(LOG_DEBUG, "SCPreferences() access: %s, size=%lld",
 	       prefsPrivate->newPath ? prefsPrivate->newPath : prefsPrivate->path,
 	       __SCPreferencesPrefsSize(prefs));
@@ -611,12 +779,283 @@ __SCPreferencesAccess(SCPreferencesRef	prefs)
 	return;
 }
 
+
+/*
+ * __SCPreferencesPathGetValue_lazy
+ *
+ * Same as SCPreferencesPathGetValue() but, until the preferences have
+ * been accessed (or changed), only the top-level and second-level
+ * entries along the path are materialized from the mapped file.
+ */
+__private_extern__ CFDictionaryRef
+__SCPreferencesPathGetValue_lazy(SCPreferencesRef prefs, CFStringRef path)
+{
+	SCPreferencesExtraRef	extra;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	CFDictionaryRef		value;
+
+	if (prefsPrivate->accessed ||
+	    (prefsPrivate->authorizationData != NULL) ||
+	    __SCPreferencesJournalExists(prefs)) {
+		// if already accessed (or if using the helper, or if there are journaled changes)
+		return __SCPreferencesPathGetValue(prefs, path);
+	}
+
+	extra = __SCPreferencesGetExtra(prefs);
+	if (extra == NULL) {
+		return __SCPreferencesPathGetValue(prefs, path);
+	}
+
+	if ((extra->document != NULL) &&
+	    ((prefsPrivate->signature == NULL) ||
+	     !CFEqual(__SCPDocumentGetSignature(extra->document), prefsPrivate->signature))) {
+		// if the preferences have been synchronized since the file was mapped
+		__SCPreferencesReleaseDocument(extra);
+	}
+
+	if (extra->document == NULL) {
+		CFDictionaryRef	cached;
+		int		fd;
+		CFDataRef	signature;
+		struct stat	statBuf;
+
+		if (stat(prefsPrivate->path, &statBuf) == 0) {
+			// if the [unchanged] file has already been parsed, use it
+			signature = __SCPSignatureFromStatbuf(&statBuf);
+			cached = __SCPreferencesCacheCopy(prefsPrivate->path, signature, NULL);
+			CFRelease(signature);
+			if (cached != NULL) {
+				CFRelease(cached);
+				return __SCPreferencesPathGetValue(prefs, path);
+			}
+		}
+
+		fd = open(prefsPrivate->path, O_RDONLY, 0644);
+		if (fd == -1) {
+			return __SCPreferencesPathGetValue(prefs, path);
+		}
+		if (fstat(fd, &statBuf) == 0) {
+			extra->document = __SCPDocumentCreate(fd, &statBuf);
+		}
+		(void) close(fd);
+		if (extra->document == NULL) {
+			return __SCPreferencesPathGetValue(prefs, path);
+		}
+
+		if (prefsPrivate->signature != NULL) CFRelease(prefsPrivate->signature);
+		prefsPrivate->signature = CFRetain(__SCPDocumentGetSignature(extra->document));
+	}
+
+	value = __SCPDocumentGetPathValue(extra->document, path);
+	_SCErrorSet((value != NULL) ? kSCStatusOK : kSCStatusNoKey);
+	return value;
+}
+
+
+/*
+ * __SCPreferencesCreateXMLData
+ *
+ * Returns the XML to be written for the preferences.  If the file has not
+ * changed since it was mapped, untouched entries are copied verbatim.
+ */
+__private_extern__ CFDataRef
+__SCPreferencesCreateXMLData(SCPreferencesRef prefs)
+{
+	SCPreferencesExtraRef	extra;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+
+	__SCPreferencesAccess(prefs);
+
+	extra = __SCPreferencesGetExtra(prefs);
+	if ((extra != NULL) &&
+	    (extra->document != NULL) &&
+	    (prefsPrivate->signature != NULL) &&
+	    CFEqual(__SCPDocumentGetSignature(extra->document), prefsPrivate->signature)) {
+		return __SCPDocumentCreateXMLData(extra->document, prefsPrivate->prefs);
+	}
+
+	return CFPropertyListCreateData(NULL,
+					prefsPrivate->prefs,
+					kCFPropertyListXMLFormat_v1_0,
+					0,
+					NULL);
+}
+
+
+/*
+ * __SCPreferencesGetStorageFormat
+ *
+ * Returns the format the preferences should be written in : the
+ * "storage-format" option if specified, otherwise the format of the
+ * file that was read.
+ */
+__private_extern__ CFPropertyListFormat
+__SCPreferencesGetStorageFormat(SCPreferencesRef prefs)
+{
+	SCPreferencesExtraRef	extra;
+	CFStringRef		format;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+
+	if (prefsPrivate->options != NULL) {
+		format = CFDictionaryGetValue(prefsPrivate->options, kSCPreferencesOptionStorageFormat);
+		if (isA_CFString(format)) {
+			if (CFEqual(format, kSCPreferencesStorageFormatBinary)) {
+				return kCFPropertyListBinaryFormat_v1_0;
+			} else if (CFEqual(format, kSCPreferencesStorageFormatXML)) {
+				return kCFPropertyListXMLFormat_v1_0;
+			}
+		}
+	}
+
+	extra = __SCPreferencesGetExtra(prefs);
+	return (extra != NULL) ? extra->format : kCFPropertyListXMLFormat_v1_0;
+}
+
+
+/*
+ * __SCPreferencesCreateData
+ *
+ * Returns the data to be written for the preferences, in the storage
+ * format.
+ */
+__private_extern__ CFDataRef
+__SCPreferencesCreateData(SCPreferencesRef prefs)
+{
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+
+	if (__SCPreferencesGetStorageFormat(prefs) != kCFPropertyListBinaryFormat_v1_0) {
+		return __SCPreferencesCreateXMLData(prefs);
+	}
+
+	__SCPreferencesAccess(prefs);
+	return CFPropertyListCreateData(NULL,
+					prefsPrivate->prefs,
+					kCFPropertyListBinaryFormat_v1_0,
+					0,
+					NULL);
+}
+
+
+Boolean
+_SCPreferencesConvertStorageFormat(SCPreferencesRef prefs, CFPropertyListFormat format)
+{
+	CFDataRef		data		= NULL;
+	SCPreferencesExtraRef	extra;
+	int			fd		= -1;
+	char			*newPath	= NULL;
+	Boolean			ok		= FALSE;
+	const char		*path;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	int			sc_status	= kSCStatusFailed;
+	struct stat		statBuf;
+	Boolean			wasLocked;
+
+	if ((format != kCFPropertyListXMLFormat_v1_0) && (format != kCFPropertyListBinaryFormat_v1_0)) {
+		_SCErrorSet(kSCStatusInvalidArgument);
+		return FALSE;
+	}
+
+	if (prefsPrivate->authorizationData != NULL) {
+		// conversion is not supported via the helper
+		_SCErrorSet(kSCStatusAccessError);
+		return FALSE;
+	}
+
+	wasLocked = prefsPrivate->locked;
+	if (!wasLocked && !__SCPreferencesLockTimed(prefs, TRUE)) {
+		return FALSE;
+	}
+
+	if (prefsPrivate->changed) {
+		// if uncommitted changes (we only change the format)
+		sc_status = kSCStatusStale;
+		goto done;
+	}
+
+	__SCPreferencesAccess(prefs);
+
+	path = (prefsPrivate->newPath != NULL) ? prefsPrivate->newPath : prefsPrivate->path;
+	if (stat(path, &statBuf) == -1) {
+		sc_status = (errno == ENOENT) ? kSCStatusNoConfigFile : kSCStatusFailed;
+		goto done;
+	}
+
+	extra = __SCPreferencesGetExtra(prefs);
+	if ((extra != NULL) && (extra->format == format)) {
+		// if already in the requested format
+		ok = TRUE;
+		goto done;
+	}
+
+	data = CFPropertyListCreateData(NULL, prefsPrivate->prefs, format, 0, NULL);
+	if (data == NULL) {
+		goto done;
+	}
+
+	// write the new file alongside the old and then rename it into place
+	if (asprintf(&newPath, "%s-convert", path) == -1) {
+		newPath = NULL;
+		goto done;
+	}
+	(void) unlink(newPath);
+	fd = open(newPath, O_WRONLY|O_CREAT|O_EXCL, statBuf.st_mode & 07777);
+	if (fd == -1) {
+		SC_log(LOG_NOTICE, "open() failed: %s", strerror(errno));
+		sc_status = (errno == EACCES) ? kSCStatusAccessError : kSCStatusFailed;
+		goto done;
+	}
+	(void) fchown(fd, statBuf.st_uid, statBuf.st_gid);
+
+	if ((write(fd, CFDataGetBytePtr(data), CFDataGetLength(data)) != CFDataGetLength(data)) ||
+	    (__SCPreferencesSyncTimed(prefs, fd) == -1)) {
+		SC_log(LOG_NOTICE, "write() failed: %s", strerror(errno));
+		(void) unlink(newPath);
+		goto done;
+	}
+	if (rename(newPath, path) == -1) {
+		SC_log(LOG_NOTICE, "rename() failed: %s", strerror(errno));
+		(void) unlink(newPath);
+		goto done;
+	}
+
+	// the file we read has been replaced
+	if (fstat(fd, &statBuf) == 0) {
+		if (prefsPrivate->signature != NULL) CFRelease(prefsPrivate->signature);
+		prefsPrivate->signature = __SCPSignatureFromStatbuf(&statBuf);
+	}
+	if (extra != NULL) {
+		__SCPreferencesReleaseDocument(extra);
+		extra->format = format;
+	}
+	__SCPreferencesStatsAdd(prefs, kSCPStatBytesWritten, (uint64_t)CFDataGetLength(data));
+
+	SC_log(LOG_INFO, "SCPreferences() converted: %s, %s, size=%ld",
+	       path,
+	       (format == kCFPropertyListBinaryFormat_v1_0) ? "binary" : "XML",
+	       (long)CFDataGetLength(data));
+	ok = TRUE;
+
+    done :
+
+	if (fd != -1)		(void) close(fd);
+	if (newPath != NULL)	free(newPath);
+	if (data != NULL)	CFRelease(data);
+	if (!wasLocked) {
+		(void) SCPreferencesUnlock(prefs);
+	}
+
+	_SCErrorSet(ok ? kSCStatusOK : sc_status);
+	return ok;
+}
+
+
 static void
 prefsNotify(SCDynamicStoreRef store, CFArrayRef changedKeys, void *info)
 {
-#pragma unused(store)
+	CFDictionaryRef			changes		= NULL;
 	void				*context_info;
 	void				(*context_release)(const void *);
+	SCPreferencesExtraRef		extra;
 	CFIndex				i;
 	CFIndex				n;
 	SCPreferencesNotification       notify		= 0;
@@ -650,6 +1089,11 @@ prefsNotify(SCDynamicStoreRef store, CFArrayRef changedKeys, void *info)
 		return;
 	}
 
+	if ((notify & kSCPreferencesNotificationCommit) != 0) {
+		// get the paths changed by the commit
+		changes = __SCPreferencesCopyNotifiedChanges(prefs, store);
+	}
+
 	pthread_mutex_lock(&prefsPrivate->lock);
 
 	/* callout */
@@ -670,8 +1114,16 @@ prefsNotify(SCDynamicStoreRef store, CFArrayRef changedKeys, void *info)
 		       (((notify & kSCPreferencesNotificationCommit) != 0) &&
 			((notify & kSCPreferencesNotificationApply ) != 0)) ? ", " : "",
 		       ((notify & kSCPreferencesNotificationApply)  != 0) ? "apply"  : "");
+		extra = __SCPreferencesGetExtra(prefs);
+		if (extra != NULL) {
+			extra->changes = changes;
+		}
 		(*rlsFunction)(prefs, notify, context_info);
+		if (extra != NULL) {
+			extra->changes = NULL;
+		}
 	}
+	if (changes != NULL) CFRelease(changes);
 
 	if (context_release != NULL) {
 		(*context_release)(context_info);
@@ -773,6 +1225,7 @@ __SCPreferencesUpdateLockedState(SCPreferencesRef prefs, Boolean locked)
 	static dispatch_queue_t		lockedQueue;
 	static CFMutableDictionaryRef	lockedState;
 	static dispatch_once_t		once;
+	SCPreferencesExtraRef		extra;
 	SCPreferencesPrivateRef		prefsPrivate	= (SCPreferencesPrivateRef)prefs;
 
 	dispatch_once(&once, ^{
@@ -835,6 +1288,17 @@ __SCPreferencesUpdateLockedState(SCPreferencesRef prefs, Boolean locked)
 		(void) os_state_add_handler(lockedQueue, state_block);
 	});
 
+	extra = __SCPreferencesGetExtra(prefs);
+	if (extra != NULL) {
+		if (locked) {
+			extra->lockAcquired = __SCPreferencesStatsNow();
+		} else if (prefsPrivate->locked) {
+			__SCPreferencesStatsAdd(prefs,
+						kSCPStatLockHold,
+						__SCPreferencesStatsNow() - extra->lockAcquired);
+		}
+	}
+
 	// update the locked state
 	prefsPrivate->locked = locked;
 
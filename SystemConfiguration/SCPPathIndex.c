@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: per-session index of resolved preferences paths
+ */
+
+#include "SCPreferencesInternal.h"
+
+
+/*
+ * Each session keeps a dictionary mapping a path to what it resolved to.
+ * An index entry is an array :
+ *
+ *   [0]		the resolved dictionary (or kCFNull if no such path)
+ *   [1], [2]		a top-level key and the value it had when resolved
+ *   ...		(one pair for the path and for each link followed)
+ *
+ * Changing the preferences (SCPreferencesSetValue, SCPreferencesPath-
+ * SetValue, ...) always replaces, rather than modifies, the affected
+ * top-level value so an entry is valid as long as each recorded top-level
+ * key still has the recorded value.  The index holds references to those
+ * values (and to the preferences dictionary itself, which is replaced on
+ * reload) so a pointer comparison is all that is needed.
+ */
+
+
+#define	kLinkKey		CFSTR("__LINK__")	// kSCResvLink
+#define	N_LINKS_MAX		8
+#define	N_INDEX_ENTRIES_MAX	4096
+
+
+static void
+indexFlush(SCPreferencesExtraRef extra)
+{
+	if (extra->pathIndex != NULL) {
+		CFRelease(extra->pathIndex);
+		extra->pathIndex = NULL;
+	}
+	if (extra->pathIndexPrefs != NULL) {
+		CFRelease(extra->pathIndexPrefs);
+		extra->pathIndexPrefs = NULL;
+	}
+	return;
+}
+
+
+static Boolean
+indexEntryIsValid(CFDictionaryRef prefs, CFArrayRef entry)
+{
+	CFIndex		i;
+	CFIndex		n	= CFArrayGetCount(entry);
+
+	for (i = 1; i + 1 < n; i += 2) {
+		CFTypeRef	root;
+		CFTypeRef	then;
+
+		root = CFDictionaryGetValue(prefs, CFArrayGetValueAtIndex(entry, i));
+		then = CFArrayGetValueAtIndex(entry, i + 1);
+		if (root != ((then != kCFNull) ? then : NULL)) {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+
+static CFDictionaryRef
+pathResolve(CFDictionaryRef prefs, CFStringRef path, CFMutableArrayRef entry)
+{
+	CFArrayRef		components;
+	CFIndex			i;
+	int			nLinks		= 0;
+	CFIndex			n;
+	CFMutableStringRef	newPath		= NULL;
+	CFTypeRef		value		= NULL;
+
+    restart :
+
+	components = CFStringCreateArrayBySeparatingStrings(NULL, path, CFSTR("/"));
+	n = CFArrayGetCount(components);
+	if ((n < 2) ||
+	    (CFStringGetLength(CFArrayGetValueAtIndex(components, 0)) != 0) ||
+	    (CFStringGetLength(CFArrayGetValueAtIndex(components, 1)) == 0)) {
+		// if not an absolute path (or if "/")
+		value = NULL;
+		goto done;
+	}
+
+	value = prefs;
+	for (i = 1; i < n; i++) {
+		CFStringRef	component	= CFArrayGetValueAtIndex(components, i);
+		CFStringRef	link;
+
+		if (CFStringGetLength(component) == 0) {
+			// if trailing (or empty) component
+			continue;
+		}
+
+		value = CFDictionaryGetValue(value, component);
+		if (i == 1) {
+			// remember the top-level value this lookup depends on
+			CFArrayAppendValue(entry, component);
+			CFArrayAppendValue(entry, (value != NULL) ? value : kCFNull);
+		}
+		if (!isA_CFDictionary(value)) {
+			value = NULL;
+			goto done;
+		}
+
+		link = CFDictionaryGetValue(value, kLinkKey);
+		if (isA_CFString(link)) {
+			CFIndex	j;
+
+			// follow the link, then the rest of the path
+			if (++nLinks > N_LINKS_MAX) {
+				value = NULL;
+				goto done;
+			}
+			if (newPath != NULL) CFRelease(newPath);
+			newPath = CFStringCreateMutableCopy(NULL, 0, link);
+			for (j = i + 1; j < n; j++) {
+				CFStringAppend(newPath, CFSTR("/"));
+				CFStringAppend(newPath, CFArrayGetValueAtIndex(components, j));
+			}
+			CFRelease(components);
+			path = newPath;
+			goto restart;
+		}
+	}
+
+    done :
+
+	CFRelease(components);
+	if (newPath != NULL) CFRelease(newPath);
+	return value;
+}
+
+
+/*
+ * __SCPreferencesPathGetValue
+ *
+ * Same as SCPreferencesPathGetValue() but remembers what each path
+ * resolved to so that, until the preferences are changed or reloaded,
+ * repeated lookups of a path are a hash probe.
+ */
+CFDictionaryRef
+__SCPreferencesPathGetValue(SCPreferencesRef prefs, CFStringRef path)
+{
+	CFMutableArrayRef	entry;
+	SCPreferencesExtraRef	extra;
+	CFArrayRef		indexed;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	CFDictionaryRef		value;
+
+	if (prefsPrivate->authorizationData != NULL) {
+		// if using the helper
+		return SCPreferencesPathGetValue(prefs, path);
+	}
+
+	extra = __SCPreferencesGetExtra(prefs);
+	if (extra == NULL) {
+		return SCPreferencesPathGetValue(prefs, path);
+	}
+
+	__SCPreferencesAccess(prefs);
+
+	if (extra->pathIndexPrefs != prefsPrivate->prefs) {
+		// if the preferences have been reloaded
+		indexFlush(extra);
+	}
+
+	if (extra->pathIndex != NULL) {
+		indexed = CFDictionaryGetValue(extra->pathIndex, path);
+		if (indexed != NULL) {
+			if (indexEntryIsValid(prefsPrivate->prefs, indexed)) {
+				value = CFArrayGetValueAtIndex(indexed, 0);
+				if (value == (CFDictionaryRef)kCFNull) {
+					_SCErrorSet(kSCStatusNoKey);
+					return NULL;
+				}
+				_SCErrorSet(kSCStatusOK);
+				return value;
+			}
+
+			// if stale
+			CFDictionaryRemoveValue(extra->pathIndex, path);
+		}
+	}
+
+	entry = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	CFArrayAppendValue(entry, kCFNull);
+	value = pathResolve(prefsPrivate->prefs, path, entry);
+	if (CFArrayGetCount(entry) == 1) {
+		// if not a path we index (e.g. "/")
+		CFRelease(entry);
+		return SCPreferencesPathGetValue(prefs, path);
+	}
+	if (value != NULL) {
+		CFArraySetValueAtIndex(entry, 0, value);
+	}
+
+	if (extra->pathIndex == NULL) {
+		extra->pathIndex = CFDictionaryCreateMutable(NULL,
+							     0,
+							     &kCFTypeDictionaryKeyCallBacks,
+							     &kCFTypeDictionaryValueCallBacks);
+		extra->pathIndexPrefs = CFRetain(prefsPrivate->prefs);
+	} else if (CFDictionaryGetCount(extra->pathIndex) >= N_INDEX_ENTRIES_MAX) {
+		CFDictionaryRemoveAllValues(extra->pathIndex);
+	}
+	CFDictionarySetValue(extra->pathIndex, path, entry);
+	CFRelease(entry);
+
+	_SCErrorSet((value != NULL) ? kSCStatusOK : kSCStatusNoKey);
+	return value;
+}
+
+
+__private_extern__ void
+__SCPreferencesPathIndexFlush(SCPreferencesExtraRef extra)
+{
+	indexFlush(extra);
+	return;
+}
@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: lock / commit / apply instrumentation
+ */
+
+#include <mach/mach_time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "SCPreferencesInternal.h"
+
+
+/*
+ * Per-process statistics for the preferences lock (how long we waited
+ * for it, how long we held it), commits (duration, bytes written, time
+ * spent syncing to disk) and applies.  Each statistic is kept as a
+ * count, total, maximum and a log2 histogram (bucket "i" counting the
+ * values up to 2^i).  The lock, commit and apply statistics are also
+ * kept per holder (the name the session was created with) so that the
+ * agents holding the lock for a long time can be found.
+ *
+ * Setting SCPREFERENCES_TRACE in the environment logs each event.
+ */
+
+
+#define	N_BUCKETS	40
+#define	N_HOLDERS_MAX	64	// beyond this, sessions are summarized as "(other)"
+
+
+typedef struct {
+	uint64_t	count;
+	uint64_t	total;
+	uint64_t	max;
+	uint64_t	buckets[N_BUCKETS];
+} statHistogram;
+
+
+typedef struct {
+	uint64_t	count;
+	uint64_t	total;
+	uint64_t	max;
+} statSummary;
+
+
+static const struct {
+	CFStringRef	key;
+	const char	*name;
+	const char	*units;
+} statNames[kSCPStatMax]	= {
+	{ CFSTR("LockWait"),		"lock wait",	"usec"	},
+	{ CFSTR("LockHold"),		"lock hold",	"usec"	},
+	{ CFSTR("Commit"),		"commit",	"usec"	},
+	{ CFSTR("BytesWritten"),	"write",	"bytes"	},
+	{ CFSTR("Sync"),		"sync",		"usec"	},
+	{ CFSTR("Apply"),		"apply",	"usec"	},
+};
+
+
+static statHistogram		stats[kSCPStatMax];
+static CFMutableDictionaryRef	stats_holders		= NULL;	// name --> CFData[kSCPStatMax] of statSummary
+static pthread_mutex_t		stats_lock		= PTHREAD_MUTEX_INITIALIZER;
+
+
+static Boolean
+traceEnabled(void)
+{
+	static Boolean		enabled	= FALSE;
+	static dispatch_once_t	once;
+
+	dispatch_once(&once, ^{
+		enabled = (getenv("SCPREFERENCES_TRACE") != NULL);
+	});
+
+	return enabled;
+}
+
+
+__private_extern__ uint64_t
+__SCPreferencesStatsNow(void)
+{
+	static mach_timebase_info_data_t	timebase	= { 0, 0 };
+
+	if (timebase.denom == 0) {
+		(void) mach_timebase_info(&timebase);
+	}
+
+	return mach_absolute_time() * timebase.numer / timebase.denom / 1000;
+}
+
+
+static int
+statBucket(uint64_t value)
+{
+	int	bucket	= 0;
+
+	while ((value > ((uint64_t)1 << bucket)) && (bucket < (N_BUCKETS - 1))) {
+		bucket++;
+	}
+
+	return bucket;
+}
+
+
+/*
+ * __SCPreferencesStatsAdd
+ *
+ * Records a lock, commit or apply event for the session.
+ */
+__private_extern__ void
+__SCPreferencesStatsAdd(SCPreferencesRef prefs, SCPStat stat, uint64_t value)
+{
+	CFMutableDataRef	holder;
+	CFStringRef		holderName;
+	CFStringRef		name		= NULL;
+	SCPreferencesPrivateRef	prefsPrivate	= (SCPreferencesPrivateRef)prefs;
+	statSummary		*summary;
+
+	if ((stat < 0) || (stat >= kSCPStatMax)) {
+		return;
+	}
+
+	if (prefsPrivate != NULL) {
+		name = prefsPrivate->name;
+	}
+	if (name == NULL) {
+		name = CFSTR("?");
+	}
+	holderName = name;
+
+	pthread_mutex_lock(&stats_lock);
+
+	stats[stat].count++;
+	stats[stat].total += value;
+	if (value > stats[stat].max) {
+		stats[stat].max = value;
+	}
+	stats[stat].buckets[statBucket(value)]++;
+
+	if (stats_holders == NULL) {
+		stats_holders = CFDictionaryCreateMutable(NULL,
+							  0,
+							  &kCFTypeDictionaryKeyCallBacks,
+							  &kCFTypeDictionaryValueCallBacks);
+	}
+	holder = (CFMutableDataRef)CFDictionaryGetValue(stats_holders, name);
+	if ((holder == NULL) && (CFDictionaryGetCount(stats_holders) >= N_HOLDERS_MAX)) {
+		holderName = CFSTR("(other)");
+		holder = (CFMutableDataRef)CFDictionaryGetValue(stats_holders, holderName);
+	}
+	if (holder == NULL) {
+		holder = CFDataCreateMutable(NULL, 0);
+		CFDataSetLength(holder, kSCPStatMax * sizeof(statSummary));	// zero-filled
+		CFDictionarySetValue(stats_holders, holderName, holder);
+		CFRelease(holder);
+	}
+	summary = &((statSummary *)(void *)CFDataGetMutableBytePtr(holder))[stat];
+	summary->count++;
+	summary->total += value;
+	if (value > summary->max) {
+		summary->max = value;
+	}
+
+	pthread_mutex_unlock(&stats_lock);
+
+	if (traceEnabled()) {
+		SC_log(LOG_NOTICE, "SCPreferences trace: %@ %s %llu %s",
+		       name,
+		       statNames[stat].name,
+		       (unsigned long long)value,
+		       statNames[stat].units);
+	}
+
+	return;
+}
+
+
+/*
+ * __SCPreferencesLockTimed
+ *
+ * SCPreferencesLock(), recording how long we waited for the lock.
+ */
+__private_extern__ Boolean
+__SCPreferencesLockTimed(SCPreferencesRef prefs, Boolean wait)
+{
+	Boolean		ok;
+	uint64_t	started;
+
+	started = __SCPreferencesStatsNow();
+	ok = SCPreferencesLock(prefs, wait);
+	if (ok) {
+		__SCPreferencesStatsAdd(prefs, kSCPStatLockWait, __SCPreferencesStatsNow() - started);
+	}
+
+	return ok;
+}
+
+
+/*
+ * __SCPreferencesSyncTimed
+ *
+ * fsync(), recording how long the sync took.
+ */
+__private_extern__ int
+__SCPreferencesSyncTimed(SCPreferencesRef prefs, int fd)
+{
+	int		ret;
+	uint64_t	started;
+
+	started = __SCPreferencesStatsNow();
+	ret = fsync(fd);
+	__SCPreferencesStatsAdd(prefs, kSCPStatSync, __SCPreferencesStatsNow() - started);
+
+	return ret;
+}
+
+
+static void
+addNumber(CFMutableDictionaryRef dict, CFStringRef key, uint64_t value)
+{
+	CFNumberRef	num;
+	SInt64		val	= (SInt64)value;
+
+	num = CFNumberCreate(NULL, kCFNumberSInt64Type, &val);
+	CFDictionarySetValue(dict, key, num);
+	CFRelease(num);
+	return;
+}
+
+
+static CFMutableDictionaryRef
+summaryCopyDictionary(uint64_t count, uint64_t total, uint64_t max)
+{
+	CFMutableDictionaryRef	dict;
+
+	dict = CFDictionaryCreateMutable(NULL,
+					 0,
+					 &kCFTypeDictionaryKeyCallBacks,
+					 &kCFTypeDictionaryValueCallBacks);
+	addNumber(dict, CFSTR("Count"), count);
+	addNumber(dict, CFSTR("Total"), total);
+	addNumber(dict, CFSTR("Max"), max);
+	return dict;
+}
+
+
+static void
+appendHolder(const void *key, const void *value, void *context)
+{
+	CFMutableDictionaryRef	dict;
+	CFMutableDictionaryRef	holders		= (CFMutableDictionaryRef)context;
+	int			i;
+	const statSummary	*summary;
+
+	summary = (const statSummary *)(const void *)CFDataGetBytePtr((CFDataRef)value);
+	dict = CFDictionaryCreateMutable(NULL,
+					 0,
+					 &kCFTypeDictionaryKeyCallBacks,
+					 &kCFTypeDictionaryValueCallBacks);
+	for (i = 0; i < kSCPStatMax; i++) {
+		CFMutableDictionaryRef	stat;
+
+		if (summary[i].count == 0) {
+			continue;
+		}
+		stat = summaryCopyDictionary(summary[i].count, summary[i].total, summary[i].max);
+		CFDictionarySetValue(dict, statNames[i].key, stat);
+		CFRelease(stat);
+	}
+	CFDictionarySetValue(holders, key, dict);
+	CFRelease(dict);
+	return;
+}
+
+
+/*
+ * _SCPreferencesCopyStatistics
+ *
+ * Returns the lock / commit / apply statistics of this process :
+ *   <stat> = { Count, Total, Max, Histogram = [ n <= 1, n <= 2, n <= 4, ... ] }
+ *   Holders = { <name> = { <stat> = { Count, Total, Max } } }
+ * Times are in microseconds, sizes in bytes.
+ */
+CFDictionaryRef
+_SCPreferencesCopyStatistics(void)
+{
+	CFMutableDictionaryRef	dict;
+	CFMutableDictionaryRef	holders;
+	int			i;
+
+	dict = CFDictionaryCreateMutable(NULL,
+					 0,
+					 &kCFTypeDictionaryKeyCallBacks,
+					 &kCFTypeDictionaryValueCallBacks);
+	holders = CFDictionaryCreateMutable(NULL,
+					    0,
+					    &kCFTypeDictionaryKeyCallBacks,
+					    &kCFTypeDictionaryValueCallBacks);
+
+	pthread_mutex_lock(&stats_lock);
+
+	for (i = 0; i < kSCPStatMax; i++) {
+		int			b;
+		CFMutableArrayRef	histogram;
+		int			last;
+		CFMutableDictionaryRef	stat;
+
+		if (stats[i].count == 0) {
+			continue;
+		}
+
+		stat = summaryCopyDictionary(stats[i].count, stats[i].total, stats[i].max);
+		for (last = N_BUCKETS - 1; (last > 0) && (stats[i].buckets[last] == 0); last--) {
+			// find the last non-empty bucket
+		}
+		histogram = CFArrayCreateMutable(NULL, last + 1, &kCFTypeArrayCallBacks);
+		for (b = 0; b <= last; b++) {
+			CFNumberRef	num;
+			SInt64		val	= (SInt64)stats[i].buckets[b];
+
+			num = CFNumberCreate(NULL, kCFNumberSInt64Type, &val);
+			CFArrayAppendValue(histogram, num);
+			CFRelease(num);
+		}
+		CFDictionarySetValue(stat, CFSTR("Histogram"), histogram);
+		CFRelease(histogram);
+		CFDictionarySetValue(dict, statNames[i].key, stat);
+		CFRelease(stat);
+	}
+
+	if (stats_holders != NULL) {
+		CFDictionaryApplyFunction(stats_holders, appendHolder, holders);
+	}
+
+	pthread_mutex_unlock(&stats_lock);
+
+	CFDictionarySetValue(dict, CFSTR("Holders"), holders);
+	CFRelease(holders);
+
+	return dict;
+}
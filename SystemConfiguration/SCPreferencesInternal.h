@@ -63,7 +63,77 @@
 #define	INTERFACES			CFSTR("Interfaces")
 
 
-/* Define the per-preference-handle structure */
+/*
+ * storage format option (CFString); when not specified, preferences are
+ * written back in the format they were read in (XML for new files)
+ */
+#define	kSCPreferencesOptionStorageFormat	CFSTR("storage-format")
+#define	kSCPreferencesStorageFormatXML		CFSTR("xml")
+#define	kSCPreferencesStorageFormatBinary	CFSTR("binary")
+
+
+/*
+ * journal option (CFBoolean); journaled commits (_SCPreferencesCommitJournal)
+ * are only allowed for sessions created with this option
+ */
+#define	kSCPreferencesOptionJournal		CFSTR("journal")
+
+
+/*
+ * journal compaction threshold option (CFNumber, bytes); once the journal
+ * of changes committed with _SCPreferencesCommitJournal() grows past this
+ * size it is folded back into the preferences file
+ */
+#define	kSCPreferencesOptionJournalCompactSize	CFSTR("journal-compact-size")
+
+
+/*
+ * change set (see _SCPreferencesGetChanges) keys; each is a CFArray of
+ * paths ("/key" or "/key/subkey")
+ */
+#define	kSCPreferencesChangesAdded		CFSTR("Added")
+#define	kSCPreferencesChangesRemoved		CFSTR("Removed")
+#define	kSCPreferencesChangesModified		CFSTR("Modified")
+
+
+/*
+ * commit latency (see _SCPreferencesCopyCommitLatency) keys; each is a
+ * CFNumber (the latencies in microseconds)
+ */
+#define	kSCPreferencesLatencyCount		CFSTR("Count")
+#define	kSCPreferencesLatencyP50		CFSTR("P50")
+#define	kSCPreferencesLatencyP90		CFSTR("P90")
+#define	kSCPreferencesLatencyP99		CFSTR("P99")
+#define	kSCPreferencesLatencyMax		CFSTR("Max")
+
+
+/* lock / commit / apply statistics (see _SCPreferencesCopyStatistics) */
+typedef enum {
+	kSCPStatLockWait	= 0,	// usec
+	kSCPStatLockHold,		// usec
+	kSCPStatCommit,			// usec
+	kSCPStatBytesWritten,		// bytes
+	kSCPStatSync,			// usec
+	kSCPStatApply,			// usec
+	kSCPStatMax
+} SCPStat;
+
+
+/* asynchronous commit / apply completion handler */
+typedef void (^SCPreferencesCompletionHandler)(Boolean ok, int sc_status);
+
+
+/* mmap-backed, lazily materialized preferences file */
+typedef struct __SCPDocument	*SCPDocumentRef;
+
+
+/*
+ * Define the per-preference-handle structure
+ *
+ * Note: the SCPreferences objects are allocated by the SystemConfiguration
+ *       framework; this layout must match the framework's.  Any state that
+ *       is specific to this library belongs in SCPreferencesExtra.
+ */
 typedef struct {
 
 	/* base CFType information */
@@ -132,6 +202,39 @@ typedef struct {
 } SCPreferencesPrivate, *SCPreferencesPrivateRef;
 
 
+/* Define the additional per-preference-handle state (see __SCPreferencesGetExtra) */
+typedef struct {
+
+	/* preferences */
+	SCPDocumentRef		document;	// the mapped file [backing] prefs
+	CFPropertyListFormat	format;		// of the file, as read
+
+	/* preferences lock */
+	uint64_t		lockAcquired;	// __SCPreferencesStatsNow()
+
+	/* resolved paths */
+	CFMutableDictionaryRef	pathIndex;	// path --> [ value, top-level key, value, ... ]
+	CFDictionaryRef		pathIndexPrefs;	// the prefs the index was built from
+
+	/* journal */
+	CFDictionaryRef		journalBase;	// the prefs as read (with the journal applied), to diff / rebase against
+	off_t			journalSize;	// valid length of the journal, as read
+
+	/* change sets */
+	CFDictionaryRef		changes;	// of the commit being reported to the callback
+	CFDataRef		changesToken;	// state of the preferences when last notified
+
+	/* asynchronous commit, manipulate under (the session) lock */
+	dispatch_queue_t	asyncQueue;	// serializes the commits / applies
+	SCPreferencesRef	asyncPrefs;	// the worker session
+	CFDictionaryRef		asyncSnapshot;	// the prefs to be committed
+	struct __SCPreferencesCompletion *asyncCompletions;
+	uint64_t		asyncRequested;	// usec
+	Boolean			asyncScheduled;
+
+} SCPreferencesExtra, *SCPreferencesExtraRef;
+
+
 /* Define signature data */
 typedef struct {
 	int64_t		st_dev;		/* inode's device */
@@ -159,6 +262,18 @@ __SCPreferencesCreate_helper		(SCPreferencesRef	prefs);
 void
 __SCPreferencesAccess			(SCPreferencesRef	prefs);
 
+/*
+ * __SCPreferencesGetExtra
+ * - returns the additional state of the preferences session (created on
+ *   first use and released when the session is deallocated); NULL if the
+ *   state could not be allocated
+ */
+SCPreferencesExtraRef
+__SCPreferencesGetExtra			(SCPreferencesRef	prefs);
+
+void
+__SCPreferencesReleaseDocument		(SCPreferencesExtraRef	extra);
+
 void
 __SCPreferencesAddSessionKeys		(SCPreferencesRef       prefs);
 
@@ -193,6 +308,281 @@ _SCPNotificationKey			(CFAllocatorRef		allocator,
 					 CFStringRef		prefsID,
 					 int			keyType);
 
+/*
+ * __SCStringCreateInterned, __SCKeyCreateInterned
+ * - return the process-wide (shared, immutable) instance of a store key
+ *   or preferences path.  __SCKeyCreateInterned() joins the prefix and a
+ *   NULL terminated list of components with "/" (e.g. a prefix of
+ *   kSCDynamicStoreDomainState for a store key, or CFSTR("") for a
+ *   preferences path).  The returned string follows the Create rule.
+ */
+CF_RETURNS_RETAINED
+CFStringRef
+__SCStringCreateInterned		(const CFStringRef	*pieces,
+					 CFIndex		nPieces);
+
+CF_RETURNS_RETAINED
+CFStringRef
+__SCKeyCreateInterned			(CFStringRef		prefix,
+					 ...);
+
+SCPDocumentRef
+__SCPDocumentCreate			(int			fd,
+					 const struct stat	*statBuf);
+
+void
+__SCPDocumentRelease			(SCPDocumentRef		doc);
+
+CFDataRef
+__SCPDocumentGetSignature		(SCPDocumentRef		doc);
+
+CFDictionaryRef
+__SCPDocumentGetPreferences		(SCPDocumentRef		doc);
+
+CFDictionaryRef
+__SCPDocumentGetPathValue		(SCPDocumentRef		doc,
+					 CFStringRef		path);
+
+CF_RETURNS_RETAINED
+CFDataRef
+__SCPDocumentCreateXMLData		(SCPDocumentRef		doc,
+					 CFDictionaryRef	prefs);
+
+CFDictionaryRef
+__SCPreferencesPathGetValue_lazy	(SCPreferencesRef	prefs,
+					 CFStringRef		path);
+
+CF_RETURNS_RETAINED
+CFDataRef
+__SCPreferencesCreateXMLData		(SCPreferencesRef	prefs);
+
+/*
+ * __SCPreferencesPathGetValue
+ * - same as SCPreferencesPathGetValue() but backed by a per-session
+ *   index of resolved paths
+ */
+CFDictionaryRef
+__SCPreferencesPathGetValue		(SCPreferencesRef	prefs,
+					 CFStringRef		path);
+
+void
+__SCPreferencesPathIndexFlush		(SCPreferencesExtraRef	extra);
+
+/*
+ * __SCPreferencesCacheCopy, __SCPreferencesCacheAdd
+ * - a process-wide cache of [immutable] parsed preferences, keyed by
+ *   path and file signature
+ */
+CF_RETURNS_RETAINED
+CFDictionaryRef
+__SCPreferencesCacheCopy		(const char		*path,
+					 CFDataRef		signature,
+					 CFPropertyListFormat	*format);
+
+void
+__SCPreferencesCacheAdd			(const char		*path,
+					 CFDataRef		signature,
+					 CFDictionaryRef	prefs,
+					 CFPropertyListFormat	format);
+
+void
+__SCPreferencesCacheFlush		(void);
+
+CFPropertyListFormat
+__SCPreferencesGetStorageFormat		(SCPreferencesRef	prefs);
+
+CF_RETURNS_RETAINED
+CFDataRef
+__SCPreferencesCreateData		(SCPreferencesRef	prefs);
+
+/*
+ * _SCPreferencesConvertStorageFormat
+ * - rewrites the preferences file in the requested format (under the
+ *   preferences lock); the content is not changed
+ */
+Boolean
+_SCPreferencesConvertStorageFormat	(SCPreferencesRef	prefs,
+					 CFPropertyListFormat	format);
+
+void
+__SCPreferencesJournalReplay		(SCPreferencesRef	prefs);
+
+Boolean
+__SCPreferencesJournalExists		(SCPreferencesRef	prefs);
+
+Boolean
+__SCPreferencesJournalCompact		(SCPreferencesRef	prefs);
+
+Boolean
+__SCPreferencesIsCurrent		(SCPreferencesRef	prefs);
+
+CF_RETURNS_RETAINED
+CFDictionaryRef
+__SCPreferencesCreateChanges		(CFDictionaryRef	before,
+					 CFDictionaryRef	after);
+
+void
+__SCPreferencesCommitted		(SCPreferencesRef	prefs,
+					 off_t			journalSize);
+
+CF_RETURNS_RETAINED
+CFDictionaryRef
+__SCPreferencesCopyNotifiedChanges	(SCPreferencesRef	prefs,
+					 SCDynamicStoreRef	store);
+
+/*
+ * _SCPreferencesGetChanges, _SCPreferencesPathChanged
+ * - for use by an SCPreferences callback reporting a commit : returns the
+ *   paths added, removed and modified by the commit (NULL if not known)
+ *   and whether a path (or a path below or above it) was changed (TRUE
+ *   if not known)
+ */
+CFDictionaryRef
+_SCPreferencesGetChanges		(SCPreferencesRef	prefs);
+
+Boolean
+_SCPreferencesPathChanged		(SCPreferencesRef	prefs,
+					 CFStringRef		path);
+
+/*
+ * _SCPreferencesCommitOptimistic, _SCPreferencesRebase
+ * - commits the changes only if the preferences have not been committed
+ *   by others since they were read (without holding the preferences lock
+ *   while reading and changing them); fails with kSCStatusStale if they
+ *   have.  _SCPreferencesRebase() re-applies the changes to the current
+ *   preferences, failing with kSCStatusStale if they conflict.
+ */
+Boolean
+_SCPreferencesCommitOptimistic		(SCPreferencesRef	prefs);
+
+Boolean
+_SCPreferencesRebase			(SCPreferencesRef	prefs);
+
+int
+__SCPreferencesLockFileOpen		(SCPreferencesRef	prefs);
+
+void
+__SCPreferencesGroupRecover		(SCPreferencesRef	prefs);
+
+/*
+ * _SCPreferencesCommitGroup
+ * - commits the changes made to the preferences, their parent and their
+ *   companions (SCPreferencesCreateCompanion) as a unit, with a single
+ *   full sync
+ */
+Boolean
+_SCPreferencesCommitGroup		(SCPreferencesRef	prefs);
+
+/*
+ * _SCPreferencesCommitJournal
+ * - commits the changes by appending them to "<file>.journal" rather than
+ *   rewriting the preferences file.  The journal is applied when the
+ *   preferences are read by this library (SCPreferencesPathGetValue()
+ *   and friends in the SystemConfiguration framework do not) and is
+ *   periodically compacted.  The session must have been created with
+ *   the kSCPreferencesOptionJournal option and the preferences must not
+ *   be in the default directory; otherwise kSCStatusInvalidArgument.
+ */
+Boolean
+_SCPreferencesCommitJournal		(SCPreferencesRef	prefs);
+
+/*
+ * _SCPreferencesCommitChangesAsync, _SCPreferencesApplyChangesAsync
+ * - commit (apply) the changes on a background worker and call the
+ *   handler on the given queue when done.  Back-to-back commits from
+ *   the same session are coalesced.  Commits fail with kSCStatusStale
+ *   if others have committed since the preferences were read.
+ */
+Boolean
+_SCPreferencesCommitChangesAsync	(SCPreferencesRef			prefs,
+					 dispatch_queue_t			queue,
+					 SCPreferencesCompletionHandler		handler);
+
+Boolean
+_SCPreferencesApplyChangesAsync		(SCPreferencesRef			prefs,
+					 dispatch_queue_t			queue,
+					 SCPreferencesCompletionHandler		handler);
+
+CF_RETURNS_RETAINED
+CFDictionaryRef
+_SCPreferencesCopyCommitLatency		(void);
+
+void
+__SCPreferencesAsyncRelease		(SCPreferencesExtraRef	extra);
+
+uint64_t
+__SCPreferencesStatsNow			(void);
+
+void
+__SCPreferencesStatsAdd			(SCPreferencesRef	prefs,
+					 SCPStat		stat,
+					 uint64_t		value);
+
+Boolean
+__SCPreferencesLockTimed		(SCPreferencesRef	prefs,
+					 Boolean		wait);
+
+int
+__SCPreferencesSyncTimed		(SCPreferencesRef	prefs,
+					 int			fd);
+
+/*
+ * _SCPreferencesCopyStatistics
+ * - returns the preferences lock wait / hold, commit, write, sync and
+ *   apply statistics of this process (overall and by session name)
+ */
+CF_RETURNS_RETAINED
+CFDictionaryRef
+_SCPreferencesCopyStatistics		(void);
+
+/*
+ * _SCCreatePropertyListWithXMLBytes
+ * - a fast (SIMD scanning, interning) XML property list parser.  Returns
+ *   NULL if the XML is malformed or uses a form it does not handle; the
+ *   caller should then fall back to CFPropertyListCreateWithData().
+ */
+CF_RETURNS_RETAINED
+CFPropertyListRef
+_SCCreatePropertyListWithXMLBytes	(const UInt8		*bytes,
+					 CFIndex		len);
+
+CF_RETURNS_RETAINED
+CFPropertyListRef
+__SCCreatePropertyListFromResource	(CFURLRef		url);
+
+/*
+ * interned equivalents of the SCPreferencesPathKeyCreate*() and
+ * SCDynamicStoreKeyCreate*() convenience routines (a NULL entity
+ * returns the path/key of the parent)
+ */
+static __inline__ CFStringRef
+__SCPreferencesPathKeyCreateNetworkServiceEntity(CFAllocatorRef allocator, CFStringRef service, CFStringRef entity)
+{
+#pragma unused(allocator)
+	return __SCKeyCreateInterned(CFSTR(""), kSCPrefNetworkServices, service, entity, NULL);
+}
+
+static __inline__ CFStringRef
+__SCPreferencesPathKeyCreateSetNetworkServiceEntity(CFAllocatorRef allocator, CFStringRef set, CFStringRef service, CFStringRef entity)
+{
+#pragma unused(allocator)
+	return __SCKeyCreateInterned(CFSTR(""), kSCPrefSets, set, kSCCompNetwork, kSCCompService, service, entity, NULL);
+}
+
+static __inline__ CFStringRef
+__SCPreferencesPathKeyCreateSetNetworkInterfaceEntity(CFAllocatorRef allocator, CFStringRef set, CFStringRef ifname, CFStringRef entity)
+{
+#pragma unused(allocator)
+	return __SCKeyCreateInterned(CFSTR(""), kSCPrefSets, set, kSCCompNetwork, kSCCompInterface, ifname, entity, NULL);
+}
+
+static __inline__ CFStringRef
+__SCDynamicStoreKeyCreateNetworkServiceEntity(CFAllocatorRef allocator, CFStringRef domain, CFStringRef service, CFStringRef entity)
+{
+#pragma unused(allocator)
+	return __SCKeyCreateInterned(domain, kSCCompNetwork, kSCCompService, service, entity, NULL);
+}
+
 uint32_t
 __SCPreferencesGetNetworkConfigurationFlags
 					(SCPreferencesRef	prefs);
@@ -0,0 +1,908 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: streaming XML property list parser
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#if	defined(__SSE2__)
+#include <emmintrin.h>
+#elif	defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif	// __ARM_NEON
+
+#include "SCPreferencesInternal.h"
+
+
+/*
+ * A single pass, non-validating parser for the XML property lists that
+ * we read on hot paths (preferences, NetworkConfiguration.plist).
+ *
+ * - text content is scanned 16 bytes at a time for the next '<' or '&'
+ * - dictionary keys and short strings are interned for the duration of
+ *   the parse (preferences repeat the same keys and values many times)
+ * - immutable CF objects are created directly; container contents are
+ *   collected on a shared stack so no per-container buffers are needed
+ *
+ * The parser handles everything that CFPropertyListCreateData() writes.
+ * For anything else (e.g. unusual integer or date forms) it gives up and
+ * returns NULL; callers then fall back to CFPropertyListCreateWithData(),
+ * which also reports the error.
+ */
+
+
+#define	N_DEPTH_MAX		256
+#define	N_STRING_CACHE		1024	// power of 2
+#define	STRING_CACHE_LEN_MAX	64
+
+
+typedef struct {
+	uint32_t	hash;
+	CFIndex		len;
+	const UInt8	*bytes;		// in the input
+	CFStringRef	str;
+} stringCacheEntry;
+
+
+typedef struct {
+	const UInt8		*p;
+	const UInt8		*end;
+	int			depth;
+
+	/* container contents (keys only used for dictionaries) */
+	CFTypeRef		*keys;
+	CFTypeRef		*values;
+	CFIndex			nValues;
+	CFIndex			nAlloc;
+
+	/* decoded text (entities, CDATA) */
+	UInt8			*text;
+	CFIndex			textAlloc;
+
+	stringCacheEntry	cache[N_STRING_CACHE];
+} parserState, *parserStateRef;
+
+
+#pragma mark -
+#pragma mark Scanning
+
+
+static const UInt8 *
+scanText(const UInt8 *p, const UInt8 *end)
+{
+#if	defined(__SSE2__)
+	const __m128i	amp	= _mm_set1_epi8('&');
+	const __m128i	lt	= _mm_set1_epi8('<');
+
+	while ((end - p) >= 16) {
+		int	mask;
+		__m128i	v;
+
+		v = _mm_loadu_si128((const __m128i *)(const void *)p);
+		mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, lt),
+						      _mm_cmpeq_epi8(v, amp)));
+		if (mask != 0) {
+			return p + __builtin_ctz(mask);
+		}
+		p += 16;
+	}
+#elif	defined(__ARM_NEON)
+	const uint8x16_t	amp	= vdupq_n_u8('&');
+	const uint8x16_t	lt	= vdupq_n_u8('<');
+
+	while ((end - p) >= 16) {
+		uint64_t	mask;
+		uint8x16_t	v;
+
+		v = vld1q_u8(p);
+		v = vorrq_u8(vceqq_u8(v, lt), vceqq_u8(v, amp));
+		// 4 bits per byte
+		mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+		if (mask != 0) {
+			return p + (__builtin_ctzll(mask) >> 2);
+		}
+		p += 16;
+	}
+#endif	// __ARM_NEON
+
+	while ((p < end) && (*p != '<') && (*p != '&')) {
+		p++;
+	}
+	return p;
+}
+
+
+static Boolean
+hasPrefix(parserStateRef state, const char *str, size_t len)
+{
+	return (((size_t)(state->end - state->p) >= len) && (memcmp(state->p, str, len) == 0));
+}
+
+
+/*
+ * skipMisc
+ * - skips white space, comments, processing instructions and <!DOCTYPE>
+ */
+static Boolean
+skipMisc(parserStateRef state)
+{
+	while (TRUE) {
+		while ((state->p < state->end) &&
+		       ((*state->p == ' ') || (*state->p == '\t') || (*state->p == '\n') || (*state->p == '\r'))) {
+			state->p++;
+		}
+
+		if (hasPrefix(state, "<!--", 4)) {
+			const UInt8	*q;
+
+			q = memmem(state->p + 4, state->end - state->p - 4, "-->", 3);
+			if (q == NULL) {
+				return FALSE;
+			}
+			state->p = q + 3;
+		} else if (hasPrefix(state, "<?", 2) || hasPrefix(state, "<!DOCTYPE", 9)) {
+			const UInt8	*q;
+
+			q = memchr(state->p, '>', state->end - state->p);
+			if (q == NULL) {
+				return FALSE;
+			}
+			state->p = q + 1;
+		} else {
+			return TRUE;
+		}
+	}
+}
+
+
+/*
+ * parseTag
+ * - parses "<name ...>" or "<name .../>", returning the name
+ */
+static Boolean
+parseTag(parserStateRef state, const UInt8 **name, CFIndex *nameLen, Boolean *empty)
+{
+	const UInt8	*q;
+
+	if ((state->p >= state->end) || (*state->p != '<')) {
+		return FALSE;
+	}
+	*name = state->p + 1;
+	for (q = *name; (q < state->end) && (*q >= 'a') && (*q <= 'z'); q++) {
+	}
+	*nameLen = q - *name;
+	if (*nameLen == 0) {
+		return FALSE;
+	}
+
+	q = memchr(q, '>', state->end - q);
+	if (q == NULL) {
+		return FALSE;
+	}
+	*empty = (q[-1] == '/');
+	state->p = q + 1;
+
+	return TRUE;
+}
+
+
+static Boolean
+parseCloseTag(parserStateRef state, const char *name, CFIndex nameLen)
+{
+	if (((state->end - state->p) < (nameLen + 3)) ||
+	    (state->p[0] != '<') ||
+	    (state->p[1] != '/') ||
+	    (memcmp(state->p + 2, name, nameLen) != 0) ||
+	    (state->p[2 + nameLen] != '>')) {
+		return FALSE;
+	}
+	state->p += nameLen + 3;
+	return TRUE;
+}
+
+
+#pragma mark -
+#pragma mark Text
+
+
+static void
+textAppend(parserStateRef state, CFIndex *len, const UInt8 *bytes, CFIndex n)
+{
+	if ((*len + n) > state->textAlloc) {
+		state->textAlloc = (*len + n) * 2;
+		state->text = reallocf(state->text, state->textAlloc);
+	}
+	if (state->text != NULL) {
+		memcpy(state->text + *len, bytes, n);
+		*len += n;
+	}
+	return;
+}
+
+
+static Boolean
+decodeEntity(parserStateRef state, CFIndex *len)
+{
+	UInt8		buf[4];
+	uint32_t	c	= 0;
+	const UInt8	*q;
+
+	// state->p is at the '&'
+	q = memchr(state->p, ';', MIN(state->end - state->p, 12));
+	if (q == NULL) {
+		return FALSE;
+	}
+
+	if (state->p[1] == '#') {
+		const UInt8	*d	= state->p + 2;
+		int		base	= 10;
+
+		if ((d < q) && (*d == 'x')) {
+			base = 16;
+			d++;
+		}
+		if (d == q) {
+			return FALSE;
+		}
+		for (; d < q; d++) {
+			int	v;
+
+			if ((*d >= '0') && (*d <= '9')) {
+				v = *d - '0';
+			} else if ((base == 16) && (*d >= 'a') && (*d <= 'f')) {
+				v = *d - 'a' + 10;
+			} else if ((base == 16) && (*d >= 'A') && (*d <= 'F')) {
+				v = *d - 'A' + 10;
+			} else {
+				return FALSE;
+			}
+			c = (c * base) + v;
+			if (c > 0x10ffff) {
+				return FALSE;
+			}
+		}
+	} else {
+		size_t	n	= q - state->p - 1;
+
+		if ((n == 3) && (memcmp(state->p + 1, "amp", 3) == 0)) {
+			c = '&';
+		} else if ((n == 2) && (memcmp(state->p + 1, "lt", 2) == 0)) {
+			c = '<';
+		} else if ((n == 2) && (memcmp(state->p + 1, "gt", 2) == 0)) {
+			c = '>';
+		} else if ((n == 4) && (memcmp(state->p + 1, "quot", 4) == 0)) {
+			c = '"';
+		} else if ((n == 4) && (memcmp(state->p + 1, "apos", 4) == 0)) {
+			c = '\'';
+		} else {
+			return FALSE;
+		}
+	}
+
+	// as UTF-8
+	if (c < 0x80) {
+		buf[0] = c;
+		textAppend(state, len, buf, 1);
+	} else if (c < 0x800) {
+		buf[0] = 0xc0 | (c >> 6);
+		buf[1] = 0x80 | (c & 0x3f);
+		textAppend(state, len, buf, 2);
+	} else if (c < 0x10000) {
+		buf[0] = 0xe0 | (c >> 12);
+		buf[1] = 0x80 | ((c >> 6) & 0x3f);
+		buf[2] = 0x80 | (c & 0x3f);
+		textAppend(state, len, buf, 3);
+	} else {
+		buf[0] = 0xf0 | (c >> 18);
+		buf[1] = 0x80 | ((c >> 12) & 0x3f);
+		buf[2] = 0x80 | ((c >> 6) & 0x3f);
+		buf[3] = 0x80 | (c & 0x3f);
+		textAppend(state, len, buf, 4);
+	}
+
+	state->p = q + 1;
+	return TRUE;
+}
+
+
+/*
+ * parseText
+ * - returns the content of the element up to its closing tag.  Text
+ *   without entities (or CDATA) is returned in place; otherwise it is
+ *   decoded into state->text.
+ */
+static Boolean
+parseText(parserStateRef	state,
+	  const char		*name,
+	  CFIndex		nameLen,
+	  const UInt8		**text,
+	  CFIndex		*textLen,
+	  Boolean		*decoded)
+{
+	CFIndex		len	= 0;
+	const UInt8	*start	= state->p;
+
+	*decoded = FALSE;
+
+	while (TRUE) {
+		const UInt8	*q;
+
+		q = scanText(state->p, state->end);
+		if (q >= state->end) {
+			return FALSE;
+		}
+
+		if ((*q == '<') && ((q + 1) < state->end) && (q[1] == '/')) {
+			// if the closing tag
+			if (*decoded) {
+				textAppend(state, &len, state->p, q - state->p);
+				*text = state->text;
+				*textLen = len;
+			} else {
+				*text = start;
+				*textLen = q - start;
+			}
+			state->p = q;
+			if (*decoded && (state->text == NULL)) {
+				return FALSE;
+			}
+			return parseCloseTag(state, name, nameLen);
+		}
+
+		// switch to decoding
+		if (!*decoded) {
+			*decoded = TRUE;
+			len = 0;
+		}
+		textAppend(state, &len, state->p, q - state->p);
+		state->p = q;
+
+		if (*q == '&') {
+			if (!decodeEntity(state, &len)) {
+				return FALSE;
+			}
+		} else if (hasPrefix(state, "<![CDATA[", 9)) {
+			const UInt8	*cdataEnd;
+
+			state->p += 9;
+			cdataEnd = memmem(state->p, state->end - state->p, "]]>", 3);
+			if (cdataEnd == NULL) {
+				return FALSE;
+			}
+			textAppend(state, &len, state->p, cdataEnd - state->p);
+			state->p = cdataEnd + 3;
+		} else {
+			// if markup (e.g. a comment) within the text
+			return FALSE;
+		}
+	}
+}
+
+
+static CFStringRef
+createString(parserStateRef state, const UInt8 *bytes, CFIndex len, Boolean decoded)
+{
+	uint32_t		hash	= 2166136261U;		// FNV-1a
+	CFIndex			i;
+	stringCacheEntry	*entry;
+
+	if (decoded || (len > STRING_CACHE_LEN_MAX)) {
+		return CFStringCreateWithBytes(NULL, bytes, len, kCFStringEncodingUTF8, FALSE);
+	}
+
+	for (i = 0; i < len; i++) {
+		hash = (hash ^ bytes[i]) * 16777619U;
+	}
+
+	entry = &state->cache[hash & (N_STRING_CACHE - 1)];
+	if ((entry->str != NULL) &&
+	    (entry->hash == hash) &&
+	    (entry->len == len) &&
+	    (memcmp(entry->bytes, bytes, len) == 0)) {
+		return CFRetain(entry->str);
+	}
+
+	if (entry->str != NULL) CFRelease(entry->str);
+	entry->str = CFStringCreateWithBytes(NULL, bytes, len, kCFStringEncodingUTF8, FALSE);
+	entry->hash = hash;
+	entry->len = len;
+	entry->bytes = bytes;
+
+	return (entry->str != NULL) ? CFRetain(entry->str) : NULL;
+}
+
+
+#pragma mark -
+#pragma mark Scalars
+
+
+static CFNumberRef
+createInteger(const UInt8 *text, CFIndex len)
+{
+	Boolean		negative	= FALSE;
+	const UInt8	*p		= text;
+	const UInt8	*end		= text + len;
+	uint64_t	val		= 0;
+	int64_t		val_s;
+
+	if ((p < end) && ((*p == '-') || (*p == '+'))) {
+		negative = (*p == '-');
+		p++;
+	}
+	if (p == end) {
+		return NULL;
+	}
+	for (; p < end; p++) {
+		unsigned int	digit;
+
+		if ((*p < '0') || (*p > '9')) {
+			// if not [simple] decimal
+			return NULL;
+		}
+		digit = *p - '0';
+		if (val > ((UINT64_MAX - digit) / 10)) {
+			// if too large
+			return NULL;
+		}
+		val = (val * 10) + digit;
+	}
+
+	if (negative) {
+		if (val > ((uint64_t)INT64_MAX + 1)) {
+			return NULL;
+		}
+		val_s = (int64_t)(0 - val);
+	} else {
+		if (val > INT64_MAX) {
+			return NULL;
+		}
+		val_s = (int64_t)val;
+	}
+
+	return CFNumberCreate(NULL, kCFNumberSInt64Type, &val_s);
+}
+
+
+static CFNumberRef
+createReal(const UInt8 *text, CFIndex len)
+{
+	char	buf[64];
+	char	*end;
+	double	val;
+
+	if ((len == 0) || (len >= (CFIndex)sizeof(buf))) {
+		return NULL;
+	}
+	memcpy(buf, text, len);
+	buf[len] = '\0';
+
+	val = strtod(buf, &end);
+	if (*end != '\0') {
+		return NULL;
+	}
+
+	return CFNumberCreate(NULL, kCFNumberFloat64Type, &val);
+}
+
+
+static Boolean
+getDigits(const UInt8 *p, int n, int *val)
+{
+	int	i;
+
+	*val = 0;
+	for (i = 0; i < n; i++) {
+		if ((p[i] < '0') || (p[i] > '9')) {
+			return FALSE;
+		}
+		*val = (*val * 10) + (p[i] - '0');
+	}
+	return TRUE;
+}
+
+
+static CFDateRef
+createDate(const UInt8 *text, CFIndex len)
+{
+	int		day;
+	int64_t		days;
+	int		hour;
+	int		min;
+	int		mon;
+	int		sec;
+	int		year;
+	int		y;
+
+	// YYYY-MM-DDTHH:MM:SSZ (as written by the XML writer)
+	if ((len != 20) ||
+	    (text[4] != '-') || (text[7] != '-') || (text[10] != 'T') ||
+	    (text[13] != ':') || (text[16] != ':') || (text[19] != 'Z') ||
+	    !getDigits(text +  0, 4, &year) ||
+	    !getDigits(text +  5, 2, &mon)  ||
+	    !getDigits(text +  8, 2, &day)  ||
+	    !getDigits(text + 11, 2, &hour) ||
+	    !getDigits(text + 14, 2, &min)  ||
+	    !getDigits(text + 17, 2, &sec)  ||
+	    (mon < 1) || (mon > 12) || (day < 1) || (day > 31)) {
+		return NULL;
+	}
+
+	// days since 1970-01-01 (proleptic Gregorian calendar)
+	y = (mon <= 2) ? year - 1 : year;
+	days = (int64_t)365 * y + (y / 4) - (y / 100) + (y / 400)
+	       + ((153 * (mon + ((mon > 2) ? -3 : 9)) + 2) / 5) + day - 1
+	       - 719468;
+
+	return CFDateCreate(NULL,
+			    (CFAbsoluteTime)(days * 86400 + hour * 3600 + min * 60 + sec)
+			    - kCFAbsoluteTimeIntervalSince1970);
+}
+
+
+static CFDataRef
+createData(const UInt8 *text, CFIndex len)
+{
+	static const int8_t	b64[256]	= {
+		['A'] =  0, ['B'] =  1, ['C'] =  2, ['D'] =  3, ['E'] =  4, ['F'] =  5, ['G'] =  6, ['H'] =  7,
+		['I'] =  8, ['J'] =  9, ['K'] = 10, ['L'] = 11, ['M'] = 12, ['N'] = 13, ['O'] = 14, ['P'] = 15,
+		['Q'] = 16, ['R'] = 17, ['S'] = 18, ['T'] = 19, ['U'] = 20, ['V'] = 21, ['W'] = 22, ['X'] = 23,
+		['Y'] = 24, ['Z'] = 25, ['a'] = 26, ['b'] = 27, ['c'] = 28, ['d'] = 29, ['e'] = 30, ['f'] = 31,
+		['g'] = 32, ['h'] = 33, ['i'] = 34, ['j'] = 35, ['k'] = 36, ['l'] = 37, ['m'] = 38, ['n'] = 39,
+		['o'] = 40, ['p'] = 41, ['q'] = 42, ['r'] = 43, ['s'] = 44, ['t'] = 45, ['u'] = 46, ['v'] = 47,
+		['w'] = 48, ['x'] = 49, ['y'] = 50, ['z'] = 51, ['0'] = 52, ['1'] = 53, ['2'] = 54, ['3'] = 55,
+		['4'] = 56, ['5'] = 57, ['6'] = 58, ['7'] = 59, ['8'] = 60, ['9'] = 61, ['+'] = 62, ['/'] = 63,
+	};
+	uint32_t		acc	= 0;
+	UInt8			*bytes;
+	CFIndex			i;
+	CFIndex			n	= 0;
+	int			nBits	= 0;
+	Boolean			pad	= FALSE;
+
+	bytes = CFAllocatorAllocate(NULL, (len * 3) / 4 + 1, 0);
+	for (i = 0; i < len; i++) {
+		UInt8	c	= text[i];
+
+		if ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r')) {
+			continue;
+		}
+		if (c == '=') {
+			pad = TRUE;
+			continue;
+		}
+		if (pad || ((b64[c] == 0) && (c != 'A'))) {
+			// if data after padding, or not base64
+			CFAllocatorDeallocate(NULL, bytes);
+			return NULL;
+		}
+		acc = (acc << 6) | b64[c];
+		nBits += 6;
+		if (nBits >= 8) {
+			nBits -= 8;
+			bytes[n++] = (acc >> nBits) & 0xff;
+		}
+	}
+
+	return CFDataCreateWithBytesNoCopy(NULL, bytes, n, NULL);
+}
+
+
+#pragma mark -
+#pragma mark Objects
+
+
+static Boolean
+push(parserStateRef state, CFTypeRef key, CFTypeRef value)
+{
+	if (state->nValues == state->nAlloc) {
+		state->nAlloc = (state->nAlloc == 0) ? 256 : state->nAlloc * 2;
+		state->keys = reallocf(state->keys, state->nAlloc * sizeof(CFTypeRef));
+		state->values = reallocf(state->values, state->nAlloc * sizeof(CFTypeRef));
+		if ((state->keys == NULL) || (state->values == NULL)) {
+			return FALSE;
+		}
+	}
+	state->keys[state->nValues] = key;
+	state->values[state->nValues] = value;
+	state->nValues++;
+	return TRUE;
+}
+
+
+static void
+popTo(parserStateRef state, CFIndex mark)
+{
+	while (state->nValues > mark) {
+		state->nValues--;
+		if (state->keys[state->nValues] != NULL) CFRelease(state->keys[state->nValues]);
+		CFRelease(state->values[state->nValues]);
+	}
+	return;
+}
+
+
+static CFTypeRef	parseObject	(parserStateRef state);
+
+
+static CFTypeRef
+parseContainer(parserStateRef state, Boolean isDict)
+{
+	CFIndex		mark	= state->nValues;
+	CFTypeRef	obj;
+
+	if (++state->depth > N_DEPTH_MAX) {
+		return NULL;
+	}
+
+	while (TRUE) {
+		CFStringRef	key	= NULL;
+		CFTypeRef	value;
+
+		if (!skipMisc(state)) {
+			goto fail;
+		}
+		if (isDict ? parseCloseTag(state, "dict", 4) : parseCloseTag(state, "array", 5)) {
+			break;
+		}
+
+		if (isDict) {
+			const UInt8	*text;
+			CFIndex		textLen;
+			Boolean		decoded;
+
+			if (hasPrefix(state, "<key/>", 6)) {
+				state->p += 6;
+				key = CFRetain(CFSTR(""));
+			} else if (hasPrefix(state, "<key>", 5)) {
+				state->p += 5;
+				if (!parseText(state, "key", 3, &text, &textLen, &decoded)) {
+					goto fail;
+				}
+				key = createString(state, text, textLen, decoded);
+			}
+			if (key == NULL) {
+				goto fail;
+			}
+			if (!skipMisc(state)) {
+				CFRelease(key);
+				goto fail;
+			}
+		}
+
+		value = parseObject(state);
+		if (value == NULL) {
+			if (key != NULL) CFRelease(key);
+			goto fail;
+		}
+		if (!push(state, key, value)) {
+			if (key != NULL) CFRelease(key);
+			CFRelease(value);
+			goto fail;
+		}
+	}
+
+	if (isDict) {
+		obj = CFDictionaryCreate(NULL,
+					 state->keys + mark,
+					 state->values + mark,
+					 state->nValues - mark,
+					 &kCFTypeDictionaryKeyCallBacks,
+					 &kCFTypeDictionaryValueCallBacks);
+	} else {
+		obj = CFArrayCreate(NULL,
+				    state->values + mark,
+				    state->nValues - mark,
+				    &kCFTypeArrayCallBacks);
+	}
+	popTo(state, mark);
+	state->depth--;
+	return obj;
+
+    fail :
+
+	popTo(state, mark);
+	return NULL;
+}
+
+
+static CFTypeRef
+parseObject(parserStateRef state)
+{
+	Boolean		decoded;
+	Boolean		empty;
+	const UInt8	*name;
+	CFIndex		nameLen;
+	CFTypeRef	obj	= NULL;
+	const UInt8	*text;
+	CFIndex		textLen;
+
+	if (!parseTag(state, &name, &nameLen, &empty)) {
+		return NULL;
+	}
+
+#define	IS_TAG(s)	((nameLen == (CFIndex)(sizeof(s) - 1)) && (memcmp(name, s, sizeof(s) - 1) == 0))
+
+	if (IS_TAG("dict")) {
+		if (empty) {
+			return CFDictionaryCreate(NULL, NULL, NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+		}
+		return parseContainer(state, TRUE);
+	}
+	if (IS_TAG("array")) {
+		if (empty) {
+			return CFArrayCreate(NULL, NULL, 0, &kCFTypeArrayCallBacks);
+		}
+		return parseContainer(state, FALSE);
+	}
+	if (IS_TAG("true") && empty) {
+		return CFRetain(kCFBooleanTrue);
+	}
+	if (IS_TAG("false") && empty) {
+		return CFRetain(kCFBooleanFalse);
+	}
+	if (IS_TAG("plist") && !empty) {
+		if (!skipMisc(state)) {
+			return NULL;
+		}
+		obj = parseObject(state);
+		if ((obj != NULL) && (!skipMisc(state) || !parseCloseTag(state, "plist", 5))) {
+			CFRelease(obj);
+			obj = NULL;
+		}
+		return obj;
+	}
+
+	if (empty) {
+		if (IS_TAG("string")) {
+			return CFRetain(CFSTR(""));
+		}
+		if (IS_TAG("data")) {
+			return CFDataCreate(NULL, NULL, 0);
+		}
+		return NULL;
+	}
+
+	if (IS_TAG("string")) {
+		if (parseText(state, "string", 6, &text, &textLen, &decoded)) {
+			obj = createString(state, text, textLen, decoded);
+		}
+	} else if (IS_TAG("integer")) {
+		if (parseText(state, "integer", 7, &text, &textLen, &decoded)) {
+			obj = createInteger(text, textLen);
+		}
+	} else if (IS_TAG("real")) {
+		if (parseText(state, "real", 4, &text, &textLen, &decoded)) {
+			obj = createReal(text, textLen);
+		}
+	} else if (IS_TAG("date")) {
+		if (parseText(state, "date", 4, &text, &textLen, &decoded)) {
+			obj = createDate(text, textLen);
+		}
+	} else if (IS_TAG("data")) {
+		if (parseText(state, "data", 4, &text, &textLen, &decoded)) {
+			obj = createData(text, textLen);
+		}
+	}
+
+#undef	IS_TAG
+
+	return obj;
+}
+
+
+#pragma mark -
+#pragma mark Property lists
+
+
+/*
+ * _SCCreatePropertyListWithXMLBytes
+ *
+ * Returns an immutable property list, or NULL if the XML is malformed or
+ * uses a form the parser does not handle (in which case the caller should
+ * use CFPropertyListCreateWithData()).
+ */
+CFPropertyListRef
+_SCCreatePropertyListWithXMLBytes(const UInt8 *bytes, CFIndex len)
+{
+	CFIndex			i;
+	CFPropertyListRef	plist;
+	parserStateRef		state;
+
+	if ((len >= 8) && (memcmp(bytes, "bplist", 6) == 0)) {
+		// if binary
+		return NULL;
+	}
+
+	state = calloc(1, sizeof(*state));
+	state->p = bytes;
+	state->end = bytes + len;
+
+	plist = NULL;
+	if (skipMisc(state)) {
+		plist = parseObject(state);
+	}
+	if ((plist != NULL) && (!skipMisc(state) || (state->p != state->end))) {
+		// if trailing content
+		CFRelease(plist);
+		plist = NULL;
+	}
+
+	for (i = 0; i < N_STRING_CACHE; i++) {
+		if (state->cache[i].str != NULL) CFRelease(state->cache[i].str);
+	}
+	if (state->keys != NULL)	free(state->keys);
+	if (state->values != NULL)	free(state->values);
+	if (state->text != NULL)	free(state->text);
+	free(state);
+
+	return plist;
+}
+
+
+/*
+ * __SCCreatePropertyListFromResource
+ *
+ * Same as _SCCreatePropertyListFromResource() but maps and parses XML
+ * files with _SCCreatePropertyListWithXMLBytes().
+ */
+__private_extern__ CFPropertyListRef
+__SCCreatePropertyListFromResource(CFURLRef url)
+{
+	void			*bytes;
+	int			fd;
+	char			path[MAXPATHLEN];
+	CFPropertyListRef	plist	= NULL;
+	struct stat		statBuf;
+
+	if (!CFURLGetFileSystemRepresentation(url, TRUE, (UInt8 *)path, sizeof(path))) {
+		return _SCCreatePropertyListFromResource(url);
+	}
+
+	fd = open(path, O_RDONLY, 0);
+	if (fd == -1) {
+		return _SCCreatePropertyListFromResource(url);
+	}
+	if ((fstat(fd, &statBuf) == 0) && (statBuf.st_size > 0)) {
+		bytes = mmap(NULL, (size_t)statBuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (bytes != MAP_FAILED) {
+			plist = _SCCreatePropertyListWithXMLBytes(bytes, (CFIndex)statBuf.st_size);
+			(void) munmap(bytes, (size_t)statBuf.st_size);
+		}
+	}
+	(void) close(fd);
+
+	if (plist == NULL) {
+		// if not XML (or not something we handle)
+		plist = _SCCreatePropertyListFromResource(url);
+	}
+
+	return plist;
+}
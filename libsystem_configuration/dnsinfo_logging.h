@@ -39,6 +39,7 @@
 
 #include <dnsinfo.h>
 #include "dnsinfo_private.h"
+#include "structured_logging.h"
 
 __BEGIN_DECLS
 
@@ -68,6 +69,13 @@ _dns_resolver_log(uint32_t version, dns_resolver_t *resolver, int index, Boolean
 	char			reach_str[100];
 	CFMutableStringRef	str;
 
+#ifdef	MY_LOG_DEFINED_LOCALLY
+	if (!os_log_type_enabled(SC_LOG_HANDLE(), OS_LOG_TYPE_INFO)) {
+		// if not logging, don't format anything
+		return;
+	}
+#endif	// MY_LOG_DEFINED_LOCALLY
+
 	my_log(LOG_INFO, "%s", "");
 	my_log(LOG_INFO, "resolver #%d", index);
 
@@ -184,6 +192,16 @@ _dns_resolver_log(uint32_t version, dns_resolver_t *resolver, int index, Boolean
 	return;
 }
 
+static __inline__ Boolean
+_dns_configuration_emit(dns_config_t *dns_config, Boolean debug, sc_emitter_t e);
+
+/*
+ * _dns_configuration_log()
+ *
+ * Log the DNS configuration.  When logging with SC_log(), the
+ * configuration is reported as a single structured record (and nothing
+ * is formatted if the log level is disabled).
+ */
 static __inline__ void
 _dns_configuration_log(dns_config_t *dns_config, Boolean debug, my_log_context_type my_log_context_name)
 {
@@ -192,6 +210,17 @@ _dns_configuration_log(dns_config_t *dns_config, Boolean debug, my_log_context_t
 #endif
 	int	i;
 
+#ifdef	MY_LOG_DEFINED_LOCALLY
+	sc_emitter	e;
+
+	_sc_emit_init_log(&e, SC_LOG_HANDLE(), OS_LOG_TYPE_INFO);
+	if (_sc_emit_enabled(&e)) {
+		(void) _dns_configuration_emit(dns_config, debug, &e);
+		_sc_emit_release(&e);
+	}
+	return;
+#endif	// MY_LOG_DEFINED_LOCALLY
+
 	my_log(LOG_INFO, "%s", "DNS configuration");
 
 	for (i = 0; i < dns_config->n_resolver; i++) {
@@ -225,6 +254,175 @@ _dns_configuration_log(dns_config_t *dns_config, Boolean debug, my_log_context_t
 	return;
 }
 
+#pragma mark -
+#pragma mark Structured output
+
+
+static __inline__ void
+_dns_resolver_emit(uint32_t version, dns_resolver_t *resolver, Boolean debug, sc_emitter_t e)
+{
+	static const sc_emit_flag_name_t	names[]	= {
+		{ DNS_RESOLVER_FLAGS_SCOPED,			"Scoped"		},
+		{ DNS_RESOLVER_FLAGS_SERVICE_SPECIFIC,		"Service-specific"	},
+		{ DNS_RESOLVER_FLAGS_SUPPLEMENTAL,		"Supplemental"		},
+		{ DNS_RESOLVER_FLAGS_REQUEST_A_RECORDS,		"Request A records"	},
+		{ DNS_RESOLVER_FLAGS_REQUEST_AAAA_RECORDS,	"Request AAAA records"	},
+	};
+	int	i;
+
+	_sc_emit_object_begin(e, NULL);
+
+	if (resolver->domain != NULL) {
+		_sc_emit_string(e, "domain", resolver->domain);
+	}
+
+	_sc_emit_array_begin(e, "search");
+	for (i = 0; i < resolver->n_search; i++) {
+		_sc_emit_string(e, NULL, resolver->search[i]);
+	}
+	_sc_emit_array_end(e);
+
+	_sc_emit_array_begin(e, "nameserver");
+	for (i = 0; i < resolver->n_nameserver; i++) {
+		char	buf[128];
+
+		_SC_sockaddr_to_string(resolver->nameserver[i], buf, sizeof(buf));
+		_sc_emit_string(e, NULL, buf);
+	}
+	_sc_emit_array_end(e);
+
+	if (resolver->n_sortaddr > 0) {
+		_sc_emit_array_begin(e, "sortaddr");
+		for (i = 0; i < resolver->n_sortaddr; i++) {
+			char	abuf[32];
+			char	mbuf[32];
+
+			(void)inet_ntop(AF_INET, &resolver->sortaddr[i]->address, abuf, sizeof(abuf));
+			(void)inet_ntop(AF_INET, &resolver->sortaddr[i]->mask,    mbuf, sizeof(mbuf));
+			_sc_emit_object_begin(e, NULL);
+			_sc_emit_string(e, "address", abuf);
+			_sc_emit_string(e, "mask", mbuf);
+			_sc_emit_object_end(e);
+		}
+		_sc_emit_array_end(e);
+	}
+
+	if (resolver->options != NULL) {
+		_sc_emit_string(e, "options", resolver->options);
+	}
+
+	if (resolver->port != 0) {
+		_sc_emit_uint(e, "port", resolver->port);
+	}
+
+	if (resolver->timeout != 0) {
+		_sc_emit_uint(e, "timeout", resolver->timeout);
+	}
+
+	if (resolver->if_index != 0) {
+#ifndef	_LIBLOG_SYSTEMCONFIGURATION_
+		char	buf[IFNAMSIZ];
+#endif	// !_LIBLOG_SYSTEMCONFIGURATION_
+		char	*if_name	= NULL;
+
+		if ((version >= 20170629) && (resolver->if_name != NULL)) {
+			if_name = resolver->if_name;
+#ifndef	_LIBLOG_SYSTEMCONFIGURATION_
+		} else {
+			if_name = if_indextoname(resolver->if_index, buf);
+#endif	// !_LIBLOG_SYSTEMCONFIGURATION_
+		}
+		_sc_emit_uint(e, "if_index", resolver->if_index);
+		if (if_name != NULL) {
+			_sc_emit_string(e, "if_name", if_name);
+		}
+	}
+
+	if (resolver->service_identifier != 0) {
+		_sc_emit_uint(e, "service_identifier", resolver->service_identifier);
+	}
+
+	_sc_emit_uint(e, "flags", resolver->flags);
+	_sc_emit_flag_names(e, "flag_names", resolver->flags, names, sizeof(names) / sizeof(names[0]));
+
+	_sc_emit_reachability_flags(e, "reach", resolver->reach_flags);
+
+	if (resolver->search_order != 0) {
+		_sc_emit_uint(e, "order", resolver->search_order);
+	}
+
+	if (debug && (resolver->cid != NULL)) {
+		_sc_emit_string(e, "config_id", resolver->cid);
+	}
+
+	_sc_emit_object_end(e);
+	return;
+}
+
+
+static __inline__ void
+_dns_resolver_list_emit(uint32_t version, const char *name, dns_resolver_t **list, int32_t n, Boolean debug, sc_emitter_t e)
+{
+	_sc_emit_array_begin(e, name);
+	if (list != NULL) {
+		for (int32_t i = 0; i < n; i++) {
+			_dns_resolver_emit(version, list[i], debug, e);
+		}
+	}
+	_sc_emit_array_end(e);
+	return;
+}
+
+
+/*
+ * _dns_configuration_emit()
+ *
+ * Emit the DNS configuration as a single structured record.  The record
+ * is only built if the emitter's destination is enabled.
+ */
+static __inline__ Boolean
+_dns_configuration_emit(dns_config_t *dns_config, Boolean debug, sc_emitter_t e)
+{
+	if (!_sc_emit_enabled(e)) {
+		return TRUE;
+	}
+
+	_sc_emit_record_begin(e);
+	_sc_emit_string(e, "type", "dns");
+
+	if (dns_config == NULL) {
+		_sc_emit_bool(e, "available", false);
+		return _sc_emit_record_end(e);
+	}
+
+	_sc_emit_bool(e, "available", true);
+	_sc_emit_uint(e, "generation", dns_config->generation);
+	if (debug) {
+		_sc_emit_uint(e, "version", dns_config->version);
+	}
+
+	_dns_resolver_list_emit(dns_config->version,
+				"resolver",
+				dns_config->resolver,
+				dns_config->n_resolver,
+				debug,
+				e);
+	_dns_resolver_list_emit(dns_config->version,
+				"scoped_resolver",
+				dns_config->scoped_resolver,
+				dns_config->n_scoped_resolver,
+				debug,
+				e);
+	_dns_resolver_list_emit(dns_config->version,
+				"service_specific_resolver",
+				dns_config->service_specific_resolver,
+				dns_config->n_service_specific_resolver,
+				debug,
+				e);
+
+	return _sc_emit_record_end(e);
+}
+
 #ifdef	MY_LOG_DEFINED_LOCALLY
 #undef	my_log
 #undef	MY_LOG_DEFINED_LOCALLY
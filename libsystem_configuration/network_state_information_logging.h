@@ -33,6 +33,7 @@
 
 #include <network_information.h>
 #include "network_state_information_priv.c"
+#include "structured_logging.h"
 
 __BEGIN_DECLS
 
@@ -185,6 +186,13 @@ _nwi_ifstate_log(nwi_ifstate_t ifstate, boolean_t debug, my_log_context_type my_
 	char				reach_str[100];
 	const struct sockaddr		*vpn_addr;
 
+#ifdef	MY_LOG_DEFINED_LOCALLY
+	if (!os_log_type_enabled(SC_LOG_HANDLE(), OS_LOG_TYPE_INFO)) {
+		// if not logging, don't format anything
+		return;
+	}
+#endif	// MY_LOG_DEFINED_LOCALLY
+
 	// nwi_ifstate flags
 	flags_ifstate = nwi_ifstate_get_flags(ifstate);
 	if (debug) {
@@ -281,6 +289,16 @@ _nwi_state_reachability_log(nwi_state_t state, boolean_t debug, int af, my_log_c
 	return;
 }
 
+static __inline__ boolean_t
+_nwi_state_emit(nwi_state_t state, boolean_t debug, sc_emitter_t e);
+
+/*
+ * _nwi_state_log()
+ *
+ * Log the network information.  When logging with SC_log(), the state is
+ * reported as a single structured record (and nothing is formatted if
+ * the log level is disabled).
+ */
 static __inline__ void
 _nwi_state_log(nwi_state_t state, boolean_t debug, my_log_context_type my_log_context_name)
 {
@@ -291,6 +309,17 @@ _nwi_state_log(nwi_state_t state, boolean_t debug, my_log_context_type my_log_co
 	nwi_ifindex_t	i;
 	nwi_ifstate_t	ifstate;
 
+#ifdef	MY_LOG_DEFINED_LOCALLY
+	sc_emitter	e;
+
+	_sc_emit_init_log(&e, SC_LOG_HANDLE(), OS_LOG_TYPE_INFO);
+	if (_sc_emit_enabled(&e)) {
+		(void) _nwi_state_emit(state, debug, &e);
+		_sc_emit_release(&e);
+	}
+	return;
+#endif	// MY_LOG_DEFINED_LOCALLY
+
 	if (!debug) {
 		my_log(LOG_INFO, "%s", "Network information");
 	} else {
@@ -382,6 +411,188 @@ _nwi_state_log(nwi_state_t state, boolean_t debug, my_log_context_type my_log_co
 	return;
 }
 
+#pragma mark -
+#pragma mark Structured output
+
+
+static __inline__ void
+_nwi_ifstate_emit(nwi_ifstate_t ifstate, boolean_t debug, sc_emitter_t e)
+{
+	static const sc_emit_flag_name_t	names[]	= {
+		{ NWI_IFSTATE_FLAGS_HAS_IPV4,		"IPv4"		},
+		{ NWI_IFSTATE_FLAGS_HAS_IPV6,		"IPv6"		},
+		{ NWI_IFSTATE_FLAGS_HAS_DNS,		"DNS"		},
+		{ NWI_IFSTATE_FLAGS_HAS_CLAT46,		"CLAT46"	},
+		{ NWI_IFSTATE_FLAGS_NOT_IN_LIST,	"NOT-IN-LIST"	},
+		{ NWI_IFSTATE_FLAGS_HAS_SIGNATURE,	"SIGNATURE"	},
+		{ NWI_IFSTATE_FLAGS_NOT_IN_IFLIST,	"NOT-IN-IFLIST"	},
+	};
+	char				addr_str[INET6_ADDRSTRLEN];
+	nwi_ifstate_flags		flags_ifstate;
+	const struct sockaddr		*vpn_addr;
+
+	flags_ifstate = nwi_ifstate_get_flags(ifstate);
+	if (debug) {
+		flags_ifstate |= NWI_IFSTATE_FLAGS(ifstate->flags);
+	}
+	flags_ifstate &= NWI_IFSTATE_FLAGS_MASK;
+	flags_ifstate &= ~NWI_IFSTATE_FLAGS_HAS_SIGNATURE;	// exclude flag ('cause we'll report the signature only if present)
+
+	_sc_emit_object_begin(e, NULL);
+
+	_sc_emit_string(e, "ifname", nwi_ifstate_get_ifname(ifstate));
+	_sc_emit_uint(e, "af", ifstate->af);
+
+	_sc_emit_uint(e, "flags", flags_ifstate);
+	_sc_emit_flag_names(e, "flag_names", flags_ifstate, names, sizeof(names) / sizeof(names[0]));
+
+	if (inet_ntop(ifstate->af, nwi_ifstate_get_address(ifstate), addr_str, sizeof(addr_str)) != NULL) {
+		_sc_emit_string(e, "address", addr_str);
+	}
+
+	vpn_addr = nwi_ifstate_get_vpn_server(ifstate);
+	if (vpn_addr != NULL) {
+		char		vpn_str[INET6_ADDRSTRLEN];
+
+		_SC_sockaddr_to_string(vpn_addr, vpn_str, sizeof(vpn_str));
+		_sc_emit_string(e, "vpn_server", vpn_str);
+	}
+
+	_sc_emit_reachability_flags(e, "reach", nwi_ifstate_get_reachability_flags(ifstate));
+
+	if (debug) {
+		const uint8_t	*signature;
+		int		signature_length	= 0;
+
+		_sc_emit_uint(e, "rank", ifstate->rank);
+		_sc_emit_string(e, "rank_assertion", _nwi_ifstate_rank_str(ifstate->rank));
+		if (RANK_INDEX_MASK(ifstate->rank) != kRankIndexMask) {
+			_sc_emit_uint(e, "rank_index", RANK_INDEX_MASK(ifstate->rank));
+		}
+
+		signature = nwi_ifstate_get_signature(ifstate, AF_UNSPEC, &signature_length);
+		if ((signature != NULL) && (signature_length > 0)) {
+			_sc_emit_hex(e, "signature", signature, (size_t)signature_length);
+		}
+
+		_sc_emit_uint(e, "generation", nwi_ifstate_get_generation(ifstate));
+	}
+
+	_sc_emit_object_end(e);
+	return;
+}
+
+
+static __inline__ void
+_nwi_state_emit_af(nwi_state_t state, boolean_t debug, int af, sc_emitter_t e)
+{
+	nwi_ifstate_t	ifstate;
+
+	_sc_emit_object_begin(e, (af == AF_INET) ? "ipv4" : "ipv6");
+	_sc_emit_array_begin(e, "interfaces");
+	if (!debug) {
+		// regular interfaces
+		for (ifstate = nwi_state_get_first_ifstate(state, af);
+		     ifstate != NULL;
+		     ifstate = nwi_ifstate_get_next(ifstate, af)) {
+			_nwi_ifstate_emit(ifstate, debug, e);
+		}
+	} else {
+		nwi_ifindex_t	count	= (af == AF_INET) ? state->ipv4_count : state->ipv6_count;
+		nwi_ifindex_t	i;
+
+		// ALL interfaces
+		for (i = 0, ifstate = nwi_state_ifstate_list(state, af); i < count; i++, ifstate++) {
+			_nwi_ifstate_emit(ifstate, debug, e);
+		}
+	}
+	_sc_emit_array_end(e);
+	_sc_emit_reachability_flags(e, "reach", nwi_state_get_reachability_flags(state, af));
+	_sc_emit_object_end(e);
+
+	return;
+}
+
+
+/*
+ * _nwi_state_emit()
+ *
+ * Emit the network information as a single structured record.  The
+ * record is only built if the emitter's destination is enabled.
+ */
+static __inline__ boolean_t
+_nwi_state_emit(nwi_state_t state, boolean_t debug, sc_emitter_t e)
+{
+	unsigned int	count;
+
+	if (!_sc_emit_enabled(e)) {
+		return TRUE;
+	}
+
+	_sc_emit_record_begin(e);
+	_sc_emit_string(e, "type", "nwi");
+
+	if (state == NULL) {
+		_sc_emit_bool(e, "available", false);
+		return _sc_emit_record_end(e);
+	}
+
+	_sc_emit_bool(e, "available", true);
+	_sc_emit_uint(e, "generation", nwi_state_get_generation(state));
+	if (debug) {
+		_sc_emit_uint(e, "size", nwi_state_size(state));
+	}
+
+	_nwi_state_emit_af(state, debug, AF_INET,  e);
+	_nwi_state_emit_af(state, debug, AF_INET6, e);
+
+	_sc_emit_array_begin(e, "interface_names");
+	count = nwi_state_get_interface_names(state, NULL, 0);
+	if (count > 0) {
+		const char	*names[count];
+
+		count = nwi_state_get_interface_names(state, names, count);
+		for (unsigned int i = 0; i < count; i++) {
+			_sc_emit_string(e, NULL, names[i]);
+		}
+	}
+	_sc_emit_array_end(e);
+
+	return _sc_emit_record_end(e);
+}
+
+
+/*
+ * _nwi_ifstate_emit_record()
+ *
+ * Emit the network information for a single interface (and its alias)
+ * as a structured record.
+ */
+static __inline__ boolean_t
+_nwi_ifstate_emit_record(nwi_ifstate_t ifstate, boolean_t debug, sc_emitter_t e)
+{
+	nwi_ifstate_t	alias;
+
+	if (!_sc_emit_enabled(e)) {
+		return TRUE;
+	}
+
+	_sc_emit_record_begin(e);
+	_sc_emit_string(e, "type", "nwi_ifstate");
+	_sc_emit_bool(e, "available", (ifstate != NULL));
+	if (ifstate != NULL) {
+		_sc_emit_array_begin(e, "interfaces");
+		_nwi_ifstate_emit(ifstate, debug, e);
+		alias = nwi_ifstate_get_alias(ifstate, nwi_other_af(ifstate->af));
+		if (alias != NULL) {
+			_nwi_ifstate_emit(alias, debug, e);
+		}
+		_sc_emit_array_end(e);
+	}
+
+	return _sc_emit_record_end(e);
+}
+
 #ifdef	MY_LOG_DEFINED_LOCALLY
 #undef	my_log
 #undef	MY_LOG_DEFINED_LOCALLY
@@ -0,0 +1,738 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef _S_STRUCTURED_LOGGING_H
+#define _S_STRUCTURED_LOGGING_H
+
+#include <os/availability.h>
+#include <TargetConditionals.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+#include <os/log.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <SystemConfiguration/SystemConfiguration.h>
+
+/*
+ * Structured (machine readable) emitter used by the nwi_state and
+ * dns_config "log" helpers.
+ *
+ * A record is accumulated into a single buffer and handed to the
+ * destination with one write(2).  os_log() truncates long messages so a
+ * record longer than SC_EMIT_LOG_CHUNK bytes is logged as several
+ * messages, each prefixed with "[<n>/<count>] ".  Nothing is formatted
+ * unless the destination is enabled; callers should check
+ * _sc_emit_enabled() before walking their state.
+ *
+ * Two encodings are supported :
+ *
+ *   kSCEmitFormatNDJSON
+ *	one JSON object per record, terminated with a newline
+ *
+ *   kSCEmitFormatBinary
+ *	a compact, length-prefixed TLV encoding :
+ *
+ *	record  := "SCE1" <uint32 length> item*
+ *	item    := <uint8 type> <uint8 name length> <name> [value]
+ *	value   := uint64 (little endian, 8 bytes)		['u']
+ *		 | uint8					['b']
+ *		 | <uint32 length> <bytes>			['s']
+ *		 | (none)					['{', '}', '[', ']']
+ */
+
+__BEGIN_DECLS
+
+typedef enum {
+	kSCEmitFormatNDJSON	= 0,
+	kSCEmitFormatBinary	= 1,
+} sc_emit_format_t;
+
+#define	SC_EMIT_MAX_DEPTH	16
+#define	SC_EMIT_QUICK_SIZE	4096
+#define	SC_EMIT_LOG_CHUNK	768	// bytes per os_log() message
+#define	SC_EMIT_BINARY_MAGIC	"SCE1"
+
+typedef struct {
+	sc_emit_format_t	format;
+
+	/* destination */
+	int			fd;		// write(2) destination (or -1)
+	os_log_t		log;		// os_log destination (or NULL)
+	os_log_type_t		log_type;
+
+	/* record buffer */
+	char			*buf;
+	size_t			len;
+	size_t			size;
+	bool			failed;
+	char			buf_q[SC_EMIT_QUICK_SIZE];
+
+	/* nesting */
+	int			depth;
+	bool			need_comma[SC_EMIT_MAX_DEPTH];
+} sc_emitter, *sc_emitter_t;
+
+
+/*
+ * _sc_emit_init_fd()
+ *
+ * Initialize an emitter that writes each record to the provided file
+ * descriptor.
+ */
+static __inline__ void
+_sc_emit_init_fd(sc_emitter_t e, sc_emit_format_t format, int fd)
+{
+	memset(e, 0, sizeof(*e));
+	e->format = format;
+	e->fd     = fd;
+	e->buf    = e->buf_q;
+	e->size   = sizeof(e->buf_q);
+	return;
+}
+
+
+/*
+ * _sc_emit_init_log()
+ *
+ * Initialize an emitter that hands each [NDJSON] record to os_log.  Records
+ * are only formatted when the log handle is enabled for the provided type.
+ */
+static __inline__ void
+_sc_emit_init_log(sc_emitter_t e, os_log_t log, os_log_type_t type)
+{
+	memset(e, 0, sizeof(*e));
+	e->format   = kSCEmitFormatNDJSON;
+	e->fd       = -1;
+	e->log      = log;
+	e->log_type = type;
+	e->buf      = e->buf_q;
+	e->size     = sizeof(e->buf_q);
+	return;
+}
+
+
+static __inline__ void
+_sc_emit_release(sc_emitter_t e)
+{
+	if (e->buf != e->buf_q) {
+		free(e->buf);
+	}
+	e->buf  = e->buf_q;
+	e->size = sizeof(e->buf_q);
+	e->len  = 0;
+	return;
+}
+
+
+static __inline__ bool
+_sc_emit_enabled(sc_emitter_t e)
+{
+	if (e == NULL) {
+		return false;
+	}
+
+	if (e->fd != -1) {
+		return true;
+	}
+
+	if (e->log != NULL) {
+		return os_log_type_enabled(e->log, e->log_type);
+	}
+
+	return false;
+}
+
+
+#pragma mark -
+#pragma mark Buffer management
+
+
+static __inline__ bool
+__sc_emit_reserve(sc_emitter_t e, size_t need)
+{
+	char	*buf;
+	size_t	size;
+
+	if (e->failed) {
+		return false;
+	}
+
+	if ((e->len + need) <= e->size) {
+		return true;
+	}
+
+	size = e->size;
+	while ((e->len + need) > size) {
+		size *= 2;
+	}
+
+	if (e->buf == e->buf_q) {
+		buf = malloc(size);
+		if (buf != NULL) {
+			memcpy(buf, e->buf_q, e->len);
+		}
+	} else {
+		buf = realloc(e->buf, size);
+	}
+	if (buf == NULL) {
+		e->failed = true;
+		return false;
+	}
+
+	e->buf  = buf;
+	e->size = size;
+	return true;
+}
+
+
+static __inline__ void
+__sc_emit_bytes(sc_emitter_t e, const void *bytes, size_t n)
+{
+	if (__sc_emit_reserve(e, n)) {
+		memcpy(e->buf + e->len, bytes, n);
+		e->len += n;
+	}
+	return;
+}
+
+
+static __inline__ void
+__sc_emit_char(sc_emitter_t e, char c)
+{
+	__sc_emit_bytes(e, &c, 1);
+	return;
+}
+
+
+static __inline__ void
+__sc_emit_le32(sc_emitter_t e, uint32_t v)
+{
+	uint8_t	b[4];
+
+	for (int i = 0; i < 4; i++) {
+		b[i] = (uint8_t)(v >> (i * 8));
+	}
+	__sc_emit_bytes(e, b, sizeof(b));
+	return;
+}
+
+
+static __inline__ void
+__sc_emit_le64(sc_emitter_t e, uint64_t v)
+{
+	uint8_t	b[8];
+
+	for (int i = 0; i < 8; i++) {
+		b[i] = (uint8_t)(v >> (i * 8));
+	}
+	__sc_emit_bytes(e, b, sizeof(b));
+	return;
+}
+
+
+#pragma mark -
+#pragma mark JSON encoding
+
+
+static __inline__ void
+__sc_emit_json_string(sc_emitter_t e, const char *str, size_t n)
+{
+	static const char	hex[]	= "0123456789abcdef";
+	size_t			start	= 0;
+
+	__sc_emit_char(e, '"');
+	for (size_t i = 0; i < n; i++) {
+		unsigned char	c	= (unsigned char)str[i];
+		char		esc[6];
+
+		if ((c >= 0x20) && (c != '"') && (c != '\\')) {
+			continue;
+		}
+
+		// flush the run of characters that did not need escaping
+		__sc_emit_bytes(e, str + start, i - start);
+		start = i + 1;
+
+		esc[0] = '\\';
+		switch (c) {
+			case '"'  : esc[1] = '"';  __sc_emit_bytes(e, esc, 2); break;
+			case '\\' : esc[1] = '\\'; __sc_emit_bytes(e, esc, 2); break;
+			case '\n' : esc[1] = 'n';  __sc_emit_bytes(e, esc, 2); break;
+			case '\r' : esc[1] = 'r';  __sc_emit_bytes(e, esc, 2); break;
+			case '\t' : esc[1] = 't';  __sc_emit_bytes(e, esc, 2); break;
+			default :
+				esc[1] = 'u';
+				esc[2] = '0';
+				esc[3] = '0';
+				esc[4] = hex[c >> 4];
+				esc[5] = hex[c & 0x0f];
+				__sc_emit_bytes(e, esc, 6);
+				break;
+		}
+	}
+	__sc_emit_bytes(e, str + start, n - start);
+	__sc_emit_char(e, '"');
+	return;
+}
+
+
+/*
+ * __sc_emit_json_member()
+ *
+ * Emit the separator and (when inside an object) the member name.
+ */
+static __inline__ void
+__sc_emit_json_member(sc_emitter_t e, const char *name)
+{
+	if (e->depth > 0) {
+		if (e->need_comma[e->depth - 1]) {
+			__sc_emit_char(e, ',');
+		}
+		e->need_comma[e->depth - 1] = true;
+	}
+
+	if (name != NULL) {
+		__sc_emit_json_string(e, name, strlen(name));
+		__sc_emit_char(e, ':');
+	}
+
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Binary encoding
+
+
+static __inline__ void
+__sc_emit_binary_item(sc_emitter_t e, char type, const char *name)
+{
+	size_t	n	= (name != NULL) ? strlen(name) : 0;
+
+	if (n > UINT8_MAX) {
+		n = UINT8_MAX;
+	}
+
+	__sc_emit_char(e, type);
+	__sc_emit_char(e, (char)(uint8_t)n);
+	__sc_emit_bytes(e, name, n);
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Records
+
+
+/*
+ * _sc_emit_record_begin()
+ *
+ * Start a new record.  A record is a [top-level] object.
+ */
+static __inline__ void
+_sc_emit_record_begin(sc_emitter_t e)
+{
+	e->len    = 0;
+	e->depth  = 0;
+	e->failed = false;
+
+	if (e->format == kSCEmitFormatBinary) {
+		__sc_emit_bytes(e, SC_EMIT_BINARY_MAGIC, sizeof(SC_EMIT_BINARY_MAGIC) - 1);
+		__sc_emit_le32(e, 0);		// length, updated in _sc_emit_record_end()
+		__sc_emit_binary_item(e, '{', NULL);
+	} else {
+		__sc_emit_char(e, '{');
+	}
+
+	e->need_comma[0] = false;
+	e->depth = 1;
+	return;
+}
+
+
+/*
+ * __sc_emit_log_piece()
+ *
+ * Returns the length of the piece of the record starting at "off", at
+ * most SC_EMIT_LOG_CHUNK bytes and not splitting a UTF-8 character.
+ */
+static __inline__ size_t
+__sc_emit_log_piece(sc_emitter_t e, size_t off)
+{
+	size_t	n	= e->len - off;
+
+	if (n > SC_EMIT_LOG_CHUNK) {
+		n = SC_EMIT_LOG_CHUNK;
+		while ((n > 1) && (((unsigned char)e->buf[off + n] & 0xc0) == 0x80)) {
+			n--;
+		}
+	}
+
+	return n;
+}
+
+
+static __inline__ void
+__sc_emit_log(sc_emitter_t e)
+{
+	size_t	count	= 0;
+	size_t	off;
+
+	if (e->len <= SC_EMIT_LOG_CHUNK) {
+		os_log_with_type(e->log, e->log_type, "%{public}.*s", (int)e->len, e->buf);
+		return;
+	}
+
+	for (off = 0; off < e->len; off += __sc_emit_log_piece(e, off)) {
+		count++;
+	}
+	off = 0;
+	for (size_t i = 1; i <= count; i++) {
+		size_t	n	= __sc_emit_log_piece(e, off);
+
+		os_log_with_type(e->log, e->log_type, "[%zu/%zu] %{public}.*s", i, count, (int)n, e->buf + off);
+		off += n;
+	}
+
+	return;
+}
+
+
+/*
+ * _sc_emit_record_end()
+ *
+ * Complete the current record and hand it to the destination (with a
+ * single write).  Returns false if the record could not be delivered.
+ */
+static __inline__ bool
+_sc_emit_record_end(sc_emitter_t e)
+{
+	size_t	off	= 0;
+	bool	ok	= true;
+
+	if (e->format == kSCEmitFormatBinary) {
+		uint32_t	len;
+
+		__sc_emit_binary_item(e, '}', NULL);
+		if (!e->failed) {
+			len = (uint32_t)(e->len - (sizeof(SC_EMIT_BINARY_MAGIC) - 1) - sizeof(uint32_t));
+			for (int i = 0; i < 4; i++) {
+				e->buf[(sizeof(SC_EMIT_BINARY_MAGIC) - 1) + i] = (char)(uint8_t)(len >> (i * 8));
+			}
+		}
+	} else {
+		__sc_emit_char(e, '}');
+		if (e->fd != -1) {
+			__sc_emit_char(e, '\n');
+		}
+	}
+	e->depth = 0;
+
+	if (e->failed) {
+		e->len = 0;
+		return false;
+	}
+
+	if (e->fd != -1) {
+		while (off < e->len) {
+			ssize_t	n;
+
+			n = write(e->fd, e->buf + off, e->len - off);
+			if (n == -1) {
+				if (errno == EINTR) {
+					continue;
+				}
+				ok = false;
+				break;
+			}
+			off += (size_t)n;
+		}
+	} else if (e->log != NULL) {
+		__sc_emit_log(e);
+	}
+
+	e->len = 0;
+	return ok;
+}
+
+
+#pragma mark -
+#pragma mark Containers
+
+
+static __inline__ void
+_sc_emit_object_begin(sc_emitter_t e, const char *name)
+{
+	if (e->depth >= SC_EMIT_MAX_DEPTH) {
+		e->failed = true;
+		return;
+	}
+
+	if (e->format == kSCEmitFormatBinary) {
+		__sc_emit_binary_item(e, '{', name);
+	} else {
+		__sc_emit_json_member(e, name);
+		__sc_emit_char(e, '{');
+	}
+
+	e->need_comma[e->depth++] = false;
+	return;
+}
+
+
+static __inline__ void
+_sc_emit_object_end(sc_emitter_t e)
+{
+	if (e->depth <= 1) {
+		e->failed = true;
+		return;
+	}
+
+	if (e->format == kSCEmitFormatBinary) {
+		__sc_emit_binary_item(e, '}', NULL);
+	} else {
+		__sc_emit_char(e, '}');
+	}
+
+	e->depth--;
+	return;
+}
+
+
+static __inline__ void
+_sc_emit_array_begin(sc_emitter_t e, const char *name)
+{
+	if (e->depth >= SC_EMIT_MAX_DEPTH) {
+		e->failed = true;
+		return;
+	}
+
+	if (e->format == kSCEmitFormatBinary) {
+		__sc_emit_binary_item(e, '[', name);
+	} else {
+		__sc_emit_json_member(e, name);
+		__sc_emit_char(e, '[');
+	}
+
+	e->need_comma[e->depth++] = false;
+	return;
+}
+
+
+static __inline__ void
+_sc_emit_array_end(sc_emitter_t e)
+{
+	if (e->depth <= 1) {
+		e->failed = true;
+		return;
+	}
+
+	if (e->format == kSCEmitFormatBinary) {
+		__sc_emit_binary_item(e, ']', NULL);
+	} else {
+		__sc_emit_char(e, ']');
+	}
+
+	e->depth--;
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Values
+
+
+/*
+ * Note: "name" must be NULL for array elements.
+ */
+
+static __inline__ void
+_sc_emit_string_n(sc_emitter_t e, const char *name, const char *str, size_t n)
+{
+	if (str == NULL) {
+		str = "";
+		n = 0;
+	}
+
+	if (e->format == kSCEmitFormatBinary) {
+		__sc_emit_binary_item(e, 's', name);
+		__sc_emit_le32(e, (uint32_t)n);
+		__sc_emit_bytes(e, str, n);
+	} else {
+		__sc_emit_json_member(e, name);
+		__sc_emit_json_string(e, str, n);
+	}
+
+	return;
+}
+
+
+static __inline__ void
+_sc_emit_string(sc_emitter_t e, const char *name, const char *str)
+{
+	_sc_emit_string_n(e, name, str, (str != NULL) ? strlen(str) : 0);
+	return;
+}
+
+
+static __inline__ void
+_sc_emit_uint(sc_emitter_t e, const char *name, uint64_t val)
+{
+	if (e->format == kSCEmitFormatBinary) {
+		__sc_emit_binary_item(e, 'u', name);
+		__sc_emit_le64(e, val);
+	} else {
+		char	str[24];
+		int	n;
+
+		__sc_emit_json_member(e, name);
+		n = snprintf(str, sizeof(str), "%llu", (unsigned long long)val);
+		__sc_emit_bytes(e, str, (size_t)n);
+	}
+
+	return;
+}
+
+
+static __inline__ void
+_sc_emit_bool(sc_emitter_t e, const char *name, bool val)
+{
+	if (e->format == kSCEmitFormatBinary) {
+		__sc_emit_binary_item(e, 'b', name);
+		__sc_emit_char(e, val ? 1 : 0);
+	} else {
+		__sc_emit_json_member(e, name);
+		if (val) {
+			__sc_emit_bytes(e, "true", 4);
+		} else {
+			__sc_emit_bytes(e, "false", 5);
+		}
+	}
+
+	return;
+}
+
+
+/*
+ * _sc_emit_hex()
+ *
+ * Emit a byte string (e.g. a signature) as a hex string.
+ */
+static __inline__ void
+_sc_emit_hex(sc_emitter_t e, const char *name, const uint8_t *bytes, size_t n)
+{
+	static const char	hex[]	= "0123456789abcdef";
+	char			str_q[128];
+	char			*str	= str_q;
+
+	if ((n * 2) > sizeof(str_q)) {
+		str = malloc(n * 2);
+		if (str == NULL) {
+			e->failed = true;
+			return;
+		}
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		str[i * 2]     = hex[bytes[i] >> 4];
+		str[i * 2 + 1] = hex[bytes[i] & 0x0f];
+	}
+	_sc_emit_string_n(e, name, str, n * 2);
+
+	if (str != str_q) {
+		free(str);
+	}
+	return;
+}
+
+
+/*
+ * _sc_emit_flag_names()
+ *
+ * Emit an array with the names of the bits set in "flags".  Any bits not
+ * described by the table are reported as a single hex string.
+ */
+typedef struct {
+	uint64_t	flag;
+	const char	*name;
+} sc_emit_flag_name_t;
+
+static __inline__ void
+_sc_emit_flag_names(sc_emitter_t e, const char *name, uint64_t flags,
+		    const sc_emit_flag_name_t *names, size_t n_names)
+{
+	_sc_emit_array_begin(e, name);
+	for (size_t i = 0; i < n_names; i++) {
+		if ((flags & names[i].flag) != 0) {
+			_sc_emit_string(e, NULL, names[i].name);
+			flags &= ~names[i].flag;
+		}
+	}
+	if (flags != 0) {
+		char	str[24];
+
+		snprintf(str, sizeof(str), "0x%llx", (unsigned long long)flags);
+		_sc_emit_string(e, NULL, str);
+	}
+	_sc_emit_array_end(e);
+	return;
+}
+
+
+/*
+ * _sc_emit_reachability_flags()
+ *
+ * Emit the SCNetworkReachability flags (value and names).
+ */
+static __inline__ void
+_sc_emit_reachability_flags(sc_emitter_t e, const char *name, SCNetworkReachabilityFlags flags)
+{
+	static const sc_emit_flag_name_t	names[]	= {
+		{ kSCNetworkReachabilityFlagsReachable,			"Reachable"				},
+		{ kSCNetworkReachabilityFlagsTransientConnection,	"Transient Connection"			},
+		{ kSCNetworkReachabilityFlagsConnectionRequired,	"Connection Required"			},
+		{ kSCNetworkReachabilityFlagsConnectionOnTraffic,	"Automatic Connection On Traffic"	},
+		{ kSCNetworkReachabilityFlagsConnectionOnDemand,	"Automatic Connection On Demand"	},
+		{ kSCNetworkReachabilityFlagsInterventionRequired,	"Intervention Required"			},
+		{ kSCNetworkReachabilityFlagsIsLocalAddress,		"Local Address"				},
+		{ kSCNetworkReachabilityFlagsIsDirect,			"Directly Reachable Address"		},
+#if	TARGET_OS_IPHONE
+		{ kSCNetworkReachabilityFlagsIsWWAN,			"WWAN"					},
+#endif	// TARGET_OS_IPHONE
+	};
+
+	_sc_emit_object_begin(e, name);
+	_sc_emit_uint(e, "value", flags);
+	_sc_emit_flag_names(e, "names", flags, names, sizeof(names) / sizeof(names[0]));
+	_sc_emit_object_end(e);
+	return;
+}
+
+__END_DECLS
+
+#endif	/* !_S_STRUCTURED_LOGGING_H */
@@ -0,0 +1,729 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <mach/mach_time.h>
+
+#include "scdlocal.h"
+
+
+/*
+ * Load generator for the scdlocal server
+ *
+ * - request throughput (get / set / notify / key list) from one session
+ * - notification fan-out latency with N sessions each watching M patterns,
+ *   one of which matches the key being changed
+ */
+
+
+#define	BENCH_ROUND_TIMEOUT_MS	10000
+
+
+static uint64_t
+bench_now_ns(void)
+{
+	static mach_timebase_info_data_t	timebase	= { 0, 0 };
+
+	if (timebase.denom == 0) {
+		(void) mach_timebase_info(&timebase);
+	}
+
+	return mach_absolute_time() * timebase.numer / timebase.denom;
+}
+
+
+static int
+bench_compare_u64(const void *p1, const void *p2)
+{
+	uint64_t	v1	= *(const uint64_t *)p1;
+	uint64_t	v2	= *(const uint64_t *)p2;
+
+	return (v1 < v2) ? -1 : ((v1 > v2) ? 1 : 0);
+}
+
+
+static void
+bench_report_ops(const char *label, int nOps, uint64_t elapsed_ns)
+{
+	SCPrint(TRUE, stdout,
+		CFSTR("  %-24s %8d ops, %10.3f ms, %10.0f ops/sec\n"),
+		label,
+		nOps,
+		(double)elapsed_ns / 1000000.0,
+		(elapsed_ns > 0) ? (double)nOps * 1000000000.0 / (double)elapsed_ns : 0.0);
+	return;
+}
+
+
+static void
+bench_report_latency(const char *label, uint64_t *samples, CFIndex n)
+{
+	if (n == 0) {
+		SCPrint(TRUE, stdout, CFSTR("  %-24s no samples\n"), label);
+		return;
+	}
+
+	qsort(samples, n, sizeof(uint64_t), bench_compare_u64);
+
+#define	PCT(p)	((double)samples[(CFIndex)(((n - 1) * (p)) / 1000)] / 1000.0)
+	SCPrint(TRUE, stdout,
+		CFSTR("  %-24s %ld samples, p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n"),
+		label,
+		(long)n,
+		PCT(500),
+		PCT(900),
+		PCT(990),
+		PCT(999),
+		(double)samples[n - 1] / 1000.0);
+#undef	PCT
+
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Request throughput
+
+
+static Boolean
+bench_requests(const char *path, int nOps)
+{
+	SCDLocalClientRef	client;
+	uint64_t		elapsed;
+	int			i;
+	CFStringRef		keys[64];
+	CFStringRef		pattern;
+
+	client = SCDLocalClientCreate(path, CFSTR("scdlocal-bench"), FALSE);
+	if (client == NULL) {
+		SCPrint(TRUE, stderr, CFSTR("could not connect to \"%s\": %s\n"), path, SCErrorString(SCError()));
+		return FALSE;
+	}
+
+	for (i = 0; i < (int)(sizeof(keys) / sizeof(keys[0])); i++) {
+		keys[i] = CFStringCreateWithFormat(NULL, NULL, CFSTR("State:/Bench/Ops/Key%d"), i);
+	}
+
+	SCPrint(TRUE, stdout, CFSTR("request throughput (1 session)\n"));
+
+	elapsed = bench_now_ns();
+	for (i = 0; i < nOps; i++) {
+		CFNumberRef	num;
+
+		num = CFNumberCreate(NULL, kCFNumberIntType, &i);
+		(void) SCDLocalClientSetValue(client, keys[i % 64], num);
+		CFRelease(num);
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report_ops("set", nOps, elapsed);
+
+	elapsed = bench_now_ns();
+	for (i = 0; i < nOps; i++) {
+		CFPropertyListRef	val;
+
+		val = SCDLocalClientCopyValue(client, keys[i % 64]);
+		if (val != NULL) CFRelease(val);
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report_ops("get", nOps, elapsed);
+
+	elapsed = bench_now_ns();
+	for (i = 0; i < nOps; i++) {
+		(void) SCDLocalClientNotifyValue(client, keys[i % 64]);
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report_ops("notify", nOps, elapsed);
+
+	pattern = CFSTR("^State:/Bench/Ops/Key[0-9]+$");
+	elapsed = bench_now_ns();
+	for (i = 0; i < nOps; i++) {
+		CFArrayRef	list;
+
+		list = SCDLocalClientCopyKeyList(client, pattern);
+		if (list != NULL) CFRelease(list);
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report_ops("list (64 keys)", nOps, elapsed);
+
+	for (i = 0; i < (int)(sizeof(keys) / sizeof(keys[0])); i++) {
+		(void) SCDLocalClientRemoveValue(client, keys[i]);
+		CFRelease(keys[i]);
+	}
+	SCDLocalClientRelease(client);
+
+	return TRUE;
+}
+
+
+#pragma mark -
+#pragma mark Transactions
+
+
+#define	BENCH_TXN_WRITERS	4
+
+
+typedef struct {
+	const char		*path;
+	int			nOps;
+	int			commits;
+	int			conflicts;
+	Boolean			ok;
+} bench_txn_t;
+
+
+static CFStringRef	bench_txn_keys[]	= {
+	CFSTR("State:/Bench/Txn/Service/IPv4"),
+	CFSTR("State:/Bench/Txn/Service/DNS"),
+};
+
+
+static void *
+bench_txn_writer(void *arg)
+{
+	SCDLocalClientRef	client;
+	int			i;
+	CFArrayRef		keys;
+	bench_txn_t		*txn	= (bench_txn_t *)arg;
+
+	client = SCDLocalClientCreate(txn->path, CFSTR("scdlocal-bench-txn"), FALSE);
+	if (client == NULL) {
+		txn->ok = FALSE;
+		return NULL;
+	}
+
+	keys = CFArrayCreate(NULL, (const void **)bench_txn_keys, 2, &kCFTypeArrayCallBacks);
+	txn->ok = TRUE;
+	for (i = 0; i < txn->nOps; ) {
+		CFDictionaryRef		generations;
+		CFMutableDictionaryRef	newValues;
+		int			n	= 0;
+		CFNumberRef		num;
+		CFDictionaryRef		values;
+
+		// read both keys (and their generations), update both
+		values = SCDLocalClientCopyValuesWithGenerations(client, keys, &generations);
+		if ((values == NULL) || (generations == NULL)) {
+			if (values != NULL) CFRelease(values);
+			txn->ok = FALSE;
+			break;
+		}
+		num = CFDictionaryGetValue(values, bench_txn_keys[0]);
+		if (isA_CFNumber(num)) {
+			(void) CFNumberGetValue(num, kCFNumberIntType, &n);
+		}
+		n++;
+
+		num = CFNumberCreate(NULL, kCFNumberIntType, &n);
+		newValues = CFDictionaryCreateMutable(NULL,
+						      0,
+						      &kCFTypeDictionaryKeyCallBacks,
+						      &kCFTypeDictionaryValueCallBacks);
+		CFDictionarySetValue(newValues, bench_txn_keys[0], num);
+		CFDictionarySetValue(newValues, bench_txn_keys[1], num);
+		CFRelease(num);
+
+		if (SCDLocalClientCommit(client, generations, newValues, NULL, NULL, NULL)) {
+			txn->commits++;
+			i++;
+		} else if (SCError() == kSCStatusStale) {
+			txn->conflicts++;
+		} else {
+			txn->ok = FALSE;
+		}
+		CFRelease(newValues);
+		CFRelease(generations);
+		CFRelease(values);
+		if (!txn->ok) {
+			break;
+		}
+	}
+
+	CFRelease(keys);
+	SCDLocalClientRelease(client);
+	return NULL;
+}
+
+
+static Boolean
+bench_transactions(const char *path, int nOps)
+{
+	SCDLocalClientRef	client;
+	int			commits		= 0;
+	int			conflicts	= 0;
+	uint64_t		elapsed;
+	int			i;
+	Boolean			ok		= TRUE;
+	pthread_t		threads[BENCH_TXN_WRITERS];
+	bench_txn_t		txns[BENCH_TXN_WRITERS];
+
+	SCPrint(TRUE, stdout,
+		CFSTR("compare-and-set transactions (%d writers, 2 keys)\n"),
+		BENCH_TXN_WRITERS);
+
+	elapsed = bench_now_ns();
+	for (i = 0; i < BENCH_TXN_WRITERS; i++) {
+		memset(&txns[i], 0, sizeof(txns[i]));
+		txns[i].path = path;
+		txns[i].nOps = nOps / BENCH_TXN_WRITERS;
+		pthread_create(&threads[i], NULL, bench_txn_writer, &txns[i]);
+	}
+	for (i = 0; i < BENCH_TXN_WRITERS; i++) {
+		pthread_join(threads[i], NULL);
+		commits += txns[i].commits;
+		conflicts += txns[i].conflicts;
+		if (!txns[i].ok) ok = FALSE;
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report_ops("read + commit", commits, elapsed);
+	SCPrint(TRUE, stdout, CFSTR("  %d conflicts (retried)\n"), conflicts);
+
+	// all of the increments must have been applied, to both keys
+	client = SCDLocalClientCreate(path, CFSTR("scdlocal-bench-txn"), FALSE);
+	if (client != NULL) {
+		CFArrayRef	keys;
+		CFTypeRef	val0	= NULL;
+		CFTypeRef	val1	= NULL;
+		CFDictionaryRef	values;
+
+		keys = CFArrayCreate(NULL, (const void **)bench_txn_keys, 2, &kCFTypeArrayCallBacks);
+		values = SCDLocalClientCopyMultiple(client, keys, NULL);
+		if (values != NULL) {
+			val0 = CFDictionaryGetValue(values, bench_txn_keys[0]);
+			val1 = CFDictionaryGetValue(values, bench_txn_keys[1]);
+		}
+		if ((commits > 0) &&
+		    ((val0 == NULL) || (val1 == NULL) || !CFEqual(val0, val1))) {
+			SCPrint(TRUE, stderr, CFSTR("  transaction keys are inconsistent\n"));
+			ok = FALSE;
+		}
+		if (values != NULL) CFRelease(values);
+		(void) SCDLocalClientCommit(client, NULL, NULL, keys, NULL, NULL);
+		CFRelease(keys);
+		SCDLocalClientRelease(client);
+	}
+
+	return ok;
+}
+
+
+#pragma mark -
+#pragma mark Snapshots
+
+
+/* names in the server's private directory */
+#define	BENCH_SNAPSHOT_NAME	"bench.snapshot"
+#define	BENCH_SNAPSHOT_DELTA	"bench.snapshot.delta"
+
+
+static CFDictionaryRef
+bench_value(int i)
+{
+	CFStringRef		addr;
+	CFArrayRef		addrs;
+	CFMutableDictionaryRef	value;
+
+	addr = CFStringCreateWithFormat(NULL, NULL, CFSTR("10.%d.%d.%d"), (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff);
+	addrs = CFArrayCreate(NULL, (const void **)&addr, 1, &kCFTypeArrayCallBacks);
+	value = CFDictionaryCreateMutable(NULL,
+					  0,
+					  &kCFTypeDictionaryKeyCallBacks,
+					  &kCFTypeDictionaryValueCallBacks);
+	CFDictionarySetValue(value, CFSTR("Addresses"), addrs);
+	CFDictionarySetValue(value, CFSTR("InterfaceName"), CFSTR("en0"));
+	CFRelease(addrs);
+	CFRelease(addr);
+
+	return value;
+}
+
+
+static void
+bench_snapshot_unlink(const char *name)
+{
+	char	path[PATH_MAX];
+
+	// the server runs as the same user, in the same private directory
+	if (SCDLocalGetDirectory(path, sizeof(path), FALSE) &&
+	    (strlcat(path, "/", sizeof(path)) < sizeof(path)) &&
+	    (strlcat(path, name, sizeof(path)) < sizeof(path))) {
+		(void) unlink(path);
+	}
+	return;
+}
+
+
+static Boolean
+bench_snapshots(const char *path, int nOps)
+{
+	SCDLocalClientRef	client;
+	uint64_t		elapsed;
+	int64_t			generation	= 0;
+	int			i;
+	CFMutableArrayRef	keys;
+	Boolean			ok		= FALSE;
+	CFMutableDictionaryRef	values;
+
+	client = SCDLocalClientCreate(path, CFSTR("scdlocal-bench-snapshot"), FALSE);
+	if (client == NULL) {
+		SCPrint(TRUE, stderr, CFSTR("could not connect: %s\n"), SCErrorString(SCError()));
+		return FALSE;
+	}
+
+	SCPrint(TRUE, stdout, CFSTR("snapshots (%d keys)\n"), nOps);
+
+	keys = CFArrayCreateMutable(NULL, nOps, &kCFTypeArrayCallBacks);
+	values = CFDictionaryCreateMutable(NULL,
+					   nOps,
+					   &kCFTypeDictionaryKeyCallBacks,
+					   &kCFTypeDictionaryValueCallBacks);
+	for (i = 0; i < nOps; i++) {
+		CFStringRef	key;
+		CFDictionaryRef	value;
+
+		key = CFStringCreateWithFormat(NULL, NULL, CFSTR("State:/Bench/Snapshot/%d/IPv4"), i);
+		value = bench_value(i);
+		CFArrayAppendValue(keys, key);
+		CFDictionarySetValue(values, key, value);
+		CFRelease(key);
+		CFRelease(value);
+	}
+	if (!SCDLocalClientCommit(client, NULL, values, NULL, NULL, NULL)) {
+		SCPrint(TRUE, stderr, CFSTR("  populate failed: %s\n"), SCErrorString(SCError()));
+		goto done;
+	}
+
+	elapsed = bench_now_ns();
+	if (!SCDLocalClientWriteSnapshot(client, BENCH_SNAPSHOT_NAME, 0, &generation)) {
+		SCPrint(TRUE, stderr, CFSTR("  snapshot failed: %s\n"), SCErrorString(SCError()));
+		goto done;
+	}
+	elapsed = bench_now_ns() - elapsed;
+	SCPrint(TRUE, stdout, CFSTR("  %-24s %10.3f ms\n"), "full snapshot", (double)elapsed / 1000000.0);
+
+	// change 1% of the keys
+	CFDictionaryRemoveAllValues(values);
+	for (i = 0; i < nOps; i += 100) {
+		CFDictionaryRef	value;
+
+		value = bench_value(i + 1);
+		CFDictionarySetValue(values, CFArrayGetValueAtIndex(keys, i), value);
+		CFRelease(value);
+	}
+	(void) SCDLocalClientCommit(client, NULL, values, NULL, NULL, NULL);
+
+	elapsed = bench_now_ns();
+	if (!SCDLocalClientWriteSnapshot(client, BENCH_SNAPSHOT_DELTA, generation, NULL)) {
+		SCPrint(TRUE, stderr, CFSTR("  delta snapshot failed: %s\n"), SCErrorString(SCError()));
+		goto done;
+	}
+	elapsed = bench_now_ns() - elapsed;
+	SCPrint(TRUE, stdout, CFSTR("  %-24s %10.3f ms\n"), "delta snapshot (1%)", (double)elapsed / 1000000.0);
+
+	elapsed = bench_now_ns();
+	if (!SCDLocalClientRestoreSnapshot(client, BENCH_SNAPSHOT_NAME) ||
+	    !SCDLocalClientRestoreSnapshot(client, BENCH_SNAPSHOT_DELTA)) {
+		SCPrint(TRUE, stderr, CFSTR("  restore failed: %s\n"), SCErrorString(SCError()));
+		goto done;
+	}
+	elapsed = bench_now_ns() - elapsed;
+	SCPrint(TRUE, stdout, CFSTR("  %-24s %10.3f ms\n"), "restore (full + delta)", (double)elapsed / 1000000.0);
+
+	ok = TRUE;
+
+    done :
+
+	(void) SCDLocalClientCommit(client, NULL, NULL, keys, NULL, NULL);
+	bench_snapshot_unlink(BENCH_SNAPSHOT_NAME);
+	bench_snapshot_unlink(BENCH_SNAPSHOT_DELTA);
+	CFRelease(keys);
+	CFRelease(values);
+	SCDLocalClientRelease(client);
+	return ok;
+}
+
+
+#pragma mark -
+#pragma mark Notification fan-out
+
+
+typedef struct {
+	const char		*path;
+	int			nSessions;
+	int			nPatterns;
+	int			nRounds;
+
+	pthread_mutex_t		lock;
+	pthread_cond_t		cond;
+	int			ready;		// # of sessions watching
+	int			acked;		// # of sessions notified (this round)
+	int			failed;
+
+	uint64_t		sent_ns;
+	uint64_t		*latencies;	// [nRounds * nSessions]
+	CFIndex			nLatencies;
+} bench_fanout_t;
+
+
+typedef struct {
+	bench_fanout_t		*fanout;
+	int			index;
+} bench_watcher_t;
+
+
+static CFStringRef	bench_fanout_key	= CFSTR("State:/Bench/FanOut/Value");
+
+
+static void *
+bench_watcher(void *arg)
+{
+	SCDLocalClientRef	client;
+	bench_fanout_t		*fanout	= ((bench_watcher_t *)arg)->fanout;
+	int			i;
+	int			index	= ((bench_watcher_t *)arg)->index;
+	CFStringRef		name;
+	CFMutableArrayRef	patterns;
+	Boolean			ok	= FALSE;
+
+	name = CFStringCreateWithFormat(NULL, NULL, CFSTR("scdlocal-bench-%d"), index);
+	client = SCDLocalClientCreate(fanout->path, name, FALSE);
+	CFRelease(name);
+
+	if (client != NULL) {
+		patterns = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+		for (i = 0; i < fanout->nPatterns - 1; i++) {
+			CFStringRef	pattern;
+
+			pattern = CFStringCreateWithFormat(NULL, NULL,
+							   CFSTR("^State:/Bench/Session%d/Pattern%d/[^/]+$"),
+							   index, i);
+			CFArrayAppendValue(patterns, pattern);
+			CFRelease(pattern);
+		}
+		CFArrayAppendValue(patterns, CFSTR("^State:/Bench/FanOut/[^/]+$"));
+		ok = SCDLocalClientSetNotificationKeys(client, NULL, patterns);
+		CFRelease(patterns);
+	}
+
+	pthread_mutex_lock(&fanout->lock);
+	fanout->ready++;
+	if (!ok) fanout->failed++;
+	pthread_cond_broadcast(&fanout->cond);
+	pthread_mutex_unlock(&fanout->lock);
+
+	for (i = 0; ok && (i < fanout->nRounds); i++) {
+		CFArrayRef	changes;
+		uint64_t	now;
+
+		changes = SCDLocalClientCopyNotifiedKeys(client, BENCH_ROUND_TIMEOUT_MS);
+		now = bench_now_ns();
+		if (changes == NULL) {
+			ok = FALSE;
+			break;
+		}
+		CFRelease(changes);
+
+		pthread_mutex_lock(&fanout->lock);
+		fanout->latencies[fanout->nLatencies++] = now - __atomic_load_n(&fanout->sent_ns, __ATOMIC_ACQUIRE);
+		fanout->acked++;
+		pthread_cond_broadcast(&fanout->cond);
+		pthread_mutex_unlock(&fanout->lock);
+	}
+
+	if (!ok) {
+		pthread_mutex_lock(&fanout->lock);
+		fanout->failed++;
+		pthread_cond_broadcast(&fanout->cond);
+		pthread_mutex_unlock(&fanout->lock);
+	}
+
+	if (client != NULL) SCDLocalClientRelease(client);
+	return NULL;
+}
+
+
+static Boolean
+bench_fanout_wait(bench_fanout_t *fanout, int *counter, int target)
+{
+	struct timespec	ts;
+
+	ts.tv_sec  = BENCH_ROUND_TIMEOUT_MS / 1000;
+	ts.tv_nsec = 0;
+	while ((*counter < target) && (fanout->failed == 0)) {
+		if (pthread_cond_timedwait_relative_np(&fanout->cond, &fanout->lock, &ts) == ETIMEDOUT) {
+			return FALSE;
+		}
+	}
+
+	return (fanout->failed == 0);
+}
+
+
+static Boolean
+bench_notify_fanout(const char *path, int nSessions, int nPatterns, int nRounds)
+{
+	SCDLocalClientRef	client;
+	bench_fanout_t		fanout;
+	int			i;
+	Boolean			ok		= TRUE;
+	SCDLocalClientRef	stalled;
+	pthread_t		*threads;
+	bench_watcher_t		*watchers;
+
+	client = SCDLocalClientCreate(path, CFSTR("scdlocal-bench-writer"), FALSE);
+	if (client == NULL) {
+		SCPrint(TRUE, stderr, CFSTR("could not connect to \"%s\": %s\n"), path, SCErrorString(SCError()));
+		return FALSE;
+	}
+
+	memset(&fanout, 0, sizeof(fanout));
+	fanout.path = path;
+	fanout.nSessions = nSessions;
+	fanout.nPatterns = nPatterns;
+	fanout.nRounds = nRounds;
+	fanout.latencies = calloc((size_t)nSessions * nRounds, sizeof(uint64_t));
+	pthread_mutex_init(&fanout.lock, NULL);
+	pthread_cond_init(&fanout.cond, NULL);
+
+	SCPrint(TRUE, stdout,
+		CFSTR("notification fan-out (%d sessions, %d patterns/session, %d rounds)\n"),
+		nSessions, nPatterns, nRounds);
+
+	// a session that watches the same key but never reads its notifications
+	stalled = SCDLocalClientCreate(path, CFSTR("scdlocal-bench-stalled"), FALSE);
+	if (stalled != NULL) {
+		CFArrayRef	patterns;
+		CFStringRef	pattern	= CFSTR("^State:/Bench/FanOut/[^/]+$");
+
+		patterns = CFArrayCreate(NULL, (const void **)&pattern, 1, &kCFTypeArrayCallBacks);
+		(void) SCDLocalClientSetNotificationKeys(stalled, NULL, patterns);
+		CFRelease(patterns);
+	}
+
+	threads = calloc(nSessions, sizeof(pthread_t));
+	watchers = calloc(nSessions, sizeof(bench_watcher_t));
+	for (i = 0; i < nSessions; i++) {
+		watchers[i].fanout = &fanout;
+		watchers[i].index = i;
+		pthread_create(&threads[i], NULL, bench_watcher, &watchers[i]);
+	}
+
+	pthread_mutex_lock(&fanout.lock);
+	ok = bench_fanout_wait(&fanout, &fanout.ready, nSessions);
+	pthread_mutex_unlock(&fanout.lock);
+
+	for (i = 0; ok && (i < nRounds); i++) {
+		CFNumberRef	num;
+
+		pthread_mutex_lock(&fanout.lock);
+		fanout.acked = 0;
+		pthread_mutex_unlock(&fanout.lock);
+
+		num = CFNumberCreate(NULL, kCFNumberIntType, &i);
+		__atomic_store_n(&fanout.sent_ns, bench_now_ns(), __ATOMIC_RELEASE);
+		ok = SCDLocalClientSetValue(client, bench_fanout_key, num);
+		CFRelease(num);
+		if (!ok) {
+			break;
+		}
+
+		pthread_mutex_lock(&fanout.lock);
+		ok = bench_fanout_wait(&fanout, &fanout.acked, nSessions);
+		pthread_mutex_unlock(&fanout.lock);
+	}
+
+	if (!ok) {
+		SCPrint(TRUE, stderr, CFSTR("  fan-out round %d did not complete\n"), i);
+	}
+
+	// let any remaining watchers time out
+	for (i = 0; i < nSessions; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	bench_report_latency("set --> notified", fanout.latencies, fanout.nLatencies);
+
+	if (stalled != NULL) {
+		CFDictionaryRef	stats;
+
+		stats = SCDLocalClientCopyStatistics(stalled);
+		if (stats != NULL) {
+			SCPrint(TRUE, stdout,
+				CFSTR("  stalled session: %@ sent, %@ merged, %@ dropped, %@ resyncs\n"),
+				CFDictionaryGetValue(stats, kSCDLocalStatisticsSent),
+				CFDictionaryGetValue(stats, kSCDLocalStatisticsMerged),
+				CFDictionaryGetValue(stats, kSCDLocalStatisticsDropped),
+				CFDictionaryGetValue(stats, kSCDLocalStatisticsResyncs));
+			CFRelease(stats);
+		}
+		SCDLocalClientRelease(stalled);
+	}
+
+	(void) SCDLocalClientRemoveValue(client, bench_fanout_key);
+	SCDLocalClientRelease(client);
+
+	free(threads);
+	free(watchers);
+	free(fanout.latencies);
+	pthread_cond_destroy(&fanout.cond);
+	pthread_mutex_destroy(&fanout.lock);
+
+	return ok;
+}
+
+
+#pragma mark -
+#pragma mark Load generator
+
+
+int
+SCDLocalBenchRun(const char *path, int nSessions, int nPatterns, int nOps)
+{
+	Boolean	ok;
+
+	ok = bench_requests(path, nOps);
+	if (ok) {
+		SCPrint(TRUE, stdout, CFSTR("\n"));
+		ok = bench_transactions(path, nOps);
+	}
+	if (ok) {
+		SCPrint(TRUE, stdout, CFSTR("\n"));
+		ok = bench_snapshots(path, nOps);
+	}
+	if (ok) {
+		SCPrint(TRUE, stdout, CFSTR("\n"));
+		ok = bench_notify_fanout(path, nSessions, nPatterns, (nOps > 1000) ? 1000 : nOps);
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,700 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "scdlocal.h"
+
+
+/*
+ * A minimal, synchronous client for the scdlocal server.  A client is not
+ * thread safe; each thread should use its own connection (just like each
+ * SCDynamicStore session is one "configd" session).
+ */
+
+
+struct __SCDLocalClient {
+	int			fd;
+	int			requestID;
+
+	/* keys reported changed while waiting for a reply */
+	CFMutableSetRef		changedKeys;
+
+	/* ... and their values, if delivered with the notification */
+	CFMutableDictionaryRef	changedValues;
+
+	/* the server dropped changes, everything must be re-read */
+	Boolean			resync;
+};
+
+
+static void
+clientAddChangedKeys(SCDLocalClientRef client, CFDictionaryRef message)
+{
+	CFIndex		i;
+	CFArrayRef	keys;
+	CFIndex		n;
+	CFArrayRef	removed;
+	CFDictionaryRef	values;
+
+	if (SCDLocalMessageGetInt(message, kSCDLocalMessageResync, 0) != 0) {
+		client->resync = TRUE;
+		return;
+	}
+
+	keys = isA_CFArray(CFDictionaryGetValue(message, kSCDLocalMessageKeys));
+	if (keys == NULL) {
+		return;
+	}
+
+	values = isA_CFDictionary(CFDictionaryGetValue(message, kSCDLocalMessageValues));
+	removed = isA_CFArray(CFDictionaryGetValue(message, kSCDLocalMessageRemoved));
+
+	n = CFArrayGetCount(keys);
+	for (i = 0; i < n; i++) {
+		CFStringRef		key	= CFArrayGetValueAtIndex(keys, i);
+		CFPropertyListRef	value	= NULL;
+
+		CFSetAddValue(client->changedKeys, key);
+
+		if (values != NULL) {
+			value = CFDictionaryGetValue(values, key);
+		}
+		if ((value == NULL) &&
+		    (removed != NULL) &&
+		    CFArrayContainsValue(removed, CFRangeMake(0, CFArrayGetCount(removed)), key)) {
+			value = kCFNull;
+		}
+		if (value != NULL) {
+			CFDictionarySetValue(client->changedValues, key, value);
+		} else {
+			// key only, any earlier value is stale
+			CFDictionaryRemoveValue(client->changedValues, key);
+		}
+	}
+
+	return;
+}
+
+
+static CFDictionaryRef
+clientRequest(SCDLocalClientRef client, CFMutableDictionaryRef request)
+{
+	int		requestID;
+
+	requestID = ++client->requestID;
+	SCDLocalMessageSetInt(request, kSCDLocalMessageID, requestID);
+	if (!SCDLocalMessageSend(client->fd, request)) {
+		_SCErrorSet(kSCStatusFailed);
+		return NULL;
+	}
+
+	while (TRUE) {
+		CFDictionaryRef	reply;
+
+		reply = SCDLocalMessageReceive(client->fd);
+		if (reply == NULL) {
+			_SCErrorSet(kSCStatusFailed);
+			return NULL;
+		}
+
+		if (SCDLocalMessageGetInt(reply, kSCDLocalMessageOp, 0) == kSCDLocalOpChanged) {
+			clientAddChangedKeys(client, reply);
+			CFRelease(reply);
+			continue;
+		}
+
+		if (SCDLocalMessageGetInt(reply, kSCDLocalMessageID, 0) != requestID) {
+			// if not our reply
+			CFRelease(reply);
+			continue;
+		}
+
+		_SCErrorSet(SCDLocalMessageGetInt(reply, kSCDLocalMessageStatus, kSCStatusFailed));
+		return reply;
+	}
+}
+
+
+static CFMutableDictionaryRef
+clientRequestCreate(SCDLocalOp op, CFStringRef key, CFPropertyListRef value)
+{
+	CFMutableDictionaryRef	request;
+
+	request = CFDictionaryCreateMutable(NULL,
+					    0,
+					    &kCFTypeDictionaryKeyCallBacks,
+					    &kCFTypeDictionaryValueCallBacks);
+	SCDLocalMessageSetInt(request, kSCDLocalMessageOp, op);
+	if (key != NULL) {
+		CFDictionarySetValue(request, kSCDLocalMessageKey, key);
+	}
+	if (value != NULL) {
+		CFDictionarySetValue(request, kSCDLocalMessageValue, value);
+	}
+
+	return request;
+}
+
+
+static Boolean
+clientRequestStatus(SCDLocalClientRef client, CFMutableDictionaryRef request)
+{
+	CFDictionaryRef	reply;
+
+	reply = clientRequest(client, request);
+	CFRelease(request);
+	if (reply == NULL) {
+		return FALSE;
+	}
+	CFRelease(reply);
+
+	return (SCError() == kSCStatusOK);
+}
+
+
+static CFTypeRef
+clientRequestValue(SCDLocalClientRef client, CFMutableDictionaryRef request)
+{
+	CFDictionaryRef	reply;
+	CFTypeRef	value	= NULL;
+
+	reply = clientRequest(client, request);
+	CFRelease(request);
+	if (reply == NULL) {
+		return NULL;
+	}
+
+	if (SCError() == kSCStatusOK) {
+		value = CFDictionaryGetValue(reply, kSCDLocalMessageValue);
+		if (value != NULL) {
+			CFRetain(value);
+		}
+	}
+	CFRelease(reply);
+
+	return value;
+}
+
+
+#pragma mark -
+#pragma mark Directory
+
+
+/*
+ * SCDLocalGetDirectory
+ *
+ * Returns the directory holding the server socket and the snapshots
+ * written at a client's request: "$TMPDIR/scdlocal", or "/tmp/scdlocal-<uid>"
+ * if TMPDIR is not set.  The directory (created if "create" is set) must
+ * be owned by the caller and not accessible to anyone else.
+ */
+Boolean
+SCDLocalGetDirectory(char *dir, size_t dirLen, Boolean create)
+{
+	int		n;
+	struct stat	sb;
+	const char	*tmpdir;
+
+	tmpdir = getenv("TMPDIR");
+	if ((tmpdir != NULL) && (*tmpdir != '\0')) {
+		n = snprintf(dir, dirLen, "%s/%s", tmpdir, SCDLOCAL_DIRECTORY_NAME);
+	} else {
+		n = snprintf(dir, dirLen, "/tmp/%s-%u", SCDLOCAL_DIRECTORY_NAME, (unsigned int)getuid());
+	}
+	if ((n < 0) || ((size_t)n >= dirLen)) {
+		_SCErrorSet(kSCStatusInvalidArgument);
+		return FALSE;
+	}
+
+	if (create && (mkdir(dir, 0700) == -1) && (errno != EEXIST)) {
+		_SCErrorSet(errno);
+		return FALSE;
+	}
+
+	if (lstat(dir, &sb) == -1) {
+		_SCErrorSet(errno);
+		return FALSE;
+	}
+	if (!S_ISDIR(sb.st_mode) || (sb.st_uid != getuid()) || ((sb.st_mode & 077) != 0)) {
+		// not ours, or someone else could plant a socket or snapshot
+		_SCErrorSet(kSCStatusAccessError);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+#pragma mark -
+#pragma mark Session
+
+
+SCDLocalClientRef
+SCDLocalClientCreate(const char *path, CFStringRef name, Boolean useSessionKeys)
+{
+	struct sockaddr_un	addr;
+	SCDLocalClientRef	client;
+	int			fd;
+	CFMutableDictionaryRef	request;
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1) {
+		_SCErrorSet(errno);
+		return NULL;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	(void) strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+		_SCErrorSet(kSCStatusNoStoreServer);
+		close(fd);
+		return NULL;
+	}
+#ifdef	SO_NOSIGPIPE
+	{
+		int	on	= 1;
+
+		(void) setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	}
+#endif	// SO_NOSIGPIPE
+
+	client = calloc(1, sizeof(*client));
+	client->fd = fd;
+	client->changedKeys = CFSetCreateMutable(NULL, 0, &kCFTypeSetCallBacks);
+	client->changedValues = CFDictionaryCreateMutable(NULL,
+							  0,
+							  &kCFTypeDictionaryKeyCallBacks,
+							  &kCFTypeDictionaryValueCallBacks);
+
+	request = clientRequestCreate(kSCDLocalOpOpen, NULL, NULL);
+	if (name != NULL) {
+		CFDictionarySetValue(request, kSCDLocalMessageName, name);
+	}
+	SCDLocalMessageSetInt(request, kSCDLocalMessageUseSessionKeys, useSessionKeys ? 1 : 0);
+	if (!clientRequestStatus(client, request)) {
+		SCDLocalClientRelease(client);
+		return NULL;
+	}
+
+	return client;
+}
+
+
+void
+SCDLocalClientRelease(SCDLocalClientRef client)
+{
+	close(client->fd);
+	CFRelease(client->changedKeys);
+	CFRelease(client->changedValues);
+	free(client);
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Store operations
+
+
+CFPropertyListRef
+SCDLocalClientCopyValue(SCDLocalClientRef client, CFStringRef key)
+{
+	return clientRequestValue(client, clientRequestCreate(kSCDLocalOpCopyValue, key, NULL));
+}
+
+
+Boolean
+SCDLocalClientSetValue(SCDLocalClientRef client, CFStringRef key, CFPropertyListRef value)
+{
+	return clientRequestStatus(client, clientRequestCreate(kSCDLocalOpSetValue, key, value));
+}
+
+
+Boolean
+SCDLocalClientAddValue(SCDLocalClientRef client, CFStringRef key, CFPropertyListRef value, Boolean temporary)
+{
+	return clientRequestStatus(client,
+				   clientRequestCreate(temporary ? kSCDLocalOpAddTemporaryValue : kSCDLocalOpAddValue,
+						       key,
+						       value));
+}
+
+
+Boolean
+SCDLocalClientRemoveValue(SCDLocalClientRef client, CFStringRef key)
+{
+	return clientRequestStatus(client, clientRequestCreate(kSCDLocalOpRemoveValue, key, NULL));
+}
+
+
+Boolean
+SCDLocalClientNotifyValue(SCDLocalClientRef client, CFStringRef key)
+{
+	return clientRequestStatus(client, clientRequestCreate(kSCDLocalOpNotifyValue, key, NULL));
+}
+
+
+CFArrayRef
+SCDLocalClientCopyKeyList(SCDLocalClientRef client, CFStringRef pattern)
+{
+	CFMutableDictionaryRef	request;
+
+	request = clientRequestCreate(kSCDLocalOpCopyKeyList, NULL, NULL);
+	CFDictionarySetValue(request, kSCDLocalMessagePattern, pattern);
+	return clientRequestValue(client, request);
+}
+
+
+CFDictionaryRef
+SCDLocalClientCopyMultiple(SCDLocalClientRef client, CFArrayRef keys, CFArrayRef patterns)
+{
+	CFMutableDictionaryRef	request;
+
+	request = clientRequestCreate(kSCDLocalOpCopyMultiple, NULL, NULL);
+	if (keys != NULL) {
+		CFDictionarySetValue(request, kSCDLocalMessageKeys, keys);
+	}
+	if (patterns != NULL) {
+		CFDictionarySetValue(request, kSCDLocalMessagePatterns, patterns);
+	}
+	return clientRequestValue(client, request);
+}
+
+
+#pragma mark -
+#pragma mark Notifications
+
+
+Boolean
+SCDLocalClientSetNotificationKeys(SCDLocalClientRef client, CFArrayRef keys, CFArrayRef patterns)
+{
+	CFMutableDictionaryRef	request;
+
+	request = clientRequestCreate(kSCDLocalOpSetNotificationKeys, NULL, NULL);
+	if (keys != NULL) {
+		CFDictionarySetValue(request, kSCDLocalMessageKeys, keys);
+	}
+	if (patterns != NULL) {
+		CFDictionarySetValue(request, kSCDLocalMessagePatterns, patterns);
+	}
+	return clientRequestStatus(client, request);
+}
+
+
+Boolean
+SCDLocalClientSetNotificationPayloads(SCDLocalClientRef client, Boolean enable, CFIndex payloadMax)
+{
+	CFMutableDictionaryRef	request;
+
+	request = clientRequestCreate(kSCDLocalOpSetNotificationOptions, NULL, NULL);
+	SCDLocalMessageSetInt(request, kSCDLocalMessagePayloads, enable ? 1 : 0);
+	SCDLocalMessageSetInt(request, kSCDLocalMessagePayloadMax, (int)payloadMax);
+	return clientRequestStatus(client, request);
+}
+
+
+Boolean
+SCDLocalClientSetNotificationLimit(SCDLocalClientRef client, CFIndex changedMax)
+{
+	CFMutableDictionaryRef	request;
+
+	request = clientRequestCreate(kSCDLocalOpSetNotificationOptions, NULL, NULL);
+	SCDLocalMessageSetInt(request, kSCDLocalMessageChangedMax, (int)changedMax);
+	return clientRequestStatus(client, request);
+}
+
+
+/*
+ * SCDLocalClientCheckResync
+ *
+ * Returns TRUE (once) if the server has discarded changes for this
+ * session because too many were pending; the caller should re-read all
+ * of the keys/patterns that it is watching.
+ */
+Boolean
+SCDLocalClientCheckResync(SCDLocalClientRef client)
+{
+	Boolean	resync	= client->resync;
+
+	client->resync = FALSE;
+	return resync;
+}
+
+
+CFDictionaryRef
+SCDLocalClientCopyStatistics(SCDLocalClientRef client)
+{
+	return clientRequestValue(client, clientRequestCreate(kSCDLocalOpCopyStatistics, NULL, NULL));
+}
+
+
+/*
+ * SCDLocalClientCopyNotifiedChanges
+ *
+ * Returns the changed keys (an empty list if only a resync is pending,
+ * see SCDLocalClientCheckResync()).  If "values" is not NULL it is set
+ * to a dictionary of the values delivered with the notifications
+ * (kCFNull if the key was removed).  Keys without an entry were sent
+ * without a payload and must be fetched.
+ */
+CFArrayRef
+SCDLocalClientCopyNotifiedChanges(SCDLocalClientRef client, int timeout_ms, CFDictionaryRef *values)
+{
+	CFArrayRef	changes;
+	const void	**keys;
+	CFIndex		n;
+
+	if (values != NULL) {
+		*values = NULL;
+	}
+
+	while ((CFSetGetCount(client->changedKeys) == 0) && !client->resync) {
+		CFDictionaryRef	message;
+		struct pollfd	pfd	= { client->fd, POLLIN, 0 };
+		int		status;
+
+		status = poll(&pfd, 1, timeout_ms);
+		if (status == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			_SCErrorSet(kSCStatusFailed);
+			return NULL;
+		}
+		if (status == 0) {
+			// if timeout
+			_SCErrorSet(kSCStatusOK);
+			return NULL;
+		}
+
+		message = SCDLocalMessageReceive(client->fd);
+		if (message == NULL) {
+			_SCErrorSet(kSCStatusNoStoreServer);
+			return NULL;
+		}
+		if (SCDLocalMessageGetInt(message, kSCDLocalMessageOp, 0) == kSCDLocalOpChanged) {
+			clientAddChangedKeys(client, message);
+		}
+		CFRelease(message);
+	}
+
+	n = CFSetGetCount(client->changedKeys);
+	keys = CFAllocatorAllocate(NULL, (n > 0 ? n : 1) * sizeof(CFTypeRef), 0);
+	CFSetGetValues(client->changedKeys, keys);
+	changes = CFArrayCreate(NULL, keys, n, &kCFTypeArrayCallBacks);
+	CFAllocatorDeallocate(NULL, keys);
+	CFSetRemoveAllValues(client->changedKeys);
+
+	if (values != NULL) {
+		*values = CFDictionaryCreateCopy(NULL, client->changedValues);
+	}
+	CFDictionaryRemoveAllValues(client->changedValues);
+
+	_SCErrorSet(kSCStatusOK);
+	return changes;
+}
+
+
+CFArrayRef
+SCDLocalClientCopyNotifiedKeys(SCDLocalClientRef client, int timeout_ms)
+{
+	return SCDLocalClientCopyNotifiedChanges(client, timeout_ms, NULL);
+}
+
+
+#pragma mark -
+#pragma mark Transactions
+
+
+CFDictionaryRef
+SCDLocalClientCopyValuesWithGenerations(SCDLocalClientRef client, CFArrayRef keys, CFDictionaryRef *generations)
+{
+	CFDictionaryRef		reply;
+	CFMutableDictionaryRef	request;
+	CFDictionaryRef		values;
+
+	if (generations != NULL) {
+		*generations = NULL;
+	}
+
+	request = clientRequestCreate(kSCDLocalOpCopyGenerations, NULL, NULL);
+	CFDictionarySetValue(request, kSCDLocalMessageKeys, keys);
+	reply = clientRequestValue(client, request);
+	if (reply == NULL) {
+		return NULL;
+	}
+
+	values = CFDictionaryGetValue(reply, kSCDLocalMessageValues);
+	if (values != NULL) {
+		CFRetain(values);
+	}
+	if (generations != NULL) {
+		*generations = CFDictionaryGetValue(reply, kSCDLocalMessageGenerations);
+		if (*generations != NULL) {
+			CFRetain(*generations);
+		}
+	}
+	CFRelease(reply);
+
+	return values;
+}
+
+
+/*
+ * SCDLocalClientCommit
+ *
+ * Sets, removes, and notifies a group of keys in one request, provided
+ * that the keys in "expected" still have the given generations.  Returns
+ * FALSE with SCError() == kSCStatusStale on a conflict, in which case
+ * "generations" (if not NULL) holds the current generations of the
+ * conflicting keys.  On success it holds the new generations.
+ */
+Boolean
+SCDLocalClientCommit(SCDLocalClientRef	client,
+		     CFDictionaryRef	expected,
+		     CFDictionaryRef	keysToSet,
+		     CFArrayRef		keysToRemove,
+		     CFArrayRef		keysToNotify,
+		     CFDictionaryRef	*generations)
+{
+	CFDictionaryRef		reply;
+	CFMutableDictionaryRef	request;
+	int			sc_status;
+
+	if (generations != NULL) {
+		*generations = NULL;
+	}
+
+	request = clientRequestCreate(kSCDLocalOpCommit, NULL, NULL);
+	if (expected != NULL) {
+		CFDictionarySetValue(request, kSCDLocalMessageExpect, expected);
+	}
+	if (keysToSet != NULL) {
+		CFDictionarySetValue(request, kSCDLocalMessageSet, keysToSet);
+	}
+	if (keysToRemove != NULL) {
+		CFDictionarySetValue(request, kSCDLocalMessageRemove, keysToRemove);
+	}
+	if (keysToNotify != NULL) {
+		CFDictionarySetValue(request, kSCDLocalMessageNotify, keysToNotify);
+	}
+
+	reply = clientRequest(client, request);
+	CFRelease(request);
+	if (reply == NULL) {
+		return FALSE;
+	}
+
+	sc_status = SCError();
+	if ((generations != NULL) &&
+	    ((sc_status == kSCStatusOK) || (sc_status == kSCStatusStale))) {
+		*generations = CFDictionaryGetValue(reply, kSCDLocalMessageValue);
+		if (*generations != NULL) {
+			CFRetain(*generations);
+		}
+	}
+	CFRelease(reply);
+
+	_SCErrorSet(sc_status);
+	return (sc_status == kSCStatusOK);
+}
+
+
+#pragma mark -
+#pragma mark Snapshots
+
+
+static CFMutableDictionaryRef
+clientSnapshotRequestCreate(SCDLocalOp op, const char *name)
+{
+	CFStringRef		nameString;
+	CFMutableDictionaryRef	request;
+
+	request = clientRequestCreate(op, NULL, NULL);
+	nameString = CFStringCreateWithFileSystemRepresentation(NULL, name);
+	CFDictionarySetValue(request, kSCDLocalMessagePath, nameString);
+	CFRelease(nameString);
+
+	return request;
+}
+
+
+/*
+ * SCDLocalClientWriteSnapshot
+ *
+ * Has the server write a snapshot of the store to the file "name" in
+ * its private directory (see SCDLocalGetDirectory()).  A non-zero
+ * "sinceGeneration" (a generation returned by an earlier snapshot) writes
+ * only the changes made since.
+ */
+Boolean
+SCDLocalClientWriteSnapshot(SCDLocalClientRef	client,
+			    const char		*name,
+			    int64_t		sinceGeneration,
+			    int64_t		*generation)
+{
+	CFMutableDictionaryRef	request;
+	CFNumberRef		value;
+
+	request = clientSnapshotRequestCreate(kSCDLocalOpSnapshot, name);
+	if (sinceGeneration > 0) {
+		CFNumberRef	since;
+
+		since = CFNumberCreate(NULL, kCFNumberSInt64Type, &sinceGeneration);
+		CFDictionarySetValue(request, kSCDLocalMessageGeneration, since);
+		CFRelease(since);
+	}
+
+	value = clientRequestValue(client, request);
+	if (value == NULL) {
+		return FALSE;
+	}
+	if ((generation != NULL) && isA_CFNumber(value)) {
+		(void) CFNumberGetValue(value, kCFNumberSInt64Type, generation);
+	}
+	CFRelease(value);
+
+	return TRUE;
+}
+
+
+Boolean
+SCDLocalClientRestoreSnapshot(SCDLocalClientRef client, const char *name)
+{
+	return clientRequestStatus(client, clientSnapshotRequestCreate(kSCDLocalOpRestore, name));
+}
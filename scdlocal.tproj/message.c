@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "scdlocal.h"
+
+
+#pragma mark -
+#pragma mark Message I/O
+
+
+static Boolean
+writeAll(int fd, const UInt8 *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t		n;
+
+		n = write(fd, buf, len);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN) {
+				struct pollfd	pfd	= { fd, POLLOUT, 0 };
+
+				(void) poll(&pfd, 1, -1);
+				continue;
+			}
+			return FALSE;
+		}
+		buf += n;
+		len -= n;
+	}
+
+	return TRUE;
+}
+
+
+static Boolean
+readAll(int fd, UInt8 *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t		n;
+
+		n = read(fd, buf, len);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return FALSE;
+		}
+		if (n == 0) {
+			// if EOF
+			return FALSE;
+		}
+		buf += n;
+		len -= n;
+	}
+
+	return TRUE;
+}
+
+
+CFDataRef
+SCDLocalMessageCreateData(CFDictionaryRef message)
+{
+	return CFPropertyListCreateData(NULL, message, kCFPropertyListBinaryFormat_v1_0, 0, NULL);
+}
+
+
+Boolean
+SCDLocalMessageSendData(int fd, CFDataRef data)
+{
+	CFIndex		len;
+	Boolean		ok;
+	UInt8		*buf;
+	UInt8		buf_q[1024];
+	uint32_t	len_n;
+
+	len = CFDataGetLength(data);
+	if (len > SCDLOCAL_MESSAGE_MAX) {
+		// the peer would refuse it
+		errno = EMSGSIZE;
+		return FALSE;
+	}
+
+	// send the length and the message with a single write
+	buf = (len + sizeof(len_n) <= sizeof(buf_q)) ? buf_q : CFAllocatorAllocate(NULL, len + sizeof(len_n), 0);
+	len_n = htonl((uint32_t)len);
+	memcpy(buf, &len_n, sizeof(len_n));
+	memcpy(buf + sizeof(len_n), CFDataGetBytePtr(data), len);
+	ok = writeAll(fd, buf, len + sizeof(len_n));
+	if (buf != buf_q) {
+		CFAllocatorDeallocate(NULL, buf);
+	}
+
+	return ok;
+}
+
+
+Boolean
+SCDLocalMessageAppendData(CFMutableDataRef buffer, CFDataRef data)
+{
+	uint32_t	len_n;
+
+	if (CFDataGetLength(data) > SCDLOCAL_MESSAGE_MAX) {
+		// the peer would refuse it
+		return FALSE;
+	}
+
+	len_n = htonl((uint32_t)CFDataGetLength(data));
+	CFDataAppendBytes(buffer, (const UInt8 *)&len_n, sizeof(len_n));
+	CFDataAppendBytes(buffer, CFDataGetBytePtr(data), CFDataGetLength(data));
+	return TRUE;
+}
+
+
+Boolean
+SCDLocalMessageSend(int fd, CFDictionaryRef message)
+{
+	CFDataRef	data;
+	Boolean		ok;
+
+	data = SCDLocalMessageCreateData(message);
+	if (data == NULL) {
+		return FALSE;
+	}
+
+	ok = SCDLocalMessageSendData(fd, data);
+	CFRelease(data);
+
+	return ok;
+}
+
+
+static CFDictionaryRef
+messageCreateWithBytes(const UInt8 *bytes, CFIndex len)
+{
+	CFDataRef		data;
+	CFPropertyListRef	message;
+
+	data = CFDataCreateWithBytesNoCopy(NULL, bytes, len, kCFAllocatorNull);
+	message = CFPropertyListCreateWithData(NULL, data, kCFPropertyListImmutable, NULL, NULL);
+	CFRelease(data);
+	if ((message != NULL) && !isA_CFDictionary(message)) {
+		CFRelease(message);
+		message = NULL;
+	}
+
+	return message;
+}
+
+
+CFDictionaryRef
+SCDLocalMessageReceive(int fd)
+{
+	UInt8		*buf;
+	uint32_t	len;
+	CFDictionaryRef	message;
+
+	if (!readAll(fd, (UInt8 *)&len, sizeof(len))) {
+		return NULL;
+	}
+	len = ntohl(len);
+	if (len > SCDLOCAL_MESSAGE_MAX) {
+		return NULL;
+	}
+
+	buf = CFAllocatorAllocate(NULL, len, 0);
+	if (!readAll(fd, buf, len)) {
+		CFAllocatorDeallocate(NULL, buf);
+		return NULL;
+	}
+	message = messageCreateWithBytes(buf, len);
+	CFAllocatorDeallocate(NULL, buf);
+
+	return message;
+}
+
+
+/*
+ * SCDLocalMessageCreateFromBuffer
+ *
+ * Returns the next complete message in the buffer (and removes it) or
+ * NULL if more data is needed.  A malformed message is reported by an
+ * empty dictionary.
+ */
+CFDictionaryRef
+SCDLocalMessageCreateFromBuffer(CFMutableDataRef buffer)
+{
+	uint32_t	len;
+	CFDictionaryRef	message;
+
+	if (CFDataGetLength(buffer) < (CFIndex)sizeof(len)) {
+		return NULL;
+	}
+
+	memcpy(&len, CFDataGetBytePtr(buffer), sizeof(len));
+	len = ntohl(len);
+	if (len > SCDLOCAL_MESSAGE_MAX) {
+		return CFDictionaryCreate(NULL, NULL, NULL, 0, NULL, NULL);
+	}
+	if (CFDataGetLength(buffer) < (CFIndex)(sizeof(len) + len)) {
+		return NULL;
+	}
+
+	message = messageCreateWithBytes(CFDataGetBytePtr(buffer) + sizeof(len), len);
+	CFDataDeleteBytes(buffer, CFRangeMake(0, sizeof(len) + len));
+	if (message == NULL) {
+		message = CFDictionaryCreate(NULL, NULL, NULL, 0, NULL, NULL);
+	}
+
+	return message;
+}
+
+
+int
+SCDLocalMessageGetInt(CFDictionaryRef message, CFStringRef key, int defaultValue)
+{
+	CFNumberRef	num;
+	int		val;
+
+	num = CFDictionaryGetValue(message, key);
+	if (!isA_CFNumber(num) || !CFNumberGetValue(num, kCFNumberIntType, &val)) {
+		return defaultValue;
+	}
+
+	return val;
+}
+
+
+void
+SCDLocalMessageSetInt(CFMutableDictionaryRef message, CFStringRef key, int value)
+{
+	CFNumberRef	num;
+
+	num = CFNumberCreate(NULL, kCFNumberIntType, &value);
+	CFDictionarySetValue(message, key, num);
+	CFRelease(num);
+	return;
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision
+ */
+
+#include <getopt.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include "scdlocal.h"
+
+
+static const struct option longopts[] = {
+	{ "bench",		no_argument,		0,	'b' },
+	{ "patterns",		required_argument,	0,	'm' },
+	{ "sessions",		required_argument,	0,	'n' },
+	{ "ops",		required_argument,	0,	'o' },
+	{ "restore",		required_argument,	0,	'r' },
+	{ "socket",		required_argument,	0,	's' },
+	{ "watch",		no_argument,		0,	'w' },
+	{ "help",		no_argument,		0,	'?' },
+	{ 0,			0,                      0,	0 }
+};
+
+
+static void
+usage(const char *command)
+{
+	SCPrint(TRUE, stderr, CFSTR("usage: %s [-s socket] [-r snapshot]\n"), command);
+	SCPrint(TRUE, stderr, CFSTR("   or: %s -b [-s socket] [-n sessions] [-m patterns] [-o ops]\n"), command);
+	SCPrint(TRUE, stderr, CFSTR("   or: %s -w [-s socket] pattern ...\n"), command);
+	SCPrint(TRUE, stderr, CFSTR("\n"));
+	SCPrint(TRUE, stderr, CFSTR("\t-b\trun the load generator against a running server\n"));
+	SCPrint(TRUE, stderr, CFSTR("\t-n\tnumber of sessions watching for changes (default 100)\n"));
+	SCPrint(TRUE, stderr, CFSTR("\t-m\tnumber of patterns watched by each session (default 10)\n"));
+	SCPrint(TRUE, stderr, CFSTR("\t-o\tnumber of operations for each request type (default 10000)\n"));
+	SCPrint(TRUE, stderr, CFSTR("\t-r\tpopulate the store from a snapshot before accepting connections\n"));
+	SCPrint(TRUE, stderr, CFSTR("\t-s\tserver socket (default $TMPDIR/%s/%s)\n"),
+		SCDLOCAL_DIRECTORY_NAME,
+		SCDLOCAL_SOCKET_NAME);
+	SCPrint(TRUE, stderr, CFSTR("\t-w\twatch the keys matching the patterns and report the new\n"));
+	SCPrint(TRUE, stderr, CFSTR("\t\tvalues delivered with each change notification\n"));
+	exit (EX_USAGE);
+}
+
+
+static int
+getCount(const char *command, const char *arg)
+{
+	char	*end;
+	long	val;
+
+	val = strtol(arg, &end, 10);
+	if ((*end != '\0') || (val <= 0) || (val > 1000000)) {
+		usage(command);
+	}
+
+	return (int)val;
+}
+
+
+static CFComparisonResult
+sortKeys(const void *p1, const void *p2, void *context)
+{
+#pragma unused(context)
+	return CFStringCompare((CFStringRef)p1, (CFStringRef)p2, 0);
+}
+
+
+/*
+ * watch()
+ *
+ * Report the changes to the keys matching the patterns.  The new values
+ * come with the notifications (no additional requests are made); a key
+ * whose value was too large to be included is reported as such.
+ */
+static int
+watch(const char *path, int argc, char **argv)
+{
+	SCDLocalClientRef	client;
+	int			i;
+	CFMutableArrayRef	patterns;
+
+	client = SCDLocalClientCreate(path, CFSTR("scdlocal-watch"), FALSE);
+	if (client == NULL) {
+		SCPrint(TRUE, stderr, CFSTR("could not connect: %s\n"), SCErrorString(SCError()));
+		return EX_UNAVAILABLE;
+	}
+
+	patterns = CFArrayCreateMutable(NULL, argc, &kCFTypeArrayCallBacks);
+	for (i = 0; i < argc; i++) {
+		CFStringRef	pattern;
+
+		pattern = CFStringCreateWithCString(NULL, argv[i], kCFStringEncodingUTF8);
+		if (pattern == NULL) {
+			SCPrint(TRUE, stderr, CFSTR("invalid pattern: %s\n"), argv[i]);
+			CFRelease(patterns);
+			SCDLocalClientRelease(client);
+			return EX_USAGE;
+		}
+		CFArrayAppendValue(patterns, pattern);
+		CFRelease(pattern);
+	}
+
+	if (!SCDLocalClientSetNotificationPayloads(client, TRUE, SCDLOCAL_PAYLOAD_MAX_DEFAULT) ||
+	    !SCDLocalClientSetNotificationKeys(client, NULL, patterns)) {
+		SCPrint(TRUE, stderr, CFSTR("could not watch: %s\n"), SCErrorString(SCError()));
+		CFRelease(patterns);
+		SCDLocalClientRelease(client);
+		return EX_UNAVAILABLE;
+	}
+	CFRelease(patterns);
+
+	while (TRUE) {
+		CFArrayRef		changes;
+		CFMutableArrayRef	sorted;
+		CFIndex			n;
+		CFDictionaryRef		values	= NULL;
+
+		changes = SCDLocalClientCopyNotifiedChanges(client, -1, &values);
+		if (changes == NULL) {
+			SCPrint(TRUE, stderr, CFSTR("notification failed: %s\n"), SCErrorString(SCError()));
+			break;
+		}
+
+		if (SCDLocalClientCheckResync(client)) {
+			SCPrint(TRUE, stdout, CFSTR("changes were dropped, re-read the watched keys\n"));
+		}
+
+		n = CFArrayGetCount(changes);
+		sorted = CFArrayCreateMutableCopy(NULL, 0, changes);
+		CFArraySortValues(sorted, CFRangeMake(0, n), sortKeys, NULL);
+		for (i = 0; i < n; i++) {
+			CFStringRef		key	= CFArrayGetValueAtIndex(sorted, i);
+			CFPropertyListRef	value;
+
+			SCPrint(TRUE, stdout, CFSTR("changedKey [%d] = %@\n"), i, key);
+
+			value = (values != NULL) ? CFDictionaryGetValue(values, key) : NULL;
+			if (value == NULL) {
+				SCPrint(TRUE, stdout, CFSTR("  <value exceeds %d bytes, not delivered>\n"),
+					SCDLOCAL_PAYLOAD_MAX_DEFAULT);
+			} else if (value == kCFNull) {
+				SCPrint(TRUE, stdout, CFSTR("  <removed>\n"));
+			} else {
+				SCPrint(TRUE, stdout, CFSTR("  %@\n"), value);
+			}
+		}
+		CFRelease(sorted);
+		CFRelease(changes);
+		if (values != NULL) CFRelease(values);
+	}
+
+	SCDLocalClientRelease(client);
+	return EX_UNAVAILABLE;
+}
+
+
+int
+main(int argc, char **argv)
+{
+	Boolean		bench		= FALSE;
+	const char	*command	= argv[0];
+	int		nOps		= 10000;
+	int		nPatterns	= 10;
+	int		nSessions	= 100;
+	int		opt;
+	const char	*path		= NULL;
+	char		pathBuf[PATH_MAX];
+	const char	*snapshotPath	= NULL;
+	Boolean		watching	= FALSE;
+
+	while ((opt = getopt_long(argc, argv, "bm:n:o:r:s:w", longopts, NULL)) != -1) {
+		switch (opt) {
+			case 'b' :
+				bench = TRUE;
+				break;
+			case 'm' :
+				nPatterns = getCount(command, optarg);
+				break;
+			case 'n' :
+				nSessions = getCount(command, optarg);
+				break;
+			case 'o' :
+				nOps = getCount(command, optarg);
+				break;
+			case 'r' :
+				snapshotPath = optarg;
+				break;
+			case 's' :
+				path = optarg;
+				break;
+			case 'w' :
+				watching = TRUE;
+				break;
+			case '?' :
+			default :
+				usage(command);
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	if (watching ? (argc == 0) : (argc != 0)) {
+		usage(command);
+	}
+
+	(void) signal(SIGPIPE, SIG_IGN);
+
+	if ((bench && watching) || ((bench || watching) && (snapshotPath != NULL))) {
+		usage(command);
+	}
+
+	if (path == NULL) {
+		// the server creates its private directory, a client only checks it
+		if (!SCDLocalGetDirectory(pathBuf, sizeof(pathBuf), !bench && !watching) ||
+		    (strlcat(pathBuf, "/" SCDLOCAL_SOCKET_NAME, sizeof(pathBuf)) >= sizeof(pathBuf))) {
+			SCPrint(TRUE, stderr, CFSTR("no private directory: %s\n"), SCErrorString(SCError()));
+			exit(EX_UNAVAILABLE);
+		}
+		path = pathBuf;
+	}
+
+	if (bench) {
+		exit(SCDLocalBenchRun(path, nSessions, nPatterns, nOps));
+	}
+
+	if (watching) {
+		exit(watch(path, argc, argv));
+	}
+
+	exit(SCDLocalServerRun(path, snapshotPath));
+}
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef _SCDLOCAL_H
+#define _SCDLOCAL_H
+
+#include <sys/cdefs.h>
+#include <CoreFoundation/CoreFoundation.h>
+#include <SystemConfiguration/SystemConfiguration.h>
+#include <SystemConfiguration/SCPrivate.h>
+#include <SystemConfiguration/SCValidation.h>
+
+
+/*
+ * scdlocal is a self-contained stand-in for the "configd" SCDynamicStore
+ * server.  Clients talk to it over a UNIX domain socket.  Each message is
+ * a 32-bit (network byte order) length followed by a binary property list
+ * dictionary.
+ *
+ * Requests carry an operation code and a request ID.  Every request gets
+ * exactly one reply with the same ID and an SCError() status.  Change
+ * notifications are sent by the server without a request ID and may be
+ * interleaved with replies.
+ */
+
+
+/*
+ * The server socket and the snapshots written or read at a client's
+ * request live in a directory private to the user running the server
+ * (see SCDLocalGetDirectory()).
+ */
+#define	SCDLOCAL_DIRECTORY_NAME		"scdlocal"
+#define	SCDLOCAL_SOCKET_NAME		"socket"
+#define	SCDLOCAL_MESSAGE_MAX		(16 * 1024 * 1024)	// neither sent nor accepted if larger
+
+
+typedef enum {
+	kSCDLocalOpOpen			= 1,	// name, useSessionKeys
+	kSCDLocalOpCopyValue		= 2,	// key
+	kSCDLocalOpSetValue		= 3,	// key, value
+	kSCDLocalOpAddValue		= 4,	// key, value
+	kSCDLocalOpAddTemporaryValue	= 5,	// key, value
+	kSCDLocalOpRemoveValue		= 6,	// key
+	kSCDLocalOpNotifyValue		= 7,	// key
+	kSCDLocalOpCopyKeyList		= 8,	// pattern
+	kSCDLocalOpCopyMultiple		= 9,	// keys, patterns
+	kSCDLocalOpSetNotificationKeys	= 10,	// keys, patterns
+	kSCDLocalOpSetNotificationOptions	= 11,	// [payloads, payloadMax] [changedMax]
+	kSCDLocalOpCopyStatistics	= 12,
+	kSCDLocalOpCopyGenerations	= 13,	// keys
+	kSCDLocalOpCommit		= 14,	// expect, set, remove, notify
+	kSCDLocalOpSnapshot		= 15,	// path (name) [, generation]
+	kSCDLocalOpRestore		= 16,	// path (name)
+
+	kSCDLocalOpChanged		= 100,	// (server --> client) keys [, values, removed] or resync
+} SCDLocalOp;
+
+
+/* message dictionary keys */
+#define	kSCDLocalMessageOp		CFSTR("op")
+#define	kSCDLocalMessageID		CFSTR("id")
+#define	kSCDLocalMessageStatus		CFSTR("status")
+#define	kSCDLocalMessageName		CFSTR("name")
+#define	kSCDLocalMessageUseSessionKeys	CFSTR("useSessionKeys")
+#define	kSCDLocalMessageKey		CFSTR("key")
+#define	kSCDLocalMessageKeys		CFSTR("keys")
+#define	kSCDLocalMessagePattern		CFSTR("pattern")
+#define	kSCDLocalMessagePatterns	CFSTR("patterns")
+#define	kSCDLocalMessageValue		CFSTR("value")
+#define	kSCDLocalMessageValues		CFSTR("values")
+#define	kSCDLocalMessageRemoved		CFSTR("removed")
+#define	kSCDLocalMessagePayloads	CFSTR("payloads")
+#define	kSCDLocalMessagePayloadMax	CFSTR("payloadMax")
+#define	kSCDLocalMessageChangedMax	CFSTR("changedMax")
+#define	kSCDLocalMessageResync		CFSTR("resync")
+#define	kSCDLocalMessageGenerations	CFSTR("generations")
+#define	kSCDLocalMessageExpect		CFSTR("expect")
+#define	kSCDLocalMessageSet		CFSTR("set")
+#define	kSCDLocalMessageRemove		CFSTR("remove")
+#define	kSCDLocalMessageNotify		CFSTR("notify")
+#define	kSCDLocalMessagePath		CFSTR("path")
+#define	kSCDLocalMessageGeneration	CFSTR("generation")
+
+
+/*
+ * Change notifications normally carry only the changed keys.  A session
+ * can ask (kSCDLocalOpSetNotificationOptions) for the new values to be
+ * included: "values" holds the current value of each changed key that
+ * still exists and "removed" lists the keys that no longer do.  If the
+ * (estimated) size of the message is larger than "payloadMax" bytes the
+ * values are left out and the client must fetch them itself.
+ */
+#define	SCDLOCAL_PAYLOAD_MAX_DEFAULT	(64 * 1024)
+
+
+/*
+ * Changes are coalesced per session: a key appears at most once in the
+ * pending set (and the latest value is read when the notification is
+ * sent).  A new notification is not built until the previous one has
+ * been written so a slow reader only accumulates keys, never messages.
+ * If more than "changedMax" keys are pending the set is discarded and
+ * the session is sent a single notification with "resync" set; the
+ * client must then re-read everything it is watching.
+ */
+#define	SCDLOCAL_CHANGED_MAX_DEFAULT	4096
+
+
+/*
+ * Every set or remove stamps the key with the next value of a store-wide
+ * generation counter; a key that has never existed has generation 0.
+ * kSCDLocalOpCopyGenerations returns the values and generations of a set
+ * of keys ({ "values" : {...}, "generations" : {...} }).
+ * kSCDLocalOpCommit applies a set of changes only if each key listed in
+ * "expect" still has the expected generation.  Otherwise nothing is
+ * changed, the status is kSCStatusStale and the reply value holds the
+ * current generations of the conflicting keys.  On success the reply
+ * value holds the new generations of the keys that were set or removed.
+ */
+
+
+/*
+ * kSCDLocalOpSnapshot has the server stream the store to a binary snapshot
+ * file (see __SCDSnapshotWriterCreate()).  With a non-zero "generation"
+ * only the keys set or removed after that generation are written.  The
+ * reply value is the current generation, to be passed to the next delta.
+ * kSCDLocalOpRestore replays a full or delta snapshot into the store.
+ * The "path" of either request is a plain file name (no "/") in the
+ * server's private directory.
+ *
+ * Removed keys keep their generation so that a delta can carry the
+ * removal.  When there are too many of them they are dropped, and a
+ * delta since a generation older than that is refused with
+ * kSCStatusStale; the client must take a full snapshot instead.
+ */
+
+
+/* kSCDLocalOpCopyStatistics reply value keys */
+#define	kSCDLocalStatisticsMerged	CFSTR("merged")		// changes to an already pending key
+#define	kSCDLocalStatisticsDropped	CFSTR("dropped")	// changes discarded on overflow
+#define	kSCDLocalStatisticsResyncs	CFSTR("resyncs")	// "resync required" notifications
+#define	kSCDLocalStatisticsSent		CFSTR("sent")		// notifications sent
+#define	kSCDLocalStatisticsPending	CFSTR("pending")	// keys waiting to be sent
+
+
+typedef struct __SCDLocalClient	*SCDLocalClientRef;
+
+
+__BEGIN_DECLS
+
+#pragma mark -
+#pragma mark Messages (message.c)
+
+CFDataRef
+SCDLocalMessageCreateData		(CFDictionaryRef	message);
+
+Boolean
+SCDLocalMessageSendData			(int			fd,
+					 CFDataRef		data);
+
+Boolean
+SCDLocalMessageAppendData		(CFMutableDataRef	buffer,
+					 CFDataRef		data);
+
+Boolean
+SCDLocalMessageSend			(int			fd,
+					 CFDictionaryRef	message);
+
+CFDictionaryRef
+SCDLocalMessageReceive			(int			fd);
+
+CFDictionaryRef
+SCDLocalMessageCreateFromBuffer		(CFMutableDataRef	buffer);
+
+int
+SCDLocalMessageGetInt			(CFDictionaryRef	message,
+					 CFStringRef		key,
+					 int			defaultValue);
+
+void
+SCDLocalMessageSetInt			(CFMutableDictionaryRef	message,
+					 CFStringRef		key,
+					 int			value);
+
+#pragma mark -
+#pragma mark Server (server.c)
+
+int
+SCDLocalServerRun			(const char		*path,
+					 const char		*snapshotPath);	// restore at startup, may be NULL
+
+#pragma mark -
+#pragma mark Client (client.c)
+
+Boolean
+SCDLocalGetDirectory			(char			*dir,
+					 size_t			dirLen,
+					 Boolean		create);
+
+SCDLocalClientRef
+SCDLocalClientCreate			(const char		*path,
+					 CFStringRef		name,
+					 Boolean		useSessionKeys);
+
+void
+SCDLocalClientRelease			(SCDLocalClientRef	client);
+
+CFPropertyListRef
+SCDLocalClientCopyValue			(SCDLocalClientRef	client,
+					 CFStringRef		key);
+
+Boolean
+SCDLocalClientSetValue			(SCDLocalClientRef	client,
+					 CFStringRef		key,
+					 CFPropertyListRef	value);
+
+Boolean
+SCDLocalClientAddValue			(SCDLocalClientRef	client,
+					 CFStringRef		key,
+					 CFPropertyListRef	value,
+					 Boolean		temporary);
+
+Boolean
+SCDLocalClientRemoveValue		(SCDLocalClientRef	client,
+					 CFStringRef		key);
+
+Boolean
+SCDLocalClientNotifyValue		(SCDLocalClientRef	client,
+					 CFStringRef		key);
+
+CFArrayRef
+SCDLocalClientCopyKeyList		(SCDLocalClientRef	client,
+					 CFStringRef		pattern);
+
+CFDictionaryRef
+SCDLocalClientCopyMultiple		(SCDLocalClientRef	client,
+					 CFArrayRef		keys,
+					 CFArrayRef		patterns);
+
+CFDictionaryRef
+SCDLocalClientCopyValuesWithGenerations	(SCDLocalClientRef	client,
+					 CFArrayRef		keys,
+					 CFDictionaryRef	*generations);
+
+Boolean
+SCDLocalClientCommit			(SCDLocalClientRef	client,
+					 CFDictionaryRef	expected,	// <key> --> generation
+					 CFDictionaryRef	keysToSet,
+					 CFArrayRef		keysToRemove,
+					 CFArrayRef		keysToNotify,
+					 CFDictionaryRef	*generations);	// new (or conflicting) generations
+
+Boolean
+SCDLocalClientWriteSnapshot		(SCDLocalClientRef	client,
+					 const char		*name,
+					 int64_t		sinceGeneration,	// 0 == full
+					 int64_t		*generation);
+
+Boolean
+SCDLocalClientRestoreSnapshot		(SCDLocalClientRef	client,
+					 const char		*name);
+
+Boolean
+SCDLocalClientSetNotificationKeys	(SCDLocalClientRef	client,
+					 CFArrayRef		keys,
+					 CFArrayRef		patterns);
+
+Boolean
+SCDLocalClientSetNotificationPayloads	(SCDLocalClientRef	client,
+					 Boolean		enable,
+					 CFIndex		payloadMax);	// 0 == default
+
+Boolean
+SCDLocalClientSetNotificationLimit	(SCDLocalClientRef	client,
+					 CFIndex		changedMax);	// 0 == default
+
+Boolean
+SCDLocalClientCheckResync		(SCDLocalClientRef	client);
+
+CFDictionaryRef
+SCDLocalClientCopyStatistics		(SCDLocalClientRef	client);
+
+CFArrayRef
+SCDLocalClientCopyNotifiedKeys		(SCDLocalClientRef	client,
+					 int			timeout_ms);	// -1 == wait forever
+
+CFArrayRef
+SCDLocalClientCopyNotifiedChanges	(SCDLocalClientRef	client,
+					 int			timeout_ms,
+					 CFDictionaryRef	*values);	// <key> --> <value> or kCFNull
+
+#pragma mark -
+#pragma mark Load generator (bench.c)
+
+int
+SCDLocalBenchRun			(const char		*path,
+					 int			nSessions,
+					 int			nPatterns,
+					 int			nOps);
+
+__END_DECLS
+
+#endif	/* !_SCDLOCAL_H */
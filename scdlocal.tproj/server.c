@@ -0,0 +1,1507 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "scdlocal.h"
+#include "SCDynamicStoreInternal.h"
+
+
+/*
+ * The server runs all of its work on a single serial queue so the store,
+ * the key index and the sessions need no additional locking.  Sockets are
+ * non-blocking and output is buffered per session so that a client that
+ * stops reading cannot stall the server (or the other sessions).  Once a
+ * session has more than SESSION_OUTBUF_MAX bytes of output pending, its
+ * requests are no longer read until the client catches up.
+ */
+
+
+#define	SESSION_OUTBUF_MAX	(1024 * 1024)
+
+
+/*
+ * Removed keys keep their generation (so a delta snapshot can carry the
+ * removal) until there are more than STORE_REMOVED_MAX of them, or more
+ * of them than there are keys in the store.
+ */
+#define	STORE_REMOVED_MAX	4096
+
+
+typedef struct SCDLocalSession {
+	struct SCDLocalSession	*next;
+
+	int			fd;
+	dispatch_source_t	source;
+	Boolean			sourceSuspended;
+	CFMutableDataRef	inbuf;
+
+	/* pending output, written as the socket drains */
+	dispatch_source_t	writeSource;
+	Boolean			writeSourceActive;
+	CFMutableDataRef	outbuf;
+	CFIndex			outbufOffset;
+
+	CFStringRef		name;
+	Boolean			useSessionKeys;
+
+	/* temporary / session keys, removed when the session is closed */
+	CFMutableSetRef		ownedKeys;
+
+	/* keys changed since the last notification (coalesced) */
+	CFMutableSetRef		changedKeys;
+	CFIndex			changedMax;
+	Boolean			resync;
+
+	/* coalescing statistics */
+	uint64_t		nMerged;
+	uint64_t		nDropped;
+	uint64_t		nResyncs;
+	uint64_t		nSent;
+
+	/* include the new values with change notifications */
+	Boolean			payloads;
+	CFIndex			payloadMax;
+} SCDLocalSession, *SCDLocalSessionRef;
+
+
+static dispatch_queue_t		serverQueue	= NULL;
+static SCDLocalSessionRef	sessions	= NULL;
+
+static CFMutableDictionaryRef	storeData	= NULL;	// <key> --> <value>
+static SCDKeyIndexRef		storeIndex	= NULL;
+static CFMutableDictionaryRef	storeOwners	= NULL;	// <key> --> SCDLocalSessionRef
+
+/* per-key generations, see kSCDLocalOpCommit */
+static int64_t			storeGeneration	= 0;
+static CFMutableDictionaryRef	storeGenerations	= NULL;	// <key> --> <generation of last set/remove>
+static int64_t			storeGenerationFloor	= 0;	// removals before this were dropped
+
+/* snapshots requested by clients are confined to this directory */
+static char			storeSnapshotDirectory[PATH_MAX];
+
+/* watched keys and patterns --> sessions */
+static SCDNotifyRouterRef	storeRouter	= NULL;
+
+
+#pragma mark -
+#pragma mark Notifications
+
+
+static void
+sessionKeyChanged(const void *watcher, void *context)
+{
+	CFIndex			n;
+	CFStringRef		key	= (CFStringRef)context;
+	SCDLocalSessionRef	session	= (SCDLocalSessionRef)watcher;
+
+	if (session->resync) {
+		// the session will be asked to re-read everything
+		session->nDropped++;
+		return;
+	}
+
+	if (CFSetContainsValue(session->changedKeys, key)) {
+		session->nMerged++;
+		return;
+	}
+
+	n = CFSetGetCount(session->changedKeys);
+	if (n >= session->changedMax) {
+		// too far behind, replace the pending changes with a "resync"
+		CFSetRemoveAllValues(session->changedKeys);
+		session->resync = TRUE;
+		session->nDropped += n + 1;
+		session->nResyncs++;
+		return;
+	}
+
+	CFSetAddValue(session->changedKeys, key);
+	return;
+}
+
+
+static void
+storeKeyChanged(CFStringRef key)
+{
+	__SCDNotifyRouterApply(storeRouter, key, sessionKeyChanged, (void *)key);
+	return;
+}
+
+
+static void	sessionClose	(SCDLocalSessionRef session);
+
+
+static Boolean
+sessionWrite(SCDLocalSessionRef session)
+{
+	CFIndex		len;
+
+	len = CFDataGetLength(session->outbuf) - session->outbufOffset;
+	while (len > 0) {
+		ssize_t		n;
+
+		n = write(session->fd, CFDataGetBytePtr(session->outbuf) + session->outbufOffset, len);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN) {
+				break;
+			}
+			return FALSE;
+		}
+		session->outbufOffset += n;
+		len -= n;
+	}
+
+	if (len == 0) {
+		// all written
+		CFDataSetLength(session->outbuf, 0);
+		session->outbufOffset = 0;
+		if (session->writeSourceActive) {
+			dispatch_suspend(session->writeSource);
+			session->writeSourceActive = FALSE;
+		}
+	} else if (!session->writeSourceActive) {
+		// wait for the socket to drain
+		dispatch_resume(session->writeSource);
+		session->writeSourceActive = TRUE;
+	}
+
+	if (len > SESSION_OUTBUF_MAX) {
+		if (!session->sourceSuspended) {
+			// stop reading requests until the client reads the replies
+			dispatch_suspend(session->source);
+			session->sourceSuspended = TRUE;
+		}
+	} else if (session->sourceSuspended) {
+		dispatch_resume(session->source);
+		session->sourceSuspended = FALSE;
+	}
+
+	return TRUE;
+}
+
+
+/*
+ * sessionSendReply()
+ *
+ * Queues (and starts writing) the reply to a request.  A reply larger
+ * than SCDLOCAL_MESSAGE_MAX would be refused by the client so it is
+ * replaced by one with just the request ID and an error status.
+ */
+static Boolean
+sessionSendReply(SCDLocalSessionRef session, CFDictionaryRef reply)
+{
+	CFDataRef	data;
+
+	data = SCDLocalMessageCreateData(reply);
+	if ((data != NULL) && (CFDataGetLength(data) > SCDLOCAL_MESSAGE_MAX)) {
+		CFMutableDictionaryRef	error;
+
+		SC_log(LOG_NOTICE, "reply too large (%ld bytes), returning an error",
+		       (long)CFDataGetLength(data));
+		CFRelease(data);
+
+		error = CFDictionaryCreateMutable(NULL,
+						  0,
+						  &kCFTypeDictionaryKeyCallBacks,
+						  &kCFTypeDictionaryValueCallBacks);
+		SCDLocalMessageSetInt(error, kSCDLocalMessageID, SCDLocalMessageGetInt(reply, kSCDLocalMessageID, 0));
+		SCDLocalMessageSetInt(error, kSCDLocalMessageStatus, kSCStatusFailed);
+		data = SCDLocalMessageCreateData(error);
+		CFRelease(error);
+	}
+	if (data == NULL) {
+		return FALSE;
+	}
+	(void) SCDLocalMessageAppendData(session->outbuf, data);
+	CFRelease(data);
+
+	return sessionWrite(session);
+}
+
+
+static Boolean
+sessionIsBusy(SCDLocalSessionRef session)
+{
+	return (CFDataGetLength(session->outbuf) > 0);
+}
+
+
+static CFDataRef
+sessionCreateNotification(SCDLocalSessionRef session, CFArrayRef changes)
+{
+	CFDataRef		data;
+	CFMutableDictionaryRef	message;
+
+	message = CFDictionaryCreateMutable(NULL,
+					    0,
+					    &kCFTypeDictionaryKeyCallBacks,
+					    &kCFTypeDictionaryValueCallBacks);
+	SCDLocalMessageSetInt(message, kSCDLocalMessageOp, kSCDLocalOpChanged);
+	CFDictionarySetValue(message, kSCDLocalMessageKeys, changes);
+
+	if (session->payloads) {
+		CFIndex			i;
+		CFIndex			n;
+		CFMutableArrayRef	removed;
+		CFIndex			size;
+		CFMutableDictionaryRef	values;
+
+		values = CFDictionaryCreateMutable(NULL,
+						   0,
+						   &kCFTypeDictionaryKeyCallBacks,
+						   &kCFTypeDictionaryValueCallBacks);
+		removed = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+		n = CFArrayGetCount(changes);
+		size = _SCDynamicStoreEstimateSize(changes);
+		for (i = 0; i < n; i++) {
+			CFStringRef		key	= CFArrayGetValueAtIndex(changes, i);
+			CFPropertyListRef	value;
+
+			value = CFDictionaryGetValue(storeData, key);
+			if (value != NULL) {
+				CFDictionarySetValue(values, key, value);
+				size += _SCDynamicStoreEstimateSize(key) + _SCDynamicStoreEstimateSize(value) + 4;
+			} else {
+				CFArrayAppendValue(removed, key);
+				size += _SCDynamicStoreEstimateSize(key) + 2;
+			}
+			if (size > session->payloadMax) {
+				// too large, send only the keys
+				break;
+			}
+		}
+		if (size <= session->payloadMax) {
+			CFDictionarySetValue(message, kSCDLocalMessageValues, values);
+			CFDictionarySetValue(message, kSCDLocalMessageRemoved, removed);
+		}
+		CFRelease(values);
+		CFRelease(removed);
+	}
+
+	data = SCDLocalMessageCreateData(message);
+	CFRelease(message);
+	return data;
+}
+
+
+static CFDataRef
+sessionCreateResync(SCDLocalSessionRef session)
+{
+	CFDataRef		data;
+	CFMutableDictionaryRef	resync;
+
+	resync = CFDictionaryCreateMutable(NULL,
+					   0,
+					   &kCFTypeDictionaryKeyCallBacks,
+					   &kCFTypeDictionaryValueCallBacks);
+	SCDLocalMessageSetInt(resync, kSCDLocalMessageOp, kSCDLocalOpChanged);
+	SCDLocalMessageSetInt(resync, kSCDLocalMessageResync, 1);
+	data = SCDLocalMessageCreateData(resync);
+	CFRelease(resync);
+	session->resync = FALSE;
+	return data;
+}
+
+
+static void
+storeFlushNotifications(void)
+{
+	SCDLocalSessionRef	next;
+	SCDLocalSessionRef	session;
+
+    restart :
+
+	for (session = sessions; session != NULL; session = next) {
+		CFIndex			n;
+		CFDataRef		message;
+		Boolean			ok;
+
+		next = session->next;
+
+		if (sessionIsBusy(session)) {
+			// keep coalescing until the last notification has been read
+			continue;
+		}
+
+		if (session->resync) {
+			message = sessionCreateResync(session);
+		} else {
+			const void *	keys_q[64];
+			const void **	keys		= keys_q;
+			CFArrayRef	changes;
+
+			n = CFSetGetCount(session->changedKeys);
+			if (n == 0) {
+				continue;
+			}
+
+			if (n > (CFIndex)(sizeof(keys_q) / sizeof(CFTypeRef))) {
+				keys = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+			}
+			CFSetGetValues(session->changedKeys, keys);
+			changes = CFArrayCreate(NULL, keys, n, &kCFTypeArrayCallBacks);
+			if (keys != keys_q) {
+				CFAllocatorDeallocate(NULL, keys);
+			}
+			CFSetRemoveAllValues(session->changedKeys);
+
+			message = sessionCreateNotification(session, changes);
+			CFRelease(changes);
+
+			if ((message != NULL) && (CFDataGetLength(message) > SCDLOCAL_MESSAGE_MAX)) {
+				// too large to be received, have the client re-read everything
+				CFRelease(message);
+				session->nResyncs++;
+				message = sessionCreateResync(session);
+			}
+		}
+
+		ok = (message != NULL);
+		if (ok) {
+			(void) SCDLocalMessageAppendData(session->outbuf, message);
+			CFRelease(message);
+			session->nSent++;
+			ok = sessionWrite(session);
+		}
+		if (!ok) {
+			// closing the session may have removed keys (and queued more changes)
+			sessionClose(session);
+			goto restart;
+		}
+	}
+
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Store
+
+
+static void
+storeSetOwner(SCDLocalSessionRef session, CFStringRef key, Boolean owned)
+{
+	SCDLocalSessionRef	owner;
+
+	owner = (SCDLocalSessionRef)CFDictionaryGetValue(storeOwners, key);
+	if ((owner != NULL) && (owner != session)) {
+		CFSetRemoveValue(owner->ownedKeys, key);
+	}
+
+	if (owned && (session != NULL)) {
+		CFDictionarySetValue(storeOwners, key, session);
+		CFSetAddValue(session->ownedKeys, key);
+	} else {
+		CFDictionaryRemoveValue(storeOwners, key);
+		if (session != NULL) {
+			CFSetRemoveValue(session->ownedKeys, key);
+		}
+	}
+
+	return;
+}
+
+
+static int64_t
+storeGetGeneration(CFStringRef key)
+{
+	CFNumberRef	num;
+	int64_t		generation	= 0;
+
+	num = CFDictionaryGetValue(storeGenerations, key);
+	if (num != NULL) {
+		(void) CFNumberGetValue(num, kCFNumberSInt64Type, &generation);
+	}
+
+	return generation;
+}
+
+
+static void
+storeNextGeneration(CFStringRef key)
+{
+	CFNumberRef	num;
+
+	storeGeneration++;
+	num = CFNumberCreate(NULL, kCFNumberSInt64Type, &storeGeneration);
+	CFDictionarySetValue(storeGenerations, key, num);
+	CFRelease(num);
+	return;
+}
+
+
+static void
+collectRemovedKey(const void *key, const void *value, void *context)
+{
+#pragma unused(value)
+	CFMutableArrayRef	removed	= (CFMutableArrayRef)context;
+
+	if (!CFDictionaryContainsKey(storeData, key)) {
+		CFArrayAppendValue(removed, key);
+	}
+	return;
+}
+
+
+/*
+ * storePruneGenerations
+ *
+ * Drops the generations of removed keys once there are too many of them.
+ * A commit that expects the dropped generation of a removed key is then
+ * refused as stale (the key is back at generation 0), as is a delta
+ * snapshot since a generation before the floor.
+ */
+static void
+storePruneGenerations(void)
+{
+	CFIndex			i;
+	CFIndex			n;
+	CFIndex			nKeys;
+	CFMutableArrayRef	removed;
+
+	nKeys = CFDictionaryGetCount(storeData);
+	n = CFDictionaryGetCount(storeGenerations) - nKeys;
+	if ((n <= STORE_REMOVED_MAX) || (n <= nKeys)) {
+		return;
+	}
+
+	removed = CFArrayCreateMutable(NULL, n, &kCFTypeArrayCallBacks);
+	CFDictionaryApplyFunction(storeGenerations, collectRemovedKey, removed);
+	n = CFArrayGetCount(removed);
+	for (i = 0; i < n; i++) {
+		CFDictionaryRemoveValue(storeGenerations, CFArrayGetValueAtIndex(removed, i));
+	}
+	CFRelease(removed);
+
+	storeGenerationFloor = storeGeneration;
+	return;
+}
+
+
+static int
+storeSetValue(SCDLocalSessionRef session, CFStringRef key, CFPropertyListRef value, Boolean temporary)
+{
+	if (!CFDictionaryContainsKey(storeData, key)) {
+		(void) __SCDKeyIndexAddKey(storeIndex, key);
+	}
+	CFDictionarySetValue(storeData, key, value);
+	storeNextGeneration(key);
+	storeSetOwner(session, key, temporary || ((session != NULL) && session->useSessionKeys));
+	storeKeyChanged(key);
+
+	return kSCStatusOK;
+}
+
+
+static int
+storeRemoveValue(SCDLocalSessionRef session, CFStringRef key)
+{
+	if (!CFDictionaryContainsKey(storeData, key)) {
+		return kSCStatusNoKey;
+	}
+
+	CFDictionaryRemoveValue(storeData, key);
+	(void) __SCDKeyIndexRemoveKey(storeIndex, key);
+	storeNextGeneration(key);
+	storeSetOwner(session, key, FALSE);
+	storeKeyChanged(key);
+	storePruneGenerations();
+
+	return kSCStatusOK;
+}
+
+
+static void
+addGeneration(CFMutableDictionaryRef generations, CFStringRef key)
+{
+	int64_t		generation;
+	CFNumberRef	num;
+
+	generation = storeGetGeneration(key);
+	num = CFNumberCreate(NULL, kCFNumberSInt64Type, &generation);
+	CFDictionarySetValue(generations, key, num);
+	CFRelease(num);
+	return;
+}
+
+
+static CFDictionaryRef
+storeCopyGenerations(CFArrayRef keys)
+{
+	CFMutableDictionaryRef	generations;
+	CFIndex			i;
+	CFIndex			n;
+	CFMutableDictionaryRef	reply;
+	CFMutableDictionaryRef	values;
+
+	values = CFDictionaryCreateMutable(NULL,
+					   0,
+					   &kCFTypeDictionaryKeyCallBacks,
+					   &kCFTypeDictionaryValueCallBacks);
+	generations = CFDictionaryCreateMutable(NULL,
+						0,
+						&kCFTypeDictionaryKeyCallBacks,
+						&kCFTypeDictionaryValueCallBacks);
+
+	n = CFArrayGetCount(keys);
+	for (i = 0; i < n; i++) {
+		CFStringRef		key	= CFArrayGetValueAtIndex(keys, i);
+		CFPropertyListRef	value;
+
+		if (!isA_CFString(key)) {
+			continue;
+		}
+		value = CFDictionaryGetValue(storeData, key);
+		if (value != NULL) {
+			CFDictionarySetValue(values, key, value);
+		}
+		addGeneration(generations, key);
+	}
+
+	reply = CFDictionaryCreateMutable(NULL,
+					  0,
+					  &kCFTypeDictionaryKeyCallBacks,
+					  &kCFTypeDictionaryValueCallBacks);
+	CFDictionarySetValue(reply, kSCDLocalMessageValues, values);
+	CFDictionarySetValue(reply, kSCDLocalMessageGenerations, generations);
+	CFRelease(values);
+	CFRelease(generations);
+
+	return reply;
+}
+
+
+static Boolean
+validKeys(CFArrayRef keys)
+{
+	CFIndex		i;
+	CFIndex		n;
+
+	n = (keys != NULL) ? CFArrayGetCount(keys) : 0;
+	for (i = 0; i < n; i++) {
+		if (!isA_CFString(CFArrayGetValueAtIndex(keys, i))) {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+
+static void
+validKeyToSet(const void *key, const void *value, void *context)
+{
+#pragma unused(value)
+	Boolean		*valid	= (Boolean *)context;
+
+	if (!isA_CFString(key)) {
+		*valid = FALSE;
+	}
+	return;
+}
+
+
+static Boolean
+validKeysToSet(CFDictionaryRef keysToSet)
+{
+	Boolean		valid	= TRUE;
+
+	if (keysToSet != NULL) {
+		CFDictionaryApplyFunction(keysToSet, validKeyToSet, &valid);
+	}
+
+	return valid;
+}
+
+
+typedef struct {
+	CFMutableDictionaryRef	conflicts;
+	Boolean			valid;
+} commitCheckContext;
+
+
+static void
+commitCheckGeneration(const void *key, const void *value, void *context)
+{
+	commitCheckContext	*check		= (commitCheckContext *)context;
+	int64_t			expected;
+	int64_t			generation;
+
+	if (!isA_CFString(key) ||
+	    !isA_CFNumber(value) ||
+	    !CFNumberGetValue((CFNumberRef)value, kCFNumberSInt64Type, &expected)) {
+		check->valid = FALSE;
+		return;
+	}
+
+	generation = storeGetGeneration((CFStringRef)key);
+	if (generation != expected) {
+		addGeneration(check->conflicts, (CFStringRef)key);
+	}
+
+	return;
+}
+
+
+/*
+ * storeCommit
+ *
+ * Applies a set of changes if (and only if) none of the "expected" keys
+ * have changed.  Since the server is single threaded, all of the changes
+ * are visible at once and the watchers get one (coalesced) notification.
+ */
+static int
+storeCommit(SCDLocalSessionRef session, CFDictionaryRef request, CFDictionaryRef *reply_value)
+{
+	commitCheckContext	check;
+	CFDictionaryRef		expected;
+	CFMutableDictionaryRef	generations;
+	CFIndex			i;
+	CFIndex			n;
+	CFArrayRef		keysToNotify;
+	CFArrayRef		keysToRemove;
+	CFDictionaryRef		keysToSet;
+
+	expected     = CFDictionaryGetValue(request, kSCDLocalMessageExpect);
+	keysToSet    = CFDictionaryGetValue(request, kSCDLocalMessageSet);
+	keysToRemove = CFDictionaryGetValue(request, kSCDLocalMessageRemove);
+	keysToNotify = CFDictionaryGetValue(request, kSCDLocalMessageNotify);
+	if (((expected     != NULL) && !isA_CFDictionary(expected))		||
+	    ((keysToSet    != NULL) && !isA_CFDictionary(keysToSet))		||
+	    ((keysToRemove != NULL) && !isA_CFArray(keysToRemove))		||
+	    ((keysToNotify != NULL) && !isA_CFArray(keysToNotify))		||
+	    !validKeysToSet(keysToSet)						||
+	    !validKeys(keysToRemove)						||
+	    !validKeys(keysToNotify)) {
+		return kSCStatusInvalidArgument;
+	}
+
+	// check the generations of the keys the caller depends on
+	check.conflicts = CFDictionaryCreateMutable(NULL,
+						    0,
+						    &kCFTypeDictionaryKeyCallBacks,
+						    &kCFTypeDictionaryValueCallBacks);
+	check.valid = TRUE;
+	if (expected != NULL) {
+		CFDictionaryApplyFunction(expected, commitCheckGeneration, &check);
+	}
+	if (!check.valid) {
+		CFRelease(check.conflicts);
+		return kSCStatusInvalidArgument;
+	}
+	if (CFDictionaryGetCount(check.conflicts) > 0) {
+		*reply_value = check.conflicts;
+		return kSCStatusStale;
+	}
+	CFRelease(check.conflicts);
+
+	// apply
+	generations = CFDictionaryCreateMutable(NULL,
+						0,
+						&kCFTypeDictionaryKeyCallBacks,
+						&kCFTypeDictionaryValueCallBacks);
+
+	n = (keysToSet != NULL) ? CFDictionaryGetCount(keysToSet) : 0;
+	if (n > 0) {
+		const void	**keys;
+		const void	**values;
+
+		keys   = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+		values = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+		CFDictionaryGetKeysAndValues(keysToSet, keys, values);
+		for (i = 0; i < n; i++) {
+			(void) storeSetValue(session, (CFStringRef)keys[i], values[i], FALSE);
+			addGeneration(generations, (CFStringRef)keys[i]);
+		}
+		CFAllocatorDeallocate(NULL, keys);
+		CFAllocatorDeallocate(NULL, values);
+	}
+
+	n = (keysToRemove != NULL) ? CFArrayGetCount(keysToRemove) : 0;
+	for (i = 0; i < n; i++) {
+		CFStringRef	key	= CFArrayGetValueAtIndex(keysToRemove, i);
+
+		if (storeRemoveValue(session, key) == kSCStatusOK) {
+			addGeneration(generations, key);
+		}
+	}
+
+	n = (keysToNotify != NULL) ? CFArrayGetCount(keysToNotify) : 0;
+	for (i = 0; i < n; i++) {
+		storeKeyChanged(CFArrayGetValueAtIndex(keysToNotify, i));
+	}
+
+	*reply_value = generations;
+	return kSCStatusOK;
+}
+
+
+#pragma mark -
+#pragma mark Snapshots
+
+
+typedef struct {
+	SCDSnapshotWriterRef	writer;
+	int64_t			since;
+	Boolean			ok;
+} snapshotContext;
+
+
+static void
+snapshotAddValue(const void *key, const void *value, void *context)
+{
+	snapshotContext	*snapshot	= (snapshotContext *)context;
+
+	if (snapshot->ok) {
+		snapshot->ok = __SCDSnapshotWriterAddValue(snapshot->writer, key, value);
+	}
+	return;
+}
+
+
+static void
+snapshotAddChange(const void *key, const void *value, void *context)
+{
+	int64_t			generation	= 0;
+	snapshotContext		*snapshot	= (snapshotContext *)context;
+	CFPropertyListRef	storeValue;
+
+	(void) CFNumberGetValue((CFNumberRef)value, kCFNumberSInt64Type, &generation);
+	if (!snapshot->ok || (generation <= snapshot->since)) {
+		return;
+	}
+
+	storeValue = CFDictionaryGetValue(storeData, key);
+	if (storeValue != NULL) {
+		snapshot->ok = __SCDSnapshotWriterAddValue(snapshot->writer, key, storeValue);
+	} else {
+		snapshot->ok = __SCDSnapshotWriterAddRemoval(snapshot->writer, key);
+	}
+	return;
+}
+
+
+/*
+ * storeWriteSnapshot
+ *
+ * Writes a full (since == 0) or delta snapshot.  The file is written
+ * under a temporary name and renamed so that a reader never sees a
+ * partial snapshot.  A delta since a generation whose removals have
+ * been dropped is refused as stale.
+ */
+static int
+storeWriteSnapshot(const char *path, int64_t since)
+{
+	int			fd;
+	SCDSnapshotHeader	header;
+	snapshotContext		snapshot;
+	char			tmp[PATH_MAX];
+
+	if ((since > 0) && (since < storeGenerationFloor)) {
+		return kSCStatusStale;
+	}
+
+	if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+		return kSCStatusInvalidArgument;
+	}
+	fd = open(tmp, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	if (fd == -1) {
+		SC_log(LOG_NOTICE, "open(%s) failed: %s", tmp, strerror(errno));
+		return kSCStatusFailed;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.flags = (since > 0) ? kSCDSnapshotFlagDelta : 0;
+	header.baseGeneration = since;
+	header.generation = storeGeneration;
+
+	snapshot.writer = __SCDSnapshotWriterCreate(fd, &header);
+	if (snapshot.writer == NULL) {
+		(void) close(fd);
+		(void) unlink(tmp);
+		return kSCStatusFailed;
+	}
+	snapshot.since = since;
+	snapshot.ok = TRUE;
+	if (since > 0) {
+		// the keys set or removed after "since"
+		CFDictionaryApplyFunction(storeGenerations, snapshotAddChange, &snapshot);
+	} else {
+		CFDictionaryApplyFunction(storeData, snapshotAddValue, &snapshot);
+	}
+	if (!__SCDSnapshotWriterClose(snapshot.writer)) {
+		snapshot.ok = FALSE;
+	}
+	(void) close(fd);
+
+	if (!snapshot.ok || (rename(tmp, path) == -1)) {
+		(void) unlink(tmp);
+		return kSCStatusFailed;
+	}
+
+	return kSCStatusOK;
+}
+
+
+static void
+snapshotRestoreValue(CFStringRef key, CFPropertyListRef value, void *context)
+{
+#pragma unused(context)
+	if (value != NULL) {
+		(void) storeSetValue(NULL, key, value, FALSE);
+	} else {
+		(void) storeRemoveValue(NULL, key);
+	}
+	return;
+}
+
+
+static int
+storeRestoreSnapshot(const char *path)
+{
+	int			fd;
+	SCDSnapshotHeader	header;
+	Boolean			ok;
+
+	fd = open(path, O_RDONLY, 0);
+	if (fd == -1) {
+		SC_log(LOG_NOTICE, "open(%s) failed: %s", path, strerror(errno));
+		return kSCStatusNoConfigFile;
+	}
+	ok = __SCDSnapshotRead(fd, &header, snapshotRestoreValue, NULL);
+	(void) close(fd);
+	if (!ok) {
+		return kSCStatusFailed;
+	}
+
+	// keep generations monotonic with respect to the snapshot source
+	if (storeGeneration < header.generation) {
+		storeGeneration = header.generation;
+	}
+
+	return kSCStatusOK;
+}
+
+
+/*
+ * snapshotGetPath
+ *
+ * Maps the file name in a client's snapshot request to a path in the
+ * server's private directory.  Anything but a plain name is refused.
+ */
+static Boolean
+snapshotGetPath(CFStringRef name, char *path, size_t pathLen)
+{
+	char	buf[NAME_MAX + 1];
+	int	n;
+
+	if (!CFStringGetFileSystemRepresentation(name, buf, sizeof(buf)) ||
+	    (buf[0] == '\0') ||
+	    (strchr(buf, '/') != NULL) ||
+	    (strcmp(buf, ".") == 0) ||
+	    (strcmp(buf, "..") == 0)) {
+		return FALSE;
+	}
+
+	n = snprintf(path, pathLen, "%s/%s", storeSnapshotDirectory, buf);
+	return ((n > 0) && ((size_t)n < pathLen));
+}
+
+
+static CFDictionaryRef
+storeCopyMultiple(CFArrayRef keys, CFArrayRef patterns, int *sc_status)
+{
+	CFIndex			i;
+	CFIndex			n;
+	CFMutableDictionaryRef	values;
+
+	values = CFDictionaryCreateMutable(NULL,
+					   0,
+					   &kCFTypeDictionaryKeyCallBacks,
+					   &kCFTypeDictionaryValueCallBacks);
+
+	n = (keys != NULL) ? CFArrayGetCount(keys) : 0;
+	for (i = 0; i < n; i++) {
+		CFStringRef		key;
+		CFPropertyListRef	value;
+
+		key = CFArrayGetValueAtIndex(keys, i);
+		value = isA_CFString(key) ? CFDictionaryGetValue(storeData, key) : NULL;
+		if (value != NULL) {
+			CFDictionarySetValue(values, key, value);
+		}
+	}
+
+	n = (patterns != NULL) ? CFArrayGetCount(patterns) : 0;
+	for (i = 0; i < n; i++) {
+		CFIndex		j;
+		CFArrayRef	matches;
+		CFIndex		nMatches;
+
+		matches = __SCDKeyIndexCopyMatchingKeys(storeIndex, CFArrayGetValueAtIndex(patterns, i));
+		if (matches == NULL) {
+			CFRelease(values);
+			*sc_status = kSCStatusFailed;
+			return NULL;
+		}
+
+		nMatches = CFArrayGetCount(matches);
+		for (j = 0; j < nMatches; j++) {
+			CFStringRef	key	= CFArrayGetValueAtIndex(matches, j);
+
+			CFDictionarySetValue(values, key, CFDictionaryGetValue(storeData, key));
+		}
+		CFRelease(matches);
+	}
+
+	*sc_status = kSCStatusOK;
+	return values;
+}
+
+
+#pragma mark -
+#pragma mark Sessions
+
+
+static int
+sessionSetNotificationKeys(SCDLocalSessionRef session, CFArrayRef keys, CFArrayRef patterns)
+{
+	if (!__SCDNotifyRouterSetWatcher(storeRouter, session, keys, patterns)) {
+		return kSCStatusFailed;
+	}
+
+	return kSCStatusOK;
+}
+
+
+static void
+addStatistic(CFMutableDictionaryRef stats, CFStringRef key, int64_t value)
+{
+	CFNumberRef	num;
+
+	num = CFNumberCreate(NULL, kCFNumberSInt64Type, &value);
+	CFDictionarySetValue(stats, key, num);
+	CFRelease(num);
+	return;
+}
+
+
+static CFDictionaryRef
+sessionHandleRequest(SCDLocalSessionRef session, CFDictionaryRef request)
+{
+	CFStringRef		key;
+	CFArrayRef		keys;
+	CFPropertyListRef	reply_value	= NULL;	// retained
+	CFMutableDictionaryRef	reply;
+	int			sc_status	= kSCStatusOK;
+	CFPropertyListRef	value;
+
+	key   = isA_CFString(CFDictionaryGetValue(request, kSCDLocalMessageKey));
+	value = CFDictionaryGetValue(request, kSCDLocalMessageValue);
+
+	switch (SCDLocalMessageGetInt(request, kSCDLocalMessageOp, 0)) {
+		case kSCDLocalOpOpen : {
+			CFStringRef	name;
+
+			name = isA_CFString(CFDictionaryGetValue(request, kSCDLocalMessageName));
+			if (name != NULL) {
+				if (session->name != NULL) CFRelease(session->name);
+				session->name = CFRetain(name);
+			}
+			session->useSessionKeys = (SCDLocalMessageGetInt(request, kSCDLocalMessageUseSessionKeys, 0) != 0);
+			break;
+		}
+
+		case kSCDLocalOpCopyValue :
+			if (key == NULL) {
+				sc_status = kSCStatusInvalidArgument;
+				break;
+			}
+			reply_value = CFDictionaryGetValue(storeData, key);
+			if (reply_value == NULL) {
+				sc_status = kSCStatusNoKey;
+				break;
+			}
+			CFRetain(reply_value);
+			break;
+
+		case kSCDLocalOpSetValue :
+			if ((key == NULL) || (value == NULL)) {
+				sc_status = kSCStatusInvalidArgument;
+				break;
+			}
+			sc_status = storeSetValue(session, key, value, FALSE);
+			break;
+
+		case kSCDLocalOpAddValue :
+		case kSCDLocalOpAddTemporaryValue :
+			if ((key == NULL) || (value == NULL)) {
+				sc_status = kSCStatusInvalidArgument;
+				break;
+			}
+			if (CFDictionaryContainsKey(storeData, key)) {
+				sc_status = kSCStatusKeyExists;
+				break;
+			}
+			sc_status = storeSetValue(session,
+						  key,
+						  value,
+						  (SCDLocalMessageGetInt(request, kSCDLocalMessageOp, 0) == kSCDLocalOpAddTemporaryValue));
+			break;
+
+		case kSCDLocalOpRemoveValue :
+			if (key == NULL) {
+				sc_status = kSCStatusInvalidArgument;
+				break;
+			}
+			sc_status = storeRemoveValue(session, key);
+			break;
+
+		case kSCDLocalOpNotifyValue :
+			if (key == NULL) {
+				sc_status = kSCStatusInvalidArgument;
+				break;
+			}
+			storeKeyChanged(key);
+			break;
+
+		case kSCDLocalOpCopyKeyList : {
+			CFStringRef	pattern;
+
+			pattern = isA_CFString(CFDictionaryGetValue(request, kSCDLocalMessagePattern));
+			if (pattern == NULL) {
+				sc_status = kSCStatusInvalidArgument;
+				break;
+			}
+			reply_value = __SCDKeyIndexCopyMatchingKeys(storeIndex, pattern);
+			if (reply_value == NULL) {
+				sc_status = kSCStatusFailed;
+			}
+			break;
+		}
+
+		case kSCDLocalOpCopyMultiple :
+			keys = isA_CFArray(CFDictionaryGetValue(request, kSCDLocalMessageKeys));
+			reply_value = storeCopyMultiple(keys,
+							isA_CFArray(CFDictionaryGetValue(request, kSCDLocalMessagePatterns)),
+							&sc_status);
+			break;
+
+		case kSCDLocalOpSetNotificationKeys :
+			keys = isA_CFArray(CFDictionaryGetValue(request, kSCDLocalMessageKeys));
+			sc_status = sessionSetNotificationKeys(session,
+							       keys,
+							       isA_CFArray(CFDictionaryGetValue(request, kSCDLocalMessagePatterns)));
+			break;
+
+		case kSCDLocalOpSetNotificationOptions : {
+			int	changedMax;
+			int	payloadMax;
+
+			payloadMax = SCDLocalMessageGetInt(request, kSCDLocalMessagePayloadMax, 0);
+			changedMax = SCDLocalMessageGetInt(request, kSCDLocalMessageChangedMax, 0);
+			if ((payloadMax < 0) || (payloadMax > SCDLOCAL_MESSAGE_MAX) || (changedMax < 0)) {
+				sc_status = kSCStatusInvalidArgument;
+				break;
+			}
+			if (CFDictionaryContainsKey(request, kSCDLocalMessagePayloads)) {
+				session->payloads = (SCDLocalMessageGetInt(request, kSCDLocalMessagePayloads, 0) != 0);
+				session->payloadMax = (payloadMax > 0) ? payloadMax : SCDLOCAL_PAYLOAD_MAX_DEFAULT;
+			}
+			if (CFDictionaryContainsKey(request, kSCDLocalMessageChangedMax)) {
+				session->changedMax = (changedMax > 0) ? changedMax : SCDLOCAL_CHANGED_MAX_DEFAULT;
+			}
+			break;
+		}
+
+		case kSCDLocalOpCopyGenerations :
+			keys = isA_CFArray(CFDictionaryGetValue(request, kSCDLocalMessageKeys));
+			if (keys == NULL) {
+				sc_status = kSCStatusInvalidArgument;
+				break;
+			}
+			reply_value = storeCopyGenerations(keys);
+			break;
+
+		case kSCDLocalOpCommit : {
+			CFDictionaryRef	generations	= NULL;
+
+			sc_status = storeCommit(session, request, &generations);
+			reply_value = generations;
+			break;
+		}
+
+		case kSCDLocalOpSnapshot :
+		case kSCDLocalOpRestore : {
+			CFStringRef	name;
+			char		path[PATH_MAX];
+			int64_t		since		= 0;
+
+			name = isA_CFString(CFDictionaryGetValue(request, kSCDLocalMessagePath));
+			if ((name == NULL) || !snapshotGetPath(name, path, sizeof(path))) {
+				sc_status = kSCStatusInvalidArgument;
+				break;
+			}
+
+			if (SCDLocalMessageGetInt(request, kSCDLocalMessageOp, 0) == kSCDLocalOpRestore) {
+				sc_status = storeRestoreSnapshot(path);
+				break;
+			}
+
+			if (isA_CFNumber(CFDictionaryGetValue(request, kSCDLocalMessageGeneration))) {
+				(void) CFNumberGetValue(CFDictionaryGetValue(request, kSCDLocalMessageGeneration),
+							kCFNumberSInt64Type,
+							&since);
+			}
+			sc_status = storeWriteSnapshot(path, since);
+			if (sc_status == kSCStatusOK) {
+				reply_value = CFNumberCreate(NULL, kCFNumberSInt64Type, &storeGeneration);
+			}
+			break;
+		}
+
+		case kSCDLocalOpCopyStatistics : {
+			CFMutableDictionaryRef	stats;
+
+			stats = CFDictionaryCreateMutable(NULL,
+							  0,
+							  &kCFTypeDictionaryKeyCallBacks,
+							  &kCFTypeDictionaryValueCallBacks);
+			addStatistic(stats, kSCDLocalStatisticsMerged, session->nMerged);
+			addStatistic(stats, kSCDLocalStatisticsDropped, session->nDropped);
+			addStatistic(stats, kSCDLocalStatisticsResyncs, session->nResyncs);
+			addStatistic(stats, kSCDLocalStatisticsSent, session->nSent);
+			addStatistic(stats, kSCDLocalStatisticsPending, CFSetGetCount(session->changedKeys));
+			reply_value = stats;
+			break;
+		}
+
+		default :
+			sc_status = kSCStatusInvalidArgument;
+			break;
+	}
+
+	reply = CFDictionaryCreateMutable(NULL,
+					  0,
+					  &kCFTypeDictionaryKeyCallBacks,
+					  &kCFTypeDictionaryValueCallBacks);
+	SCDLocalMessageSetInt(reply, kSCDLocalMessageID, SCDLocalMessageGetInt(request, kSCDLocalMessageID, 0));
+	SCDLocalMessageSetInt(reply, kSCDLocalMessageStatus, sc_status);
+	if (reply_value != NULL) {
+		CFDictionarySetValue(reply, kSCDLocalMessageValue, reply_value);
+		CFRelease(reply_value);
+	}
+
+	return reply;
+}
+
+
+static void
+sessionClose(SCDLocalSessionRef session)
+{
+	CFIndex			i;
+	CFIndex			n;
+	SCDLocalSessionRef	*scan;
+
+	// unlink
+	for (scan = &sessions; *scan != NULL; scan = &(*scan)->next) {
+		if (*scan == session) {
+			*scan = session->next;
+			break;
+		}
+	}
+
+	// remove any temporary / session keys
+	n = CFSetGetCount(session->ownedKeys);
+	if (n > 0) {
+		const void	**keys;
+
+		keys = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+		CFSetGetValues(session->ownedKeys, keys);
+		for (i = 0; i < n; i++) {
+			CFStringRef	key	= CFRetain(keys[i]);
+
+			(void) storeRemoveValue(session, key);
+			CFRelease(key);
+		}
+		CFAllocatorDeallocate(NULL, keys);
+	}
+
+	// (the socket is closed once both sources have been cancelled)
+	dispatch_source_cancel(session->writeSource);
+	if (!session->writeSourceActive) {
+		dispatch_resume(session->writeSource);
+	}
+	dispatch_release(session->writeSource);
+	dispatch_source_cancel(session->source);
+	if (session->sourceSuspended) {
+		dispatch_resume(session->source);
+	}
+	dispatch_release(session->source);
+
+	__SCDNotifyRouterRemoveWatcher(storeRouter, session);
+	if (session->name != NULL) CFRelease(session->name);
+	CFRelease(session->inbuf);
+	CFRelease(session->outbuf);
+	CFRelease(session->ownedKeys);
+	CFRelease(session->changedKeys);
+	free(session);
+
+	return;
+}
+
+
+static void
+sessionRead(SCDLocalSessionRef session)
+{
+	UInt8		buf[65536];
+	CFDictionaryRef	request;
+	ssize_t		n;
+
+	n = read(session->fd, buf, sizeof(buf));
+	if (n == -1) {
+		if ((errno == EAGAIN) || (errno == EINTR)) {
+			return;
+		}
+	}
+	if (n <= 0) {
+		// if EOF (or error)
+		sessionClose(session);
+		storeFlushNotifications();
+		return;
+	}
+	CFDataAppendBytes(session->inbuf, buf, n);
+
+	while ((request = SCDLocalMessageCreateFromBuffer(session->inbuf)) != NULL) {
+		CFDictionaryRef	reply;
+		Boolean		ok;
+
+		if (CFDictionaryGetCount(request) == 0) {
+			// if malformed
+			CFRelease(request);
+			sessionClose(session);
+			storeFlushNotifications();
+			return;
+		}
+
+		reply = sessionHandleRequest(session, request);
+		CFRelease(request);
+		ok = sessionSendReply(session, reply);
+		CFRelease(reply);
+		if (!ok) {
+			sessionClose(session);
+			storeFlushNotifications();
+			return;
+		}
+	}
+
+	storeFlushNotifications();
+	return;
+}
+
+
+static void
+sessionOpen(int fd)
+{
+	int			*nSources;
+	SCDLocalSessionRef	session;
+
+	(void) fcntl(fd, F_SETFL, O_NONBLOCK);
+#ifdef	SO_NOSIGPIPE
+	{
+		int	on	= 1;
+
+		(void) setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	}
+#endif	// SO_NOSIGPIPE
+
+	session = calloc(1, sizeof(*session));
+	session->fd = fd;
+	session->inbuf = CFDataCreateMutable(NULL, 0);
+	session->ownedKeys = CFSetCreateMutable(NULL, 0, &kCFTypeSetCallBacks);
+	session->changedKeys = CFSetCreateMutable(NULL, 0, &kCFTypeSetCallBacks);
+	session->changedMax = SCDLOCAL_CHANGED_MAX_DEFAULT;
+	session->outbuf = CFDataCreateMutable(NULL, 0);
+	session->payloadMax = SCDLOCAL_PAYLOAD_MAX_DEFAULT;
+
+	// close the socket after both the read and write sources are cancelled
+	nSources = malloc(sizeof(*nSources));
+	*nSources = 2;
+
+	session->source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, fd, 0, serverQueue);
+	dispatch_source_set_event_handler(session->source, ^{
+		sessionRead(session);
+	});
+	dispatch_source_set_cancel_handler(session->source, ^{
+		if (--(*nSources) == 0) {
+			close(fd);
+			free(nSources);
+		}
+	});
+
+	// (only resumed while there is pending output)
+	session->writeSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_WRITE, fd, 0, serverQueue);
+	dispatch_source_set_event_handler(session->writeSource, ^{
+		if (!sessionWrite(session)) {
+			sessionClose(session);
+		}
+		storeFlushNotifications();
+	});
+	dispatch_source_set_cancel_handler(session->writeSource, ^{
+		if (--(*nSources) == 0) {
+			close(fd);
+			free(nSources);
+		}
+	});
+
+	session->next = sessions;
+	sessions = session;
+
+	dispatch_resume(session->source);
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Server
+
+
+int
+SCDLocalServerRun(const char *path, const char *snapshotPath)
+{
+	struct sockaddr_un	addr;
+	dispatch_source_t	listener;
+	struct stat		sb;
+	int			sock;
+
+	if (!SCDLocalGetDirectory(storeSnapshotDirectory, sizeof(storeSnapshotDirectory), TRUE)) {
+		SCPrint(TRUE, stderr, CFSTR("no private directory \"%s\": %s\n"),
+			storeSnapshotDirectory,
+			SCErrorString(SCError()));
+		return 1;
+	}
+
+	storeData = CFDictionaryCreateMutable(NULL,
+					      0,
+					      &kCFTypeDictionaryKeyCallBacks,
+					      &kCFTypeDictionaryValueCallBacks);
+	storeOwners = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, NULL);
+	storeGenerations = CFDictionaryCreateMutable(NULL,
+						     0,
+						     &kCFTypeDictionaryKeyCallBacks,
+						     &kCFTypeDictionaryValueCallBacks);
+	storeIndex = __SCDKeyIndexCreate();
+	if (storeIndex == NULL) {
+		SCPrint(TRUE, stderr, CFSTR("could not create the key index: %s\n"), SCErrorString(SCError()));
+		return 1;
+	}
+	storeRouter = __SCDNotifyRouterCreate();
+
+	if (snapshotPath != NULL) {
+		int		sc_status;
+		CFAbsoluteTime	start;
+
+		// warm start
+		start = CFAbsoluteTimeGetCurrent();
+		sc_status = storeRestoreSnapshot(snapshotPath);
+		if (sc_status != kSCStatusOK) {
+			SCPrint(TRUE, stderr, CFSTR("could not restore \"%s\": %s\n"),
+				snapshotPath,
+				SCErrorString(sc_status));
+			return 1;
+		}
+		storeFlushNotifications();
+		SCPrint(TRUE, stdout, CFSTR("scdlocal: restored %ld keys in %.3f ms\n"),
+			(long)CFDictionaryGetCount(storeData),
+			(CFAbsoluteTimeGetCurrent() - start) * 1000.0);
+	}
+
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock == -1) {
+		SCPrint(TRUE, stderr, CFSTR("socket() failed: %s\n"), strerror(errno));
+		return 1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlcpy(addr.sun_path, path, sizeof(addr.sun_path)) >= sizeof(addr.sun_path)) {
+		SCPrint(TRUE, stderr, CFSTR("socket path too long\n"));
+		close(sock);
+		return 1;
+	}
+	if (lstat(path, &sb) == 0) {
+		// only replace a stale socket, never some other file
+		if (!S_ISSOCK(sb.st_mode)) {
+			SCPrint(TRUE, stderr, CFSTR("%s: not a socket\n"), path);
+			close(sock);
+			return 1;
+		}
+		(void) unlink(path);
+	}
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+		SCPrint(TRUE, stderr, CFSTR("bind() failed: %s\n"), strerror(errno));
+		close(sock);
+		return 1;
+	}
+	if (listen(sock, SOMAXCONN) == -1) {
+		SCPrint(TRUE, stderr, CFSTR("listen() failed: %s\n"), strerror(errno));
+		close(sock);
+		return 1;
+	}
+	(void) fcntl(sock, F_SETFL, O_NONBLOCK);
+
+	serverQueue = dispatch_queue_create("com.apple.SystemConfiguration.scdlocal", NULL);
+	listener = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, sock, 0, serverQueue);
+	dispatch_source_set_event_handler(listener, ^{
+		int	fd;
+
+		while ((fd = accept(sock, NULL, NULL)) != -1) {
+			sessionOpen(fd);
+		}
+	});
+	dispatch_resume(listener);
+
+	SCPrint(TRUE, stdout, CFSTR("scdlocal: listening on %s\n"), path);
+	dispatch_main();
+
+	/* not reached */
+	return 0;
+}
@@ -0,0 +1,2210 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Modification History
+ *
+ * October 18, 2026
+ * - initial revision: micro-benchmarks for the SCDynamicStore key index
+ * - added notification routing benchmark
+ * - added merged key list / values benchmark
+ * - added XML property list parsing benchmark
+ * - added preferences storage format benchmark
+ * - added preferences path lookup benchmark
+ * - added preferences write contention benchmark
+ * - added synthetic network configuration generator and benchmark
+ */
+
+#include <crt_externs.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <mach/mach_time.h>
+#include <mach-o/dyld.h>
+#include <regex.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "scutil.h"
+#include "bench.h"
+#include "SCDynamicStoreInternal.h"
+#include "SCNetworkConfigurationInternal.h"
+#include "SCPreferencesInternal.h"
+
+
+#pragma mark -
+#pragma mark Timing
+
+
+static uint64_t
+bench_now_ns(void)
+{
+	static mach_timebase_info_data_t	timebase	= { 0, 0 };
+
+	if (timebase.denom == 0) {
+		(void) mach_timebase_info(&timebase);
+	}
+
+	return mach_absolute_time() * timebase.numer / timebase.denom;
+}
+
+
+static void
+bench_report(const char *label, uint64_t elapsed_ns, CFIndex ops, CFIndex matches)
+{
+	SCPrint(TRUE, stdout,
+		CFSTR("  %-36s %8ld ops, %10.3f ms, %9.3f us/op, %ld matches\n"),
+		label,
+		(long)ops,
+		(double)elapsed_ns / 1000000.0,
+		(ops > 0) ? ((double)elapsed_ns / 1000.0) / (double)ops : 0.0,
+		(long)matches);
+	return;
+}
+
+
+#pragma mark -
+#pragma mark SCDynamicStore key index
+
+
+static const char	*bench_entities[]	= {
+	"IPv4", "IPv6", "DNS", "Proxies", "Interface", "Link", "AirPort", "SMB",
+};
+#define	N_BENCH_ENTITIES	(sizeof(bench_entities) / sizeof(bench_entities[0]))
+
+
+static const char	*bench_patterns[]	= {
+	"^State:/Network/Service/[^/]+/IPv4$",
+	"^State:/Network/Interface/[^/]+/Link$",
+	"^Setup:/Network/Service/[^/]+/DNS$",
+	"^State:/Network/Service/S00042/.*",
+	"^State:/Network/Global/IPv4$",
+	"State:/Network/Interface/en[0-9]+/AirPort",
+	"/Proxies$",
+};
+#define	N_BENCH_PATTERNS	(sizeof(bench_patterns) / sizeof(bench_patterns[0]))
+
+
+static CFArrayRef
+bench_create_keys(CFIndex nKeys)
+{
+	CFIndex			i;
+	CFMutableArrayRef	keys;
+
+	keys = CFArrayCreateMutable(NULL, nKeys, &kCFTypeArrayCallBacks);
+	CFArrayAppendValue(keys, CFSTR("State:/Network/Global/IPv4"));
+	CFArrayAppendValue(keys, CFSTR("State:/Network/Global/IPv6"));
+	CFArrayAppendValue(keys, CFSTR("State:/Network/Global/DNS"));
+	for (i = 0; CFArrayGetCount(keys) < nKeys; i++) {
+		CFStringRef	key;
+		const char	*entity	= bench_entities[i % N_BENCH_ENTITIES];
+
+		switch ((i / N_BENCH_ENTITIES) % 4) {
+			case 0 :
+				key = CFStringCreateWithFormat(NULL, NULL,
+							       CFSTR("State:/Network/Service/S%05ld/%s"),
+							       (long)(i / (N_BENCH_ENTITIES * 4)), entity);
+				break;
+			case 1 :
+				key = CFStringCreateWithFormat(NULL, NULL,
+							       CFSTR("Setup:/Network/Service/S%05ld/%s"),
+							       (long)(i / (N_BENCH_ENTITIES * 4)), entity);
+				break;
+			case 2 :
+				key = CFStringCreateWithFormat(NULL, NULL,
+							       CFSTR("State:/Network/Interface/en%ld/%s"),
+							       (long)(i / (N_BENCH_ENTITIES * 4)), entity);
+				break;
+			default :
+				key = CFStringCreateWithFormat(NULL, NULL,
+							       CFSTR("Plugin:Bench/%ld/%s"),
+							       (long)i, entity);
+				break;
+		}
+		CFArrayAppendValue(keys, key);
+		CFRelease(key);
+	}
+
+	return keys;
+}
+
+
+static CFIndex
+bench_regex_scan(CFStringRef pattern, char **keys, CFIndex nKeys)
+{
+	CFIndex		i;
+	CFIndex		matches	= 0;
+	regex_t		preg;
+	char		*str;
+
+	// what a linear, regex-only, key list query does
+	str = _SC_cfstring_to_cstring(pattern, NULL, 0, kCFStringEncodingUTF8);
+	if (regcomp(&preg, str, REG_EXTENDED) != 0) {
+		CFAllocatorDeallocate(NULL, str);
+		return 0;
+	}
+	CFAllocatorDeallocate(NULL, str);
+
+	for (i = 0; i < nKeys; i++) {
+		if (regexec(&preg, keys[i], 0, NULL, 0) == 0) {
+			matches++;
+		}
+	}
+	regfree(&preg);
+
+	return matches;
+}
+
+
+__private_extern__
+void
+do_bench_keys(int argc, char **argv)
+{
+	uint64_t		elapsed;
+	CFIndex			i;
+	SCDKeyIndexRef		keyIndex;
+	CFArrayRef		keys;
+	char			**keys_c;
+	CFIndex			nKeys		= 100000;
+	CFIndex			nQueries	= 10;
+
+	if (argc > 0) {
+		nKeys = strtol(argv[0], NULL, 10);
+		if (nKeys <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid key count\n"));
+			return;
+		}
+	}
+	if (argc > 1) {
+		nQueries = strtol(argv[1], NULL, 10);
+		if (nQueries <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid query count\n"));
+			return;
+		}
+	}
+
+	keys = bench_create_keys(nKeys);
+	keys_c = CFAllocatorAllocate(NULL, nKeys * sizeof(char *), 0);
+	for (i = 0; i < nKeys; i++) {
+		keys_c[i] = _SC_cfstring_to_cstring(CFArrayGetValueAtIndex(keys, i), NULL, 0, kCFStringEncodingUTF8);
+	}
+
+	SCPrint(TRUE, stdout, CFSTR("SCDynamicStore key index, %ld keys, %ld queries/pattern\n"),
+		(long)nKeys, (long)nQueries);
+
+	keyIndex = __SCDKeyIndexCreate();
+	if (keyIndex == NULL) {
+		SCPrint(TRUE, stdout, CFSTR("__SCDKeyIndexCreate() failed: %s\n"), SCErrorString(SCError()));
+		goto done;
+	}
+
+	elapsed = bench_now_ns();
+	for (i = 0; i < nKeys; i++) {
+		__SCDKeyIndexAddKey(keyIndex, CFArrayGetValueAtIndex(keys, i));
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("index build", elapsed, nKeys, __SCDKeyIndexGetCount(keyIndex));
+
+	for (i = 0; i < (CFIndex)N_BENCH_PATTERNS; i++) {
+		CFIndex		matches		= 0;
+		CFIndex		n;
+		CFStringRef	pattern;
+
+		pattern = CFStringCreateWithCString(NULL, bench_patterns[i], kCFStringEncodingUTF8);
+		SCPrint(TRUE, stdout, CFSTR("\n  pattern: %@\n"), pattern);
+
+		elapsed = bench_now_ns();
+		for (n = 0; n < nQueries; n++) {
+			matches = bench_regex_scan(pattern, keys_c, nKeys);
+		}
+		elapsed = bench_now_ns() - elapsed;
+		bench_report("regex scan", elapsed, nQueries, matches);
+
+		elapsed = bench_now_ns();
+		for (n = 0; n < nQueries; n++) {
+			CFArrayRef	list;
+
+			list = __SCDKeyIndexCopyMatchingKeys(keyIndex, pattern);
+			matches = (list != NULL) ? CFArrayGetCount(list) : 0;
+			if (list != NULL) CFRelease(list);
+		}
+		elapsed = bench_now_ns() - elapsed;
+		bench_report("key index", elapsed, nQueries, matches);
+
+		CFRelease(pattern);
+	}
+
+	__SCDKeyIndexRelease(keyIndex);
+
+    done :
+
+	for (i = 0; i < nKeys; i++) {
+		CFAllocatorDeallocate(NULL, keys_c[i]);
+	}
+	CFAllocatorDeallocate(NULL, keys_c);
+	CFRelease(keys);
+
+	return;
+}
+
+
+#pragma mark -
+#pragma mark SCDynamicStore notification routing
+
+
+typedef struct {
+	CFSetRef	keys;
+	regex_t		*preg;
+	CFIndex		nPatterns;
+} bench_watcher;
+
+
+static CFStringRef
+bench_create_watcher_pattern(CFIndex session, CFIndex n)
+{
+	switch (n % 8) {
+		case 0 :
+			return CFStringCreateWithFormat(NULL, NULL,
+							CFSTR("^State:/Network/Service/S%05ld/[^/]+$"),
+							(long)session);
+		case 1 :
+			return CFStringCreateWithFormat(NULL, NULL,
+							CFSTR("^Setup:/Network/Service/S%05ld/(IPv4|IPv6)$"),
+							(long)session);
+		case 2 :
+			return CFStringCreateWithFormat(NULL, NULL,
+							CFSTR("^State:/Network/Interface/en%ld/Link$"),
+							(long)session);
+		case 3 :
+			return CFStringCreateWithFormat(NULL, NULL,
+							CFSTR("^Plugin:Bench/%ld/[^/]+$"),
+							(long)(session * 8 + n));
+		case 4 :
+			return CFStringCreateWithFormat(NULL, NULL,
+							CFSTR("^State:/Network/Service/S%05ld/%s$"),
+							(long)(session + n),
+							bench_entities[n % N_BENCH_ENTITIES]);
+		default :
+			// shared by many sessions
+			return CFStringCreateWithCString(NULL,
+							 bench_patterns[(session + n) % N_BENCH_PATTERNS],
+							 kCFStringEncodingUTF8);
+	}
+}
+
+
+static void
+bench_count_watcher(const void *watcher, void *context)
+{
+#pragma unused(watcher)
+	CFIndex		*count	= (CFIndex *)context;
+
+	(*count)++;
+	return;
+}
+
+
+__private_extern__
+void
+do_bench_notify(int argc, char **argv)
+{
+	CFIndex			deliveries;
+	uint64_t		elapsed;
+	CFIndex			i;
+	CFArrayRef		keys;
+	char			**keys_c;
+	CFIndex			nChanges	= 1000;
+	CFIndex			nPatterns	= 10;
+	CFIndex			nWatchers	= 1000;
+	SCDNotifyRouterRef	router;
+	SCDNotifyRouterStatistics	stats;
+	bench_watcher		*watchers;
+
+	if (argc > 0) {
+		nWatchers = strtol(argv[0], NULL, 10);
+		if (nWatchers <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid session count\n"));
+			return;
+		}
+	}
+	if (argc > 1) {
+		nPatterns = strtol(argv[1], NULL, 10);
+		if (nPatterns < 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid pattern count\n"));
+			return;
+		}
+	}
+	if (argc > 2) {
+		nChanges = strtol(argv[2], NULL, 10);
+		if (nChanges <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid change count\n"));
+			return;
+		}
+	}
+
+	keys = bench_create_keys(nChanges);
+	keys_c = CFAllocatorAllocate(NULL, nChanges * sizeof(char *), 0);
+	for (i = 0; i < nChanges; i++) {
+		keys_c[i] = _SC_cfstring_to_cstring(CFArrayGetValueAtIndex(keys, i), NULL, 0, kCFStringEncodingUTF8);
+	}
+
+	SCPrint(TRUE, stdout, CFSTR("SCDynamicStore notification routing, %ld sessions, %ld patterns/session, %ld changes\n"),
+		(long)nWatchers, (long)nPatterns, (long)nChanges);
+
+	router = __SCDNotifyRouterCreate();
+	watchers = CFAllocatorAllocate(NULL, nWatchers * sizeof(bench_watcher), 0);
+	elapsed = 0;
+	for (i = 0; i < nWatchers; i++) {
+		CFIndex			n;
+		CFMutableArrayRef	patterns;
+		CFStringRef		watchKeys[2];
+		uint64_t		start;
+
+		watchKeys[0] = CFSTR("State:/Network/Global/IPv4");
+		watchKeys[1] = CFStringCreateWithFormat(NULL, NULL,
+							CFSTR("Setup:/Network/Service/S%05ld/DNS"),
+							(long)i);
+		watchers[i].keys = CFSetCreate(NULL, (const void **)watchKeys, 2, &kCFTypeSetCallBacks);
+		watchers[i].preg = CFAllocatorAllocate(NULL, (nPatterns + 1) * sizeof(regex_t), 0);
+		watchers[i].nPatterns = 0;
+
+		patterns = CFArrayCreateMutable(NULL, nPatterns, &kCFTypeArrayCallBacks);
+		for (n = 0; n < nPatterns; n++) {
+			CFStringRef	pattern;
+			char		*str;
+
+			pattern = bench_create_watcher_pattern(i, n);
+			str = _SC_cfstring_to_cstring(pattern, NULL, 0, kCFStringEncodingUTF8);
+			if (regcomp(&watchers[i].preg[watchers[i].nPatterns], str, REG_EXTENDED) == 0) {
+				watchers[i].nPatterns++;
+				CFArrayAppendValue(patterns, pattern);
+			}
+			CFAllocatorDeallocate(NULL, str);
+			CFRelease(pattern);
+		}
+
+		{
+			CFArrayRef	keyList;
+
+			keyList = CFArrayCreate(NULL, (const void **)watchKeys, 2, &kCFTypeArrayCallBacks);
+			start = bench_now_ns();
+			(void) __SCDNotifyRouterSetWatcher(router, &watchers[i], keyList, patterns);
+			elapsed += bench_now_ns() - start;
+			CFRelease(keyList);
+		}
+
+		CFRelease(watchKeys[1]);
+		CFRelease(patterns);
+	}
+	(void) __SCDNotifyRouterGetStatistics(router, &stats);
+	bench_report("router build", elapsed, nWatchers, stats.patterns);
+
+	// what a linear, per-session, regex scan does
+	deliveries = 0;
+	elapsed = bench_now_ns();
+	for (i = 0; i < nChanges; i++) {
+		CFIndex		j;
+		CFStringRef	key	= CFArrayGetValueAtIndex(keys, i);
+
+		for (j = 0; j < nWatchers; j++) {
+			CFIndex		n;
+
+			if (CFSetContainsValue(watchers[j].keys, key)) {
+				deliveries++;
+				continue;
+			}
+
+			for (n = 0; n < watchers[j].nPatterns; n++) {
+				if (regexec(&watchers[j].preg[n], keys_c[i], 0, NULL, 0) == 0) {
+					deliveries++;
+					break;
+				}
+			}
+		}
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("linear scan", elapsed, nChanges, deliveries);
+
+	// ... vs. the routing index (the first lookup also builds the automaton)
+	deliveries = 0;
+	elapsed = bench_now_ns();
+	for (i = 0; i < nChanges; i++) {
+		__SCDNotifyRouterApply(router,
+				       CFArrayGetValueAtIndex(keys, i),
+				       bench_count_watcher,
+				       &deliveries);
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("routing index", elapsed, nChanges, deliveries);
+
+	(void) __SCDNotifyRouterGetStatistics(router, &stats);
+	SCPrint(TRUE, stdout, CFSTR("\n  %ld watched keys, %ld distinct patterns, %llu candidates, %llu confirmed\n"),
+		(long)stats.keys,
+		(long)stats.patterns,
+		stats.candidates,
+		stats.confirmed);
+
+	__SCDNotifyRouterRelease(router);
+	for (i = 0; i < nWatchers; i++) {
+		CFIndex		n;
+
+		for (n = 0; n < watchers[i].nPatterns; n++) {
+			regfree(&watchers[i].preg[n]);
+		}
+		CFAllocatorDeallocate(NULL, watchers[i].preg);
+		CFRelease(watchers[i].keys);
+	}
+	CFAllocatorDeallocate(NULL, watchers);
+	for (i = 0; i < nChanges; i++) {
+		CFAllocatorDeallocate(NULL, keys_c[i]);
+	}
+	CFAllocatorDeallocate(NULL, keys_c);
+	CFRelease(keys);
+
+	return;
+}
+
+
+#pragma mark -
+#pragma mark SCDynamicStore merged key list / values
+
+
+/*
+ * bench_merged()
+ *
+ * With "nPending" keys set (but not yet committed) in a block of
+ * operations, time the key list and multi-key fetches that overlay the
+ * pending changes.  The pending keys do not exist in the server so the
+ * time is (mostly) that of the overlay.
+ */
+static void
+bench_merged(SCDynamicStoreRef session, CFIndex nPending, CFIndex nRounds)
+{
+	uint64_t		elapsed;
+	CFIndex			i;
+	CFMutableArrayRef	keys;
+	CFIndex			matches		= 0;
+	CFStringRef		pattern		= CFSTR("^State:/Bench/Merged/Key[0-9]+$");
+
+	_SCDynamicStoreCacheOpen(session);
+
+	keys = CFArrayCreateMutable(NULL, nPending, &kCFTypeArrayCallBacks);
+	for (i = 0; i < nPending; i++) {
+		CFStringRef	key;
+
+		key = CFStringCreateWithFormat(NULL, NULL, CFSTR("State:/Bench/Merged/Key%ld"), (long)i);
+		(void) SCDynamicStoreSetValue(session, key, key);
+		if ((i % 2) == 0) {
+			CFArrayAppendValue(keys, key);
+		}
+		CFRelease(key);
+	}
+	for (i = 0; i < (nPending / 10); i++) {
+		CFStringRef	key;
+
+		key = CFStringCreateWithFormat(NULL, NULL, CFSTR("State:/Bench/Merged/Removed%ld"), (long)i);
+		(void) SCDynamicStoreRemoveValue(session, key);
+		CFRelease(key);
+	}
+
+	SCPrint(TRUE, stdout, CFSTR("\n  %ld pending keys\n"), (long)nPending);
+
+	elapsed = bench_now_ns();
+	for (i = 0; i < nRounds; i++) {
+		CFArrayRef	list;
+
+		list = _SCDynamicStoreCopyKeyListMerged(session, pattern);
+		matches = (list != NULL) ? CFArrayGetCount(list) : 0;
+		if (list != NULL) CFRelease(list);
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("key list (merged)", elapsed, nRounds, matches);
+
+	elapsed = bench_now_ns();
+	for (i = 0; i < nRounds; i++) {
+		CFDictionaryRef	dict;
+
+		dict = _SCDynamicStoreCopyMultipleMerged(session, keys, NULL);
+		matches = (dict != NULL) ? CFDictionaryGetCount(dict) : 0;
+		if (dict != NULL) CFRelease(dict);
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("multiple, keys (merged)", elapsed, nRounds, matches);
+
+	// discard the pending changes
+	_SCDynamicStoreCacheClose(session);
+	CFRelease(keys);
+	return;
+}
+
+
+__private_extern__
+void
+do_bench_merged(int argc, char **argv)
+{
+	static const CFIndex	divisors[]	= { 100, 10, 1 };
+	size_t			i;
+	CFIndex			nPending	= 10000;
+	CFIndex			nRounds		= 10;
+	SCDynamicStoreRef	session;
+
+	if (argc > 0) {
+		nPending = strtol(argv[0], NULL, 10);
+		if (nPending <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid key count\n"));
+			return;
+		}
+	}
+	if (argc > 1) {
+		nRounds = strtol(argv[1], NULL, 10);
+		if (nRounds <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid round count\n"));
+			return;
+		}
+	}
+
+	session = SCDynamicStoreCreate(NULL, CFSTR("scutil (bench.merged)"), NULL, NULL);
+	if (session == NULL) {
+		SCPrint(TRUE, stdout, CFSTR("SCDynamicStoreCreate() failed: %s\n"), SCErrorString(SCError()));
+		return;
+	}
+
+	SCPrint(TRUE, stdout, CFSTR("SCDynamicStore merged key list / values, up to %ld pending keys, %ld rounds\n"),
+		(long)nPending,
+		(long)nRounds);
+
+	// the per-key cost should not grow with the number of pending keys
+	for (i = 0; i < sizeof(divisors) / sizeof(divisors[0]); i++) {
+		CFIndex		n	= nPending / divisors[i];
+
+		if (n > 0) {
+			bench_merged(session, n, nRounds);
+		}
+	}
+
+	CFRelease(session);
+	return;
+}
+
+
+#pragma mark -
+#pragma mark XML property list parsing
+
+
+static CFDictionaryRef
+bench_create_prefs(CFIndex size)
+{
+	CFMutableDictionaryRef	prefs;
+	CFMutableDictionaryRef	services;
+	CFIndex			i;
+
+	// ~1KB of XML per service
+	prefs = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	services = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	for (i = 0; (i == 0) || (i < size / 1024); i++) {
+		CFStringRef		addr;
+		CFArrayRef		array;
+		CFMutableDictionaryRef	dns;
+		CFMutableDictionaryRef	interface;
+		CFMutableDictionaryRef	ipv4;
+		CFStringRef		name;
+		CFNumberRef		num;
+		CFMutableDictionaryRef	service;
+		CFStringRef		serviceID;
+		CFStringRef		subnet	= CFSTR("255.255.255.0");
+
+		serviceID = CFStringCreateWithFormat(NULL, NULL, CFSTR("S%05ld-0000-0000-0000-000000000000"), (long)i);
+		name = CFStringCreateWithFormat(NULL, NULL, CFSTR("Ethernet & VPN #%ld"), (long)i);
+		addr = CFStringCreateWithFormat(NULL, NULL, CFSTR("10.%ld.%ld.1"), (long)((i >> 8) & 0xff), (long)(i & 0xff));
+
+		interface = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+		CFDictionarySetValue(interface, kSCPropNetInterfaceDeviceName, CFSTR("en0"));
+		CFDictionarySetValue(interface, kSCPropNetInterfaceHardware, kSCEntNetEthernet);
+		CFDictionarySetValue(interface, kSCPropNetInterfaceType, kSCValNetInterfaceTypeEthernet);
+		CFDictionarySetValue(interface, kSCPropUserDefinedName, name);
+
+		ipv4 = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+		CFDictionarySetValue(ipv4, kSCPropNetIPv4ConfigMethod, kSCValNetIPv4ConfigMethodManual);
+		array = CFArrayCreate(NULL, (const void **)&addr, 1, &kCFTypeArrayCallBacks);
+		CFDictionarySetValue(ipv4, kSCPropNetIPv4Addresses, array);
+		CFRelease(array);
+		array = CFArrayCreate(NULL, (const void **)&subnet, 1, &kCFTypeArrayCallBacks);
+		CFDictionarySetValue(ipv4, kSCPropNetIPv4SubnetMasks, array);
+		CFRelease(array);
+		CFDictionarySetValue(ipv4, kSCPropNetIPv4Router, CFSTR("10.0.0.1"));
+
+		dns = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+		CFDictionarySetValue(dns, kSCPropNetDNSDomainName, CFSTR("example.com"));
+		num = CFNumberCreate(NULL, kCFNumberCFIndexType, &i);
+		CFDictionarySetValue(dns, kSCPropNetDNSSearchOrder, num);
+		CFRelease(num);
+
+		service = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+		CFDictionarySetValue(service, kSCEntNetInterface, interface);
+		CFDictionarySetValue(service, kSCEntNetIPv4, ipv4);
+		CFDictionarySetValue(service, kSCEntNetDNS, dns);
+		CFDictionarySetValue(service, kSCPropUserDefinedName, name);
+		CFDictionarySetValue(service, CFSTR("__INACTIVE__"), kCFBooleanFalse);
+		CFDictionarySetValue(services, serviceID, service);
+
+		CFRelease(service);
+		CFRelease(dns);
+		CFRelease(ipv4);
+		CFRelease(interface);
+		CFRelease(addr);
+		CFRelease(name);
+		CFRelease(serviceID);
+	}
+	CFDictionarySetValue(prefs, kSCPrefNetworkServices, services);
+	CFRelease(services);
+
+	return prefs;
+}
+
+
+static CFDataRef
+bench_create_plist_xml(CFIndex size)
+{
+	CFDictionaryRef		prefs;
+	CFDataRef		xml;
+
+	prefs = bench_create_prefs(size);
+	xml = CFPropertyListCreateData(NULL, prefs, kCFPropertyListXMLFormat_v1_0, 0, NULL);
+	CFRelease(prefs);
+	return xml;
+}
+
+
+static void
+bench_plist(CFDataRef xml)
+{
+	uint64_t		elapsed_cf;
+	uint64_t		elapsed_sc;
+	CFIndex			i;
+	CFIndex			len		= CFDataGetLength(xml);
+	CFIndex			nIterations;
+	CFPropertyListRef	plist_cf	= NULL;
+	CFPropertyListRef	plist_sc	= NULL;
+
+	// ~20MB of XML per parser (at least 3 passes)
+	nIterations = MAX(3, (20 * 1024 * 1024) / MAX(len, 1));
+
+	elapsed_cf = bench_now_ns();
+	for (i = 0; i < nIterations; i++) {
+		if (plist_cf != NULL) CFRelease(plist_cf);
+		plist_cf = CFPropertyListCreateWithData(NULL, xml, kCFPropertyListImmutable, NULL, NULL);
+	}
+	elapsed_cf = bench_now_ns() - elapsed_cf;
+
+	elapsed_sc = bench_now_ns();
+	for (i = 0; i < nIterations; i++) {
+		if (plist_sc != NULL) CFRelease(plist_sc);
+		plist_sc = _SCCreatePropertyListWithXMLBytes(CFDataGetBytePtr(xml), len);
+	}
+	elapsed_sc = bench_now_ns() - elapsed_sc;
+
+	SCPrint(TRUE, stdout, CFSTR("\n  %ld bytes%s\n"),
+		(long)len,
+		(plist_sc == NULL)					? ", not handled (fallback to CF)" :
+		((plist_cf == NULL) || !CFEqual(plist_cf, plist_sc))	? ", MISMATCH"			   : "");
+	bench_report("CFPropertyListCreateWithData", elapsed_cf, nIterations, 0);
+	bench_report("_SCCreatePropertyListWithXMLBytes", elapsed_sc, nIterations, 0);
+	if ((elapsed_cf > 0) && (elapsed_sc > 0)) {
+		SCPrint(TRUE, stdout, CFSTR("  %.1f MB/s vs. %.1f MB/s\n"),
+			((double)len * nIterations) / ((double)elapsed_cf / 1000.0),
+			((double)len * nIterations) / ((double)elapsed_sc / 1000.0));
+	}
+
+	if (plist_cf != NULL) CFRelease(plist_cf);
+	if (plist_sc != NULL) CFRelease(plist_sc);
+	return;
+}
+
+
+__private_extern__
+void
+do_bench_plist(int argc, char **argv)
+{
+	static const CFIndex	sizes[]	= { 1024, 10 * 1024, 100 * 1024, 1024 * 1024, 10 * 1024 * 1024 };
+	CFIndex			i;
+
+	SCPrint(TRUE, stdout, CFSTR("XML property list parsing\n"));
+
+	if (argc > 0) {
+		int			fd;
+		struct stat		statBuf;
+		CFMutableDataRef	xml;
+
+		fd = open(argv[0], O_RDONLY, 0);
+		if ((fd == -1) || (fstat(fd, &statBuf) == -1)) {
+			SCPrint(TRUE, stdout, CFSTR("could not open \"%s\": %s\n"), argv[0], strerror(errno));
+			if (fd != -1) (void) close(fd);
+			return;
+		}
+		xml = CFDataCreateMutable(NULL, (CFIndex)statBuf.st_size);
+		CFDataSetLength(xml, (CFIndex)statBuf.st_size);
+		if (read(fd, CFDataGetMutableBytePtr(xml), (size_t)statBuf.st_size) != statBuf.st_size) {
+			SCPrint(TRUE, stdout, CFSTR("could not read \"%s\"\n"), argv[0]);
+			(void) close(fd);
+			CFRelease(xml);
+			return;
+		}
+		(void) close(fd);
+		bench_plist(xml);
+		CFRelease(xml);
+		return;
+	}
+
+	for (i = 0; i < (CFIndex)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+		CFDataRef	xml;
+
+		xml = bench_create_plist_xml(sizes[i]);
+		bench_plist(xml);
+		CFRelease(xml);
+	}
+
+	return;
+}
+
+
+#pragma mark -
+#pragma mark SCPreferences storage formats
+
+
+static Boolean
+bench_write_file(const char *path, CFDataRef data)
+{
+	int	fd;
+	Boolean	ok;
+
+	fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+	if (fd == -1) {
+		SCPrint(TRUE, stdout, CFSTR("could not open \"%s\": %s\n"), path, strerror(errno));
+		return FALSE;
+	}
+	ok = (write(fd, CFDataGetBytePtr(data), CFDataGetLength(data)) == CFDataGetLength(data)) &&
+	     (fsync(fd) == 0);
+	(void) close(fd);
+
+	return ok;
+}
+
+
+static void
+bench_prefs_format(const char *path, CFDictionaryRef config, CFStringRef format, CFIndex nIterations)
+{
+	CFDataRef		data;
+	uint64_t		elapsed;
+	CFIndex			i;
+	CFStringRef		key		= kSCPreferencesOptionStorageFormat;
+	CFDictionaryRef		options;
+	CFStringRef		prefsID;
+	char			tmpPath[MAXPATHLEN];
+
+	data = CFPropertyListCreateData(NULL,
+					config,
+					CFEqual(format, kSCPreferencesStorageFormatBinary) ? kCFPropertyListBinaryFormat_v1_0
+											   : kCFPropertyListXMLFormat_v1_0,
+					0,
+					NULL);
+	if ((data == NULL) || !bench_write_file(path, data)) {
+		if (data != NULL) CFRelease(data);
+		return;
+	}
+
+	SCPrint(TRUE, stdout, CFSTR("\n  %@, %ld bytes\n"), format, (long)CFDataGetLength(data));
+	CFRelease(data);
+
+	prefsID = CFStringCreateWithCString(NULL, path, kCFStringEncodingUTF8);
+	options = CFDictionaryCreate(NULL,
+				     (const void **)&key,
+				     (const void **)&format,
+				     1,
+				     &kCFTypeDictionaryKeyCallBacks,
+				     &kCFTypeDictionaryValueCallBacks);
+
+	// open
+	elapsed = bench_now_ns();
+	for (i = 0; i < nIterations; i++) {
+		SCPreferencesRef	prefs;
+
+		prefs = SCPreferencesCreateWithOptions(NULL, CFSTR("scutil bench.prefs"), prefsID, NULL, options);
+		if (prefs != NULL) CFRelease(prefs);
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("open", elapsed, nIterations, 0);
+
+	// open + access
+	elapsed = 0;
+	for (i = 0; i < nIterations; i++) {
+		SCPreferencesRef	prefs;
+		uint64_t		start;
+
+		__SCPreferencesCacheFlush();
+		start = bench_now_ns();
+		prefs = SCPreferencesCreateWithOptions(NULL, CFSTR("scutil bench.prefs"), prefsID, NULL, options);
+		if (prefs != NULL) {
+			(void) SCPreferencesGetValue(prefs, kSCPrefNetworkServices);
+			CFRelease(prefs);
+		}
+		elapsed += bench_now_ns() - start;
+	}
+	bench_report("open + access", elapsed, nIterations, 0);
+
+	// open + access, [unchanged] file already parsed
+	elapsed = bench_now_ns();
+	for (i = 0; i < nIterations; i++) {
+		SCPreferencesRef	prefs;
+
+		prefs = SCPreferencesCreateWithOptions(NULL, CFSTR("scutil bench.prefs"), prefsID, NULL, options);
+		if (prefs != NULL) {
+			(void) SCPreferencesGetValue(prefs, kSCPrefNetworkServices);
+			CFRelease(prefs);
+		}
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("open + access (cached)", elapsed, nIterations, 0);
+
+	// commit (serialize, write, rename)
+	snprintf(tmpPath, sizeof(tmpPath), "%s-new", path);
+	elapsed = 0;
+	for (i = 0; i < nIterations; i++) {
+		SCPreferencesRef	prefs;
+		uint64_t		start;
+
+		prefs = SCPreferencesCreateWithOptions(NULL, CFSTR("scutil bench.prefs"), prefsID, NULL, options);
+		if (prefs == NULL) {
+			continue;
+		}
+		(void) SCPreferencesSetValue(prefs, CFSTR("bench"), (i & 1) ? kCFBooleanTrue : kCFBooleanFalse);
+
+		start = bench_now_ns();
+		data = __SCPreferencesCreateData(prefs);
+		if ((data != NULL) && bench_write_file(tmpPath, data)) {
+			(void) rename(tmpPath, path);
+		}
+		elapsed += bench_now_ns() - start;
+
+		if (data != NULL) CFRelease(data);
+		CFRelease(prefs);
+	}
+	bench_report("commit (serialize + write)", elapsed, nIterations, 0);
+
+	CFRelease(options);
+	CFRelease(prefsID);
+	(void) unlink(path);
+	return;
+}
+
+
+__private_extern__
+void
+do_bench_prefs(int argc, char **argv)
+{
+	CFDictionaryRef		config;
+	CFIndex			nIterations	= 10;
+	CFIndex			nServices	= 1000;
+	char			path[MAXPATHLEN];
+
+	if (argc > 0) {
+		nServices = strtol(argv[0], NULL, 10);
+		if (nServices <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid service count\n"));
+			return;
+		}
+	}
+	if (argc > 1) {
+		nIterations = strtol(argv[1], NULL, 10);
+		if (nIterations <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid iteration count\n"));
+			return;
+		}
+	}
+
+	SCPrint(TRUE, stdout, CFSTR("SCPreferences storage formats, %ld services, %ld iterations\n"),
+		(long)nServices,
+		(long)nIterations);
+
+	snprintf(path, sizeof(path), "/tmp/scutil-bench-prefs-%d.plist", getpid());
+	config = bench_create_prefs(nServices * 1024);
+	bench_prefs_format(path, config, kSCPreferencesStorageFormatXML, nIterations);
+	bench_prefs_format(path, config, kSCPreferencesStorageFormatBinary, nIterations);
+	CFRelease(config);
+
+	return;
+}
+
+
+#pragma mark -
+#pragma mark SCPreferences path lookups
+
+
+static CFArrayRef
+bench_create_paths(CFMutableDictionaryRef config)
+{
+	CFIndex			i;
+	CFIndex			n;
+	CFMutableDictionaryRef	network;
+	CFMutableArrayRef	paths;
+	CFDictionaryRef		services;
+	const void		**serviceIDs;
+	CFMutableDictionaryRef	set;
+	CFMutableDictionaryRef	sets;
+	CFMutableDictionaryRef	setServices;
+
+	services = CFDictionaryGetValue(config, kSCPrefNetworkServices);
+	n = CFDictionaryGetCount(services);
+	serviceIDs = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+	CFDictionaryGetKeysAndValues(services, serviceIDs, NULL);
+
+	// and a set that links to each service
+	setServices = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	paths = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	for (i = 0; i < n; i++) {
+		CFDictionaryRef	link;
+		CFStringRef	linkKey		= CFSTR("__LINK__");
+		CFStringRef	path;
+
+		path = CFStringCreateWithFormat(NULL, NULL, CFSTR("/%@/%@"), kSCPrefNetworkServices, serviceIDs[i]);
+		link = CFDictionaryCreate(NULL,
+					  (const void **)&linkKey,
+					  (const void **)&path,
+					  1,
+					  &kCFTypeDictionaryKeyCallBacks,
+					  &kCFTypeDictionaryValueCallBacks);
+		CFDictionarySetValue(setServices, serviceIDs[i], link);
+		CFRelease(link);
+		CFRelease(path);
+
+		path = CFStringCreateWithFormat(NULL, NULL, CFSTR("/%@/%@/%@"), kSCPrefNetworkServices, serviceIDs[i], kSCEntNetIPv4);
+		CFArrayAppendValue(paths, path);
+		CFRelease(path);
+		path = CFStringCreateWithFormat(NULL, NULL, CFSTR("/%@/%@/%@"), kSCPrefNetworkServices, serviceIDs[i], kSCEntNetDNS);
+		CFArrayAppendValue(paths, path);
+		CFRelease(path);
+		path = CFStringCreateWithFormat(NULL, NULL, CFSTR("/%@/0/%@/%@/%@/%@"),
+						kSCPrefSets, kSCCompNetwork, kSCCompService, serviceIDs[i], kSCEntNetInterface);
+		CFArrayAppendValue(paths, path);
+		CFRelease(path);
+	}
+	CFAllocatorDeallocate(NULL, serviceIDs);
+
+	network = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	CFDictionarySetValue(network, kSCCompService, setServices);
+	CFRelease(setServices);
+	set = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	CFDictionarySetValue(set, kSCCompNetwork, network);
+	CFRelease(network);
+	sets = CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+	CFDictionarySetValue(sets, CFSTR("0"), set);
+	CFRelease(set);
+	CFDictionarySetValue(config, kSCPrefSets, sets);
+	CFRelease(sets);
+
+	return paths;
+}
+
+
+static CFIndex
+bench_lookup_paths(SCPreferencesRef prefs, CFArrayRef paths, CFIndex nRounds, Boolean indexed)
+{
+	CFIndex		found	= 0;
+	CFIndex		i;
+	CFIndex		n	= CFArrayGetCount(paths);
+	CFIndex		r;
+
+	for (r = 0; r < nRounds; r++) {
+		found = 0;
+		for (i = 0; i < n; i++) {
+			CFStringRef	path	= CFArrayGetValueAtIndex(paths, i);
+			CFDictionaryRef	value;
+
+			value = indexed ? __SCPreferencesPathGetValue(prefs, path)
+					: SCPreferencesPathGetValue(prefs, path);
+			if (value != NULL) {
+				found++;
+			}
+		}
+	}
+
+	return found;
+}
+
+
+__private_extern__
+void
+do_bench_paths(int argc, char **argv)
+{
+	CFDictionaryRef		config;
+	CFMutableDictionaryRef	configWithSets;
+	CFDataRef		data;
+	uint64_t		elapsed;
+	CFIndex			found;
+	CFIndex			nRounds		= 10;
+	CFIndex			nServices	= 5000;
+	char			path[MAXPATHLEN];
+	CFArrayRef		paths;
+	SCPreferencesRef	prefs;
+	CFStringRef		prefsID;
+
+	if (argc > 0) {
+		nServices = strtol(argv[0], NULL, 10);
+		if (nServices <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid service count\n"));
+			return;
+		}
+	}
+	if (argc > 1) {
+		nRounds = strtol(argv[1], NULL, 10);
+		if (nRounds <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid round count\n"));
+			return;
+		}
+	}
+
+	config = bench_create_prefs(nServices * 1024);
+	configWithSets = CFDictionaryCreateMutableCopy(NULL, 0, config);
+	CFRelease(config);
+	paths = bench_create_paths(configWithSets);
+
+	snprintf(path, sizeof(path), "/tmp/scutil-bench-paths-%d.plist", getpid());
+	data = CFPropertyListCreateData(NULL, configWithSets, kCFPropertyListXMLFormat_v1_0, 0, NULL);
+	CFRelease(configWithSets);
+	if ((data == NULL) || !bench_write_file(path, data)) {
+		if (data != NULL) CFRelease(data);
+		CFRelease(paths);
+		return;
+	}
+	CFRelease(data);
+
+	SCPrint(TRUE, stdout, CFSTR("SCPreferences path lookups, %ld services, %ld paths, %ld rounds\n"),
+		(long)nServices,
+		(long)CFArrayGetCount(paths),
+		(long)nRounds);
+
+	prefsID = CFStringCreateWithCString(NULL, path, kCFStringEncodingUTF8);
+	prefs = SCPreferencesCreate(NULL, CFSTR("scutil bench.paths"), prefsID);
+	CFRelease(prefsID);
+	if (prefs == NULL) {
+		SCPrint(TRUE, stdout, CFSTR("SCPreferencesCreate() failed: %s\n"), SCErrorString(SCError()));
+		(void) unlink(path);
+		CFRelease(paths);
+		return;
+	}
+	(void) SCPreferencesGetValue(prefs, kSCPrefNetworkServices);	// access
+
+	elapsed = bench_now_ns();
+	found = bench_lookup_paths(prefs, paths, nRounds, FALSE);
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("SCPreferencesPathGetValue", elapsed, nRounds * CFArrayGetCount(paths), found);
+
+	elapsed = bench_now_ns();
+	found = bench_lookup_paths(prefs, paths, 1, TRUE);
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("path index (build)", elapsed, CFArrayGetCount(paths), found);
+
+	elapsed = bench_now_ns();
+	found = bench_lookup_paths(prefs, paths, nRounds, TRUE);
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("path index", elapsed, nRounds * CFArrayGetCount(paths), found);
+
+	// after a change, only the lookups below the changed top-level key are redone
+	config = CFDictionaryCreateMutableCopy(NULL, 0, SCPreferencesGetValue(prefs, kSCPrefSets));
+	(void) SCPreferencesSetValue(prefs, kSCPrefSets, config);
+	CFRelease(config);
+	elapsed = bench_now_ns();
+	found = bench_lookup_paths(prefs, paths, 1, TRUE);
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("path index (after change)", elapsed, CFArrayGetCount(paths), found);
+
+	CFRelease(prefs);
+	CFRelease(paths);
+	(void) unlink(path);
+	return;
+}
+
+
+#pragma mark -
+#pragma mark SCPreferences write contention
+
+
+#define	BENCH_WRITER_RESULT	"bench.writer: conflicts=%ld failures=%ld"
+
+
+static CFStringRef
+bench_writer_key(CFIndex writer)
+{
+	return CFStringCreateWithFormat(NULL, NULL, CFSTR("Writer-%ld"), (long)writer);
+}
+
+
+/*
+ * bench.writer path lock|optimistic writer commits
+ * - run (in a separate scutil process) by bench.contention
+ */
+__private_extern__
+void
+do_bench_writer(int argc, char **argv)
+{
+#pragma unused(argc)
+	CFIndex		conflicts	= 0;
+	CFIndex		failures	= 0;
+	CFIndex		i;
+	CFStringRef	key;
+	CFIndex		nCommits;
+	Boolean		optimistic;
+	CFStringRef	prefsID;
+
+	optimistic = (strcmp(argv[1], "optimistic") == 0);
+	key = bench_writer_key(strtol(argv[2], NULL, 10));
+	nCommits = strtol(argv[3], NULL, 10);
+	prefsID = CFStringCreateWithCString(NULL, argv[0], kCFStringEncodingUTF8);
+
+	for (i = 0; i < nCommits; i++) {
+		CFNumberRef		count;
+		SCPreferencesRef	prefs;
+		int			val	= (int)(i + 1);
+
+		prefs = SCPreferencesCreate(NULL, CFSTR("scutil bench.writer"), prefsID);
+		if (prefs == NULL) {
+			failures++;
+			continue;
+		}
+
+		if (!optimistic && !SCPreferencesLock(prefs, TRUE)) {
+			failures++;
+			CFRelease(prefs);
+			continue;
+		}
+
+		count = CFNumberCreate(NULL, kCFNumberIntType, &val);
+		(void) SCPreferencesSetValue(prefs, key, count);
+		CFRelease(count);
+
+		if (optimistic) {
+			while (!_SCPreferencesCommitOptimistic(prefs)) {
+				if ((SCError() != kSCStatusStale) || !_SCPreferencesRebase(prefs)) {
+					failures++;
+					break;
+				}
+				conflicts++;
+			}
+		} else {
+			if (!SCPreferencesCommitChanges(prefs)) {
+				failures++;
+			}
+			(void) SCPreferencesUnlock(prefs);
+		}
+
+		CFRelease(prefs);
+	}
+
+	SCPrint(TRUE, stdout, CFSTR(BENCH_WRITER_RESULT "\n"), (long)conflicts, (long)failures);
+	CFRelease(prefsID);
+	CFRelease(key);
+	return;
+}
+
+
+static pid_t
+bench_writer_spawn(const char *path, const char *mode, CFIndex writer, CFIndex nCommits, int *out)
+{
+	char				*argv[]	= { NULL, NULL };
+	char				cmd[MAXPATHLEN + 64];
+	char				exe[MAXPATHLEN];
+	posix_spawn_file_actions_t	actions;
+	int				in_fds[2];
+	int				out_fds[2];
+	pid_t				pid	= -1;
+	uint32_t			size	= sizeof(exe);
+
+	if (_NSGetExecutablePath(exe, &size) != 0) {
+		return -1;
+	}
+	argv[0] = exe;
+
+	if (pipe(in_fds) == -1) {
+		return -1;
+	}
+	if (pipe(out_fds) == -1) {
+		(void) close(in_fds[0]);
+		(void) close(in_fds[1]);
+		return -1;
+	}
+
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, in_fds[0], STDIN_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, out_fds[1], STDOUT_FILENO);
+	posix_spawn_file_actions_addclose(&actions, in_fds[1]);
+	posix_spawn_file_actions_addclose(&actions, out_fds[0]);
+	if (posix_spawn(&pid, exe, &actions, NULL, argv, *_NSGetEnviron()) != 0) {
+		pid = -1;
+	}
+	posix_spawn_file_actions_destroy(&actions);
+	(void) close(in_fds[0]);
+	(void) close(out_fds[1]);
+
+	if (pid != -1) {
+		// the writer reads (and runs) the command, then quits at EOF
+		snprintf(cmd, sizeof(cmd), "bench.writer %s %s %ld %ld\n", path, mode, (long)writer, (long)nCommits);
+		(void) write(in_fds[1], cmd, strlen(cmd));
+		*out = out_fds[0];
+	} else {
+		(void) close(out_fds[0]);
+	}
+	(void) close(in_fds[1]);
+
+	return pid;
+}
+
+
+static void
+bench_contention(const char *path, CFDictionaryRef config, const char *mode, CFIndex nWriters, CFIndex nCommits)
+{
+	CFIndex			conflicts	= 0;
+	CFDataRef		data;
+	uint64_t		elapsed;
+	CFIndex			failures	= 0;
+	CFIndex			i;
+	char			label[64];
+	CFIndex			lost		= 0;
+	int			*outs;
+	pid_t			*pids;
+	SCPreferencesRef	prefs;
+	CFStringRef		prefsID;
+
+	data = CFPropertyListCreateData(NULL, config, kCFPropertyListXMLFormat_v1_0, 0, NULL);
+	if ((data == NULL) || !bench_write_file(path, data)) {
+		if (data != NULL) CFRelease(data);
+		return;
+	}
+	CFRelease(data);
+
+	pids = CFAllocatorAllocate(NULL, nWriters * sizeof(pid_t), 0);
+	outs = CFAllocatorAllocate(NULL, nWriters * sizeof(int), 0);
+
+	elapsed = bench_now_ns();
+	for (i = 0; i < nWriters; i++) {
+		pids[i] = bench_writer_spawn(path, mode, i, nCommits, &outs[i]);
+		if (pids[i] == -1) {
+			SCPrint(TRUE, stdout, CFSTR("could not start writer: %s\n"), strerror(errno));
+		}
+	}
+	for (i = 0; i < nWriters; i++) {
+		char	buf[256];
+		long	c;
+		long	f;
+		ssize_t	n;
+		char	*result;
+		int	status;
+
+		if (pids[i] == -1) {
+			failures += nCommits;
+			continue;
+		}
+
+		n = read(outs[i], buf, sizeof(buf) - 1);
+		buf[(n > 0) ? n : 0] = '\0';
+		(void) close(outs[i]);
+		(void) waitpid(pids[i], &status, 0);
+
+		result = strstr(buf, "bench.writer:");
+		if ((result != NULL) && (sscanf(result, BENCH_WRITER_RESULT, &c, &f) == 2)) {
+			conflicts += c;
+			failures += f;
+		} else {
+			failures += nCommits;
+		}
+	}
+	elapsed = bench_now_ns() - elapsed;
+
+	// check that no commit was lost
+	prefsID = CFStringCreateWithCString(NULL, path, kCFStringEncodingUTF8);
+	prefs = SCPreferencesCreate(NULL, CFSTR("scutil bench.contention"), prefsID);
+	CFRelease(prefsID);
+	for (i = 0; i < nWriters; i++) {
+		CFNumberRef	count	= NULL;
+		CFStringRef	key;
+		int		val	= 0;
+
+		key = bench_writer_key(i);
+		if (prefs != NULL) {
+			count = SCPreferencesGetValue(prefs, key);
+		}
+		if (!isA_CFNumber(count) ||
+		    !CFNumberGetValue(count, kCFNumberIntType, &val) ||
+		    (val != nCommits)) {
+			lost++;
+		}
+		CFRelease(key);
+	}
+	if (prefs != NULL) CFRelease(prefs);
+
+	snprintf(label, sizeof(label), "%s commits", mode);
+	bench_report(label, elapsed, nWriters * nCommits, conflicts);
+	SCPrint(TRUE, stdout, CFSTR("  %-36s %ld failed commits, %ld writers with lost updates\n"),
+		"",
+		(long)failures,
+		(long)lost);
+
+	CFAllocatorDeallocate(NULL, outs);
+	CFAllocatorDeallocate(NULL, pids);
+	(void) unlink(path);
+	return;
+}
+
+
+__private_extern__
+void
+do_bench_contention(int argc, char **argv)
+{
+	CFDictionaryRef		config;
+	CFIndex			nCommits	= 50;
+	CFIndex			nWriters	= 8;
+	char			path[MAXPATHLEN];
+
+	if (argc > 0) {
+		nWriters = strtol(argv[0], NULL, 10);
+		if (nWriters <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid writer count\n"));
+			return;
+		}
+	}
+	if (argc > 1) {
+		nCommits = strtol(argv[1], NULL, 10);
+		if (nCommits <= 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid commit count\n"));
+			return;
+		}
+	}
+
+	SCPrint(TRUE, stdout, CFSTR("SCPreferences write contention, %ld writer processes, %ld commits each\n"),
+		(long)nWriters,
+		(long)nCommits);
+	SCPrint(TRUE, stdout, CFSTR("  (\"matches\" are optimistic commits that had to be rebased)\n"));
+
+	snprintf(path, sizeof(path), "/tmp/scutil-bench-contention-%d.plist", getpid());
+	config = bench_create_prefs(100 * 1024);
+	bench_contention(path, config, "lock", nWriters, nCommits);
+	bench_contention(path, config, "optimistic", nWriters, nCommits);
+	CFRelease(config);
+
+	return;
+}
+
+
+#pragma mark -
+#pragma mark Synthetic network configurations
+
+
+static CFMutableDictionaryRef
+bench_dictionary_create(void)
+{
+	return CFDictionaryCreateMutable(NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+}
+
+
+static void
+bench_set_strings(CFMutableDictionaryRef dict, CFStringRef key, CFStringRef str1, CFStringRef str2)
+{
+	CFArrayRef	array;
+	CFStringRef	strs[2];
+
+	strs[0] = str1;
+	strs[1] = str2;
+	array = CFArrayCreate(NULL, (const void **)strs, (str2 != NULL) ? 2 : 1, &kCFTypeArrayCallBacks);
+	CFDictionarySetValue(dict, key, array);
+	CFRelease(array);
+	return;
+}
+
+
+/*
+ * bench_config_add_interface
+ * - adds an Ethernet interface to the NetworkInterfaces.plist "Interfaces"
+ */
+static void
+bench_config_add_interface(CFMutableArrayRef interfaces, CFIndex unit)
+{
+	CFMutableDictionaryRef	info;
+	CFMutableDictionaryRef	interface;
+	UInt8			mac[6]	= { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	CFDataRef		data;
+	CFNumberRef		num;
+	int			type	= 6;	// IFT_ETHER
+	CFStringRef		str;
+
+	interface = bench_dictionary_create();
+
+	CFDictionarySetValue(interface, CFSTR(kSCNetworkInterfaceActive), kCFBooleanTrue);
+	str = CFStringCreateWithFormat(NULL, NULL, CFSTR("en%ld"), (long)unit);
+	CFDictionarySetValue(interface, CFSTR(kSCNetworkInterfaceBSDName), str);
+	CFRelease(str);
+	CFDictionarySetValue(interface, CFSTR(kSCNetworkInterfaceIOBuiltin), (unit == 0) ? kCFBooleanTrue : kCFBooleanFalse);
+	CFDictionarySetValue(interface, CFSTR(kSCNetworkInterfaceIOInterfaceNamePrefix), CFSTR("en"));
+	num = CFNumberCreate(NULL, kCFNumberIntType, &type);
+	CFDictionarySetValue(interface, CFSTR(kSCNetworkInterfaceIOInterfaceType), num);
+	CFRelease(num);
+	num = CFNumberCreate(NULL, kCFNumberCFIndexType, &unit);
+	CFDictionarySetValue(interface, CFSTR(kSCNetworkInterfaceIOInterfaceUnit), num);
+	CFRelease(num);
+	mac[3] = (UInt8)((unit >> 16) & 0xff);
+	mac[4] = (UInt8)((unit >>  8) & 0xff);
+	mac[5] = (UInt8)( unit        & 0xff);
+	data = CFDataCreate(NULL, mac, sizeof(mac));
+	CFDictionarySetValue(interface, CFSTR(kSCNetworkInterfaceIOMACAddress), data);
+	CFRelease(data);
+	str = CFStringCreateWithFormat(NULL, NULL, CFSTR("IOService:/scutil-bench/en%ld"), (long)unit);
+	CFDictionarySetValue(interface, CFSTR(kSCNetworkInterfaceIOPathMatch), str);
+	CFRelease(str);
+	CFDictionarySetValue(interface, CFSTR(kSCNetworkInterfaceType), kSCValNetInterfaceTypeEthernet);
+
+	info = bench_dictionary_create();
+	str = CFStringCreateWithFormat(NULL, NULL, CFSTR("Ethernet Adapter (en%ld)"), (long)unit);
+	CFDictionarySetValue(info, kSCPropUserDefinedName, str);
+	CFRelease(str);
+	CFDictionarySetValue(interface, CFSTR(kSCNetworkInterfaceInfo), info);
+	CFRelease(info);
+
+	CFArrayAppendValue(interfaces, interface);
+	CFRelease(interface);
+	return;
+}
+
+
+/*
+ * bench_config_create_service
+ * - returns a service (Interface, IPv4, IPv6, DNS, Proxies) for "device"
+ */
+static CFDictionaryRef
+bench_config_create_service(CFStringRef device, CFStringRef name, CFIndex i)
+{
+	CFMutableDictionaryRef	dns;
+	CFMutableDictionaryRef	interface;
+	CFMutableDictionaryRef	ipv4;
+	CFMutableDictionaryRef	ipv6;
+	CFNumberRef		num;
+	CFMutableDictionaryRef	proxies;
+	CFMutableDictionaryRef	service;
+	CFStringRef		str;
+	int			val;
+
+	interface = bench_dictionary_create();
+	CFDictionarySetValue(interface, kSCPropNetInterfaceDeviceName, device);
+	CFDictionarySetValue(interface, kSCPropNetInterfaceHardware, kSCEntNetEthernet);
+	CFDictionarySetValue(interface, kSCPropNetInterfaceType, kSCValNetInterfaceTypeEthernet);
+	CFDictionarySetValue(interface, kSCPropUserDefinedName, name);
+
+	ipv4 = bench_dictionary_create();
+	if ((i % 2) == 0) {
+		CFStringRef	addr;
+
+		addr = CFStringCreateWithFormat(NULL, NULL, CFSTR("10.%ld.%ld.2"), (long)((i >> 8) & 0xff), (long)(i & 0xff));
+		CFDictionarySetValue(ipv4, kSCPropNetIPv4ConfigMethod, kSCValNetIPv4ConfigMethodManual);
+		bench_set_strings(ipv4, kSCPropNetIPv4Addresses, addr, NULL);
+		bench_set_strings(ipv4, kSCPropNetIPv4SubnetMasks, CFSTR("255.255.255.0"), NULL);
+		CFRelease(addr);
+		str = CFStringCreateWithFormat(NULL, NULL, CFSTR("10.%ld.%ld.1"), (long)((i >> 8) & 0xff), (long)(i & 0xff));
+		CFDictionarySetValue(ipv4, kSCPropNetIPv4Router, str);
+		CFRelease(str);
+	} else {
+		CFDictionarySetValue(ipv4, kSCPropNetIPv4ConfigMethod, kSCValNetIPv4ConfigMethodDHCP);
+	}
+
+	ipv6 = bench_dictionary_create();
+	CFDictionarySetValue(ipv6, kSCPropNetIPv6ConfigMethod, kSCValNetIPv6ConfigMethodAutomatic);
+
+	dns = bench_dictionary_create();
+	bench_set_strings(dns, kSCPropNetDNSServerAddresses, CFSTR("10.0.0.53"), CFSTR("2001:db8::53"));
+	str = CFStringCreateWithFormat(NULL, NULL, CFSTR("site%ld.example.com"), (long)i);
+	bench_set_strings(dns, kSCPropNetDNSSearchDomains, str, CFSTR("example.com"));
+	CFRelease(str);
+
+	proxies = bench_dictionary_create();
+	bench_set_strings(proxies, kSCPropNetProxiesExceptionsList, CFSTR("*.local"), CFSTR("169.254/16"));
+	val = 1;
+	num = CFNumberCreate(NULL, kCFNumberIntType, &val);
+	CFDictionarySetValue(proxies, kSCPropNetProxiesFTPPassive, num);
+	if ((i % 4) == 0) {
+		int	port	= 3128;
+
+		CFDictionarySetValue(proxies, kSCPropNetProxiesHTTPEnable, num);
+		CFDictionarySetValue(proxies, kSCPropNetProxiesHTTPProxy, CFSTR("proxy.example.com"));
+		CFRelease(num);
+		num = CFNumberCreate(NULL, kCFNumberIntType, &port);
+		CFDictionarySetValue(proxies, kSCPropNetProxiesHTTPPort, num);
+	}
+	CFRelease(num);
+
+	service = bench_dictionary_create();
+	CFDictionarySetValue(service, kSCEntNetInterface, interface);
+	CFDictionarySetValue(service, kSCEntNetIPv4, ipv4);
+	CFDictionarySetValue(service, kSCEntNetIPv6, ipv6);
+	CFDictionarySetValue(service, kSCEntNetDNS, dns);
+	CFDictionarySetValue(service, kSCEntNetProxies, proxies);
+	CFDictionarySetValue(service, kSCPropUserDefinedName, name);
+
+	CFRelease(proxies);
+	CFRelease(dns);
+	CFRelease(ipv6);
+	CFRelease(ipv4);
+	CFRelease(interface);
+	return service;
+}
+
+
+/*
+ * bench_config_create
+ * - returns (in "ni_config") a NetworkInterfaces.plist with the Ethernet
+ *   interfaces and (as the return value) a preferences.plist with :
+ *     nServices Ethernet services
+ *     nVirtual Bond, Bridge and VLAN interfaces (each with a service), the
+ *       Bond and Bridge members being additional Ethernet interfaces
+ *     nSets sets (the first being current), each with all services
+ */
+static CFDictionaryRef
+bench_config_create(CFIndex nServices, CFIndex nSets, CFIndex nVirtual, CFDictionaryRef *ni_config)
+{
+	CFMutableDictionaryRef	bonds;
+	CFMutableDictionaryRef	bridges;
+	CFIndex			i;
+	CFMutableArrayRef	interfaces;
+	CFIndex			nMembers	= nServices;
+	CFMutableDictionaryRef	ni;
+	CFMutableArrayRef	order;
+	CFMutableDictionaryRef	prefs;
+	CFMutableDictionaryRef	services;
+	CFMutableDictionaryRef	sets;
+	CFStringRef		str;
+	CFMutableDictionaryRef	virtual;
+	CFMutableDictionaryRef	vlans;
+	int			version		= NETWORK_CONFIGURATION_VERSION;
+	CFNumberRef		num;
+
+	interfaces = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	services = bench_dictionary_create();
+	order = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+
+	// Ethernet interfaces and services
+	for (i = 0; i < nServices; i++) {
+		CFStringRef		device;
+		CFStringRef		name;
+		CFDictionaryRef		service;
+		CFStringRef		serviceID;
+
+		bench_config_add_interface(interfaces, i);
+
+		device = CFStringCreateWithFormat(NULL, NULL, CFSTR("en%ld"), (long)i);
+		name = CFStringCreateWithFormat(NULL, NULL, CFSTR("Ethernet %ld"), (long)i);
+		serviceID = CFStringCreateWithFormat(NULL, NULL, CFSTR("E%07lX-0000-4000-8000-000000000000"), (long)i);
+		service = bench_config_create_service(device, name, i);
+		CFDictionarySetValue(services, serviceID, service);
+		CFArrayAppendValue(order, serviceID);
+		CFRelease(service);
+		CFRelease(serviceID);
+		CFRelease(name);
+		CFRelease(device);
+	}
+
+	// Bond, Bridge and VLAN interfaces (and services)
+	bonds = bench_dictionary_create();
+	bridges = bench_dictionary_create();
+	vlans = bench_dictionary_create();
+	for (i = 0; i < nVirtual; i++) {
+		CFMutableDictionaryRef	config;
+		CFStringRef		device;
+		CFStringRef		member1;
+		CFStringRef		member2;
+		CFStringRef		name;
+		CFDictionaryRef		service;
+		CFStringRef		serviceID;
+		int			tag;
+		int			type;
+
+		for (type = 0; type < 3; type++) {
+			config = bench_dictionary_create();
+			switch (type) {
+				case 0 :
+				case 1 :
+					// two (otherwise unused) Ethernet members
+					bench_config_add_interface(interfaces, nMembers);
+					bench_config_add_interface(interfaces, nMembers + 1);
+					member1 = CFStringCreateWithFormat(NULL, NULL, CFSTR("en%ld"), (long)nMembers);
+					member2 = CFStringCreateWithFormat(NULL, NULL, CFSTR("en%ld"), (long)(nMembers + 1));
+					nMembers += 2;
+					if (type == 0) {
+						device = CFStringCreateWithFormat(NULL, NULL, CFSTR("bond%ld"), (long)i);
+						bench_set_strings(config, kSCPropVirtualNetworkInterfacesBondInterfaces, member1, member2);
+						CFDictionarySetValue(bonds, device, config);
+					} else {
+						device = CFStringCreateWithFormat(NULL, NULL, CFSTR("bridge%ld"), (long)i);
+						bench_set_strings(config, kSCPropVirtualNetworkInterfacesBridgeInterfaces, member1, member2);
+						CFDictionarySetValue(bridges, device, config);
+					}
+					CFRelease(member1);
+					CFRelease(member2);
+					break;
+				default :
+					// tagged, on one of the Ethernet interfaces
+					device = CFStringCreateWithFormat(NULL, NULL, CFSTR("vlan%ld"), (long)i);
+					member1 = CFStringCreateWithFormat(NULL, NULL, CFSTR("en%ld"), (long)((nServices > 0) ? i % nServices : 0));
+					CFDictionarySetValue(config, kSCPropVirtualNetworkInterfacesVLANInterface, member1);
+					CFRelease(member1);
+					tag = (int)(100 + i);
+					num = CFNumberCreate(NULL, kCFNumberIntType, &tag);
+					CFDictionarySetValue(config, kSCPropVirtualNetworkInterfacesVLANTag, num);
+					CFRelease(num);
+					CFDictionarySetValue(vlans, device, config);
+					break;
+			}
+			name = CFStringCreateWithFormat(NULL, NULL, CFSTR("Virtual %@"), device);
+			CFDictionarySetValue(config, kSCPropUserDefinedName, name);
+			CFRelease(config);
+
+			serviceID = CFStringCreateWithFormat(NULL, NULL, CFSTR("V%07lX-0000-4000-8000-00000000000%d"), (long)i, type);
+			service = bench_config_create_service(device, name, nServices + (3 * i) + type);
+			CFDictionarySetValue(services, serviceID, service);
+			CFArrayAppendValue(order, serviceID);
+			CFRelease(service);
+			CFRelease(serviceID);
+			CFRelease(name);
+			CFRelease(device);
+		}
+	}
+	virtual = bench_dictionary_create();
+	if (nVirtual > 0) {
+		CFDictionarySetValue(virtual, kSCNetworkInterfaceTypeBond, bonds);
+		CFDictionarySetValue(virtual, kSCNetworkInterfaceTypeBridge, bridges);
+		CFDictionarySetValue(virtual, kSCNetworkInterfaceTypeVLAN, vlans);
+	}
+	CFRelease(bonds);
+	CFRelease(bridges);
+	CFRelease(vlans);
+
+	// sets (locations)
+	sets = bench_dictionary_create();
+	for (i = 0; i < nSets; i++) {
+		CFMutableDictionaryRef	global;
+		CFMutableDictionaryRef	ipv4;
+		CFIndex			j;
+		CFMutableDictionaryRef	network;
+		CFIndex			n;
+		CFMutableDictionaryRef	set;
+		CFMutableDictionaryRef	setServices;
+		CFStringRef		setID;
+
+		setServices = bench_dictionary_create();
+		n = CFArrayGetCount(order);
+		for (j = 0; j < n; j++) {
+			CFMutableDictionaryRef	link;
+			CFStringRef		serviceID	= CFArrayGetValueAtIndex(order, j);
+
+			link = bench_dictionary_create();
+			str = SCPreferencesPathKeyCreateNetworkServiceEntity(NULL, serviceID, NULL);
+			CFDictionarySetValue(link, kSCResvLink, str);
+			CFRelease(str);
+			CFDictionarySetValue(setServices, serviceID, link);
+			CFRelease(link);
+		}
+
+		ipv4 = bench_dictionary_create();
+		CFDictionarySetValue(ipv4, kSCPropNetServiceOrder, order);
+		global = bench_dictionary_create();
+		CFDictionarySetValue(global, kSCEntNetIPv4, ipv4);
+		CFRelease(ipv4);
+
+		network = bench_dictionary_create();
+		CFDictionarySetValue(network, kSCCompGlobal, global);
+		CFDictionarySetValue(network, kSCCompService, setServices);
+		CFRelease(global);
+		CFRelease(setServices);
+
+		set = bench_dictionary_create();
+		CFDictionarySetValue(set, kSCCompNetwork, network);
+		str = CFStringCreateWithFormat(NULL, NULL, CFSTR("Location %ld"), (long)i);
+		CFDictionarySetValue(set, kSCPropUserDefinedName, str);
+		CFRelease(str);
+		CFRelease(network);
+
+		setID = CFStringCreateWithFormat(NULL, NULL, CFSTR("L%07lX-0000-4000-8000-000000000000"), (long)i);
+		CFDictionarySetValue(sets, setID, set);
+		CFRelease(set);
+		CFRelease(setID);
+	}
+
+	prefs = bench_dictionary_create();
+	CFDictionarySetValue(prefs, kSCPrefNetworkServices, services);
+	CFDictionarySetValue(prefs, kSCPrefSets, sets);
+	if (nSets > 0) {
+		str = SCPreferencesPathKeyCreateSet(NULL, CFSTR("L0000000-0000-4000-8000-000000000000"));
+		CFDictionarySetValue(prefs, kSCPrefCurrentSet, str);
+		CFRelease(str);
+	}
+	if (CFDictionaryGetCount(virtual) > 0) {
+		CFDictionarySetValue(prefs, kSCPrefVirtualNetworkInterfaces, virtual);
+	}
+	num = CFNumberCreate(NULL, kCFNumberIntType, &version);
+	CFDictionarySetValue(prefs, CFSTR("__VERSION__"), num);
+	CFRelease(num);
+	CFDictionarySetValue(prefs, CFSTR("Model"), CFSTR("scutil-bench"));
+	CFRelease(virtual);
+	CFRelease(sets);
+	CFRelease(order);
+	CFRelease(services);
+
+	ni = bench_dictionary_create();
+	CFDictionarySetValue(ni, CFSTR("Interfaces"), interfaces);
+	CFDictionarySetValue(ni, CFSTR("Model"), CFSTR("scutil-bench"));
+	CFRelease(interfaces);
+	*ni_config = ni;
+
+	return prefs;
+}
+
+
+static Boolean
+bench_config_write(const char *dir, CFIndex nServices, CFIndex nSets, CFIndex nVirtual)
+{
+	CFDictionaryRef		config;
+	CFDataRef		data;
+	CFDictionaryRef		ni_config;
+	Boolean			ok;
+	char			path[MAXPATHLEN];
+
+	if ((mkdir(dir, 0755) == -1) && (errno != EEXIST)) {
+		SCPrint(TRUE, stdout, CFSTR("could not create \"%s\": %s\n"), dir, strerror(errno));
+		return FALSE;
+	}
+
+	config = bench_config_create(nServices, nSets, nVirtual, &ni_config);
+
+	snprintf(path, sizeof(path), "%s/%s", dir, PREFS_DEFAULT_CONFIG_PLIST);
+	data = CFPropertyListCreateData(NULL, config, kCFPropertyListXMLFormat_v1_0, 0, NULL);
+	ok = (data != NULL) && bench_write_file(path, data);
+	if (ok) {
+		SCPrint(TRUE, stdout, CFSTR("  %s, %ld bytes\n"), path, (long)CFDataGetLength(data));
+	}
+	if (data != NULL) CFRelease(data);
+
+	snprintf(path, sizeof(path), "%s/%s", dir, INTERFACES_DEFAULT_CONFIG_PLIST);
+	data = CFPropertyListCreateData(NULL, ni_config, kCFPropertyListXMLFormat_v1_0, 0, NULL);
+	ok = ok && (data != NULL) && bench_write_file(path, data);
+	if (ok) {
+		SCPrint(TRUE, stdout, CFSTR("  %s, %ld bytes\n"), path, (long)CFDataGetLength(data));
+	}
+	if (data != NULL) CFRelease(data);
+
+	CFRelease(ni_config);
+	CFRelease(config);
+	return ok;
+}
+
+
+static Boolean
+bench_config_copy_file(const char *from, const char *to, const char *file)
+{
+	CFMutableDataRef	data;
+	int			fd;
+	Boolean			ok;
+	char			path[MAXPATHLEN];
+	struct stat		statBuf;
+
+	snprintf(path, sizeof(path), "%s/%s", from, file);
+	fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		if (errno == ENOENT) {
+			// if not present, nothing to copy
+			return TRUE;
+		}
+		SCPrint(TRUE, stdout, CFSTR("could not open \"%s\": %s\n"), path, strerror(errno));
+		return FALSE;
+	}
+	if (fstat(fd, &statBuf) == -1) {
+		SCPrint(TRUE, stdout, CFSTR("could not stat \"%s\": %s\n"), path, strerror(errno));
+		(void) close(fd);
+		return FALSE;
+	}
+	data = CFDataCreateMutable(NULL, 0);
+	CFDataSetLength(data, (CFIndex)statBuf.st_size);
+	ok = (read(fd, CFDataGetMutableBytePtr(data), (size_t)statBuf.st_size) == (ssize_t)statBuf.st_size);
+	(void) close(fd);
+	if (!ok) {
+		SCPrint(TRUE, stdout, CFSTR("could not read \"%s\"\n"), path);
+		CFRelease(data);
+		return FALSE;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s", to, file);
+	ok = bench_write_file(path, data);
+	CFRelease(data);
+	return ok;
+}
+
+
+/*
+ * bench_config_copy
+ *
+ * Copies a (captured) configuration so that the benchmark, which changes
+ * and commits the preferences, never touches the original.
+ */
+static Boolean
+bench_config_copy(const char *from, const char *to)
+{
+	if ((mkdir(to, 0755) == -1) && (errno != EEXIST)) {
+		SCPrint(TRUE, stdout, CFSTR("could not create \"%s\": %s\n"), to, strerror(errno));
+		return FALSE;
+	}
+
+	return bench_config_copy_file(from, to, PREFS_DEFAULT_CONFIG_PLIST) &&
+	       bench_config_copy_file(from, to, INTERFACES_DEFAULT_CONFIG_PLIST);
+}
+
+
+static Boolean
+bench_config_args(int argc, char **argv, CFIndex *nServices, CFIndex *nSets, CFIndex *nVirtual)
+{
+	char	*end;
+
+	if (argc > 0) {
+		*nServices = strtol(argv[0], &end, 10);
+		if ((*end != '\0') || (*nServices <= 0)) {
+			SCPrint(TRUE, stdout, CFSTR("invalid service count (or no directory) \"%s\"\n"), argv[0]);
+			return FALSE;
+		}
+	}
+	if (argc > 1) {
+		*nSets = strtol(argv[1], &end, 10);
+		if ((*end != '\0') || (*nSets <= 0)) {
+			SCPrint(TRUE, stdout, CFSTR("invalid set count\n"));
+			return FALSE;
+		}
+	}
+	if (argc > 2) {
+		*nVirtual = strtol(argv[2], &end, 10);
+		if ((*end != '\0') || (*nVirtual < 0)) {
+			SCPrint(TRUE, stdout, CFSTR("invalid virtual interface count\n"));
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+
+__private_extern__
+void
+do_bench_generate(int argc, char **argv)
+{
+	CFIndex		nServices	= 1000;
+	CFIndex		nSets		= 4;
+	CFIndex		nVirtual	= 100;
+
+	if (!bench_config_args(argc - 1, argv + 1, &nServices, &nSets, &nVirtual)) {
+		return;
+	}
+
+	SCPrint(TRUE, stdout, CFSTR("network configuration, %ld services, %ld sets, %ld bond/bridge/VLAN interfaces\n"),
+		(long)nServices,
+		(long)nSets,
+		(long)nVirtual);
+	(void) bench_config_write(argv[0], nServices, nSets, nVirtual);
+	return;
+}
+
+
+static SCPreferencesRef
+bench_config_open(CFStringRef prefsID)
+{
+	SCPreferencesRef	prefs;
+
+	prefs = SCPreferencesCreate(NULL, CFSTR("scutil bench.config"), prefsID);
+	if (prefs == NULL) {
+		SCPrint(TRUE, stdout, CFSTR("SCPreferencesCreate() failed: %s\n"), SCErrorString(SCError()));
+	}
+	return prefs;
+}
+
+
+static void
+bench_config(const char *dir, CFIndex nIterations)
+{
+	CFIndex			count;
+	uint64_t		elapsed;
+	CFIndex			i;
+	CFIndex			n;
+	CFMutableArrayRef	paths;
+	char			path[MAXPATHLEN];
+	SCPreferencesRef	prefs;
+	CFStringRef		prefsID;
+	CFDictionaryRef		services;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, PREFS_DEFAULT_CONFIG_PLIST);
+	prefsID = CFStringCreateWithCString(NULL, path, kCFStringEncodingUTF8);
+
+	// open + access (parse)
+	elapsed = 0;
+	for (i = 0; i < nIterations; i++) {
+		uint64_t	start;
+
+		__SCPreferencesCacheFlush();
+		start = bench_now_ns();
+		prefs = bench_config_open(prefsID);
+		if (prefs == NULL) {
+			CFRelease(prefsID);
+			return;
+		}
+		(void) SCPreferencesGetValue(prefs, kSCPrefNetworkServices);
+		elapsed += bench_now_ns() - start;
+		CFRelease(prefs);
+	}
+	bench_report("open + access", elapsed, nIterations, 0);
+
+	prefs = bench_config_open(prefsID);
+	if (prefs == NULL) {
+		CFRelease(prefsID);
+		return;
+	}
+
+	// the per-service entity paths
+	paths = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	services = SCPreferencesGetValue(prefs, kSCPrefNetworkServices);
+	n = isA_CFDictionary(services) ? CFDictionaryGetCount(services) : 0;
+	if (n > 0) {
+		const void	**keys;
+
+		keys = CFAllocatorAllocate(NULL, n * sizeof(CFTypeRef), 0);
+		CFDictionaryGetKeysAndValues(services, keys, NULL);
+		for (i = 0; i < n; i++) {
+			CFStringRef	entityPath;
+
+			entityPath = SCPreferencesPathKeyCreateNetworkServiceEntity(NULL, keys[i], kSCEntNetDNS);
+			CFArrayAppendValue(paths, entityPath);
+			CFRelease(entityPath);
+		}
+		CFAllocatorDeallocate(NULL, keys);
+	}
+	SCPrint(TRUE, stdout, CFSTR("  (%ld services)\n"), (long)n);
+
+	// path get
+	count = 0;
+	elapsed = bench_now_ns();
+	for (i = 0; i < nIterations; i++) {
+		CFIndex	j;
+
+		for (j = 0; j < n; j++) {
+			if (SCPreferencesPathGetValue(prefs, CFArrayGetValueAtIndex(paths, j)) != NULL) {
+				count++;
+			}
+		}
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("SCPreferencesPathGetValue", elapsed, nIterations * n, count);
+
+	// path set
+	count = 0;
+	elapsed = bench_now_ns();
+	for (i = 0; i < nIterations; i++) {
+		CFIndex	j;
+
+		for (j = 0; j < n; j++) {
+			CFDictionaryRef		dns;
+			CFMutableDictionaryRef	newDNS;
+			CFStringRef		entityPath	= CFArrayGetValueAtIndex(paths, j);
+
+			dns = SCPreferencesPathGetValue(prefs, entityPath);
+			if (dns == NULL) {
+				continue;
+			}
+			newDNS = CFDictionaryCreateMutableCopy(NULL, 0, dns);
+			CFDictionarySetValue(newDNS, kSCPropNetDNSDomainName, (i & 1) ? CFSTR("odd.example.com") : CFSTR("even.example.com"));
+			if (SCPreferencesPathSetValue(prefs, entityPath, newDNS)) {
+				count++;
+			}
+			CFRelease(newDNS);
+		}
+	}
+	elapsed = bench_now_ns() - elapsed;
+	bench_report("SCPreferencesPathSetValue", elapsed, nIterations * n, count);
+
+	// commit
+	elapsed = 0;
+	count = 0;
+	for (i = 0; i < nIterations; i++) {
+		uint64_t	start;
+
+		(void) SCPreferencesSetValue(prefs, CFSTR("bench"), (i & 1) ? kCFBooleanTrue : kCFBooleanFalse);
+		start = bench_now_ns();
+		if (SCPreferencesCommitChanges(prefs)) {
+			count++;
+		}
+		elapsed += bench_now_ns() - start;
+	}
+	bench_report("SCPreferencesCommitChanges", elapsed, nIterations, count);
+
+	CFRelease(paths);
+	CFRelease(prefs);
+
+	// sets and their services (fresh session each pass, so nothing is cached)
+	count = 0;
+	elapsed = 0;
+	for (i = 0; i < nIterations; i++) {
+		CFIndex		j;
+		CFArrayRef	sets;
+		uint64_t	start;
+
+		prefs = bench_config_open(prefsID);
+		if (prefs == NULL) {
+			break;
+		}
+		start = bench_now_ns();
+		sets = SCNetworkSetCopyAll(prefs);
+		n = (sets != NULL) ? CFArrayGetCount(sets) : 0;
+		for (j = 0; j < n; j++) {
+			CFArrayRef	setServices;
+
+			setServices = SCNetworkSetCopyServices(CFArrayGetValueAtIndex(sets, j));
+			if (setServices != NULL) {
+				count += CFArrayGetCount(setServices);
+				CFRelease(setServices);
+			}
+		}
+		elapsed += bench_now_ns() - start;
+		if (sets != NULL) CFRelease(sets);
+		CFRelease(prefs);
+	}
+	bench_report("SCNetworkSetCopyServices (all sets)", elapsed, nIterations, count);
+
+	// virtual interfaces
+	count = 0;
+	elapsed = 0;
+	for (i = 0; i < nIterations; i++) {
+		CFArrayRef	bonds;
+		uint64_t	start;
+
+		prefs = bench_config_open(prefsID);
+		if (prefs == NULL) {
+			break;
+		}
+		start = bench_now_ns();
+		bonds = SCBondInterfaceCopyAll(prefs);
+		elapsed += bench_now_ns() - start;
+		if (bonds != NULL) {
+			count += CFArrayGetCount(bonds);
+			CFRelease(bonds);
+		}
+		CFRelease(prefs);
+	}
+	bench_report("SCBondInterfaceCopyAll", elapsed, nIterations, count);
+
+	count = 0;
+	elapsed = 0;
+	for (i = 0; i < nIterations; i++) {
+		CFArrayRef	bridges;
+		uint64_t	start;
+
+		prefs = bench_config_open(prefsID);
+		if (prefs == NULL) {
+			break;
+		}
+		start = bench_now_ns();
+		bridges = SCBridgeInterfaceCopyAll(prefs);
+		elapsed += bench_now_ns() - start;
+		if (bridges != NULL) {
+			count += CFArrayGetCount(bridges);
+			CFRelease(bridges);
+		}
+		CFRelease(prefs);
+	}
+	bench_report("SCBridgeInterfaceCopyAll", elapsed, nIterations, count);
+
+	count = 0;
+	elapsed = 0;
+	for (i = 0; i < nIterations; i++) {
+		CFArrayRef	vlans;
+		uint64_t	start;
+
+		prefs = bench_config_open(prefsID);
+		if (prefs == NULL) {
+			break;
+		}
+		start = bench_now_ns();
+		vlans = SCVLANInterfaceCopyAll(prefs);
+		elapsed += bench_now_ns() - start;
+		if (vlans != NULL) {
+			count += CFArrayGetCount(vlans);
+			CFRelease(vlans);
+		}
+		CFRelease(prefs);
+	}
+	bench_report("SCVLANInterfaceCopyAll", elapsed, nIterations, count);
+
+	CFRelease(prefsID);
+	return;
+}
+
+
+__private_extern__
+void
+do_bench_config(int argc, char **argv)
+{
+	char		dir[MAXPATHLEN];
+	CFIndex		nIterations	= 10;
+	CFIndex		nServices	= 1000;
+	CFIndex		nSets		= 4;
+	CFIndex		nVirtual	= 100;
+	Boolean		ok;
+	char		path[MAXPATHLEN];
+	struct stat	statBuf;
+
+	snprintf(dir, sizeof(dir), "/tmp/scutil-bench-config-%d", getpid());
+
+	if ((argc > 0) && (stat(argv[0], &statBuf) == 0) && S_ISDIR(statBuf.st_mode)) {
+		// an existing (generated or captured) configuration, benchmarked on a copy
+		SCPrint(TRUE, stdout, CFSTR("network configuration in \"%s\"\n"), argv[0]);
+		ok = bench_config_copy(argv[0], dir);
+	} else {
+		if (!bench_config_args(argc, argv, &nServices, &nSets, &nVirtual)) {
+			return;
+		}
+
+		SCPrint(TRUE, stdout, CFSTR("network configuration, %ld services, %ld sets, %ld bond/bridge/VLAN interfaces, %ld iterations\n"),
+			(long)nServices,
+			(long)nSets,
+			(long)nVirtual,
+			(long)nIterations);
+
+		ok = bench_config_write(dir, nServices, nSets, nVirtual);
+	}
+	if (ok) {
+		bench_config(dir, nIterations);
+	}
+
+	snprintf(path, sizeof(path), "%s/%s", dir, PREFS_DEFAULT_CONFIG_PLIST);
+	(void) unlink(path);
+	snprintf(path, sizeof(path), "%s/%s", dir, INTERFACES_DEFAULT_CONFIG_PLIST);
+	(void) unlink(path);
+	(void) rmdir(dir);
+	return;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2026 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+void	do_bench_keys		(int argc, char **argv);
+void	do_bench_notify		(int argc, char **argv);
+void	do_bench_merged		(int argc, char **argv);
+void	do_bench_plist		(int argc, char **argv);
+void	do_bench_prefs		(int argc, char **argv);
+void	do_bench_paths		(int argc, char **argv);
+void	do_bench_contention	(int argc, char **argv);
+void	do_bench_writer		(int argc, char **argv);
+void	do_bench_generate	(int argc, char **argv);
+void	do_bench_config		(int argc, char **argv);
+
+__END_DECLS
+
+#endif	/* !_BENCH_H */
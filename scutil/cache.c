@@ -42,6 +42,44 @@
 #pragma mark SCDynamicStore "cache"
 
 
+__private_extern__
+void
+do_cache(int argc, char **argv)
+{
+	if ((argc < 1) || (strcasecmp(argv[0], "stats") == 0)) {
+		SCDynamicStoreReadCacheStatistics	stats;
+
+		if (!_SCDynamicStoreReadCacheGetStatistics(store, &stats)) {
+			SCPrint(TRUE, stdout, CFSTR("  read cache not enabled\n"));
+			return;
+		}
+
+		SCPrint(TRUE, stdout, CFSTR("  keys          = %ld\n"), (long)stats.keys);
+		SCPrint(TRUE, stdout, CFSTR("  hits          = %llu\n"), stats.hits);
+		SCPrint(TRUE, stdout, CFSTR("  misses        = %llu\n"), stats.misses);
+		SCPrint(TRUE, stdout, CFSTR("  invalidations = %llu\n"), stats.invalidations);
+		SCPrint(TRUE, stdout, CFSTR("  flushes       = %llu\n"), stats.flushes);
+		return;
+	}
+
+	if        ((strcasecmp(argv[0], "on"   ) == 0) ||
+		   (strcasecmp(argv[0], "1"    ) == 0)) {
+		if (!_SCDynamicStoreReadCacheEnable(store, TRUE)) {
+			SCPrint(TRUE, stdout, CFSTR("  %s\n"), SCErrorString(SCError()));
+		}
+	} else if ((strcasecmp(argv[0], "off"  ) == 0) ||
+		   (strcasecmp(argv[0], "0"    ) == 0)) {
+		(void) _SCDynamicStoreReadCacheEnable(store, FALSE);
+	} else if (strcasecmp(argv[0], "flush") == 0) {
+		_SCDynamicStoreReadCacheInvalidate(store, NULL);
+	} else {
+		SCPrint(TRUE, stdout, CFSTR("invalid value\n"));
+	}
+
+	return;
+}
+
+
 #pragma mark -
 #pragma mark SCDynamicStore operations
 
@@ -121,9 +159,6 @@ sort_keys(const void *p1, const void *p2, void *context)
 }
 
 
-#define	N_QUICK	64
-
-
 __private_extern__
 void
 do_list(int argc, char **argv)
@@ -133,52 +168,20 @@ do_list(int argc, char **argv)
 	CFArrayRef			list;
 	CFIndex				listCnt;
 	CFMutableArrayRef		sortedList;
-	SCDynamicStorePrivateRef	storePrivate	= (SCDynamicStorePrivateRef)store;
 
 	pattern = CFStringCreateWithCString(NULL,
 					    (argc >= 1) ? argv[0] : ".*",
 					    kCFStringEncodingUTF8);
 
-	list = SCDynamicStoreCopyKeyList(store, pattern);
+	list = _SCDynamicStoreCopyKeyListMerged(store, pattern);
 	CFRelease(pattern);
 	if (list == NULL) {
 		if (SCError() != kSCStatusOK) {
 			SCPrint(TRUE, stdout, CFSTR("  %s\n"), SCErrorString(SCError()));
-			return;
 		} else {
-		    if (!_SCDynamicStoreCacheIsActive(store)) {
 			SCPrint(TRUE, stdout, CFSTR("  no keys.\n"));
-			return;
-		    } else {
-			CFIndex	n;
-
-			n = (storePrivate->cached_set != NULL)
-				? CFDictionaryGetCount(storePrivate->cached_set) : 0;
-			if (n > 0) {
-				const void *	cachedKeys_q[N_QUICK];
-				const void **	cachedKeys	= cachedKeys_q;
-
-				if (n > (CFIndex)(sizeof(cachedKeys_q) / sizeof(CFStringRef))) {
-					cachedKeys = CFAllocatorAllocate(NULL, n * sizeof(CFStringRef), 0);
-				}
-				CFDictionaryGetKeysAndValues(storePrivate->cached_set, cachedKeys, NULL);
-				list = CFArrayCreate(NULL, cachedKeys, n, &kCFTypeArrayCallBacks);
-				if (cachedKeys != cachedKeys_q) {
-					CFAllocatorDeallocate(NULL, cachedKeys);
-				}
-			} else {
-				SCPrint(TRUE, stdout, CFSTR("  no keys.\n"));
-				return;
-			}
-		    }
 		}
-	} else if (_SCDynamicStoreCacheIsActive(store) &&
-		   (((storePrivate->cached_set != NULL) &&
-		     (CFDictionaryGetCount(storePrivate->cached_set) > 0)) ||
-		    ((storePrivate->cached_removals != NULL) &&
-		     (CFArrayGetCount(storePrivate->cached_removals) > 0)))) {
-		SCPrint(TRUE, stdout,
-			CFSTR("  Note: SCDynamicStore transactions in progress, key list (below) may be out of date.\n\n"));
+		return;
 	}
 
 	listCnt = CFArrayGetCount(list);
@@ -219,6 +222,7 @@ do_add(int argc, char **argv)
 			if (!SCDynamicStoreAddValue(store, key, value)) {
 				SCPrint(TRUE, stdout, CFSTR("  %s\n"), SCErrorString(SCError()));
 			}
+			_SCDynamicStoreReadCacheInvalidate(store, key);
 		} else {
 			SCPrint(TRUE, stdout, CFSTR("  Cannot \"add\" with block\n"));
 		}
@@ -227,6 +231,7 @@ do_add(int argc, char **argv)
 			if (!SCDynamicStoreAddTemporaryValue(store, key, value)) {
 				SCPrint(TRUE, stdout, CFSTR("  %s\n"), SCErrorString(SCError()));
 			}
+			_SCDynamicStoreReadCacheInvalidate(store, key);
 		} else {
 			SCPrint(TRUE, stdout, CFSTR("  Cannot \"add temporary\" with block\n"));
 		}
@@ -246,7 +251,7 @@ do_get(int argc, char **argv)
 	CFPropertyListRef	newValue;
 
 	key      = CFStringCreateWithCString(NULL, argv[0], kCFStringEncodingUTF8);
-	newValue = SCDynamicStoreCopyValue(store, key);
+	newValue = _SCDynamicStoreReadCacheCopyValue(store, key);
 	CFRelease(key);
 	if (newValue == NULL) {
 		SCPrint(TRUE, stdout, CFSTR("  %s\n"), SCErrorString(SCError()));
@@ -273,6 +278,7 @@ do_set(int argc, char **argv)
 	if (!SCDynamicStoreSetValue(store, key, value)) {
 		SCPrint(TRUE, stdout, CFSTR("  %s\n"), SCErrorString(SCError()));
 	}
+	_SCDynamicStoreReadCacheInvalidate(store, key);
 	CFRelease(key);
 	return;
 }
@@ -288,51 +294,12 @@ do_show(int argc, char **argv)
 	key = CFStringCreateWithCString(NULL, argv[0], kCFStringEncodingUTF8);
 
 	if (argc == 1) {
-		newValue = SCDynamicStoreCopyValue(store, key);
+		newValue = _SCDynamicStoreReadCacheCopyValue(store, key);
 	} else {
 		CFArrayRef	patterns;
 
 		patterns = CFArrayCreate(NULL, (const void **)&key, 1, &kCFTypeArrayCallBacks);
-		if (!_SCDynamicStoreCacheIsActive(store)) {
-			newValue = SCDynamicStoreCopyMultiple(store, NULL, patterns);
-		} else {
-			CFArrayRef			keys;
-			CFMutableDictionaryRef		newDict;
-			SCDynamicStorePrivateRef	storePrivate	= (SCDynamicStorePrivateRef)store;
-
-			newDict = CFDictionaryCreateMutable(NULL,
-							    0,
-							    &kCFTypeDictionaryKeyCallBacks,
-							    &kCFTypeDictionaryValueCallBacks);
-			keys = SCDynamicStoreCopyKeyList(store, key);
-			if (keys != NULL) {
-				CFIndex		i;
-				CFIndex		n;
-
-				n = CFArrayGetCount(keys);
-				for (i = 0; i < n; i++) {
-					CFStringRef	storeKey;
-					CFTypeRef	storeVal;
-
-					storeKey = CFArrayGetValueAtIndex(keys, i);
-					storeVal = SCDynamicStoreCopyValue(store, storeKey);
-					if (storeVal != NULL) {
-						CFDictionarySetValue(newDict, storeKey, storeVal);
-						CFRelease(storeVal);
-					}
-				}
-				CFRelease(keys);
-			}
-
-			if (((storePrivate->cached_set != NULL) &&
-			     (CFDictionaryGetCount(storePrivate->cached_set) > 0)) ||
-			    ((storePrivate->cached_removals != NULL) &&
-			     (CFArrayGetCount(storePrivate->cached_removals) > 0))) {
-				SCPrint(TRUE, stdout, CFSTR("  Note: SCDynamicStore locked, keys included (below) may be out of date.\n\n"));
-			}
-
-			newValue = newDict;
-		}
+		newValue = _SCDynamicStoreCopyMultipleMerged(store, NULL, patterns);
 		CFRelease(patterns);
 	}
 
@@ -359,6 +326,7 @@ do_remove(int argc, char **argv)
 	if (!SCDynamicStoreRemoveValue(store, key)) {
 		SCPrint(TRUE, stdout, CFSTR("  %s\n"), SCErrorString(SCError()));
 	}
+	_SCDynamicStoreReadCacheInvalidate(store, key);
 	CFRelease(key);
 	return;
 }
@@ -375,6 +343,7 @@ do_notify(int argc, char **argv)
 	if (!SCDynamicStoreNotifyValue(store, key)) {
 		SCPrint(TRUE, stdout, CFSTR("  %s\n"), SCErrorString(SCError()));
 	}
+	_SCDynamicStoreReadCacheInvalidate(store, key);
 	CFRelease(key);
 	return;
 }
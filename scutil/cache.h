@@ -41,6 +41,7 @@
 __BEGIN_DECLS
 
 void	do_block		(int argc, char **argv);
+void	do_cache		(int argc, char **argv);
 
 void	do_list			(int argc, char **argv);
 void	do_add			(int argc, char **argv);
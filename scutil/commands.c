@@ -44,6 +44,7 @@
 #include "tests.h"
 #include "net.h"
 #include "prefs.h"
+#include "bench.h"
 
 
 __private_extern__
@@ -92,6 +93,9 @@ const cmdInfo commands_store[] = {
 	{ "block",	0,	1,	do_block,		3,	1,
 		" block [\"begin\" | \"end\"]     : block multiple data store transactions"	},
 
+	{ "cache",	0,	1,	do_cache,		3,	2,
+		" cache [\"on\"|\"off\"|\"flush\"]    : read-through value cache"	},
+
 	{ "list",	0,	2,	do_list,		4,	0,
 		" list [pattern]                : list keys in data store"			},
 
@@ -125,8 +129,8 @@ const cmdInfo commands_store[] = {
 	{ "n.changes",	0,	0,	do_notify_changes,	5,	0,
 		" n.changes                     : list changed keys"				},
 
-	{ "n.watch",	0,	0,	do_notify_watch,	5,	0,
-		" n.watch                       : watch for changes"				},
+	{ "n.watch",	0,	2,	do_notify_watch,	5,	0,
+		" n.watch [values [max]]        : watch for changes (values are re-read; not a payload mode)"	},
 
 	{ "n.wait",	0,	0,	do_notify_wait,		5,	2,
 		" n.wait                        : wait for changes"				},
@@ -137,8 +141,43 @@ const cmdInfo commands_store[] = {
 	{ "n.cancel",	0,	1,	do_notify_cancel,	5,	0,
 		" n.cancel                      : cancel notification requests"			},
 
-	{ "snapshot",	0,	1,	do_snapshot,		99,	2,
-		" snapshot [file]               : save snapshot of store and session data"	}
+	{ "snapshot",	0,	3,	do_snapshot,		99,	2,
+		" snapshot [file]               : save snapshot of store and session data\n"
+		" snapshot -b file              : save binary snapshot of store\n"
+		" snapshot -d base-file file    : save binary snapshot of changes since base-file"	},
+
+	{ "snapshot.restore",	1,	1,	do_snapshot_restore,	99,	2,
+		" snapshot.restore file         : restore (replay) binary snapshot into store"	},
+
+	{ "bench.keys",	0,	2,	do_bench_keys,		99,	2,
+		" bench.keys [nkeys [queries]]  : benchmark key index vs. regex key queries"	},
+
+	{ "bench.notify",	0,	3,	do_bench_notify,	99,	2,
+		" bench.notify [n [p [c]]]      : benchmark notification routing (n sessions, p patterns, c changes)"	},
+
+	{ "bench.merged",	0,	2,	do_bench_merged,	99,	2,
+		" bench.merged [n [rounds]]     : benchmark key list / values merged with n pending changes"	},
+
+	{ "bench.plist",	0,	1,	do_bench_plist,		99,	2,
+		" bench.plist [file]            : benchmark XML property list parsing (1KB - 10MB, or file)"	},
+
+	{ "bench.prefs",	0,	2,	do_bench_prefs,		99,	2,
+		" bench.prefs [n [iterations]]  : benchmark XML vs. binary preferences (n services)"	},
+
+	{ "bench.paths",	0,	2,	do_bench_paths,		99,	2,
+		" bench.paths [n [rounds]]      : benchmark preferences path lookups (n services)"	},
+
+	{ "bench.contention",	0,	2,	do_bench_contention,	99,	2,
+		" bench.contention [w [c]]      : benchmark locked vs. optimistic preferences commits (w writers, c commits)"	},
+
+	{ "bench.generate",	1,	4,	do_bench_generate,	99,	2,
+		" bench.generate dir [n [s [v]]] : write a network configuration (n services, s sets, v bond/bridge/VLANs)"	},
+
+	{ "bench.config",	0,	3,	do_bench_config,	99,	2,
+		" bench.config [dir | n [s [v]]] : benchmark network configuration access (generated, or a copy of dir)"	},
+
+	{ "bench.writer",	4,	4,	do_bench_writer,	99,	-1,
+		NULL											}
 };
 __private_extern__
 const int nCommands_store = (sizeof(commands_store)/sizeof(cmdInfo));
@@ -283,12 +322,24 @@ const cmdInfo commands_prefs[] = {
 	{ "lock",	0,	1,	do_prefs_lock,		3,	1,
 		" lock [wait]                   : locks write access to preferences"		},
 
-	{ "commit",	0,	0,	do_prefs_commit,	2,	0,
-		" commit                        : commit any changes"				},
+	{ "commit",	0,	1,	do_prefs_commit,	2,	0,
+		" commit [journal|optimistic|async] : commit any changes"			},
+
+	{ "latency",	0,	0,	do_prefs_latency,	2,	0,
+		" latency                       : show asynchronous commit latency"		},
+
+	{ "stats",	0,	0,	do_prefs_stats,		2,	0,
+		" stats                         : show lock / commit statistics"		},
+
+	{ "rebase",	0,	0,	do_prefs_rebase,	2,	0,
+		" rebase                        : re-apply changes to the current preferences"	},
 
 	{ "apply",	0,	0,	do_prefs_apply,		2,	0,
 		" apply                         : apply any changes"				},
 
+	{ "convert",	1,	1,	do_prefs_convert,	2,	0,
+		" convert xml|binary            : rewrite the preferences file in the given format"	},
+
 	{ "unlock",	0,	0,	do_prefs_unlock,	3,	1,
 		" unlock                        : unlocks write access to preferences"		},
 
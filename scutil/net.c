@@ -587,7 +587,15 @@ do_net_commit(int argc, char **argv)
 {
 #pragma unused(argc)
 #pragma unused(argv)
-	if (!SCPreferencesCommitChanges(prefs)) {
+	Boolean	ok;
+
+	if (ni_prefs != NULL) {
+		// commit the network configuration and its companion (interfaces) as a unit
+		ok = _SCPreferencesCommitGroup(prefs);
+	} else {
+		ok = SCPreferencesCommitChanges(prefs);
+	}
+	if (!ok) {
 		SCPrint(TRUE, stdout, CFSTR("%s\n"), SCErrorString(SCError()));
 		return;
 	}
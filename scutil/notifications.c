@@ -40,6 +40,17 @@
 
 #include "scutil.h"
 #include "notifications.h"
+#include "SCDynamicStoreInternal.h"
+
+
+/*
+ * n.watch values: fetch (and report) the new values of the changed keys.
+ * The "configd" server only sends the changed keys so the values are
+ * read back with a second request; this is not a payload mode (for that,
+ * see "scdlocal -w").
+ */
+static Boolean	watchValues	= FALSE;
+static CFIndex	watchValuesMax	= 64 * 1024;
 
 
 static char *
@@ -97,14 +108,38 @@ storeCallback(SCDynamicStoreRef store, CFArrayRef changedKeys, void *info)
 
 	n = CFArrayGetCount(changedKeys);
 	if (n > 0) {
+		CFDictionaryRef	values	= NULL;
+
+		if (watchValues) {
+			values = _SCDynamicStoreCopyChangedValues(store, changedKeys, watchValuesMax);
+			if ((values == NULL) && (SCError() == kSCStatusOK)) {
+				SCPrint(TRUE, stdout, CFSTR("  values exceed %ld bytes, keys only\n"), (long)watchValuesMax);
+			}
+		}
+
 		for (i = 0; i < n; i++) {
+			CFStringRef		key	= CFArrayGetValueAtIndex(changedKeys, i);
+			CFPropertyListRef	value;
+
 			SCPrint(TRUE,
 				stdout,
 				CFSTR("  %s changedKey [%d] = %@\n"),
 				elapsed(),
 				i,
-				CFArrayGetValueAtIndex(changedKeys, i));
+				key);
+
+			if (values == NULL) {
+				continue;
+			}
+			value = CFDictionaryGetValue(values, key);
+			if (value == kCFNull) {
+				SCPrint(TRUE, stdout, CFSTR("    <removed>\n"));
+			} else if (value != NULL) {
+				SCPrint(TRUE, stdout, CFSTR("    %@\n"), value);
+			}
 		}
+
+		if (values != NULL) CFRelease(values);
 	} else {
 		SCPrint(TRUE, stdout, CFSTR("  no changed key's.\n"));
 	}
@@ -315,8 +350,6 @@ __private_extern__
 void
 do_notify_watch(int argc, char **argv)
 {
-#pragma unused(argc)
-#pragma unused(argv)
 	pthread_attr_t	tattr;
 	pthread_t	tid;
 
@@ -325,6 +358,26 @@ do_notify_watch(int argc, char **argv)
 		return;
 	}
 
+	watchValues = FALSE;
+	if (argc > 0) {
+		if (strcmp(argv[0], "values") != 0) {
+			SCPrint(TRUE, stdout, CFSTR("invalid option: %s\n"), argv[0]);
+			return;
+		}
+		watchValues = TRUE;
+
+		watchValuesMax = 64 * 1024;
+		if (argc > 1) {
+			char	*end;
+
+			watchValuesMax = strtol(argv[1], &end, 10);
+			if ((*end != '\0') || (end == argv[1]) || (watchValuesMax < 0)) {
+				SCPrint(TRUE, stdout, CFSTR("invalid size\n"));
+				return;
+			}
+		}
+	}
+
 	pthread_attr_init(&tattr);
 	pthread_attr_setscope(&tattr, PTHREAD_SCOPE_SYSTEM);
 	pthread_attr_setdetachstate(&tattr, PTHREAD_CREATE_DETACHED);
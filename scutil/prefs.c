@@ -176,6 +176,18 @@ _prefs_open(CFStringRef name, const char *path)
 		CFDictionarySetValue(options, kSCPreferencesOptionRemoveWhenEmpty, kCFBooleanTrue);
 	}
 
+	if (getenv("SCPREFERENCES_JOURNAL") != NULL) {
+		// allow "commit journal"
+		if (options == NULL) {
+			options = CFDictionaryCreateMutable(NULL,
+							    0,
+							    &kCFTypeDictionaryKeyCallBacks,
+							    &kCFTypeDictionaryValueCallBacks);
+			useOptions = TRUE;
+		}
+		CFDictionarySetValue(options, kSCPreferencesOptionJournal, kCFBooleanTrue);
+	}
+
 	env = getenv("SCPREFERENCES_PROTECTION_CLASS");
 	if (env != NULL) {
 		CFStringRef	str;
@@ -741,18 +753,132 @@ do_prefs_unlock(int argc, char **argv)
 }
 
 
+#define	ASYNC_COMMIT_TIMEOUT	30	// seconds
+
+
 __private_extern__
 void
 do_prefs_commit(int argc, char **argv)
+{
+	Boolean	ok;
+
+	if ((argc > 0) && (strcmp(argv[0], "journal") == 0)) {
+		ok = _SCPreferencesCommitJournal(prefs);
+	} else if ((argc > 0) && (strcmp(argv[0], "optimistic") == 0)) {
+		ok = _SCPreferencesCommitOptimistic(prefs);
+	} else if ((argc > 0) && (strcmp(argv[0], "async") == 0)) {
+		__block Boolean		async_ok	= FALSE;
+		__block int		async_status	= kSCStatusOK;
+		dispatch_semaphore_t	done;
+
+		done = dispatch_semaphore_create(0);
+		dispatch_retain(done);		// released by the completion handler
+		ok = _SCPreferencesCommitChangesAsync(prefs,
+						      NULL,
+						      ^(Boolean commit_ok, int sc_status) {
+							      async_ok = commit_ok;
+							      async_status = sc_status;
+							      dispatch_semaphore_signal(done);
+							      dispatch_release(done);
+						      });
+		if (!ok) {
+			dispatch_release(done);
+		} else if (dispatch_semaphore_wait(done,
+						   dispatch_time(DISPATCH_TIME_NOW,
+								 ASYNC_COMMIT_TIMEOUT * NSEC_PER_SEC)) != 0) {
+			SCPrint(TRUE, stdout, CFSTR("commit not completed after %d seconds\n"), ASYNC_COMMIT_TIMEOUT);
+			dispatch_release(done);
+			return;
+		} else {
+			ok = async_ok;
+			if (!ok) {
+				_SCErrorSet(async_status);
+			}
+		}
+		dispatch_release(done);
+	} else if (argc > 0) {
+		SCPrint(TRUE, stdout, CFSTR("usage: commit [journal|optimistic|async]\n"));
+		return;
+	} else {
+		ok = SCPreferencesCommitChanges(prefs);
+	}
+	if (!ok) {
+		SCPrint(TRUE, stdout, CFSTR("%s\n"), SCErrorString(SCError()));
+		return;
+	}
+
+	_prefs_changed = FALSE;
+	return;
+}
+
+
+__private_extern__
+void
+do_prefs_latency(int argc, char **argv)
 {
 #pragma unused(argc)
 #pragma unused(argv)
-	if (!SCPreferencesCommitChanges(prefs)) {
+	CFDictionaryRef	latency;
+
+	latency = _SCPreferencesCopyCommitLatency();
+	SCPrint(TRUE, stdout, CFSTR("%@\n"), latency);
+	CFRelease(latency);
+	return;
+}
+
+
+__private_extern__
+void
+do_prefs_stats(int argc, char **argv)
+{
+#pragma unused(argc)
+#pragma unused(argv)
+	CFDictionaryRef	stats;
+
+	stats = _SCPreferencesCopyStatistics();
+	SCPrint(TRUE, stdout, CFSTR("%@\n"), stats);
+	CFRelease(stats);
+	return;
+}
+
+
+__private_extern__
+void
+do_prefs_rebase(int argc, char **argv)
+{
+#pragma unused(argc)
+#pragma unused(argv)
+	if (!_SCPreferencesRebase(prefs)) {
+		SCPrint(TRUE, stdout, CFSTR("%s\n"), SCErrorString(SCError()));
+		return;
+	}
+
+	_prefs_changed = TRUE;
+	return;
+}
+
+
+__private_extern__
+void
+do_prefs_convert(int argc, char **argv)
+{
+#pragma unused(argc)
+	CFPropertyListFormat	format;
+
+	if (strcmp(argv[0], "binary") == 0) {
+		format = kCFPropertyListBinaryFormat_v1_0;
+	} else if (strcmp(argv[0], "xml") == 0) {
+		format = kCFPropertyListXMLFormat_v1_0;
+	} else {
+		SCPrint(TRUE, stdout, CFSTR("format must be \"xml\" or \"binary\"\n"));
+		return;
+	}
+
+	if (!_SCPreferencesConvertStorageFormat(prefs, format)) {
 		SCPrint(TRUE, stdout, CFSTR("%s\n"), SCErrorString(SCError()));
 		return;
 	}
 
-	_prefs_changed = FALSE;
 	return;
 }
 
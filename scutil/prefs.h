@@ -61,6 +61,10 @@ void	do_prefs_lock		(int argc, char **argv);
 void	do_prefs_unlock		(int argc, char **argv);
 void	do_prefs_commit		(int argc, char **argv);
 void	do_prefs_apply		(int argc, char **argv);
+void	do_prefs_convert	(int argc, char **argv);
+void	do_prefs_rebase		(int argc, char **argv);
+void	do_prefs_latency	(int argc, char **argv);
+void	do_prefs_stats		(int argc, char **argv);
 void	do_prefs_close		(int argc, char **argv);
 void	do_prefs_synchronize	(int argc, char **argv);
 
@@ -73,7 +73,9 @@
 
 __private_extern__ AuthorizationRef	authorization	= NULL;
 __private_extern__ InputRef		currentInput	= NULL;
+__private_extern__ Boolean		doBinary	= FALSE;
 __private_extern__ Boolean		doDispatch	= FALSE;
+__private_extern__ Boolean		doJSON		= FALSE;
 __private_extern__ int			nesting		= 0;
 __private_extern__ SCPreferencesRef	ni_prefs	= NULL;
 __private_extern__ CFRunLoopRef		notifyRl	= NULL;
@@ -94,11 +96,13 @@ static const struct option longopts[] = {
 //	{ "timeout",		required_argument,	NULL,	't'	},
 //	{ "wait-key",		required_argument,	NULL,	'w'	},
 //	{ "watch-reachability",	no_argument,		NULL,	'W'	},
+	{ "binary",		no_argument,		NULL,	0	},
 	{ "configuration",	no_argument,		NULL,	0	},
 	{ "dns",		no_argument,		NULL,	0	},
 	{ "get",		required_argument,	NULL,	0	},
 	{ "error",		required_argument,	NULL,	0	},
 	{ "help",		no_argument,		NULL,	'?'	},
+	{ "json",		no_argument,		NULL,	0	},
 	{ "nc",			required_argument,	NULL,	0	},
 	{ "net",		no_argument,		NULL,	0	},
 	{ "nwi",		no_argument,		NULL,	0	},
@@ -348,15 +352,20 @@ usage(const char *command)
 	SCPrint(TRUE, stderr, CFSTR("\tnewval\tNew preference value to be set.  If not specified,\n"));
 	SCPrint(TRUE, stderr, CFSTR("\t\tthe new value will be read from standard input.\n"));
 	SCPrint(TRUE, stderr, CFSTR("\n"));
-	SCPrint(TRUE, stderr, CFSTR("   or: %s --dns\n"), command);
+	SCPrint(TRUE, stderr, CFSTR("   or: %s --dns [--json|--binary]\n"), command);
 	SCPrint(TRUE, stderr, CFSTR("\tshow DNS configuration.\n"));
 	SCPrint(TRUE, stderr, CFSTR("\n"));
 	SCPrint(TRUE, stderr, CFSTR("   or: %s --proxy\n"), command);
 	SCPrint(TRUE, stderr, CFSTR("\tshow \"proxy\" configuration.\n"));
 	SCPrint(TRUE, stderr, CFSTR("\n"));
-	SCPrint(TRUE, stderr, CFSTR("   or: %s --nwi\n"), command);
+	SCPrint(TRUE, stderr, CFSTR("   or: %s --nwi [--json|--binary]\n"), command);
 	SCPrint(TRUE, stderr, CFSTR("\tshow network information\n"));
 	SCPrint(TRUE, stderr, CFSTR("\n"));
+	SCPrint(TRUE, stderr, CFSTR("\t--json\treport the DNS configuration or network information\n"));
+	SCPrint(TRUE, stderr, CFSTR("\t\tas newline delimited JSON (one record per change with -W).\n"));
+	SCPrint(TRUE, stderr, CFSTR("\t--binary\treport the DNS configuration or network information\n"));
+	SCPrint(TRUE, stderr, CFSTR("\t\tas length-prefixed binary records (see structured_logging.h).\n"));
+	SCPrint(TRUE, stderr, CFSTR("\n"));
 	SCPrint(TRUE, stderr, CFSTR("   or: %s --nc\n"), command);
 	SCPrint(TRUE, stderr, CFSTR("\tshow VPN network configuration information. Use --nc help for full command list\n"));
 
@@ -464,7 +473,9 @@ main(int argc, char * const argv[])
 			watch = TRUE;
 			break;
 		case 0:
-			if        (strcmp(longopts[opti].name, "configuration") == 0) {
+			if        (strcmp(longopts[opti].name, "binary") == 0) {
+				doBinary = TRUE;
+			} else if (strcmp(longopts[opti].name, "configuration") == 0) {
 				configuration = TRUE;
 				xStore++;
 			} else if (strcmp(longopts[opti].name, "dns") == 0) {
@@ -473,6 +484,8 @@ main(int argc, char * const argv[])
 			} else if (strcmp(longopts[opti].name, "error") == 0) {
 				error = optarg;
 				xStore++;
+			} else if (strcmp(longopts[opti].name, "json") == 0) {
+				doJSON = TRUE;
 			} else if (strcmp(longopts[opti].name, "get") == 0) {
 				get = optarg;
 				xStore++;
@@ -53,7 +53,9 @@ typedef struct {
 
 extern AuthorizationRef		authorization;
 extern InputRef			currentInput;
+extern Boolean			doBinary;
 extern Boolean			doDispatch;
+extern Boolean			doJSON;
 extern int			nesting;
 extern SCPreferencesRef		ni_prefs;
 extern CFRunLoopRef		notifyRl;
@@ -35,6 +35,7 @@
 #include "cache.h"
 #include "session.h"
 #include "notifications.h"
+#include "SCDynamicStoreInternal.h"
 
 
 static void
@@ -53,6 +54,7 @@ do_open(int argc, char **argv)
 {
 #pragma unused(argv)
 	if (store) {
+		(void) _SCDynamicStoreReadCacheEnable(store, FALSE);
 		CFRelease(store);
 		CFRelease(watchedKeys);
 		CFRelease(watchedPatterns);
@@ -113,6 +115,7 @@ do_close(int argc, char **argv)
 	}
 
 	if (store != NULL) {
+		(void) _SCDynamicStoreReadCacheEnable(store, FALSE);
 		CFRelease(store);
 		store = NULL;
 		CFRelease(watchedKeys);
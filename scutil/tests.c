@@ -59,6 +59,7 @@
 #include "network_state_information_priv.h"
 
 #include "SCNetworkReachabilityInternal.h"
+#include "SCDynamicStoreInternal.h"
 
 #include <CommonCrypto/CommonDigest.h>
 
@@ -473,9 +474,32 @@ do_checkReachability(int argc, char **argv)
 }
 
 
+static void
+do_emitNWI(int argc, char **argv, nwi_state_t state)
+{
+	sc_emitter	e;
+
+	fflush(stdout);
+	_sc_emit_init_fd(&e, doBinary ? kSCEmitFormatBinary : kSCEmitFormatNDJSON, STDOUT_FILENO);
+	if ((argc > 0) && (state != NULL)) {
+		(void) _nwi_ifstate_emit_record(nwi_state_get_ifstate(state, argv[0]), _sc_debug, &e);
+	} else {
+		(void) _nwi_state_emit(state, _sc_debug, &e);
+	}
+	_sc_emit_release(&e);
+
+	return;
+}
+
+
 static void
 do_printNWI(int argc, char **argv, nwi_state_t state)
 {
+	if (doJSON || doBinary) {
+		do_emitNWI(argc, argv, state);
+		return;
+	}
+
 	if (state == NULL) {
 		SCPrint(TRUE, stdout, CFSTR("No network information\n"));
 		return;
@@ -549,13 +573,15 @@ do_watchNWI(int argc, char **argv)
 						  struct tm		tm_now;
 						  struct timeval	tv_now;
 
-						  (void)gettimeofday(&tv_now, NULL);
-						  (void)localtime_r(&tv_now.tv_sec, &tm_now);
-						  SCPrint(TRUE, stdout, CFSTR("\n*** %2d:%02d:%02d.%03d\n\n"),
-							  tm_now.tm_hour,
-							  tm_now.tm_min,
-							  tm_now.tm_sec,
-							  tv_now.tv_usec / 1000);
+						  if (!doJSON && !doBinary) {
+							  (void)gettimeofday(&tv_now, NULL);
+							  (void)localtime_r(&tv_now.tv_sec, &tm_now);
+							  SCPrint(TRUE, stdout, CFSTR("\n*** %2d:%02d:%02d.%03d\n\n"),
+								  tm_now.tm_hour,
+								  tm_now.tm_min,
+								  tm_now.tm_sec,
+								  tv_now.tv_usec / 1000);
+						  }
 
 						  state = nwi_state_copy();
 						  do_printNWI(argc, argv, state);
@@ -676,6 +702,16 @@ do_printDNSConfiguration(int argc, char **argv, dns_config_t *dns_config)
 #pragma unused(argv)
 	int	_sc_log_save;
 
+	if (doJSON || doBinary) {
+		sc_emitter	e;
+
+		fflush(stdout);
+		_sc_emit_init_fd(&e, doBinary ? kSCEmitFormatBinary : kSCEmitFormatNDJSON, STDOUT_FILENO);
+		(void) _dns_configuration_emit(dns_config, _sc_debug, &e);
+		_sc_emit_release(&e);
+		return;
+	}
+
 	if (dns_config == NULL) {
 		SCPrint(TRUE, stdout, CFSTR("No DNS configuration available\n"));
 		return;
@@ -735,13 +771,15 @@ do_watchDNSConfiguration(int argc, char **argv)
 						  struct tm		tm_now;
 						  struct timeval	tv_now;
 
-						  (void)gettimeofday(&tv_now, NULL);
-						  (void)localtime_r(&tv_now.tv_sec, &tm_now);
-						  SCPrint(TRUE, stdout, CFSTR("\n*** %2d:%02d:%02d.%03d\n\n"),
-							  tm_now.tm_hour,
-							  tm_now.tm_min,
-							  tm_now.tm_sec,
-							  tv_now.tv_usec / 1000);
+						  if (!doJSON && !doBinary) {
+							  (void)gettimeofday(&tv_now, NULL);
+							  (void)localtime_r(&tv_now.tv_sec, &tm_now);
+							  SCPrint(TRUE, stdout, CFSTR("\n*** %2d:%02d:%02d.%03d\n\n"),
+								  tm_now.tm_hour,
+								  tm_now.tm_min,
+								  tm_now.tm_sec,
+								  tv_now.tv_usec / 1000);
+						  }
 
 						  dns_config = dns_configuration_copy();
 						  do_printDNSConfiguration(argc, argv, dns_config);
@@ -883,13 +921,191 @@ do_showProxyConfiguration(int argc, char **argv)
 }
 
 
+static void
+snapshotApplyToDictionary(CFStringRef key, CFPropertyListRef value, void *context)
+{
+	CFMutableDictionaryRef	dict	= (CFMutableDictionaryRef)context;
+
+	if (value != NULL) {
+		CFDictionarySetValue(dict, key, value);
+	} else {
+		CFDictionaryRemoveValue(dict, key);
+	}
+
+	return;
+}
+
+
+static CFMutableDictionaryRef
+snapshotCopyFile(const char *path, SCDSnapshotHeader *header)
+{
+	CFMutableDictionaryRef	dict;
+	int			fd;
+	Boolean			ok;
+
+	fd = open(path, O_RDONLY, 0);
+	if (fd == -1) {
+		SCPrint(TRUE, stdout, CFSTR("open() failed: %s\n"), strerror(errno));
+		return NULL;
+	}
+
+	dict = CFDictionaryCreateMutable(NULL,
+					 0,
+					 &kCFTypeDictionaryKeyCallBacks,
+					 &kCFTypeDictionaryValueCallBacks);
+	ok = __SCDSnapshotRead(fd, header, snapshotApplyToDictionary, dict);
+	(void) close(fd);
+	if (!ok) {
+		SCPrint(TRUE, stdout, CFSTR("%s: not a valid snapshot\n"), path);
+		CFRelease(dict);
+		return NULL;
+	}
+
+	return dict;
+}
+
+
+typedef struct {
+	SCDSnapshotWriterRef	writer;
+	CFDictionaryRef		base;
+	CFDictionaryRef		current;
+	CFIndex			nRecords;
+	Boolean			ok;
+} snapshotWriteContext;
+
+
+static void
+snapshotWriteValue(const void *key, const void *value, void *context)
+{
+	snapshotWriteContext	*write	= (snapshotWriteContext *)context;
+
+	if (!write->ok) {
+		return;
+	}
+
+	if (write->base != NULL) {
+		CFPropertyListRef	baseValue;
+
+		baseValue = CFDictionaryGetValue(write->base, key);
+		if ((baseValue != NULL) && CFEqual(baseValue, value)) {
+			// if unchanged
+			return;
+		}
+	}
+
+	write->ok = __SCDSnapshotWriterAddValue(write->writer, (CFStringRef)key, (CFPropertyListRef)value);
+	write->nRecords++;
+	return;
+}
+
+
+static void
+snapshotWriteRemoval(const void *key, const void *value, void *context)
+{
+#pragma unused(value)
+	snapshotWriteContext	*write	= (snapshotWriteContext *)context;
+
+	if (!write->ok || CFDictionaryContainsKey(write->current, key)) {
+		return;
+	}
+
+	write->ok = __SCDSnapshotWriterAddRemoval(write->writer, (CFStringRef)key);
+	write->nRecords++;
+	return;
+}
+
+
+/*
+ * snapshotWrite
+ *
+ * Streams the store content (or, given a base snapshot, only the keys
+ * that were added, changed, or removed since) to a binary snapshot.
+ */
+static void
+snapshotWrite(const char *path, const char *basePath)
+{
+	snapshotWriteContext	context;
+	CFDictionaryRef		dict;
+	int			fd;
+	SCDSnapshotHeader	header;
+	CFMutableArrayRef	patterns;
+
+	memset(&context, 0, sizeof(context));
+	memset(&header, 0, sizeof(header));
+	if (basePath != NULL) {
+		SCDSnapshotHeader	baseHeader;
+
+		context.base = snapshotCopyFile(basePath, &baseHeader);
+		if (context.base == NULL) {
+			return;
+		}
+		header.flags = kSCDSnapshotFlagDelta;
+	}
+
+	patterns = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+	CFArrayAppendValue(patterns, CFSTR(".*"));
+	dict = SCDynamicStoreCopyMultiple(store, NULL, patterns);
+	CFRelease(patterns);
+	if (dict == NULL) {
+		if (SCError() != kSCStatusOK) {
+			SCPrint(TRUE, stdout, CFSTR("%s\n"), SCErrorString(SCError()));
+			if (context.base != NULL) CFRelease(context.base);
+			return;
+		}
+		dict = CFDictionaryCreate(NULL, NULL, NULL, 0, NULL, NULL);
+	}
+
+	fd = open(path, O_WRONLY|O_CREAT|O_TRUNC|O_EXCL, 0644);
+	if (fd == -1) {
+		SCPrint(TRUE, stdout, CFSTR("open() failed: %s\n"), strerror(errno));
+		CFRelease(dict);
+		if (context.base != NULL) CFRelease(context.base);
+		return;
+	}
+
+	context.writer = __SCDSnapshotWriterCreate(fd, &header);
+	if (context.writer == NULL) {
+		SCPrint(TRUE, stdout, CFSTR("could not write snapshot\n"));
+		(void) close(fd);
+		(void) unlink(path);
+		CFRelease(dict);
+		if (context.base != NULL) CFRelease(context.base);
+		return;
+	}
+	context.current = dict;
+	context.ok = TRUE;
+	CFDictionaryApplyFunction(dict, snapshotWriteValue, &context);
+	if (context.base != NULL) {
+		CFDictionaryApplyFunction(context.base, snapshotWriteRemoval, &context);
+	}
+	if (!__SCDSnapshotWriterClose(context.writer)) {
+		context.ok = FALSE;
+	}
+	(void) close(fd);
+
+	if (context.ok) {
+		SCPrint(_sc_debug, stdout, CFSTR("%ld records\n"), (long)context.nRecords);
+	} else {
+		SCPrint(TRUE, stdout, CFSTR("could not write snapshot\n"));
+	}
+
+	CFRelease(dict);
+	if (context.base != NULL) CFRelease(context.base);
+	return;
+}
+
+
 __private_extern__
 void
 do_snapshot(int argc, char **argv)
 {
-#pragma unused(argc)
-#pragma unused(argv)
-	if (argc == 1) {
+	if ((argc > 1) && (strcmp(argv[0], "-b") == 0)) {
+		// binary snapshot
+		snapshotWrite(argv[1], NULL);
+	} else if ((argc > 2) && (strcmp(argv[0], "-d") == 0)) {
+		// delta (binary) snapshot
+		snapshotWrite(argv[2], argv[1]);
+	} else if (argc == 1) {
 		CFDictionaryRef		dict;
 		int			fd;
 		CFMutableArrayRef	patterns;
@@ -923,7 +1139,7 @@ do_snapshot(int argc, char **argv)
 			}
 		}
 		(void) close(fd);
-	} else {
+	} else if (argc == 0) {
 #if	!TARGET_OS_SIMULATOR
 		if (geteuid() != 0) {
 			SCPrint(TRUE, stdout, CFSTR("Need to be \"root\" to capture snapshot\n"));
@@ -932,8 +1148,96 @@ do_snapshot(int argc, char **argv)
 		if (!SCDynamicStoreSnapshot(store)) {
 			SCPrint(TRUE, stdout, CFSTR("%s\n"), SCErrorString(SCError()));
 		}
+	} else {
+		SCPrint(TRUE, stdout, CFSTR("usage: snapshot [file | -b file | -d base-file file]\n"));
+	}
+
+	return;
+}
+
+
+typedef struct {
+	CFMutableDictionaryRef	keysToSet;
+	CFMutableSetRef		keysToRemove;
+} snapshotRestoreContext;
+
+
+static void
+snapshotApplyToStore(CFStringRef key, CFPropertyListRef value, void *context)
+{
+	snapshotRestoreContext	*restore	= (snapshotRestoreContext *)context;
+
+	// (a later record for the same key replaces an earlier one)
+	if (value != NULL) {
+		CFDictionarySetValue(restore->keysToSet, key, value);
+		CFSetRemoveValue(restore->keysToRemove, key);
+	} else {
+		CFDictionaryRemoveValue(restore->keysToSet, key);
+		CFSetAddValue(restore->keysToRemove, key);
+	}
+
+	return;
+}
+
+
+static void
+snapshotAppendKey(const void *value, void *context)
+{
+	CFMutableArrayRef	keys	= (CFMutableArrayRef)context;
+
+	CFArrayAppendValue(keys, value);
+	return;
+}
+
+
+__private_extern__
+void
+do_snapshot_restore(int argc, char **argv)
+{
+#pragma unused(argc)
+	int			fd;
+	SCDSnapshotHeader	header;
+	CFMutableArrayRef	keysToRemove	= NULL;
+	Boolean			ok;
+	snapshotRestoreContext	restore;
+
+	fd = open(argv[0], O_RDONLY, 0);
+	if (fd == -1) {
+		SCPrint(TRUE, stdout, CFSTR("open() failed: %s\n"), strerror(errno));
+		return;
+	}
+
+	restore.keysToSet = CFDictionaryCreateMutable(NULL,
+						      0,
+						      &kCFTypeDictionaryKeyCallBacks,
+						      &kCFTypeDictionaryValueCallBacks);
+	restore.keysToRemove = CFSetCreateMutable(NULL, 0, &kCFTypeSetCallBacks);
+	ok = __SCDSnapshotRead(fd, &header, snapshotApplyToStore, &restore);
+	(void) close(fd);
+
+	if (ok) {
+		keysToRemove = CFArrayCreateMutable(NULL,
+						    CFSetGetCount(restore.keysToRemove),
+						    &kCFTypeArrayCallBacks);
+		CFSetApplyFunction(restore.keysToRemove, snapshotAppendKey, keysToRemove);
+	}
+
+	if (!ok) {
+		SCPrint(TRUE, stdout, CFSTR("%s: not a valid snapshot\n"), argv[0]);
+	} else if (!SCDynamicStoreSetMultiple(store, restore.keysToSet, keysToRemove, NULL)) {
+		// (a single request to the server)
+		SCPrint(TRUE, stdout, CFSTR("  %s\n"), SCErrorString(SCError()));
+	} else {
+		SCPrint(_sc_debug, stdout,
+			CFSTR("%s snapshot, %ld keys set, %ld keys removed\n"),
+			((header.flags & kSCDSnapshotFlagDelta) != 0) ? "delta" : "full",
+			(long)CFDictionaryGetCount(restore.keysToSet),
+			(long)CFSetGetCount(restore.keysToRemove));
 	}
 
+	CFRelease(restore.keysToSet);
+	CFRelease(restore.keysToRemove);
+	if (keysToRemove != NULL) CFRelease(keysToRemove);
 	return;
 }
 
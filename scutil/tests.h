@@ -47,6 +47,7 @@ void	do_showDNSConfiguration		(int argc, char **argv);
 void	do_watchDNSConfiguration	(int argc, char **argv);
 void	do_showProxyConfiguration	(int argc, char **argv);
 void	do_snapshot			(int argc, char **argv);
+void	do_snapshot_restore		(int argc, char **argv);
 void	do_wait				(char *waitKey, int timeout);
 void	do_showNWI			(int argc, char **argv);
 void	do_watchNWI			(int argc, char **argv);